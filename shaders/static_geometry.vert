@@ -0,0 +1,23 @@
+#version 420
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNorm;
+layout (location = 2) in vec2 inTex;
+layout (location = 3) in mat4 inModel; // per draw, selected by the command's baseInstance or set before each draw
+
+layout (binding = 0, std140) uniform UBO {
+  mat4 model; // unused, see inModel
+  mat4 view;
+  mat4 projection;
+} ubo;
+
+layout (location = 0) out vec3 outNorm;
+layout (location = 1) out vec2 outTex;
+
+void main()
+{
+  gl_Position = ubo.projection * ubo.view * inModel * vec4(inPos, 1.0);
+  mat3 normalMat = mat3(transpose(inverse(inModel))); // Note: only necessary for non-uniform scaling
+  outNorm = normalize(normalMat * inNorm);
+  outTex = inTex;
+}
\ No newline at end of file
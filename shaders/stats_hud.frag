@@ -0,0 +1,14 @@
+#version 420
+
+layout (location = 0) in vec2 inGlyphPos;
+layout (location = 1) flat in uint inGlyphBits; // rows of three bits from the top, left pixel is the high bit
+
+out vec4 FragColor;
+
+void main()
+{
+  uvec2 pixel = uvec2(min(inGlyphPos, vec2(2.5, 4.5)));
+  uint bit = 14u - (((4u - pixel.y) * 3u) + pixel.x);
+  if(((inGlyphBits >> bit) & 1u) == 0u) { discard; }
+  FragColor = vec4(1., 1., 0.4, 1.);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 420
+
+layout (location = 0) in uint inGlyph; // 3x5 glyph bits | column << 16 | row << 24
+
+uniform ivec2 windowDimens;
+uniform int glyphScale; // screen pixels per glyph pixel
+
+layout (location = 0) out vec2 outGlyphPos;
+layout (location = 1) flat out uint outGlyphBits;
+
+void main()
+{
+  // triangle strip: (0,0), (1,0), (0,1), (1,1)
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+  // in glyph pixels, cells are 4x6 and start one cell in from the top left of the window
+  vec2 windowGlyphDimens = vec2(windowDimens) / float(glyphScale);
+  vec2 cell = vec2(float((inGlyph >> 16) & 0xFFu) + 1., float(inGlyph >> 24) + 1.);
+  vec2 glyphPos = corner * vec2(3., 5.);
+  vec2 screenPos = vec2((cell.x * 4.) + glyphPos.x, windowGlyphDimens.y - ((cell.y * 6.) + 5.) + glyphPos.y);
+
+  gl_Position = vec4(((screenPos / windowGlyphDimens) * 2.) - 1., 0., 1.);
+  outGlyphPos = glyphPos;
+  outGlyphBits = inGlyph & 0x7FFFu;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 420
+
+layout (location = 0) in uvec2 inTile; // chunk local x | y << 8, atlas index
+
+layout (binding = 1, std140) uniform UBO {
+  ivec2 spriteDimens;
+  ivec2 emulatedWindowRes;
+  vec2 pos;
+} ubo;
+
+uniform vec2 chunkOffset; // chunk's bottom left relative to the bottom left of the screen, in tiles
+uniform ivec2 atlasDimens; // in tiles
+uniform float atlasTexelInset; // keeps nearest sampling inside of the tile at its edges
+
+layout (location = 0) out vec3 outNorm;
+layout (location = 1) out vec2 outTex;
+
+void main()
+{
+  // triangle strip: (0,0), (1,0), (0,1), (1,1)
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vec2 tilePos = vec2(inTile.x & 0xFFu, inTile.x >> 8) + corner;
+  vec2 normalizedScreenPos = (chunkOffset + tilePos) / ubo.emulatedWindowRes;
+
+  // drawn at the far plane, behind the rest of the scene
+  gl_Position = vec4((normalizedScreenPos.x * 2.) - 1., (normalizedScreenPos.y * 2.) - 1., 1., 1.);
+
+  vec2 atlasTile = vec2(inTile.y % uint(atlasDimens.x), inTile.y / uint(atlasDimens.x));
+  outNorm = vec3(0., 0., 1.);
+  outTex = (atlasTile + mix(vec2(atlasTexelInset), vec2(1. - atlasTexelInset), corner)) / atlasDimens;
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#pragma once
+
+// Skeletal animation
+// Skeletons store joints parents first so model space transforms are a single forward pass. Clips keep one
+// translation, rotation and scale track per joint. Key times and values of every track are packed into shared
+// arrays, rotations quantized to four signed 16-bit components. Sampling walks forward from a per instance key
+// cursor, which makes the common case (time moved forward a little) constant time.
+// Poses are blended per joint and turned into a skinning palette: model space joint * inverse bind matrix,
+// indexed the same way as the mesh's JOINTS_0 attribute.
+
+#define ANIMATION_NO_JOINT U32_MAX
+#define ANIMATION_QUAT_SCALE 32767.0f
+#define ANIMATION_TRACKS_PER_JOINT 3 // translation, rotation, scale
+
+struct QuantizedQuat {
+  s16 x, y, z, w;
+};
+
+struct JointPose {
+  glm::vec3 translation;
+  glm::quat rotation;
+  glm::vec3 scale;
+};
+
+struct Skeleton {
+  u32 jointCount;
+  u32* parents; // ANIMATION_NO_JOINT or an index lower than the joint's own
+  u32* paletteIndices; // position of the joint in the glTF skin, which is what JOINTS_0 refers to
+  s32* gltfNodes;
+  glm::mat4* inverseBindMats;
+  JointPose* bindPose;
+};
+
+enum AnimationInterpolation : u32 {
+  AnimationInterpolation_Step,
+  AnimationInterpolation_Linear, // also used for cubic splines, tangents are dropped at load
+};
+
+// keyCount of 0 leaves the joint at its bind pose
+struct AnimationTrack {
+  u32 firstTime; // into AnimationClip::keyTimes
+  u32 firstValue; // into the clip's vectorKeys or rotationKeys
+  u32 keyCount;
+  AnimationInterpolation interpolation;
+};
+
+struct AnimationClip {
+  const char* name;
+  f32 durationSeconds;
+  u32 jointCount;
+  AnimationTrack* tracks; // ANIMATION_TRACKS_PER_JOINT per joint
+  f32* keyTimes;
+  glm::vec3* vectorKeys; // translations and scales
+  QuantizedQuat* rotationKeys;
+  u32 keyTimeCount;
+  u32 vectorKeyCount;
+  u32 rotationKeyCount;
+};
+
+inline QuantizedQuat quantizeQuat(glm::quat q) {
+  // q and -q are the same rotation, keeping w positive leaves one encoding per rotation
+  f32 sign = q.w < 0.0f ? -1.0f : 1.0f;
+  auto quantize = [sign](f32 v) { return (s16)roundf(Clamp(v * sign, -1.0f, 1.0f) * ANIMATION_QUAT_SCALE); };
+  return QuantizedQuat{ quantize(q.x), quantize(q.y), quantize(q.z), quantize(q.w) };
+}
+
+// Off unit length by up to the quantization step, fine for inputs to nlerpQuat() which normalizes anyway
+internal inline glm::quat dequantizeQuatUnnormalized(QuantizedQuat q) {
+  const f32 scale = 1.0f / ANIMATION_QUAT_SCALE;
+  return glm::quat(q.w * scale, q.x * scale, q.y * scale, q.z * scale);
+}
+
+inline glm::quat dequantizeQuat(QuantizedQuat q) {
+  return normalize(dequantizeQuatUnnormalized(q));
+}
+
+// Normalized lerp along the shorter arc, close enough to slerp for neighbouring keys and blend weights
+internal inline glm::quat nlerpQuat(const glm::quat& a, const glm::quat& b, f32 t) {
+#if TRANSFORM_SIMD_WIDTH > 1
+  __m128 va = _mm_setr_ps(a.x, a.y, a.z, a.w);
+  __m128 vb = _mm_setr_ps(b.x, b.y, b.z, b.w);
+  __m128 dot = _mm_mul_ps(va, vb);
+  dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+  dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+  __m128 signMask = _mm_and_ps(dot, _mm_set1_ps(-0.0f));
+  vb = _mm_xor_ps(vb, signMask);
+  __m128 result = _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), _mm_set1_ps(t)));
+  __m128 lengthSq = _mm_mul_ps(result, result);
+  lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(2, 3, 0, 1)));
+  lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(1, 0, 3, 2)));
+  result = _mm_div_ps(result, _mm_sqrt_ps(lengthSq));
+  f32 out[4];
+  _mm_storeu_ps(out, result);
+  return glm::quat(out[3], out[0], out[1], out[2]);
+#else
+  f32 sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+  glm::quat result = glm::quat(a.w + (b.w * sign - a.w) * t, a.x + (b.x * sign - a.x) * t,
+                               a.y + (b.y * sign - a.y) * t, a.z + (b.z * sign - a.z) * t);
+  return normalize(result);
+#endif
+}
+
+// Index of the last key at or before time. cursor holds the key found last time and may be nullptr.
+internal inline u32 findAnimationKey(const f32* times, u32 keyCount, f32 time, u32* cursor) {
+  if(cursor == nullptr) {
+    u32 upper = (u32)(std::upper_bound(times, times + keyCount, time) - times);
+    return upper == 0 ? 0 : upper - 1;
+  }
+  u32 key = *cursor < keyCount && times[*cursor] <= time ? *cursor : 0; // looped around, start over
+  while(key + 1 < keyCount && times[key + 1] <= time) { key++; }
+  *cursor = key;
+  return key;
+}
+
+// Key index and blend factor towards the next key
+internal inline u32 sampleAnimationTrack(const AnimationClip& clip, const AnimationTrack& track, f32 time, u32* cursor, f32* outT) {
+  const f32* times = clip.keyTimes + track.firstTime;
+  u32 key = findAnimationKey(times, track.keyCount, time, cursor);
+  *outT = 0.0f;
+  if(track.interpolation == AnimationInterpolation_Linear && key + 1 < track.keyCount && time > times[key]) {
+    *outT = Min((time - times[key]) / (times[key + 1] - times[key]), 1.0f);
+  }
+  return key;
+}
+
+// Wraps time into the clip. cursors holds ANIMATION_TRACKS_PER_JOINT entries per joint, zero them for a new
+// instance. Passing nullptr searches every track from scratch.
+void sampleAnimation(const Skeleton& skeleton, const AnimationClip& clip, f32 timeSeconds, u32* cursors, JointPose* outPose) {
+  assert(clip.jointCount == skeleton.jointCount && "ERROR: Animation clip was loaded for a different skeleton!");
+  f32 time = clip.durationSeconds > 0.0f ? fmodf(timeSeconds, clip.durationSeconds) : 0.0f;
+  if(time < 0.0f) { time += clip.durationSeconds; }
+
+  for(u32 joint = 0; joint < skeleton.jointCount; ++joint) {
+    JointPose pose = skeleton.bindPose[joint];
+    const AnimationTrack* tracks = clip.tracks + (joint * ANIMATION_TRACKS_PER_JOINT);
+    u32* jointCursors = cursors != nullptr ? cursors + (joint * ANIMATION_TRACKS_PER_JOINT) : nullptr;
+    f32 t;
+
+    const AnimationTrack& translationTrack = tracks[0];
+    if(translationTrack.keyCount != 0) {
+      u32 key = sampleAnimationTrack(clip, translationTrack, time, jointCursors, &t);
+      const glm::vec3* keys = clip.vectorKeys + translationTrack.firstValue;
+      pose.translation = (t == 0.0f) ? keys[key] : keys[key] + (keys[key + 1] - keys[key]) * t;
+    }
+
+    const AnimationTrack& rotationTrack = tracks[1];
+    if(rotationTrack.keyCount != 0) {
+      u32 key = sampleAnimationTrack(clip, rotationTrack, time, jointCursors != nullptr ? jointCursors + 1 : nullptr, &t);
+      const QuantizedQuat* keys = clip.rotationKeys + rotationTrack.firstValue;
+      pose.rotation = (t == 0.0f) ? dequantizeQuat(keys[key]) : nlerpQuat(dequantizeQuatUnnormalized(keys[key]), dequantizeQuatUnnormalized(keys[key + 1]), t);
+    }
+
+    const AnimationTrack& scaleTrack = tracks[2];
+    if(scaleTrack.keyCount != 0) {
+      u32 key = sampleAnimationTrack(clip, scaleTrack, time, jointCursors != nullptr ? jointCursors + 2 : nullptr, &t);
+      const glm::vec3* keys = clip.vectorKeys + scaleTrack.firstValue;
+      pose.scale = (t == 0.0f) ? keys[key] : keys[key] + (keys[key + 1] - keys[key]) * t;
+    }
+
+    outPose[joint] = pose;
+  }
+}
+
+// out = a * (1 - weight) + b * weight, out may alias either input
+void blendPoses(const JointPose* a, const JointPose* b, f32 weight, u32 jointCount, JointPose* outPose) {
+  for(u32 joint = 0; joint < jointCount; ++joint) {
+    outPose[joint].translation = a[joint].translation + (b[joint].translation - a[joint].translation) * weight;
+    outPose[joint].rotation = nlerpQuat(a[joint].rotation, b[joint].rotation, weight);
+    outPose[joint].scale = a[joint].scale + (b[joint].scale - a[joint].scale) * weight;
+  }
+}
+
+// outPalette is indexed like JOINTS_0 and must hold skeleton.jointCount matrices
+void computeSkinningPalette(const Skeleton& skeleton, const JointPose* pose, glm::mat4* outPalette) {
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  glm::mat4* modelMats = pushArray(tempMemory.arena, skeleton.jointCount, glm::mat4);
+  for(u32 joint = 0; joint < skeleton.jointCount; ++joint) {
+    const JointPose& jointPose = pose[joint];
+    glm::mat4 localMat = glm::mat4_cast(jointPose.rotation);
+    localMat[0] *= jointPose.scale.x;
+    localMat[1] *= jointPose.scale.y;
+    localMat[2] *= jointPose.scale.z;
+    localMat[3] = glm::vec4(jointPose.translation, 1.0f);
+
+    u32 parent = skeleton.parents[joint];
+    if(parent == ANIMATION_NO_JOINT) {
+      modelMats[joint] = localMat;
+    } else {
+      multiplyMat4(modelMats[parent], localMat, modelMats + joint);
+    }
+    multiplyMat4(modelMats[joint], skeleton.inverseBindMats[joint], outPalette + skeleton.paletteIndices[joint]);
+  }
+  endTempMemory(tempMemory);
+}
+
+// 1k instances each sampling and blending two clips on a procedural skeleton, results are printed to stdout
+void benchmarkAnimation() {
+  const u32 instanceCount = 1000;
+  const u32 jointCount = 48;
+  const u32 keysPerSecond = 30;
+  const u32 frameCount = 120;
+  const f32 frameSeconds = 1.0f / 60.0f;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  auto elapsedMs = [secondsPerCounter](u64 start) { return (getPerformanceCounter() - start) * secondsPerCounter * 1000.0; };
+  u32 randomState = 0x9E3779B9u;
+  auto randomFloat = [&randomState]() { // xorshift32, [0, 1)
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (f32)(randomState >> 8) / (f32)(1u << 24);
+  };
+
+  // spine of 8 joints, each spine joint with a 5 joint limb hanging off of it
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Arena* arena = tempMemory.arena;
+  Skeleton skeleton;
+  skeleton.jointCount = jointCount;
+  skeleton.parents = pushArray(arena, jointCount, u32);
+  skeleton.paletteIndices = pushArray(arena, jointCount, u32);
+  skeleton.gltfNodes = pushArray(arena, jointCount, s32);
+  skeleton.inverseBindMats = pushArray(arena, jointCount, glm::mat4);
+  skeleton.bindPose = pushArray(arena, jointCount, JointPose);
+  for(u32 joint = 0; joint < jointCount; ++joint) {
+    u32 spineJoint = joint / 6, limbJoint = joint % 6;
+    skeleton.parents[joint] = limbJoint == 0 ? (spineJoint == 0 ? ANIMATION_NO_JOINT : (spineJoint - 1) * 6) : joint - 1;
+    skeleton.paletteIndices[joint] = jointCount - 1 - joint; // exercise the remap
+    skeleton.gltfNodes[joint] = (s32)joint;
+    skeleton.inverseBindMats[joint] = glm::mat4();
+    skeleton.bindPose[joint] = JointPose{ glm::vec3(0.0f, 0.5f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) };
+  }
+
+  f32 maxQuantizationError = 0.0f;
+  AnimationClip clips[2];
+  f32 clipDurations[2] = { 2.0f, 1.5f };
+  for(u32 clipIndex = 0; clipIndex < ArrayCount(clips); ++clipIndex) {
+    AnimationClip* clip = clips + clipIndex;
+    u32 keyCount = (u32)(clipDurations[clipIndex] * keysPerSecond) + 1;
+    clip->name = clipIndex == 0 ? "walk" : "run";
+    clip->durationSeconds = clipDurations[clipIndex];
+    clip->jointCount = jointCount;
+    clip->tracks = pushArray(arena, jointCount * ANIMATION_TRACKS_PER_JOINT, AnimationTrack);
+    clip->keyTimeCount = keyCount; // every track shares the same times
+    clip->vectorKeyCount = jointCount * keyCount;
+    clip->rotationKeyCount = jointCount * keyCount;
+    clip->keyTimes = pushArray(arena, clip->keyTimeCount, f32);
+    clip->vectorKeys = pushArray(arena, clip->vectorKeyCount, glm::vec3);
+    clip->rotationKeys = pushArray(arena, clip->rotationKeyCount, QuantizedQuat);
+    for(u32 key = 0; key < keyCount; ++key) { clip->keyTimes[key] = clip->durationSeconds * key / (keyCount - 1); }
+    for(u32 joint = 0; joint < jointCount; ++joint) {
+      AnimationTrack* tracks = clip->tracks + (joint * ANIMATION_TRACKS_PER_JOINT);
+      tracks[0] = AnimationTrack{ 0, joint * keyCount, keyCount, AnimationInterpolation_Linear };
+      tracks[1] = AnimationTrack{ 0, joint * keyCount, keyCount, AnimationInterpolation_Linear };
+      tracks[2] = AnimationTrack{}; // bind pose scale
+      glm::vec3 axis = normalize(glm::vec3(randomFloat() - 0.5f, randomFloat() - 0.5f, randomFloat() - 0.5f) + glm::vec3(0.0f, 0.0f, 0.01f));
+      f32 amplitude = randomFloat() * 0.8f;
+      for(u32 key = 0; key < keyCount; ++key) {
+        f32 phase = 6.2831853f * key / (keyCount - 1);
+        clip->vectorKeys[(joint * keyCount) + key] = glm::vec3(0.0f, 0.5f + 0.05f * sinf(phase), 0.0f);
+        glm::quat rotation = glm::angleAxis(amplitude * sinf(phase), axis);
+        QuantizedQuat quantized = quantizeQuat(rotation);
+        clip->rotationKeys[(joint * keyCount) + key] = quantized;
+        glm::quat dequantized = dequantizeQuat(quantized);
+        f32 dot = fabsf(rotation.x * dequantized.x + rotation.y * dequantized.y + rotation.z * dequantized.z + rotation.w * dequantized.w);
+        maxQuantizationError = Max(maxQuantizationError, 2.0f * acosf(Min(dot, 1.0f))); // angle between the rotations
+      }
+    }
+  }
+
+  JointPose* poses = pushArray(arena, instanceCount * jointCount * 2, JointPose);
+  glm::mat4* palettes = pushArray(arena, instanceCount * jointCount, glm::mat4);
+  u32* cursors = pushArrayZero(arena, instanceCount * jointCount * ANIMATION_TRACKS_PER_JOINT * 2, u32);
+  f32* instanceTimes = pushArray(arena, instanceCount, f32);
+  f32* blendWeights = pushArray(arena, instanceCount, f32);
+  for(u32 i = 0; i < instanceCount; ++i) {
+    instanceTimes[i] = randomFloat() * 2.0f;
+    blendWeights[i] = randomFloat();
+  }
+
+  auto animateInstances = [&](u32 begin, u32 end, f32 time, bool useCursors) {
+    for(u32 i = begin; i < end; ++i) {
+      JointPose* poseA = poses + (i * jointCount * 2);
+      JointPose* poseB = poseA + jointCount;
+      u32* cursorsA = useCursors ? cursors + (i * jointCount * ANIMATION_TRACKS_PER_JOINT * 2) : nullptr;
+      u32* cursorsB = useCursors ? cursorsA + (jointCount * ANIMATION_TRACKS_PER_JOINT) : nullptr;
+      sampleAnimation(skeleton, clips[0], instanceTimes[i] + time, cursorsA, poseA);
+      sampleAnimation(skeleton, clips[1], instanceTimes[i] + time, cursorsB, poseB);
+      blendPoses(poseA, poseB, blendWeights[i], jointCount, poseA);
+      computeSkinningPalette(skeleton, poseA, palettes + (i * jointCount));
+    }
+  };
+
+  u64 start = getPerformanceCounter();
+  for(u32 frame = 0; frame < frameCount; ++frame) { animateInstances(0, instanceCount, frame * frameSeconds, false); }
+  f64 searchMs = elapsedMs(start) / frameCount;
+
+  start = getPerformanceCounter();
+  for(u32 frame = 0; frame < frameCount; ++frame) { animateInstances(0, instanceCount, frame * frameSeconds, true); }
+  f64 cursorMs = elapsedMs(start) / frameCount;
+
+  start = getPerformanceCounter();
+  for(u32 frame = 0; frame < frameCount; ++frame) {
+    f32 time = frame * frameSeconds;
+    parallelFor(instanceCount, 32, [&animateInstances, time](u32 begin, u32 end) { animateInstances(begin, end, time, true); });
+  }
+  f64 parallelMs = elapsedMs(start) / frameCount;
+
+  u32 keyBytes = 0, floatKeyBytes = 0;
+  for(u32 clipIndex = 0; clipIndex < ArrayCount(clips); ++clipIndex) {
+    keyBytes += clips[clipIndex].keyTimeCount * sizeof(f32) + clips[clipIndex].vectorKeyCount * sizeof(glm::vec3) + clips[clipIndex].rotationKeyCount * sizeof(QuantizedQuat);
+    floatKeyBytes += clips[clipIndex].keyTimeCount * sizeof(f32) + clips[clipIndex].vectorKeyCount * sizeof(glm::vec3) + clips[clipIndex].rotationKeyCount * sizeof(glm::quat);
+  }
+
+  printf("Animation benchmark (%u instances, %u joints, 2 clips blended per instance)\n", instanceCount, jointCount);
+  printf("  binary search keys: %8.3f ms/frame\n", searchMs);
+  printf("  key cursors:        %8.3f ms/frame (%.2f us/instance)\n", cursorMs, cursorMs * 1000.0 / instanceCount);
+  printf("  key cursors, %u threads: %8.3f ms/frame\n", jobThreadCount(), parallelMs);
+  printf("  clip keys: %u KB (float rotations: %u KB), max quantization error %.2e rad\n", keyBytes / 1024, floatKeyBytes / 1024, maxQuantizationError);
+  endTempMemory(tempMemory);
+}
\ No newline at end of file
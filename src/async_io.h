@@ -0,0 +1,507 @@
+#pragma once
+
+// Asynchronous file reads
+// Whole files are read in batches. Files are opened and sized on the calling thread, then split into chunks that
+// are kept in flight together. On Linux the chunks go to an io_uring, as many per io_uring_enter() as the queue
+// depth allows, reading into a buffer registered with the kernel once so its pages aren't pinned again for every
+// read. Elsewhere, or when the kernel refuses an io_uring, every file is a job on the job system that blocks on its
+// own reads. Completion callbacks run as each file finishes, on the calling thread for io_uring and on a worker
+// for the fallback, so the next stage (decoding, uploading) can start while other reads are still in flight.
+// source: "Efficient IO with io_uring", Jens Axboe 2019
+
+#define ASYNC_IO_DEFAULT_QUEUE_DEPTH 64 // power of two
+#define ASYNC_IO_DEFAULT_BUFFER_SIZE Megabytes(32)
+#define ASYNC_IO_CHUNK_SIZE Kilobytes(256)
+#define ASYNC_IO_ALIGNMENT 64
+
+enum AsyncIoBackend {
+  AsyncIoBackend_ThreadPool,
+  AsyncIoBackend_IoUring,
+};
+
+struct AsyncFileRead {
+  const char* path;
+  u8* bytes; // valid until releaseAsyncReads()
+  u64 size;
+  s32 error; // errno, 0 on success
+  s32 fd;
+  u32 remainingChunks;
+  u32 readCallCount;
+  bool ownsBytes; // did not fit in the read buffer
+};
+
+typedef void (*AsyncReadCallback)(AsyncFileRead* read, void* userData);
+
+struct AsyncIoStats {
+  u64 fileCount;
+  u64 byteCount;
+  u64 chunkCount;
+  u64 submitCallCount; // io_uring_enter() calls, or read calls for the fallback
+  u64 queueDepthSum; // chunks in flight, sampled at every submit
+  u64 queueDepthSampleCount;
+  u32 maxQueueDepth;
+  f64 seconds;
+};
+
+#ifdef __linux__
+struct IoUring {
+  s32 fd;
+  u32 entries;
+  u32* sqHead;
+  u32* sqTail;
+  u32 sqMask;
+  u32* sqArray;
+  io_uring_sqe* sqes;
+  u32* cqHead;
+  u32* cqTail;
+  u32 cqMask;
+  io_uring_cqe* cqes;
+  void* sqRing;
+  size_t sqRingSize;
+  void* cqRing;
+  size_t cqRingSize;
+  size_t sqesSize;
+};
+#endif
+
+struct AsyncIo {
+  AsyncIoBackend backend;
+  u32 queueDepth;
+  u8* buffer;
+  u64 bufferSize;
+  u64 bufferUsed;
+  bool bufferRegistered;
+  AsyncIoStats stats;
+#ifdef __linux__
+  IoUring ring;
+#endif
+};
+
+// File descriptor helpers, every fallback job reads through its own descriptor
+internal s32 openFileForRead(const char* path, u64* outSize) {
+#ifdef _WIN32
+  s32 fd = _open(path, _O_RDONLY | _O_BINARY);
+  struct _stat64 fileStat;
+  if(fd >= 0 && _fstat64(fd, &fileStat) != 0) {
+    _close(fd);
+    fd = -1;
+  }
+#else
+  s32 fd = open(path, O_RDONLY);
+  struct stat fileStat;
+  if(fd >= 0 && fstat(fd, &fileStat) != 0) {
+    close(fd);
+    fd = -1;
+  }
+#endif
+  *outSize = fd >= 0 ? (u64)fileStat.st_size : 0;
+  return fd;
+}
+
+internal s64 readFileAt(s32 fd, u8* dst, u64 size, u64 offset) {
+#ifdef _WIN32
+  if(_lseeki64(fd, (s64)offset, SEEK_SET) < 0) { return -1; }
+  return _read(fd, dst, (u32)size);
+#else
+  return pread(fd, dst, size, (off_t)offset);
+#endif
+}
+
+internal void closeFileForRead(s32 fd) {
+#ifdef _WIN32
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
+
+internal void readFilesThreadPool(AsyncIo* io, AsyncFileRead* reads, u32 count, AsyncReadCallback onComplete, void* userData) {
+  struct ReadJob {
+    AsyncFileRead* read;
+    AsyncReadCallback onComplete;
+    void* userData;
+  };
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  ReadJob* jobs = pushArrayZero(tempMemory.arena, count, ReadJob);
+  JobCounter readCounter;
+  for(u32 i = 0; i < count; ++i) {
+    if(reads[i].remainingChunks == 0) { continue; }
+    reads[i].readCallCount = 0;
+    jobs[i] = ReadJob{ reads + i, onComplete, userData };
+    io->stats.chunkCount += reads[i].remainingChunks;
+    runJob([](void* data) {
+      ReadJob* job = (ReadJob*)data;
+      AsyncFileRead* read = job->read;
+      for(u64 offset = 0; offset < read->size && read->error == 0;) {
+        s64 bytesRead = readFileAt(read->fd, read->bytes + offset, Min(read->size - offset, (u64)ASYNC_IO_CHUNK_SIZE), offset);
+        read->readCallCount++;
+        if(bytesRead <= 0) {
+          read->error = bytesRead < 0 ? errno : EIO;
+        }
+        offset += bytesRead > 0 ? bytesRead : 0;
+      }
+      closeFileForRead(read->fd);
+      read->fd = -1;
+      read->remainingChunks = 0;
+      if(job->onComplete != nullptr) { job->onComplete(read, job->userData); }
+    }, jobs + i, &readCounter);
+  }
+  u32 inFlight = Min(count, jobThreadCount()); // one blocking read per thread
+  io->stats.queueDepthSum += inFlight;
+  io->stats.queueDepthSampleCount++;
+  io->stats.maxQueueDepth = Max(io->stats.maxQueueDepth, inFlight);
+  waitForCounter(&readCounter);
+  for(u32 i = 0; i < count; ++i) {
+    if(jobs[i].read != nullptr) { io->stats.submitCallCount += reads[i].readCallCount; }
+  }
+  endTempMemory(tempMemory);
+}
+
+#ifdef __linux__
+internal void deinitIoUring(IoUring* ring) {
+  if(ring->sqes != nullptr) { munmap(ring->sqes, ring->sqesSize); }
+  if(ring->cqRing != nullptr && ring->cqRing != ring->sqRing) { munmap(ring->cqRing, ring->cqRingSize); }
+  if(ring->sqRing != nullptr) { munmap(ring->sqRing, ring->sqRingSize); }
+  if(ring->fd >= 0) { close(ring->fd); }
+  *ring = {};
+  ring->fd = -1;
+}
+
+internal bool initIoUring(IoUring* ring, u32 entries) {
+  *ring = {};
+  io_uring_params params{};
+  ring->fd = (s32)syscall(__NR_io_uring_setup, entries, &params);
+  if(ring->fd < 0) { return false; }
+
+  ring->sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(u32));
+  ring->cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+  bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if(singleMap) {
+    size_t ringSize = Max(ring->sqRingSize, ring->cqRingSize);
+    ring->sqRingSize = ring->cqRingSize = ringSize;
+  }
+  void* sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->sqRing = sqRing == MAP_FAILED ? nullptr : sqRing;
+  void* cqRing = singleMap ? sqRing : mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  ring->cqRing = cqRing == MAP_FAILED ? nullptr : cqRing;
+  ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  ring->sqes = sqes == MAP_FAILED ? nullptr : (io_uring_sqe*)sqes;
+  if(ring->sqRing == nullptr || ring->cqRing == nullptr || ring->sqes == nullptr) {
+    deinitIoUring(ring);
+    return false;
+  }
+
+  u8* sq = (u8*)ring->sqRing;
+  ring->sqHead = (u32*)(sq + params.sq_off.head);
+  ring->sqTail = (u32*)(sq + params.sq_off.tail);
+  ring->sqMask = *(u32*)(sq + params.sq_off.ring_mask);
+  ring->sqArray = (u32*)(sq + params.sq_off.array);
+  u8* cq = (u8*)ring->cqRing;
+  ring->cqHead = (u32*)(cq + params.cq_off.head);
+  ring->cqTail = (u32*)(cq + params.cq_off.tail);
+  ring->cqMask = *(u32*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+  ring->entries = params.sq_entries;
+
+  // IORING_OP_READ arrived in 5.6 together with the probe, older kernels set up a ring that fails every read
+  u8 probeStorage[sizeof(io_uring_probe) + (256 * sizeof(io_uring_probe_op))] = {};
+  io_uring_probe* probe = (io_uring_probe*)probeStorage;
+  bool canRead = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+                 probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+  if(!canRead) {
+    deinitIoUring(ring);
+    return false;
+  }
+  return true;
+}
+
+// Queued for the next io_uring_enter(), the caller keeps no more than entries chunks in flight
+internal void queueIoUringRead(AsyncIo* io, s32 fd, u8* dst, u32 size, u64 offset, u64 userData) {
+  IoUring* ring = &io->ring;
+  u32 tail = std::atomic_ref<u32>(*ring->sqTail).load(std::memory_order_relaxed);
+  u32 index = tail & ring->sqMask;
+  io_uring_sqe* sqe = ring->sqes + index;
+  memset(sqe, 0, sizeof(*sqe));
+  bool inBuffer = dst >= io->buffer && dst + size <= io->buffer + io->bufferSize;
+  sqe->opcode = (io->bufferRegistered && inBuffer) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = (u64)dst;
+  sqe->len = size;
+  sqe->off = offset;
+  sqe->buf_index = 0;
+  sqe->user_data = userData;
+  ring->sqArray[index] = index;
+  std::atomic_ref<u32>(*ring->sqTail).store(tail + 1, std::memory_order_release);
+}
+
+internal void readFilesIoUring(AsyncIo* io, AsyncFileRead* reads, u32 count, AsyncReadCallback onComplete, void* userData) {
+  struct Chunk {
+    u32 readIndex;
+    u32 size;
+    u64 offset;
+    u8* dst;
+  };
+  IoUring* ring = &io->ring;
+  u32 queueDepth = Min(io->queueDepth, ring->entries);
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Chunk* chunks = pushArray(tempMemory.arena, queueDepth, Chunk);
+  u32* freeSlots = pushArray(tempMemory.arena, queueDepth, u32);
+  for(u32 i = 0; i < queueDepth; ++i) { freeSlots[i] = queueDepth - 1 - i; }
+  u32 freeSlotCount = queueDepth;
+
+  u32 remainingFiles = 0;
+  for(u32 i = 0; i < count; ++i) {
+    if(reads[i].remainingChunks > 0) { remainingFiles++; }
+  }
+  u32 nextRead = 0;
+  u64 nextOffset = 0;
+  u32 queuedCount = 0;
+  while(remainingFiles > 0) {
+    // fill every free slot with the next chunks in file order
+    while(freeSlotCount > 0) {
+      while(nextRead < count && (reads[nextRead].remainingChunks == 0 || nextOffset == reads[nextRead].size)) {
+        nextRead++;
+        nextOffset = 0;
+      }
+      if(nextRead == count) { break; }
+      AsyncFileRead& read = reads[nextRead];
+      u32 slot = freeSlots[--freeSlotCount];
+      Chunk& chunk = chunks[slot];
+      chunk.readIndex = nextRead;
+      chunk.offset = nextOffset;
+      chunk.size = (u32)Min(read.size - nextOffset, (u64)ASYNC_IO_CHUNK_SIZE);
+      chunk.dst = read.bytes + nextOffset;
+      nextOffset += chunk.size;
+      queueIoUringRead(io, read.fd, chunk.dst, chunk.size, chunk.offset, slot);
+      queuedCount++;
+      io->stats.chunkCount++;
+    }
+
+    u32 inFlight = queueDepth - freeSlotCount;
+    io->stats.queueDepthSum += inFlight;
+    io->stats.queueDepthSampleCount++;
+    io->stats.maxQueueDepth = Max(io->stats.maxQueueDepth, inFlight);
+    io->stats.submitCallCount++;
+    s32 submitted = (s32)syscall(__NR_io_uring_enter, ring->fd, queuedCount, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if(submitted < 0) {
+      if(errno == EINTR) { continue; }
+      // the ring is unusable, unfinished files are read again from the start by the thread pool. Chunks the kernel
+      // already accepted may still land, they write the same bytes to the same place.
+      printf("io_uring_enter failed (%s), falling back to the thread pool\n", strerror(errno));
+      io->backend = AsyncIoBackend_ThreadPool;
+      for(u32 i = 0; i < count; ++i) {
+        if(reads[i].remainingChunks > 0) {
+          reads[i].error = 0;
+          reads[i].remainingChunks = (u32)((reads[i].size + ASYNC_IO_CHUNK_SIZE - 1) / ASYNC_IO_CHUNK_SIZE);
+        }
+      }
+      endTempMemory(tempMemory);
+      readFilesThreadPool(io, reads, count, onComplete, userData);
+      return;
+    }
+    queuedCount -= (u32)submitted;
+
+    u32 head = std::atomic_ref<u32>(*ring->cqHead).load(std::memory_order_relaxed);
+    u32 tail = std::atomic_ref<u32>(*ring->cqTail).load(std::memory_order_acquire);
+    for(; head != tail; ++head) {
+      const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+      u32 slot = (u32)cqe.user_data;
+      Chunk& chunk = chunks[slot];
+      AsyncFileRead& read = reads[chunk.readIndex];
+      read.readCallCount++;
+      if(cqe.res > 0 && (u32)cqe.res < chunk.size) { // short read, the rest goes back in the same slot
+        chunk.offset += cqe.res;
+        chunk.dst += cqe.res;
+        chunk.size -= cqe.res;
+        queueIoUringRead(io, read.fd, chunk.dst, chunk.size, chunk.offset, slot);
+        queuedCount++;
+        continue;
+      }
+      if(cqe.res < 0) {
+        read.error = -cqe.res;
+      } else if(cqe.res == 0) {
+        read.error = EIO; // file shrank since it was sized
+      }
+      freeSlots[freeSlotCount++] = slot;
+      if(--read.remainingChunks == 0) {
+        closeFileForRead(read.fd);
+        read.fd = -1;
+        remainingFiles--;
+        if(onComplete != nullptr) { onComplete(&read, userData); }
+      }
+    }
+    std::atomic_ref<u32>(*ring->cqHead).store(head, std::memory_order_release);
+  }
+  endTempMemory(tempMemory);
+}
+#endif
+
+// Falls back to the thread pool when io_uring is unavailable or not allowed
+void initAsyncIo(AsyncIo* io, u32 queueDepth = ASYNC_IO_DEFAULT_QUEUE_DEPTH, u64 bufferSize = ASYNC_IO_DEFAULT_BUFFER_SIZE, bool allowIoUring = true) {
+  *io = {};
+  io->backend = AsyncIoBackend_ThreadPool;
+  io->queueDepth = queueDepth;
+  io->buffer = new u8[bufferSize];
+  io->bufferSize = bufferSize;
+#ifdef __linux__
+  io->ring.fd = -1;
+  if(allowIoUring && initIoUring(&io->ring, queueDepth)) {
+    io->backend = AsyncIoBackend_IoUring;
+    iovec bufferVec{ io->buffer, bufferSize };
+    // fails when the buffer is over RLIMIT_MEMLOCK, reads then go through the unregistered path
+    io->bufferRegistered = syscall(__NR_io_uring_register, io->ring.fd, IORING_REGISTER_BUFFERS, &bufferVec, 1) == 0;
+  }
+#endif
+}
+
+void deinitAsyncIo(AsyncIo* io) {
+#ifdef __linux__
+  if(io->ring.fd >= 0) {
+    deinitIoUring(&io->ring); // also unregisters the buffer
+  }
+#endif
+  delete[] io->buffer;
+  *io = {};
+}
+
+// Reads every file completely, returning once they are all done. Bytes come from the shared read buffer while it has
+// room and are valid until releaseAsyncReads(). Files that fail to open or read are completed with an error.
+void readFilesAsync(AsyncIo* io, AsyncFileRead* reads, u32 count, AsyncReadCallback onComplete = nullptr, void* userData = nullptr) {
+  u64 startCounter = getPerformanceCounter();
+  for(u32 i = 0; i < count; ++i) {
+    AsyncFileRead& read = reads[i];
+    read.bytes = nullptr;
+    read.error = 0;
+    read.readCallCount = 0;
+    read.ownsBytes = false;
+    read.fd = openFileForRead(read.path, &read.size);
+    read.remainingChunks = (u32)((read.size + ASYNC_IO_CHUNK_SIZE - 1) / ASYNC_IO_CHUNK_SIZE);
+    if(read.fd < 0) {
+      read.error = errno;
+      read.remainingChunks = 0;
+    } else {
+      u64 alignedUsed = (io->bufferUsed + ASYNC_IO_ALIGNMENT - 1) & ~(u64)(ASYNC_IO_ALIGNMENT - 1);
+      if(alignedUsed + read.size <= io->bufferSize) {
+        read.bytes = io->buffer + alignedUsed;
+        io->bufferUsed = alignedUsed + read.size;
+      } else {
+        read.bytes = new u8[read.size];
+        read.ownsBytes = true;
+      }
+    }
+    // empty and unopened files are already complete
+    if(read.remainingChunks == 0) {
+      if(read.fd >= 0) {
+        closeFileForRead(read.fd);
+        read.fd = -1;
+      }
+      if(onComplete != nullptr) { onComplete(&read, userData); }
+    }
+    io->stats.byteCount += read.size;
+  }
+
+#ifdef __linux__
+  if(io->backend == AsyncIoBackend_IoUring) {
+    readFilesIoUring(io, reads, count, onComplete, userData);
+  } else
+#endif
+  {
+    readFilesThreadPool(io, reads, count, onComplete, userData);
+  }
+  io->stats.fileCount += count;
+  io->stats.seconds += (f64)(getPerformanceCounter() - startCounter) / (f64)getPerformanceCounterFrequencyPerSecond();
+}
+
+// Every read from previous batches must be released together, the read buffer starts over afterwards
+void releaseAsyncReads(AsyncIo* io, AsyncFileRead* reads, u32 count) {
+  for(u32 i = 0; i < count; ++i) {
+    if(reads[i].ownsBytes) {
+      delete[] reads[i].bytes;
+    }
+    reads[i].bytes = nullptr;
+    reads[i].ownsBytes = false;
+  }
+  io->bufferUsed = 0;
+}
+
+void printAsyncIoStats(const AsyncIo& io, const char* label) {
+  const AsyncIoStats& stats = io.stats;
+  printf("%s [%s%s]: %llu files, %.1f KB in %.3f ms (%.1f MB/s) | chunks: %llu | submits: %llu | queue depth avg %.1f max %u\n",
+         label, io.backend == AsyncIoBackend_IoUring ? "io_uring" : "thread pool", io.bufferRegistered ? ", registered buffer" : "",
+         (unsigned long long)stats.fileCount, (f64)stats.byteCount / Kilobytes(1), stats.seconds * 1000.0,
+         stats.seconds > 0.0 ? (f64)stats.byteCount / Megabytes(1) / stats.seconds : 0.0,
+         (unsigned long long)stats.chunkCount, (unsigned long long)stats.submitCallCount,
+         stats.queueDepthSampleCount > 0 ? (f64)stats.queueDepthSum / (f64)stats.queueDepthSampleCount : 0.0, stats.maxQueueDepth);
+}
+
+// Drops the file's pages from the page cache so the next read has to go to the disk. Linux only.
+internal void evictFileFromPageCache(const char* path) {
+#ifdef __linux__
+  s32 fd = open(path, O_RDONLY);
+  if(fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+#endif
+}
+
+// Bulk loads every file under data/ cold and warm, synchronously and with each backend. Results are printed to stdout.
+void benchmarkAsyncIo() {
+  std::vector<std::string> pathStrings;
+  for(const auto& dirEntry : std::filesystem::recursive_directory_iterator("data")) {
+    if(dirEntry.is_regular_file()) { pathStrings.push_back(dirEntry.path().generic_string()); }
+  }
+  u32 fileCount = (u32)pathStrings.size();
+  if(fileCount == 0) {
+    printf("Async I/O benchmark found no files under data/\n");
+    return;
+  }
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  AsyncFileRead* reads = pushArrayZero(tempMemory.arena, fileCount, AsyncFileRead);
+  for(u32 i = 0; i < fileCount; ++i) { reads[i].path = pathStrings[i].c_str(); }
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+#ifdef __linux__
+  const char* coldLabels[] = { "cold", "warm" };
+#else
+  const char* coldLabels[] = { "warm", "warm" }; // no portable way to evict files
+#endif
+
+  printf("Async I/O: %u files under data/\n", fileCount);
+  for(u32 pass = 0; pass < 2; ++pass) {
+    if(pass == 0) { for(u32 i = 0; i < fileCount; ++i) { evictFileFromPageCache(reads[i].path); } }
+    u64 byteCount = 0;
+    u64 startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < fileCount; ++i) {
+      FILE_HANDLE file;
+      size_t size;
+      if(openFile(reads[i].path, &file, &size)) {
+        byteCount += size;
+        closeFile(file);
+      }
+    }
+    f64 seconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+    printf("  %s [synchronous]: %.1f KB in %.3f ms (%.1f MB/s)\n", coldLabels[pass], (f64)byteCount / Kilobytes(1), seconds * 1000.0,
+           (f64)byteCount / Megabytes(1) / seconds);
+  }
+
+  for(u32 backend = 0; backend < 2; ++backend) {
+    AsyncIo io;
+    initAsyncIo(&io, ASYNC_IO_DEFAULT_QUEUE_DEPTH, ASYNC_IO_DEFAULT_BUFFER_SIZE, backend == AsyncIoBackend_IoUring);
+    if(io.backend != (AsyncIoBackend)backend) {
+      printf("  io_uring is not available\n");
+    } else {
+      for(u32 pass = 0; pass < 2; ++pass) {
+        if(pass == 0) { for(u32 i = 0; i < fileCount; ++i) { evictFileFromPageCache(reads[i].path); } }
+        io.stats = {};
+        readFilesAsync(&io, reads, fileCount);
+        releaseAsyncReads(&io, reads, fileCount);
+        char label[16];
+        snprintf(label, sizeof(label), "  %s", coldLabels[pass]);
+        printAsyncIoStats(io, label);
+      }
+    }
+    deinitAsyncIo(&io);
+  }
+  endTempMemory(tempMemory);
+}
\ No newline at end of file
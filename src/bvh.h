@@ -0,0 +1,557 @@
+#pragma once
+
+// Bounding volume hierarchy over scene object boxes
+// - 4-wide nodes, each exactly one 64 byte cache line, stored in a linear array in depth-first order
+//   (a child node always has a greater index than its parent)
+// - child bounds are quantized to 8 bits relative to the parent's bounds, conservatively rounded outwards
+// - every child slot either references another node or a single object
+// - built top-down with binned SAH, each node splits its objects twice to get up to 4 children. Nodes deeper than
+//   BVH_MAX_SAH_DEPTH split at the median instead, which bounds the depth and so the traversal stack.
+// - moving objects only requires a refit, adding/removing objects requires a rebuild
+
+#define BVH_WIDTH 4
+#define BVH_EMPTY_CHILD U32_MAX
+#define BVH_OBJECT_CHILD_FLAG (1u << 31)
+#define BVH_SAH_BIN_COUNT 12
+#define BVH_MAX_SAH_DEPTH 48
+#define BVH_MAX_MEDIAN_DEPTH 32 // median splits at least halve the largest child, objectCapacity < 2^31
+#define BVH_MAX_TRAVERSAL_STACK 256
+// traversal pops one node and pushes at most BVH_WIDTH children per level
+static_assert((BVH_MAX_SAH_DEPTH + BVH_MAX_MEDIAN_DEPTH) * (BVH_WIDTH - 1) + 1 <= BVH_MAX_TRAVERSAL_STACK,
+              "BVH traversal stack is too small for the deepest tree the build can produce");
+
+struct BVHNode {
+  glm::vec3 origin;
+  glm::vec3 scale; // size of one quantization step per axis
+  u8 childMinX[BVH_WIDTH];
+  u8 childMinY[BVH_WIDTH];
+  u8 childMinZ[BVH_WIDTH];
+  u8 childMaxX[BVH_WIDTH];
+  u8 childMaxY[BVH_WIDTH];
+  u8 childMaxZ[BVH_WIDTH];
+  u32 children[BVH_WIDTH]; // node index, object index | BVH_OBJECT_CHILD_FLAG, or BVH_EMPTY_CHILD
+};
+static_assert(sizeof(BVHNode) == 64, "BVHNode is expected to fill exactly one cache line");
+
+struct BVH {
+  BVHNode* nodes;
+  u32 nodeCount;
+  u32 nodeCapacity;
+
+  Box* objectBoxes;
+  u32 objectCount;
+  u32 objectCapacity;
+
+  // build/refit scratch
+  u32* objectIndices;
+  Box* nodeBounds;
+};
+
+inline bool isBVHObjectChild(u32 child) { return child != BVH_EMPTY_CHILD && (child & BVH_OBJECT_CHILD_FLAG); }
+inline u32 bvhChildObject(u32 child) { return child & ~BVH_OBJECT_CHILD_FLAG; }
+
+void initBVH(BVH* bvh, u32 objectCapacity) {
+  *bvh = {};
+  assert(objectCapacity < BVH_OBJECT_CHILD_FLAG);
+  bvh->objectCapacity = objectCapacity;
+  // every internal node has at least two children, so there are at most objectCount - 1 nodes (or 1 for a single object)
+  bvh->nodeCapacity = Max(objectCapacity, 1u);
+  bvh->nodes = new BVHNode[bvh->nodeCapacity];
+  bvh->nodeBounds = new Box[bvh->nodeCapacity];
+  bvh->objectBoxes = new Box[objectCapacity];
+  bvh->objectIndices = new u32[objectCapacity];
+}
+
+void deinitBVH(BVH* bvh) {
+  delete[] bvh->nodes;
+  delete[] bvh->nodeBounds;
+  delete[] bvh->objectBoxes;
+  delete[] bvh->objectIndices;
+  *bvh = {}; // clear to zero
+}
+
+// The tree must be rebuilt with buildBVH() before added objects are visible to queries
+u32 addBVHObject(BVH* bvh, const Box& worldBox) {
+  assert(bvh->objectCount < bvh->objectCapacity && "ERROR: BVH is full!");
+  u32 object = bvh->objectCount++;
+  bvh->objectBoxes[object] = worldBox;
+  return object;
+}
+
+// The tree must be refit with refitBVH() before the new box is visible to queries
+inline void setBVHObjectBox(BVH* bvh, u32 object, const Box& worldBox) {
+  assert(object < bvh->objectCount);
+  bvh->objectBoxes[object] = worldBox;
+}
+
+inline void clearBVH(BVH* bvh) {
+  bvh->objectCount = 0;
+  bvh->nodeCount = 0;
+}
+
+internal void quantizeBVHChildBounds(BVHNode* node, u32 childSlot, const Box& childBounds) {
+  glm::vec3 childMax = boxMax(childBounds);
+  u8* mins[3] = { node->childMinX, node->childMinY, node->childMinZ };
+  u8* maxs[3] = { node->childMaxX, node->childMaxY, node->childMaxZ };
+  for(u32 axis = 0; axis < 3; ++axis) {
+    f32 origin = node->origin[axis];
+    f32 scale = node->scale[axis];
+    s32 qMin = (s32)floorf((childBounds.min[axis] - origin) / scale);
+    s32 qMax = (s32)ceilf((childMax[axis] - origin) / scale);
+    qMin = Clamp(qMin, 0, 255);
+    qMax = Clamp(qMax, 0, 255);
+    // guard against float rounding making the quantized box smaller than the real one
+    while(qMin > 0 && origin + (qMin * scale) > childBounds.min[axis]) { qMin--; }
+    while(qMax < 255 && origin + (qMax * scale) < childMax[axis]) { qMax++; }
+    mins[axis][childSlot] = (u8)qMin;
+    maxs[axis][childSlot] = (u8)qMax;
+  }
+}
+
+internal void setBVHNodeBounds(BVH* bvh, u32 nodeIndex, const Box* childBounds) {
+  BVHNode* node = bvh->nodes + nodeIndex;
+  Box bounds{};
+  bool first = true;
+  for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+    if(node->children[slot] == BVH_EMPTY_CHILD) { continue; }
+    bounds = first ? childBounds[slot] : mergeBoxes(bounds, childBounds[slot]);
+    first = false;
+  }
+  bvh->nodeBounds[nodeIndex] = bounds;
+
+  node->origin = bounds.min;
+  for(u32 axis = 0; axis < 3; ++axis) {
+    node->scale[axis] = Max(bounds.diagonal[axis] / 255.0f, FLT_MIN);
+  }
+  for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+    if(node->children[slot] == BVH_EMPTY_CHILD) {
+      // inverted bounds so that the empty slot never passes a test
+      node->childMinX[slot] = node->childMinY[slot] = node->childMinZ[slot] = 255;
+      node->childMaxX[slot] = node->childMaxY[slot] = node->childMaxZ[slot] = 0;
+    } else {
+      quantizeBVHChildBounds(node, slot, childBounds[slot]);
+    }
+  }
+}
+
+internal inline void bvhChildBounds(const BVHNode& node, u32 slot, glm::vec3* outMin, glm::vec3* outMax) {
+  *outMin = glm::vec3(node.origin.x + node.childMinX[slot] * node.scale.x,
+                      node.origin.y + node.childMinY[slot] * node.scale.y,
+                      node.origin.z + node.childMinZ[slot] * node.scale.z);
+  *outMax = glm::vec3(node.origin.x + node.childMaxX[slot] * node.scale.x,
+                      node.origin.y + node.childMaxY[slot] * node.scale.y,
+                      node.origin.z + node.childMaxZ[slot] * node.scale.z);
+}
+
+struct BVHRange {
+  u32 first;
+  u32 count;
+  Box bounds;
+};
+
+internal Box bvhRangeBounds(const BVH* bvh, u32 first, u32 count) {
+  Box bounds = bvh->objectBoxes[bvh->objectIndices[first]];
+  for(u32 i = first + 1; i < first + count; ++i) {
+    bounds = mergeBoxes(bounds, bvh->objectBoxes[bvh->objectIndices[i]]);
+  }
+  return bounds;
+}
+
+// Binned SAH split of a range of objects into two non-empty ranges, or a median split when sah is false
+internal void splitBVHRange(BVH* bvh, const BVHRange& range, bool sah, BVHRange* outLeft, BVHRange* outRight) {
+  assert(range.count > 1);
+  u32* indices = bvh->objectIndices + range.first;
+
+  glm::vec3 centroidMin = boxCenter(bvh->objectBoxes[indices[0]]);
+  glm::vec3 centroidMax = centroidMin;
+  for(u32 i = 1; i < range.count; ++i) {
+    glm::vec3 centroid = boxCenter(bvh->objectBoxes[indices[i]]);
+    centroidMin = glm::min(centroidMin, centroid);
+    centroidMax = glm::max(centroidMax, centroid);
+  }
+
+  f32 bestCost = FLT_MAX;
+  s32 bestAxis = -1;
+  u32 bestBin = 0;
+  for(u32 axis = 0; axis < 3 && sah; ++axis) {
+    f32 axisExtent = centroidMax[axis] - centroidMin[axis];
+    if(axisExtent <= 0.0f) { continue; }
+
+    u32 binCounts[BVH_SAH_BIN_COUNT] = {};
+    Box binBounds[BVH_SAH_BIN_COUNT];
+    f32 binScale = BVH_SAH_BIN_COUNT / axisExtent;
+    for(u32 i = 0; i < range.count; ++i) {
+      const Box& box = bvh->objectBoxes[indices[i]];
+      u32 bin = Min((u32)((boxCenter(box)[axis] - centroidMin[axis]) * binScale), (u32)BVH_SAH_BIN_COUNT - 1);
+      binBounds[bin] = binCounts[bin] == 0 ? box : mergeBoxes(binBounds[bin], box);
+      binCounts[bin]++;
+    }
+
+    // sweep from the right to get the cost of everything right of each split plane
+    f32 rightAreas[BVH_SAH_BIN_COUNT];
+    u32 rightCounts[BVH_SAH_BIN_COUNT];
+    Box accumulated{};
+    u32 accumulatedCount = 0;
+    for(s32 bin = BVH_SAH_BIN_COUNT - 1; bin > 0; --bin) {
+      if(binCounts[bin] > 0) {
+        accumulated = accumulatedCount == 0 ? binBounds[bin] : mergeBoxes(accumulated, binBounds[bin]);
+        accumulatedCount += binCounts[bin];
+      }
+      rightAreas[bin] = accumulatedCount > 0 ? surfaceArea(accumulated) : 0.0f;
+      rightCounts[bin] = accumulatedCount;
+    }
+
+    accumulatedCount = 0;
+    for(u32 bin = 0; bin < BVH_SAH_BIN_COUNT - 1; ++bin) {
+      if(binCounts[bin] > 0) {
+        accumulated = accumulatedCount == 0 ? binBounds[bin] : mergeBoxes(accumulated, binBounds[bin]);
+        accumulatedCount += binCounts[bin];
+      }
+      u32 rightCount = rightCounts[bin + 1];
+      if(accumulatedCount == 0 || rightCount == 0) { continue; }
+      f32 cost = surfaceArea(accumulated) * accumulatedCount + rightAreas[bin + 1] * rightCount;
+      if(cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestBin = bin;
+      }
+    }
+  }
+
+  u32 leftCount;
+  if(bestAxis >= 0) {
+    f32 binScale = BVH_SAH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    u32* middle = std::partition(indices, indices + range.count, [&](u32 object) {
+      u32 bin = Min((u32)((boxCenter(bvh->objectBoxes[object])[bestAxis] - centroidMin[bestAxis]) * binScale), (u32)BVH_SAH_BIN_COUNT - 1);
+      return bin <= bestBin;
+    });
+    leftCount = (u32)(middle - indices);
+  } else {
+    // median along the widest centroid axis, also taken when all centroids are identical
+    glm::vec3 centroidExtent = centroidMax - centroidMin;
+    u32 axis = (centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z) ? 0 : (centroidExtent.y >= centroidExtent.z ? 1 : 2);
+    leftCount = range.count / 2;
+    std::nth_element(indices, indices + leftCount, indices + range.count, [&](u32 a, u32 b) {
+      return boxCenter(bvh->objectBoxes[a])[axis] < boxCenter(bvh->objectBoxes[b])[axis];
+    });
+  }
+
+  outLeft->first = range.first;
+  outLeft->count = leftCount;
+  outLeft->bounds = bvhRangeBounds(bvh, outLeft->first, outLeft->count);
+  outRight->first = range.first + leftCount;
+  outRight->count = range.count - leftCount;
+  outRight->bounds = bvhRangeBounds(bvh, outRight->first, outRight->count);
+}
+
+internal u32 buildBVHNode(BVH* bvh, const BVHRange& range, u32 depth) {
+  // split the range up to twice, always splitting the largest remaining range
+  BVHRange partitions[BVH_WIDTH];
+  partitions[0] = range;
+  u32 partitionCount = 1;
+  while(partitionCount < BVH_WIDTH) {
+    s32 largest = -1;
+    for(u32 i = 0; i < partitionCount; ++i) {
+      if(partitions[i].count > 1 && (largest < 0 || partitions[i].count > partitions[largest].count)) {
+        largest = i;
+      }
+    }
+    if(largest < 0) { break; }
+    BVHRange toSplit = partitions[largest];
+    splitBVHRange(bvh, toSplit, depth < BVH_MAX_SAH_DEPTH, &partitions[largest], &partitions[partitionCount]);
+    partitionCount++;
+  }
+
+  assert(bvh->nodeCount < bvh->nodeCapacity);
+  u32 nodeIndex = bvh->nodeCount++;
+  Box childBounds[BVH_WIDTH];
+  for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+    u32 child = BVH_EMPTY_CHILD;
+    if(slot < partitionCount) {
+      const BVHRange& partition = partitions[slot];
+      child = partition.count == 1 ?
+              (bvh->objectIndices[partition.first] | BVH_OBJECT_CHILD_FLAG) :
+              buildBVHNode(bvh, partition, depth + 1);
+      childBounds[slot] = partition.bounds;
+    }
+    bvh->nodes[nodeIndex].children[slot] = child;
+  }
+  setBVHNodeBounds(bvh, nodeIndex, childBounds);
+  return nodeIndex;
+}
+
+void buildBVH(BVH* bvh) {
+  bvh->nodeCount = 0;
+  if(bvh->objectCount == 0) { return; }
+  for(u32 i = 0; i < bvh->objectCount; ++i) {
+    bvh->objectIndices[i] = i;
+  }
+  BVHRange root;
+  root.first = 0;
+  root.count = bvh->objectCount;
+  root.bounds = bvhRangeBounds(bvh, 0, bvh->objectCount);
+  buildBVHNode(bvh, root, 0);
+}
+
+// Updates all node bounds to the current object boxes without changing the tree's topology.
+// Quality degrades as objects move far from where they were when built, rebuild when that matters.
+void refitBVH(BVH* bvh) {
+  // children always come after their parents, so walking backwards visits children first
+  for(s32 nodeIndex = (s32)bvh->nodeCount - 1; nodeIndex >= 0; --nodeIndex) {
+    const BVHNode& node = bvh->nodes[nodeIndex];
+    Box childBounds[BVH_WIDTH];
+    for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+      u32 child = node.children[slot];
+      if(child == BVH_EMPTY_CHILD) { continue; }
+      childBounds[slot] = isBVHObjectChild(child) ? bvh->objectBoxes[bvhChildObject(child)] : bvh->nodeBounds[child];
+    }
+    setBVHNodeBounds(bvh, nodeIndex, childBounds);
+  }
+}
+
+enum FrustumTest {
+  FrustumTest_Outside,
+  FrustumTest_Intersects,
+  FrustumTest_Inside,
+};
+
+internal FrustumTest testBoxAgainstFrustum(const Frustum& frustum, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+  glm::vec3 center = (boxMin + boxMax) * 0.5f;
+  glm::vec3 extent = (boxMax - boxMin) * 0.5f;
+  FrustumTest result = FrustumTest_Inside;
+  for(u32 i = 0; i < 6; ++i) {
+    const glm::vec4& plane = frustum.planes[i];
+    f32 dist = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+    f32 radius = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+    if(dist + radius < 0.0f) { return FrustumTest_Outside; }
+    if(dist - radius < 0.0f) { result = FrustumTest_Intersects; }
+  }
+  return result;
+}
+
+// Appends every object under the node without further testing
+internal u32 gatherBVHObjects(const BVH& bvh, u32 nodeIndex, u32* outObjects, u32 outCount, u32 maxCount) {
+  const BVHNode& node = bvh.nodes[nodeIndex];
+  for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+    u32 child = node.children[slot];
+    if(child == BVH_EMPTY_CHILD) { continue; }
+    if(isBVHObjectChild(child)) {
+      if(outCount < maxCount) { outObjects[outCount++] = bvhChildObject(child); }
+    } else {
+      outCount = gatherBVHObjects(bvh, child, outObjects, outCount, maxCount);
+    }
+  }
+  return outCount;
+}
+
+// Returns the number of objects written to outObjects. Objects are reported by their quantized bounds,
+// which may be marginally larger than their actual bounds.
+u32 queryBVHFrustum(const BVH& bvh, const Frustum& frustum, u32* outObjects, u32 maxCount) {
+  if(bvh.nodeCount == 0) { return 0; }
+  u32 stack[BVH_MAX_TRAVERSAL_STACK];
+  u32 stackCount = 0;
+  stack[stackCount++] = 0;
+  u32 outCount = 0;
+  while(stackCount > 0) {
+    const BVHNode& node = bvh.nodes[stack[--stackCount]];
+    for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+      u32 child = node.children[slot];
+      if(child == BVH_EMPTY_CHILD) { continue; }
+      glm::vec3 childMin, childMax;
+      bvhChildBounds(node, slot, &childMin, &childMax);
+      FrustumTest test = testBoxAgainstFrustum(frustum, childMin, childMax);
+      if(test == FrustumTest_Outside) { continue; }
+      if(isBVHObjectChild(child)) {
+        if(outCount < maxCount) { outObjects[outCount++] = bvhChildObject(child); }
+      } else if(test == FrustumTest_Inside) {
+        outCount = gatherBVHObjects(bvh, child, outObjects, outCount, maxCount);
+      } else {
+        assert(stackCount < BVH_MAX_TRAVERSAL_STACK);
+        stack[stackCount++] = child;
+      }
+    }
+  }
+  return outCount;
+}
+
+u32 queryBVHOverlap(const BVH& bvh, const Box& queryBox, u32* outObjects, u32 maxCount) {
+  if(bvh.nodeCount == 0) { return 0; }
+  glm::vec3 queryMax = boxMax(queryBox);
+  u32 stack[BVH_MAX_TRAVERSAL_STACK];
+  u32 stackCount = 0;
+  stack[stackCount++] = 0;
+  u32 outCount = 0;
+  while(stackCount > 0) {
+    const BVHNode& node = bvh.nodes[stack[--stackCount]];
+    for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+      u32 child = node.children[slot];
+      if(child == BVH_EMPTY_CHILD) { continue; }
+      glm::vec3 childMin, childMax;
+      bvhChildBounds(node, slot, &childMin, &childMax);
+      if(childMin.x > queryMax.x || childMax.x < queryBox.min.x ||
+         childMin.y > queryMax.y || childMax.y < queryBox.min.y ||
+         childMin.z > queryMax.z || childMax.z < queryBox.min.z) {
+        continue;
+      }
+      if(isBVHObjectChild(child)) {
+        // test exact bounds at the leaves
+        if(boxesOverlap(bvh.objectBoxes[bvhChildObject(child)], queryBox) && outCount < maxCount) {
+          outObjects[outCount++] = bvhChildObject(child);
+        }
+      } else {
+        assert(stackCount < BVH_MAX_TRAVERSAL_STACK);
+        stack[stackCount++] = child;
+      }
+    }
+  }
+  return outCount;
+}
+
+// Finds the object whose bounding box the ray enters first within maxT
+bool raycastBVH(const BVH& bvh, const Ray& ray, u32* outObject, f32* outT, f32 maxT = FLT_MAX) {
+  if(bvh.nodeCount == 0) { return false; }
+  glm::vec3 invDirection = glm::vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+  u32 stack[BVH_MAX_TRAVERSAL_STACK];
+  u32 stackCount = 0;
+  stack[stackCount++] = 0;
+  bool hit = false;
+  f32 closestT = maxT;
+  while(stackCount > 0) {
+    const BVHNode& node = bvh.nodes[stack[--stackCount]];
+
+    // push nearer children last so they are visited first
+    u32 hitChildren[BVH_WIDTH];
+    f32 hitTs[BVH_WIDTH];
+    u32 hitCount = 0;
+    for(u32 slot = 0; slot < BVH_WIDTH; ++slot) {
+      u32 child = node.children[slot];
+      if(child == BVH_EMPTY_CHILD) { continue; }
+      glm::vec3 childMin, childMax;
+      f32 t;
+      if(isBVHObjectChild(child)) {
+        const Box& objectBox = bvh.objectBoxes[bvhChildObject(child)];
+        if(rayIntersectsBox(ray.origin, invDirection, objectBox.min, boxMax(objectBox), closestT, &t)) {
+          hit = true;
+          closestT = t;
+          *outObject = bvhChildObject(child);
+        }
+        continue;
+      }
+      bvhChildBounds(node, slot, &childMin, &childMax);
+      if(rayIntersectsBox(ray.origin, invDirection, childMin, childMax, closestT, &t)) {
+        u32 insert = hitCount++;
+        while(insert > 0 && hitTs[insert - 1] < t) {
+          hitTs[insert] = hitTs[insert - 1];
+          hitChildren[insert] = hitChildren[insert - 1];
+          insert--;
+        }
+        hitTs[insert] = t;
+        hitChildren[insert] = child;
+      }
+    }
+    for(u32 i = 0; i < hitCount; ++i) {
+      assert(stackCount < BVH_MAX_TRAVERSAL_STACK);
+      stack[stackCount++] = hitChildren[i];
+    }
+  }
+  if(hit) { *outT = closestT; }
+  return hit;
+}
+
+/* BENCHMARK */
+internal f32 benchmarkRandomFloat(u32* state) {
+  // xorshift32
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return (*state & 0xFFFFFF) / (f32)0xFFFFFF;
+}
+
+// Compares BVH queries against brute force over the same boxes, results are printed to stdout
+void benchmarkBVH() {
+  const u32 objectCounts[] = { 1000, 10000, 100000 };
+  const u32 queryCount = 100;
+  const f32 worldSize = 200.0f;
+  const f64 secondsPerCounter = 1.0 / getPerformanceCounterFrequencyPerSecond();
+  glm::mat4 projMat = perspective(fieldOfView(13.5f, 25.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+
+  for(u32 countIndex = 0; countIndex < ArrayCount(objectCounts); ++countIndex) {
+    u32 objectCount = objectCounts[countIndex];
+    u32 randomState = 0x9E3779B9;
+    BVH bvh;
+    initBVH(&bvh, objectCount);
+    for(u32 i = 0; i < objectCount; ++i) {
+      glm::vec3 min = glm::vec3(benchmarkRandomFloat(&randomState), benchmarkRandomFloat(&randomState), benchmarkRandomFloat(&randomState)) * worldSize - (worldSize * 0.5f);
+      addBVHObject(&bvh, boxFromMinMax(min, min + glm::vec3(0.5f + benchmarkRandomFloat(&randomState))));
+    }
+    u32* results = new u32[objectCount];
+
+    u64 startCounter = getPerformanceCounter();
+    buildBVH(&bvh);
+    f64 buildSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+    startCounter = getPerformanceCounter();
+    refitBVH(&bvh);
+    f64 refitSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+    Frustum frustums[queryCount];
+    Ray rays[queryCount];
+    Box boxes[queryCount];
+    for(u32 i = 0; i < queryCount; ++i) {
+      glm::vec3 origin = glm::vec3(benchmarkRandomFloat(&randomState), benchmarkRandomFloat(&randomState), benchmarkRandomFloat(&randomState)) * worldSize - (worldSize * 0.5f);
+      f32 yaw = benchmarkRandomFloat(&randomState) * Tau32;
+      glm::vec3 focus = origin + glm::vec3(cosf(yaw), 0.2f, sinf(yaw));
+      Camera camera;
+      lookAt(origin, focus, &camera);
+      frustums[i] = frustumFromProjView(projMat * updateCamera(&camera, glm::vec3(0.0f), 0.0f, 0.0f));
+      rays[i] = screenPointToRay(camera, projMat, glm::vec2(0.0f));
+      boxes[i] = boxFromMinMax(origin, origin + glm::vec3(10.0f));
+    }
+
+    u64 checksum = 0;
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) { checksum += queryBVHFrustum(bvh, frustums[i], results, objectCount); }
+    f64 bvhFrustumSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) {
+      for(u32 object = 0; object < objectCount; ++object) { checksum += boxInFrustum(frustums[i], bvh.objectBoxes[object]); }
+    }
+    f64 bruteFrustumSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) { checksum += queryBVHOverlap(bvh, boxes[i], results, objectCount); }
+    f64 bvhOverlapSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) {
+      for(u32 object = 0; object < objectCount; ++object) { checksum += boxesOverlap(boxes[i], bvh.objectBoxes[object]); }
+    }
+    f64 bruteOverlapSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) {
+      u32 object; f32 t;
+      checksum += raycastBVH(bvh, rays[i], &object, &t);
+    }
+    f64 bvhRaySeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+    startCounter = getPerformanceCounter();
+    for(u32 i = 0; i < queryCount; ++i) {
+      glm::vec3 invDirection = glm::vec3(1.0f / rays[i].direction.x, 1.0f / rays[i].direction.y, 1.0f / rays[i].direction.z);
+      f32 closestT = FLT_MAX, t;
+      for(u32 object = 0; object < objectCount; ++object) {
+        const Box& box = bvh.objectBoxes[object];
+        if(rayIntersectsBox(rays[i].origin, invDirection, box.min, boxMax(box), closestT, &t)) { closestT = t; }
+      }
+      checksum += closestT != FLT_MAX;
+    }
+    f64 bruteRaySeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+    const f64 msPerQuery = 1000.0 / queryCount;
+    printf("BVH %6u objects | build %7.3f ms | refit %6.3f ms | nodes %u\n", objectCount, buildSeconds * 1000.0, refitSeconds * 1000.0, bvh.nodeCount);
+    printf("    frustum: bvh %8.4f ms  brute %8.4f ms (per query)\n", bvhFrustumSeconds * msPerQuery, bruteFrustumSeconds * msPerQuery);
+    printf("    overlap: bvh %8.4f ms  brute %8.4f ms (per query)\n", bvhOverlapSeconds * msPerQuery, bruteOverlapSeconds * msPerQuery);
+    printf("    ray:     bvh %8.4f ms  brute %8.4f ms (per query)\n", bvhRaySeconds * msPerQuery, bruteRaySeconds * msPerQuery);
+    printf("    checksum: %llu\n", (unsigned long long)checksum);
+
+    delete[] results;
+    deinitBVH(&bvh);
+  }
+}
\ No newline at end of file
@@ -29,21 +29,20 @@ glm::mat4 updateCamera(Camera* camera, glm::vec3 posOffset, f32 pitchOffset, f32
   camera->right = normalize(cross(worldUp, camera->forward));
   camera->up = cross(camera->forward, camera->right);
 
-  glm::mat4 translation{
-          1.0f,             0.0f,       0.0f,       0.0f,
-          0.0f,             1.0f,       0.0f,       0.0f,
-          0.0f,             0.0f,       1.0f,       0.0f,
-          -camera->origin.x, -camera->origin.y, -camera->origin.z, 1.0f
-  };
-
-  glm::mat4 measure{
-          camera->right.x, camera->up.x, camera->forward.x, 0.0f,
-          camera->right.y, camera->up.y, camera->forward.y, 0.0f,
-          camera->right.z, camera->up.z, camera->forward.z, 0.0f,
-          0.0f,        0.0f,              0.0f, 1.0f
-  };
+  // same as the camera's rotation times a translation by -origin, without the matrix product
+  Mat4 view = viewMat4(toVec4(camera->origin, 1.0f), toVec4(camera->right, 0.0f), toVec4(camera->up, 0.0f), toVec4(camera->forward, 0.0f));
+  return toGlm(view);
+}
 
-  return measure * translation;
+// ndc ranges from -1 to 1 with {-1,-1} being the bottom left of the screen
+// projMat is expected to come from perspective()
+Ray screenPointToRay(const Camera& camera, const glm::mat4& projMat, glm::vec2 ndc) {
+  Ray ray;
+  ray.origin = camera.origin;
+  ray.direction = normalize(camera.forward +
+                            (camera.right * (ndc.x / projMat[0][0])) +
+                            (camera.up * (ndc.y / projMat[1][1])));
+  return ray;
 }
 
 // real-time rendering 4.7.2
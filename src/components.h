@@ -0,0 +1,39 @@
+#pragma once
+
+// Components are plain data, moved between archetype chunks with memcpy.
+// Every component listed in Component.incl gets a ComponentType and can be used in entity queries.
+
+// Node in the scene's TransformHierarchy
+struct TransformComponent {
+  u32 node;
+};
+
+// Rotates the entity's transform node about an axis, on top of its initial rotation
+struct SpinComponent {
+  glm::quat baseRotation;
+  glm::vec3 axis; // normalized
+  f32 radiansPerSecond;
+};
+
+// Mesh in a StaticGeometryPool drawn with the entity's transform
+struct StaticMeshComponent {
+  StaticMeshRange lods[LOD_MAX_COUNT];
+  u32 lodCount;
+  u32 currentLOD;
+  GLuint albedoTextureId;
+  Box meshBox; // model space
+  u32 bvhObject; // U32_MAX when the mesh is not pickable
+};
+
+// Screen space sprite, in emulated sprite resolution units
+struct SpriteComponent {
+  glm::vec2 position;
+  glm::vec2 velocity; // tiles per second
+};
+
+// Plays the loaded sound effect when triggered, at most once per cooldown
+struct AudioEmitterComponent {
+  f32 cooldownSeconds;
+  f32 remainingCooldownSeconds;
+  b32 triggered;
+};
\ No newline at end of file
@@ -0,0 +1,234 @@
+#pragma once
+
+// Frustum culling of world space axis aligned boxes
+// Boxes are stored as center/extent in structure-of-arrays form so that a single SIMD register holds
+// the same component of CULL_SIMD_WIDTH boxes. Each plane test then checks all lanes at once.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CULL_SIMD_WIDTH 4
+#else
+#define CULL_SIMD_WIDTH 1
+#endif
+
+#define CULL_ALIGNMENT 32
+#define CULL_PARALLEL_MIN_BOX_COUNT 16384 // below this jobs cost more than they save
+#define CULL_PARALLEL_BATCH_SIZE 4096 // multiple of CULL_SIMD_WIDTH
+
+// planes point inwards, xyz = normal, w = distance
+struct Frustum {
+  glm::vec4 planes[6];
+};
+
+struct CullingBoxes {
+  f32* centerX;
+  f32* centerY;
+  f32* centerZ;
+  f32* extentX;
+  f32* extentY;
+  f32* extentZ;
+  u32 count;
+  u32 capacity; // always a multiple of CULL_SIMD_WIDTH
+  u8* memory;
+};
+
+struct CullStats {
+  u32 testedCount;
+  u32 culledCount;
+  f64 cullSeconds;
+};
+
+// source: "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix", Gribb & Hartmann
+// Expects OpenGL clip space (-w <= z <= w), as produced by perspective()
+Frustum frustumFromProjView(const glm::mat4& projView) {
+  glm::vec4 rows[4];
+  for(u32 row = 0; row < 4; ++row) {
+    rows[row] = glm::vec4(projView[0][row], projView[1][row], projView[2][row], projView[3][row]);
+  }
+
+  Frustum frustum;
+  frustum.planes[0] = rows[3] + rows[0]; // left
+  frustum.planes[1] = rows[3] - rows[0]; // right
+  frustum.planes[2] = rows[3] + rows[1]; // bottom
+  frustum.planes[3] = rows[3] - rows[1]; // top
+  frustum.planes[4] = rows[3] + rows[2]; // near
+  frustum.planes[5] = rows[3] - rows[2]; // far
+  for(u32 i = 0; i < 6; ++i) {
+    glm::vec4& plane = frustum.planes[i];
+    f32 invNormalLength = 1.0f / sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    plane = plane * invNormalLength;
+  }
+  return frustum;
+}
+
+void initCullingBoxes(CullingBoxes* boxes, u32 capacity) {
+  *boxes = {};
+  boxes->capacity = ((capacity + CULL_SIMD_WIDTH - 1) / CULL_SIMD_WIDTH) * CULL_SIMD_WIDTH;
+  memory_index arraySize = boxes->capacity * sizeof(f32);
+  boxes->memory = (u8*)operator new(arraySize * 6, std::align_val_t(CULL_ALIGNMENT));
+  memset(boxes->memory, 0, arraySize * 6);
+  f32** arrays[] = { &boxes->centerX, &boxes->centerY, &boxes->centerZ, &boxes->extentX, &boxes->extentY, &boxes->extentZ };
+  for(u32 i = 0; i < ArrayCount(arrays); ++i) {
+    *arrays[i] = (f32*)(boxes->memory + (i * arraySize));
+  }
+}
+
+void deinitCullingBoxes(CullingBoxes* boxes) {
+  operator delete(boxes->memory, std::align_val_t(CULL_ALIGNMENT));
+  *boxes = {}; // clear to zero
+}
+
+inline void clearCullingBoxes(CullingBoxes* boxes) { boxes->count = 0; }
+
+void setCullingBox(CullingBoxes* boxes, u32 index, const Box& worldBox) {
+  assert(index < boxes->count);
+  glm::vec3 extent = worldBox.diagonal * 0.5f;
+  glm::vec3 center = worldBox.min + extent;
+  boxes->centerX[index] = center.x;
+  boxes->centerY[index] = center.y;
+  boxes->centerZ[index] = center.z;
+  boxes->extentX[index] = extent.x;
+  boxes->extentY[index] = extent.y;
+  boxes->extentZ[index] = extent.z;
+}
+
+// returns the index of the box, which is also the index reported by cullBoxes()
+u32 addCullingBox(CullingBoxes* boxes, const Box& worldBox) {
+  assert(boxes->count < boxes->capacity && "ERROR: CullingBoxes is full!");
+  u32 index = boxes->count++;
+  setCullingBox(boxes, index, worldBox);
+  return index;
+}
+
+internal inline bool boxInFrustum(const Frustum& frustum, f32 cx, f32 cy, f32 cz, f32 ex, f32 ey, f32 ez) {
+  for(u32 i = 0; i < 6; ++i) {
+    const glm::vec4& plane = frustum.planes[i];
+    f32 dist = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+    f32 radius = fabsf(plane.x) * ex + fabsf(plane.y) * ey + fabsf(plane.z) * ez;
+    if(dist + radius < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+internal inline u32 appendVisibleLanes(u32 laneMask, u32 firstIndex, u32 endIndex, u32* outVisibleIndices, u32 visibleCount) {
+  for(u32 lane = 0; lane < CULL_SIMD_WIDTH; ++lane) {
+    u32 index = firstIndex + lane;
+    if((laneMask & (1 << lane)) && index < endIndex) {
+      outVisibleIndices[visibleCount++] = index;
+    }
+  }
+  return visibleCount;
+}
+
+// Culls boxes [begin, end), begin must be a multiple of CULL_SIMD_WIDTH
+internal u32 cullBoxRange(const CullingBoxes* boxes, const Frustum& frustum, u32 begin, u32 end, u32* outVisibleIndices) {
+  u32 visibleCount = 0;
+
+#if CULL_SIMD_WIDTH == 8
+  __m256 planeX[6], planeY[6], planeZ[6], planeW[6], planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+  for(u32 i = 0; i < 6; ++i) {
+    planeX[i] = _mm256_set1_ps(frustum.planes[i].x);
+    planeY[i] = _mm256_set1_ps(frustum.planes[i].y);
+    planeZ[i] = _mm256_set1_ps(frustum.planes[i].z);
+    planeW[i] = _mm256_set1_ps(frustum.planes[i].w);
+    planeAbsX[i] = _mm256_set1_ps(fabsf(frustum.planes[i].x));
+    planeAbsY[i] = _mm256_set1_ps(fabsf(frustum.planes[i].y));
+    planeAbsZ[i] = _mm256_set1_ps(fabsf(frustum.planes[i].z));
+  }
+  const __m256 zero = _mm256_setzero_ps();
+  for(u32 i = begin; i < end; i += 8) {
+    __m256 cx = _mm256_load_ps(boxes->centerX + i);
+    __m256 cy = _mm256_load_ps(boxes->centerY + i);
+    __m256 cz = _mm256_load_ps(boxes->centerZ + i);
+    __m256 ex = _mm256_load_ps(boxes->extentX + i);
+    __m256 ey = _mm256_load_ps(boxes->extentY + i);
+    __m256 ez = _mm256_load_ps(boxes->extentZ + i);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for(u32 p = 0; p < 6; ++p) {
+      __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)),
+                                  _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+      __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeAbsX[p], ex), _mm256_mul_ps(planeAbsY[p], ey)),
+                                    _mm256_mul_ps(planeAbsZ[p], ez));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+    }
+    visibleCount = appendVisibleLanes((u32)_mm256_movemask_ps(inside), i, end, outVisibleIndices, visibleCount);
+  }
+#elif CULL_SIMD_WIDTH == 4
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6], planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+  for(u32 i = 0; i < 6; ++i) {
+    planeX[i] = _mm_set1_ps(frustum.planes[i].x);
+    planeY[i] = _mm_set1_ps(frustum.planes[i].y);
+    planeZ[i] = _mm_set1_ps(frustum.planes[i].z);
+    planeW[i] = _mm_set1_ps(frustum.planes[i].w);
+    planeAbsX[i] = _mm_set1_ps(fabsf(frustum.planes[i].x));
+    planeAbsY[i] = _mm_set1_ps(fabsf(frustum.planes[i].y));
+    planeAbsZ[i] = _mm_set1_ps(fabsf(frustum.planes[i].z));
+  }
+  const __m128 zero = _mm_setzero_ps();
+  for(u32 i = begin; i < end; i += 4) {
+    __m128 cx = _mm_load_ps(boxes->centerX + i);
+    __m128 cy = _mm_load_ps(boxes->centerY + i);
+    __m128 cz = _mm_load_ps(boxes->centerZ + i);
+    __m128 ex = _mm_load_ps(boxes->extentX + i);
+    __m128 ey = _mm_load_ps(boxes->extentY + i);
+    __m128 ez = _mm_load_ps(boxes->extentZ + i);
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for(u32 p = 0; p < 6; ++p) {
+      __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                               _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+      __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeAbsX[p], ex), _mm_mul_ps(planeAbsY[p], ey)),
+                                 _mm_mul_ps(planeAbsZ[p], ez));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+    }
+    visibleCount = appendVisibleLanes((u32)_mm_movemask_ps(inside), i, end, outVisibleIndices, visibleCount);
+  }
+#else
+  for(u32 i = begin; i < end; ++i) {
+    if(boxInFrustum(frustum, boxes->centerX[i], boxes->centerY[i], boxes->centerZ[i], boxes->extentX[i], boxes->extentY[i], boxes->extentZ[i])) {
+      outVisibleIndices[visibleCount++] = i;
+    }
+  }
+#endif
+  return visibleCount;
+}
+
+// Writes the indices of all boxes intersecting the frustum to outVisibleIndices (which must hold boxes->count)
+// and returns how many were written. Large sets are split into batches across the job system.
+u32 cullBoxes(const CullingBoxes* boxes, const Frustum& frustum, u32* outVisibleIndices, CullStats* stats = nullptr) {
+  u64 startCounter = getPerformanceCounter();
+  u32 visibleCount = 0;
+  if(boxes->count < CULL_PARALLEL_MIN_BOX_COUNT || jobThreadCount() == 1) {
+    visibleCount = cullBoxRange(boxes, frustum, 0, boxes->count, outVisibleIndices);
+  } else {
+    // each batch writes to its own part of the output, which is compacted afterwards
+    u32 batchCount = (boxes->count + CULL_PARALLEL_BATCH_SIZE - 1) / CULL_PARALLEL_BATCH_SIZE;
+    TempMemory tempMemory = beginTempMemory(threadTempArena());
+    u32* batchVisibleCounts = pushArrayZero(tempMemory.arena, batchCount, u32);
+    parallelFor(boxes->count, CULL_PARALLEL_BATCH_SIZE, [=](u32 begin, u32 end) {
+      batchVisibleCounts[begin / CULL_PARALLEL_BATCH_SIZE] = cullBoxRange(boxes, frustum, begin, end, outVisibleIndices + begin);
+    });
+    for(u32 batch = 0; batch < batchCount; ++batch) {
+      memmove(outVisibleIndices + visibleCount, outVisibleIndices + (batch * CULL_PARALLEL_BATCH_SIZE), batchVisibleCounts[batch] * sizeof(u32));
+      visibleCount += batchVisibleCounts[batch];
+    }
+    endTempMemory(tempMemory);
+  }
+
+  if(stats) {
+    stats->testedCount = boxes->count;
+    stats->culledCount = boxes->count - visibleCount;
+    stats->cullSeconds = (getPerformanceCounter() - startCounter) / (f64)getPerformanceCounterFrequencyPerSecond();
+  }
+  return visibleCount;
+}
+
+bool boxInFrustum(const Frustum& frustum, const Box& worldBox) {
+  glm::vec3 extent = worldBox.diagonal * 0.5f;
+  glm::vec3 center = worldBox.min + extent;
+  return boxInFrustum(frustum, center.x, center.y, center.z, extent.x, extent.y, extent.z);
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+// Debug overlay
+// Debug lines are formatted into one text buffer per frame and handed to ImGui as a single window with a single text
+// item, instead of a Begin/End per line. The UI can be rebuilt only every few frames, the frames in between reuse the
+// last ImGui draw data, which stays valid until the next ImGui frame begins. Input that the UI could react to always
+// rebuilds it right away. The stats HUD skips ImGui entirely: its text travels in the frame packet and is drawn by the
+// render thread as one instanced draw of 3x5 pixel glyphs, decoded from bits in the fragment shader, no font texture.
+
+#define DEBUG_LOG_CAPACITY 4096
+#define UI_UPDATE_INTERVAL_MAX 8 // frames
+#define UI_CPU_TIME_SMOOTHING 0.05 // weight of the newest frame in the running average
+#define STATS_HUD_MAX_CHARS 128
+#define STATS_HUD_GLYPH_SCALE 3 // screen pixels per glyph pixel
+#define STATS_HUD_INSTANCE_ATTRIBUTE_INDEX 0
+
+struct DebugLog {
+  char text[DEBUG_LOG_CAPACITY];
+  u32 length;
+};
+
+struct UiThrottle {
+  u32 interval; // UI is rebuilt at least every interval frames, 1 rebuilds it every frame
+  u32 framesSinceUpdate;
+  u32 updateCount;
+  f64 cpuSeconds; // running average of the time spent recording the UI per frame, rebuilt or not
+};
+
+struct StatsHud {
+  GLuint shaderId;
+  GLuint arrayObject;
+  GLuint instanceBufferObject;
+  GLint windowDimensLocation;
+};
+
+inline void clearDebugLog(DebugLog* log) {
+  log->length = 0;
+  log->text[0] = '\0';
+}
+
+// Appends a line, lines that do not fit are cut short
+void logV(DebugLog* log, const char* fmt, ...) {
+  u32 remaining = DEBUG_LOG_CAPACITY - log->length;
+  if(remaining <= 1) { return; }
+  va_list argptr;
+  va_start(argptr, fmt);
+  s32 written = vsnprintf(log->text + log->length, remaining - 1, fmt, argptr); // leaves room for the newline
+  va_end(argptr);
+  if(written < 0) { return; }
+  log->length += Min((u32)written, remaining - 2);
+  log->text[log->length++] = '\n';
+  log->text[log->length] = '\0';
+}
+
+void submitDebugLog(const DebugLog& log, const char* windowName, bool* pOpen) {
+  if(ImGui::Begin(windowName, pOpen)) {
+    ImGui::TextUnformatted(log.text, log.text + log.length);
+  }ImGui::End();
+}
+
+void initUiThrottle(UiThrottle* throttle, u32 interval) {
+  *throttle = {};
+  throttle->interval = Clamp(interval, 1u, (u32)UI_UPDATE_INTERVAL_MAX);
+}
+
+// True when the UI should be rebuilt this frame. Mouse motion only counts when the cursor is free to point at the UI.
+bool uiNeedsUpdate(UiThrottle* throttle, const InputEventFrame& events, bool cursorVisible) {
+  bool update = ++throttle->framesSinceUpdate >= throttle->interval || throttle->updateCount == 0;
+  for(u32 i = 0; i < events.eventCount && !update; ++i) {
+    update = events.events[i].type != InputEvent_MouseMotion || cursorVisible;
+  }
+  if(update) {
+    throttle->framesSinceUpdate = 0;
+    throttle->updateCount++;
+  }
+  return update;
+}
+
+void endUiFrame(UiThrottle* throttle, u64 beginCounter) {
+  f64 seconds = (f64)(getPerformanceCounter() - beginCounter) / (f64)getPerformanceCounterFrequencyPerSecond();
+  throttle->cpuSeconds += (seconds - throttle->cpuSeconds) * UI_CPU_TIME_SMOOTHING;
+}
+
+// Rows of three pixels from the top, 4 is the left pixel and 1 the right
+#define HudGlyph(r0,r1,r2,r3,r4) (u16)((r0 << 12) | (r1 << 9) | (r2 << 6) | (r3 << 3) | r4)
+
+const u16 statsHudDigitGlyphs[] = {
+  HudGlyph(7,5,5,5,7), HudGlyph(2,6,2,2,7), HudGlyph(7,1,7,4,7), HudGlyph(7,1,3,1,7), HudGlyph(5,5,7,1,1),
+  HudGlyph(7,4,7,1,7), HudGlyph(7,4,7,5,7), HudGlyph(7,1,1,1,1), HudGlyph(7,5,7,5,7), HudGlyph(7,5,7,1,7),
+};
+
+const u16 statsHudLetterGlyphs[] = {
+  HudGlyph(2,5,7,5,5), HudGlyph(6,5,6,5,6), HudGlyph(3,4,4,4,3), HudGlyph(6,5,5,5,6), HudGlyph(7,4,6,4,7), // A-E
+  HudGlyph(7,4,6,4,4), HudGlyph(3,4,5,5,3), HudGlyph(5,5,7,5,5), HudGlyph(7,2,2,2,7), HudGlyph(1,1,1,5,2), // F-J
+  HudGlyph(5,5,6,5,5), HudGlyph(4,4,4,4,7), HudGlyph(5,7,7,5,5), HudGlyph(6,5,5,5,5), HudGlyph(2,5,5,5,2), // K-O
+  HudGlyph(6,5,6,4,4), HudGlyph(2,5,5,6,3), HudGlyph(6,5,6,5,5), HudGlyph(3,4,2,1,6), HudGlyph(7,2,2,2,2), // P-T
+  HudGlyph(5,5,5,5,7), HudGlyph(5,5,5,5,2), HudGlyph(5,5,7,7,5), HudGlyph(5,5,2,5,5), HudGlyph(5,5,2,2,2), // U-Y
+  HudGlyph(7,1,2,4,7), // Z
+};
+
+// Zero for characters without a glyph, which are drawn as spaces. Letters are all drawn uppercase.
+internal u16 statsHudGlyph(char c) {
+  if(c >= '0' && c <= '9') { return statsHudDigitGlyphs[c - '0']; }
+  if(c >= 'A' && c <= 'Z') { return statsHudLetterGlyphs[c - 'A']; }
+  if(c >= 'a' && c <= 'z') { return statsHudLetterGlyphs[c - 'a']; }
+  switch(c) {
+    case '.': return HudGlyph(0,0,0,0,2);
+    case ':': return HudGlyph(0,2,0,2,0);
+    case '/': return HudGlyph(1,1,2,4,4);
+    case '|': return HudGlyph(2,2,2,2,2);
+    case '-': return HudGlyph(0,0,7,0,0);
+    case '%': return HudGlyph(5,1,2,4,5);
+    default: return 0;
+  }
+}
+
+#undef HudGlyph
+
+// The GL context must be current
+void initStatsHud(StatsHud* hud, GLuint shaderId) {
+  hud->shaderId = shaderId;
+  hud->windowDimensLocation = glGetUniformLocation(shaderId, "windowDimens");
+  glGenVertexArrays(1, &hud->arrayObject);
+  glGenBuffers(1, &hud->instanceBufferObject);
+  glBindVertexArray(hud->arrayObject);
+  glBindBuffer(GL_ARRAY_BUFFER, hud->instanceBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, STATS_HUD_MAX_CHARS * sizeof(u32), nullptr, GL_DYNAMIC_DRAW);
+  glVertexAttribIPointer(STATS_HUD_INSTANCE_ATTRIBUTE_INDEX, 1, GL_UNSIGNED_INT, sizeof(u32), (void*)0);
+  glEnableVertexAttribArray(STATS_HUD_INSTANCE_ATTRIBUTE_INDEX);
+  glVertexAttribDivisor(STATS_HUD_INSTANCE_ATTRIBUTE_INDEX, 1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glUseProgram(shaderId);
+  glUniform1i(glGetUniformLocation(shaderId, "glyphScale"), STATS_HUD_GLYPH_SCALE);
+}
+
+void deinitStatsHud(StatsHud* hud) {
+  glDeleteBuffers(1, &hud->instanceBufferObject);
+  glDeleteVertexArrays(1, &hud->arrayObject);
+  *hud = {}; // clear to zero
+}
+
+// Draws the text from the top left of the current framebuffer, '\n' starts a new row. Returns the glyphs drawn.
+u32 drawStatsHud(const StatsHud& hud, const char* text, ivec2 windowDimens) {
+  u32 instances[STATS_HUD_MAX_CHARS];
+  u32 instanceCount = 0;
+  u32 column = 0, row = 0;
+  for(const char* c = text; *c != '\0' && instanceCount < STATS_HUD_MAX_CHARS; ++c) {
+    if(*c == '\n') {
+      column = 0;
+      row++;
+      continue;
+    }
+    u16 glyph = statsHudGlyph(*c);
+    if(glyph != 0) { // glyph bits | column << 16 | row << 24
+      instances[instanceCount++] = (u32)glyph | (Min(column, 0xFFu) << 16) | (Min(row, 0xFFu) << 24);
+    }
+    column++;
+  }
+  if(instanceCount == 0) { return 0; }
+
+  glBindBuffer(GL_ARRAY_BUFFER, hud.instanceBufferObject);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(u32), instances);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glUseProgram(hud.shaderId);
+  glUniform2i(hud.windowDimensLocation, windowDimens.x, windowDimens.y);
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(hud.arrayObject);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+  glBindVertexArray(0);
+  glEnable(GL_DEPTH_TEST);
+  return instanceCount;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+// Dynamic resolution
+// The render thread times the scene on the GPU with GL_TIME_ELAPSED queries. Results are read a few frames later,
+// once available, so measuring never stalls the pipeline. A damped controller turns the smoothed GPU time into a
+// render scale for both axes: the scene is drawn into the corner of a window sized render target and stretched over
+// the window, so changing the scale never reallocates anything.
+
+#define GPU_TIMER_QUERY_COUNT 4 // frames that can be in flight before measuring skips one
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.2 // weight of the newest GPU time
+#define DYNAMIC_RESOLUTION_DAMPING 0.15f // portion of the way to the ideal scale taken per measurement
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85 // portion of the frame budget the GPU should be busy for
+#define DYNAMIC_RESOLUTION_MIN_SCALE_STEP 0.01f // smaller changes are ignored to keep the resolution still
+
+struct GpuTimer {
+  GLuint queries[GPU_TIMER_QUERY_COUNT];
+  bool pending[GPU_TIMER_QUERY_COUNT];
+  u32 nextQuery; // next to begin
+  u32 oldestQuery; // next to read
+};
+
+// Chosen on the simulation thread and passed along with each frame
+struct DynamicResolutionSettings {
+  bool enabled;
+  f32 targetFrameMs;
+  f32 minScale;
+  f32 maxScale;
+};
+
+struct DynamicResolution {
+  f32 scale;
+  f64 smoothedGpuSeconds;
+  u32 sampleCount;
+  std::atomic<f32> publishedScale; // for display on other threads
+  std::atomic<f32> publishedGpuMs;
+};
+
+// The GL context must be current
+void initGpuTimer(GpuTimer* timer) {
+  *timer = {};
+  glGenQueries(GPU_TIMER_QUERY_COUNT, timer->queries);
+}
+
+void deinitGpuTimer(GpuTimer* timer) {
+  glDeleteQueries(GPU_TIMER_QUERY_COUNT, timer->queries);
+  *timer = {}; // clear to zero
+}
+
+// False when every query is still waiting on its result, nothing is timed this frame then
+bool beginGpuTimer(GpuTimer* timer) {
+  if(timer->pending[timer->nextQuery]) { return false; }
+  glBeginQuery(GL_TIME_ELAPSED, timer->queries[timer->nextQuery]);
+  return true;
+}
+
+void endGpuTimer(GpuTimer* timer) {
+  glEndQuery(GL_TIME_ELAPSED);
+  timer->pending[timer->nextQuery] = true;
+  timer->nextQuery = (timer->nextQuery + 1) % GPU_TIMER_QUERY_COUNT;
+}
+
+// Oldest finished timing, false if it is not available yet. Never waits on the GPU.
+bool pollGpuTimer(GpuTimer* timer, OUT f64* outSeconds) {
+  if(!timer->pending[timer->oldestQuery]) { return false; }
+  GLuint query = timer->queries[timer->oldestQuery];
+  GLint available = 0;
+  glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+  if(!available) { return false; }
+  GLuint64 nanoseconds;
+  glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+  timer->pending[timer->oldestQuery] = false;
+  timer->oldestQuery = (timer->oldestQuery + 1) % GPU_TIMER_QUERY_COUNT;
+  *outSeconds = (f64)nanoseconds * 1e-9;
+  return true;
+}
+
+void initDynamicResolution(DynamicResolution* resolution) {
+  resolution->scale = 1.0f;
+  resolution->smoothedGpuSeconds = 0.0;
+  resolution->sampleCount = 0;
+  resolution->publishedScale = 1.0f;
+  resolution->publishedGpuMs = 0.0f;
+}
+
+// Feeds one GPU frame time into the controller. GPU cost is assumed to follow the pixel count, the square of the
+// scale, so the ideal scale is the one that would have landed this frame on the target.
+void updateDynamicResolution(DynamicResolution* resolution, f64 gpuSeconds, const DynamicResolutionSettings& settings) {
+  resolution->smoothedGpuSeconds = resolution->sampleCount++ == 0 ? gpuSeconds :
+                                   resolution->smoothedGpuSeconds + (gpuSeconds - resolution->smoothedGpuSeconds) * DYNAMIC_RESOLUTION_SMOOTHING;
+  resolution->publishedGpuMs.store((f32)(resolution->smoothedGpuSeconds * 1000.0), std::memory_order_relaxed);
+  if(!settings.enabled) { return; }
+
+  f64 targetSeconds = settings.targetFrameMs * 0.001 * DYNAMIC_RESOLUTION_HEADROOM;
+  f32 idealScale = resolution->scale * (f32)sqrt(targetSeconds / Max(resolution->smoothedGpuSeconds, 1e-6));
+  f32 step = (idealScale - resolution->scale) * DYNAMIC_RESOLUTION_DAMPING;
+  if(fabsf(step) >= DYNAMIC_RESOLUTION_MIN_SCALE_STEP) {
+    resolution->scale += step;
+  }
+  resolution->scale = Clamp(resolution->scale, settings.minScale, settings.maxScale);
+  resolution->publishedScale.store(resolution->scale, std::memory_order_relaxed);
+}
+
+// Size of the part of a window sized target that is rendered to, at least one pixel
+inline ivec2 dynamicRenderDimens(f32 scale, ivec2 windowDimens) {
+  return ivec2{ Max((s32)(windowDimens.x * scale), 1), Max((s32)(windowDimens.y * scale), 1) };
+}
\ No newline at end of file
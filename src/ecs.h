@@ -0,0 +1,619 @@
+#pragma once
+
+// Entity component store
+// Entities with the same set of components share an archetype. An archetype stores its entities in fixed size
+// chunks, each chunk holding one contiguous array per component (plus the owning entity handles), so systems
+// iterate linearly over exactly the data they read. Entities are Generation::Index handles into a slot map of
+// archetype locations, destroying an entity expires its handle.
+// Structural changes (create, destroy, adding/removing components) move entities between archetypes and are not
+// allowed while a query is iterating. Record those in an EcsCommandBuffer and flush it afterwards.
+
+#define ECS_CHUNK_SIZE Kilobytes(16)
+#define ECS_CHUNK_ALIGNMENT 64
+#define ECS_COMPONENT_ALIGNMENT 16
+#define ECS_MAX_ARCHETYPES 256
+#define ECS_NO_ARCHETYPE U32_MAX
+#define ECS_PENDING_GENERATION U32_MAX // marks an entity created by a command buffer that has not been flushed
+
+enum ComponentType : u32 {
+#define Component(name, type) ComponentType_##name,
+#include "Component.incl"
+#undef Component
+  ComponentType_Count
+};
+
+typedef u32 ComponentMask;
+static_assert(ComponentType_Count <= 32, "ERROR: ComponentMask has one bit per component type!");
+
+const u32 componentSizes[ComponentType_Count] = {
+#define Component(name, type) sizeof(type),
+#include "Component.incl"
+#undef Component
+};
+
+template<typename T> struct ComponentTypeOf;
+#define Component(name, type) \
+  template<> struct ComponentTypeOf<type> { static const ComponentType value = ComponentType_##name; }; \
+  static_assert(std::is_trivially_copyable<type>::value && alignof(type) <= ECS_COMPONENT_ALIGNMENT, "ERROR: " #type " must be plain data!");
+#include "Component.incl"
+#undef Component
+
+// componentMask<SpriteComponent, AudioEmitterComponent>()
+template<typename... Components>
+constexpr ComponentMask componentMask() { return (0u | ... | (1u << ComponentTypeOf<Components>::value)); }
+
+typedef Generation::Index Entity;
+
+struct EcsChunk {
+  u8* memory; // entity handles followed by one array per component
+  u32 count;
+};
+
+struct Archetype {
+  ComponentMask mask;
+  u32 componentOffsets[ComponentType_Count]; // byte offset of each component array in a chunk, U32_MAX when absent
+  u32 chunkCapacity; // entities per chunk
+  EcsChunk* chunks;
+  u32 chunkCount; // chunks in use, every one but the last is full
+  u32 chunkArrayCapacity; // chunk memory past chunkCount is kept for reuse
+  u32 entityCount;
+  u32 addEdges[ComponentType_Count]; // archetype reached by adding/removing a component, ECS_NO_ARCHETYPE until first needed
+  u32 removeEdges[ComponentType_Count];
+};
+
+struct EntityLocation {
+  u32 archetype;
+  u32 row; // rows run across chunks, chunk = row / chunkCapacity
+};
+
+// Matching archetypes are cached and only new archetypes are checked on the next iteration
+struct EcsQuery {
+  ComponentMask required;
+  ComponentMask excluded;
+  u32 archetypes[ECS_MAX_ARCHETYPES];
+  u32 archetypeCount;
+  u32 checkedArchetypeCount;
+};
+
+struct EcsWorld {
+  Archetype* archetypes;
+  u32 archetypeCount;
+  Generation::Map<EntityLocation> entities;
+  u32 iterationDepth; // structural changes are not allowed while a query is iterating
+};
+
+// What a system sees of one chunk while iterating a query
+struct EcsChunkView {
+  const Archetype* archetype;
+  EcsChunk* chunk;
+  u32 count;
+
+  Entity* entities() { return (Entity*)chunk->memory; }
+  template<typename T> bool has() const { return (archetype->mask & componentMask<T>()) != 0; }
+  template<typename T> T* get() {
+    assert(has<T>() && "ERROR: Chunk does not have the requested component!");
+    return (T*)(chunk->memory + archetype->componentOffsets[ComponentTypeOf<T>::value]);
+  }
+};
+
+enum EcsCommandType : u32 {
+  EcsCommand_Create,
+  EcsCommand_Destroy,
+  EcsCommand_AddComponent, // also overwrites a component the entity already has
+  EcsCommand_RemoveComponent,
+};
+
+struct EcsCommand {
+  EcsCommandType type;
+  ComponentType componentType;
+  ComponentMask mask;
+  Entity entity;
+  u32 dataOffset; // component value in the buffer's data, U32_MAX to zero initialize
+};
+
+struct EcsCommandBuffer {
+  EcsCommand* commands;
+  u32 commandCount;
+  u32 commandCapacity;
+  u8* data;
+  u32 dataSize;
+  u32 dataCapacity;
+};
+
+internal inline u32 alignComponentOffset(u32 offset) {
+  return (offset + ECS_COMPONENT_ALIGNMENT - 1) & ~(u32)(ECS_COMPONENT_ALIGNMENT - 1);
+}
+
+internal u32 createArchetype(EcsWorld* world, ComponentMask mask) {
+  assert(world->archetypeCount < ECS_MAX_ARCHETYPES && "ERROR: Too many archetypes!");
+  u32 archetypeIndex = world->archetypeCount++;
+  Archetype* archetype = world->archetypes + archetypeIndex;
+  *archetype = {};
+  archetype->mask = mask;
+  for(u32 type = 0; type < ComponentType_Count; ++type) {
+    archetype->componentOffsets[type] = U32_MAX;
+    archetype->addEdges[type] = ECS_NO_ARCHETYPE;
+    archetype->removeEdges[type] = ECS_NO_ARCHETYPE;
+  }
+
+  // as many entities as fit once every array is aligned
+  u32 rowSize = sizeof(Entity);
+  for(u32 type = 0; type < ComponentType_Count; ++type) {
+    if(mask & (1u << type)) { rowSize += componentSizes[type]; }
+  }
+  u32 capacity = (u32)(ECS_CHUNK_SIZE / rowSize);
+  while(true) {
+    u32 offset = capacity * sizeof(Entity);
+    for(u32 type = 0; type < ComponentType_Count; ++type) {
+      if(mask & (1u << type)) {
+        offset = alignComponentOffset(offset);
+        archetype->componentOffsets[type] = offset;
+        offset += capacity * componentSizes[type];
+      }
+    }
+    if(offset <= ECS_CHUNK_SIZE) { break; }
+    capacity--;
+  }
+  assert(capacity > 0);
+  archetype->chunkCapacity = capacity;
+  return archetypeIndex;
+}
+
+internal u32 findOrCreateArchetype(EcsWorld* world, ComponentMask mask) {
+  for(u32 i = 0; i < world->archetypeCount; ++i) {
+    if(world->archetypes[i].mask == mask) { return i; }
+  }
+  return createArchetype(world, mask);
+}
+
+internal inline void archetypeRowLocation(const Archetype& archetype, u32 row, u32* outChunk, u32* outChunkRow) {
+  *outChunk = row / archetype.chunkCapacity;
+  *outChunkRow = row % archetype.chunkCapacity;
+}
+
+internal inline u8* archetypeComponent(const Archetype& archetype, u32 row, u32 type) {
+  u32 chunkIndex, chunkRow;
+  archetypeRowLocation(archetype, row, &chunkIndex, &chunkRow);
+  return archetype.chunks[chunkIndex].memory + archetype.componentOffsets[type] + (chunkRow * componentSizes[type]);
+}
+
+internal inline Entity* archetypeEntity(const Archetype& archetype, u32 row) {
+  u32 chunkIndex, chunkRow;
+  archetypeRowLocation(archetype, row, &chunkIndex, &chunkRow);
+  return (Entity*)archetype.chunks[chunkIndex].memory + chunkRow;
+}
+
+// Appends a row with uninitialized components
+internal u32 allocateArchetypeRow(Archetype* archetype, Entity entity) {
+  u32 row = archetype->entityCount++;
+  u32 chunkIndex, chunkRow;
+  archetypeRowLocation(*archetype, row, &chunkIndex, &chunkRow);
+  if(chunkIndex == archetype->chunkCount) {
+    if(chunkIndex == archetype->chunkArrayCapacity) {
+      u32 newCapacity = Max(archetype->chunkArrayCapacity * 2, 4u);
+      EcsChunk* newChunks = new EcsChunk[newCapacity];
+      for(u32 i = 0; i < newCapacity; ++i) {
+        newChunks[i] = (i < archetype->chunkArrayCapacity) ? archetype->chunks[i] : EcsChunk{ nullptr, 0 };
+      }
+      delete[] archetype->chunks;
+      archetype->chunks = newChunks;
+      archetype->chunkArrayCapacity = newCapacity;
+    }
+    EcsChunk* chunk = archetype->chunks + chunkIndex;
+    if(chunk->memory == nullptr) {
+      chunk->memory = (u8*)operator new(ECS_CHUNK_SIZE, std::align_val_t(ECS_CHUNK_ALIGNMENT));
+    }
+    chunk->count = 0;
+    archetype->chunkCount++;
+  }
+  archetype->chunks[chunkIndex].count++;
+  *archetypeEntity(*archetype, row) = entity;
+  return row;
+}
+
+// Fills the hole with the archetype's last entity so rows stay packed
+internal void removeArchetypeRow(EcsWorld* world, Archetype* archetype, u32 row) {
+  u32 lastRow = --archetype->entityCount;
+  if(row != lastRow) {
+    Entity movedEntity = *archetypeEntity(*archetype, lastRow);
+    *archetypeEntity(*archetype, row) = movedEntity;
+    for(u32 type = 0; type < ComponentType_Count; ++type) {
+      if(archetype->mask & (1u << type)) {
+        memcpy(archetypeComponent(*archetype, row, type), archetypeComponent(*archetype, lastRow, type), componentSizes[type]);
+      }
+    }
+    world->entities.at(movedEntity).row = row;
+  }
+  EcsChunk* lastChunk = archetype->chunks + (archetype->chunkCount - 1);
+  if(--lastChunk->count == 0) {
+    archetype->chunkCount--;
+  }
+}
+
+internal void moveEntityToArchetype(EcsWorld* world, Entity entity, u32 dstArchetypeIndex) {
+  EntityLocation* location = &world->entities.at(entity);
+  Archetype* src = world->archetypes + location->archetype;
+  Archetype* dst = world->archetypes + dstArchetypeIndex;
+  u32 srcRow = location->row;
+  u32 dstRow = allocateArchetypeRow(dst, entity);
+  for(u32 type = 0; type < ComponentType_Count; ++type) {
+    if(dst->mask & (1u << type)) {
+      u8* dstComponent = archetypeComponent(*dst, dstRow, type);
+      if(src->mask & (1u << type)) {
+        memcpy(dstComponent, archetypeComponent(*src, srcRow, type), componentSizes[type]);
+      } else {
+        memset(dstComponent, 0, componentSizes[type]);
+      }
+    }
+  }
+  removeArchetypeRow(world, src, srcRow);
+  location = &world->entities.at(entity);
+  location->archetype = dstArchetypeIndex;
+  location->row = dstRow;
+}
+
+void initEcsWorld(EcsWorld* world, u32 entityCapacity) {
+  world->archetypes = new Archetype[ECS_MAX_ARCHETYPES];
+  world->archetypeCount = 0;
+  world->entities.reserve(entityCapacity);
+  world->iterationDepth = 0;
+  findOrCreateArchetype(world, 0); // entities without components
+}
+
+void deinitEcsWorld(EcsWorld* world) {
+  for(u32 i = 0; i < world->archetypeCount; ++i) {
+    Archetype* archetype = world->archetypes + i;
+    for(u32 chunkIndex = 0; chunkIndex < archetype->chunkArrayCapacity; ++chunkIndex) {
+      if(archetype->chunks[chunkIndex].memory != nullptr) {
+        operator delete(archetype->chunks[chunkIndex].memory, std::align_val_t(ECS_CHUNK_ALIGNMENT));
+      }
+    }
+    delete[] archetype->chunks;
+  }
+  delete[] world->archetypes;
+  world->archetypes = nullptr;
+  world->archetypeCount = 0;
+}
+
+inline bool entityAlive(const EcsWorld& world, Entity entity) { return world.entities.contains(entity); }
+inline u32 entityCount(const EcsWorld& world) { return world.entities.count(); }
+
+// Components start zeroed
+Entity createEntity(EcsWorld* world, ComponentMask mask) {
+  assert(world->iterationDepth == 0 && "ERROR: Entities can not be created while iterating, use an EcsCommandBuffer!");
+  u32 archetypeIndex = findOrCreateArchetype(world, mask);
+  Archetype* archetype = world->archetypes + archetypeIndex;
+  Entity entity = world->entities.put(EntityLocation{ archetypeIndex, 0 });
+  u32 row = allocateArchetypeRow(archetype, entity);
+  world->entities.at(entity).row = row;
+  for(u32 type = 0; type < ComponentType_Count; ++type) {
+    if(mask & (1u << type)) {
+      memset(archetypeComponent(*archetype, row, type), 0, componentSizes[type]);
+    }
+  }
+  return entity;
+}
+
+void destroyEntity(EcsWorld* world, Entity entity) {
+  assert(world->iterationDepth == 0 && "ERROR: Entities can not be destroyed while iterating, use an EcsCommandBuffer!");
+  EntityLocation location = world->entities.at(entity);
+  removeArchetypeRow(world, world->archetypes + location.archetype, location.row);
+  world->entities.remove(entity);
+}
+
+// value may be nullptr to zero the component, an existing component is overwritten
+void addComponent(EcsWorld* world, Entity entity, ComponentType type, const void* value) {
+  assert(world->iterationDepth == 0 && "ERROR: Components can not be added while iterating, use an EcsCommandBuffer!");
+  EntityLocation location = world->entities.at(entity);
+  Archetype* archetype = world->archetypes + location.archetype;
+  if(!(archetype->mask & (1u << type))) {
+    u32 dstArchetype = archetype->addEdges[type];
+    if(dstArchetype == ECS_NO_ARCHETYPE) {
+      dstArchetype = findOrCreateArchetype(world, archetype->mask | (1u << type));
+      archetype->addEdges[type] = dstArchetype;
+      world->archetypes[dstArchetype].removeEdges[type] = location.archetype;
+    }
+    moveEntityToArchetype(world, entity, dstArchetype);
+    location = world->entities.at(entity);
+    archetype = world->archetypes + location.archetype;
+  }
+  u8* component = archetypeComponent(*archetype, location.row, type);
+  if(value != nullptr) {
+    memcpy(component, value, componentSizes[type]);
+  } else {
+    memset(component, 0, componentSizes[type]);
+  }
+}
+
+void removeComponent(EcsWorld* world, Entity entity, ComponentType type) {
+  assert(world->iterationDepth == 0 && "ERROR: Components can not be removed while iterating, use an EcsCommandBuffer!");
+  EntityLocation location = world->entities.at(entity);
+  Archetype* archetype = world->archetypes + location.archetype;
+  if(!(archetype->mask & (1u << type))) { return; }
+  u32 dstArchetype = archetype->removeEdges[type];
+  if(dstArchetype == ECS_NO_ARCHETYPE) {
+    dstArchetype = findOrCreateArchetype(world, archetype->mask & ~(1u << type));
+    archetype->removeEdges[type] = dstArchetype;
+    world->archetypes[dstArchetype].addEdges[type] = location.archetype;
+  }
+  moveEntityToArchetype(world, entity, dstArchetype);
+}
+
+template<typename T>
+T* addComponent(EcsWorld* world, Entity entity, const T& value) {
+  addComponent(world, entity, ComponentTypeOf<T>::value, &value);
+  EntityLocation location = world->entities.at(entity);
+  return (T*)archetypeComponent(world->archetypes[location.archetype], location.row, ComponentTypeOf<T>::value);
+}
+
+// nullptr if the entity is gone or does not have the component. Only valid until the next structural change.
+template<typename T>
+T* getComponent(EcsWorld* world, Entity entity) {
+  EntityLocation* location = world->entities.get(entity);
+  if(location == nullptr) { return nullptr; }
+  const Archetype& archetype = world->archetypes[location->archetype];
+  if(!(archetype.mask & componentMask<T>())) { return nullptr; }
+  return (T*)archetypeComponent(archetype, location->row, ComponentTypeOf<T>::value);
+}
+
+void initQuery(EcsQuery* query, ComponentMask required, ComponentMask excluded = 0) {
+  query->required = required;
+  query->excluded = excluded;
+  query->archetypeCount = 0;
+  query->checkedArchetypeCount = 0;
+}
+
+internal void refreshQuery(const EcsWorld* world, EcsQuery* query) {
+  for(u32 i = query->checkedArchetypeCount; i < world->archetypeCount; ++i) {
+    ComponentMask mask = world->archetypes[i].mask;
+    if((mask & query->required) == query->required && (mask & query->excluded) == 0) {
+      query->archetypes[query->archetypeCount++] = i;
+    }
+  }
+  query->checkedArchetypeCount = world->archetypeCount;
+}
+
+// body(EcsChunkView& view) is called for every non-empty chunk matching the query
+template<typename Body>
+void forEachChunk(EcsWorld* world, EcsQuery* query, const Body& body) {
+  refreshQuery(world, query);
+  world->iterationDepth++;
+  for(u32 i = 0; i < query->archetypeCount; ++i) {
+    Archetype* archetype = world->archetypes + query->archetypes[i];
+    for(u32 chunkIndex = 0; chunkIndex < archetype->chunkCount; ++chunkIndex) {
+      EcsChunkView view{ archetype, archetype->chunks + chunkIndex, archetype->chunks[chunkIndex].count };
+      body(view);
+    }
+  }
+  world->iterationDepth--;
+}
+
+// Same as forEachChunk() with chunks spread across the job system, body must only touch its own chunk
+template<typename Body>
+void parallelForEachChunk(EcsWorld* world, EcsQuery* query, const Body& body) {
+  refreshQuery(world, query);
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32 chunkCount = 0;
+  for(u32 i = 0; i < query->archetypeCount; ++i) {
+    chunkCount += world->archetypes[query->archetypes[i]].chunkCount;
+  }
+  EcsChunkView* views = pushArray(tempMemory.arena, chunkCount, EcsChunkView);
+  u32 viewCount = 0;
+  for(u32 i = 0; i < query->archetypeCount; ++i) {
+    Archetype* archetype = world->archetypes + query->archetypes[i];
+    for(u32 chunkIndex = 0; chunkIndex < archetype->chunkCount; ++chunkIndex) {
+      views[viewCount++] = EcsChunkView{ archetype, archetype->chunks + chunkIndex, archetype->chunks[chunkIndex].count };
+    }
+  }
+  world->iterationDepth++;
+  parallelFor(viewCount, 4, [views, &body](u32 begin, u32 end) {
+    for(u32 i = begin; i < end; ++i) { body(views[i]); }
+  });
+  world->iterationDepth--;
+  endTempMemory(tempMemory);
+}
+
+void initCommandBuffer(EcsCommandBuffer* buffer, u32 commandCapacity = 256, u32 dataCapacity = Kilobytes(16)) {
+  buffer->commands = new EcsCommand[commandCapacity];
+  buffer->commandCount = 0;
+  buffer->commandCapacity = commandCapacity;
+  buffer->data = new u8[dataCapacity];
+  buffer->dataSize = 0;
+  buffer->dataCapacity = dataCapacity;
+}
+
+void deinitCommandBuffer(EcsCommandBuffer* buffer) {
+  delete[] buffer->commands;
+  delete[] buffer->data;
+  *buffer = {}; // clear to zero
+}
+
+internal EcsCommand* pushCommand(EcsCommandBuffer* buffer, EcsCommandType type, Entity entity) {
+  if(buffer->commandCount == buffer->commandCapacity) {
+    EcsCommand* newCommands = new EcsCommand[buffer->commandCapacity * 2];
+    memcpy(newCommands, buffer->commands, buffer->commandCount * sizeof(EcsCommand));
+    delete[] buffer->commands;
+    buffer->commands = newCommands;
+    buffer->commandCapacity *= 2;
+  }
+  EcsCommand* command = buffer->commands + buffer->commandCount++;
+  *command = {};
+  command->type = type;
+  command->entity = entity;
+  command->dataOffset = U32_MAX;
+  return command;
+}
+
+// The returned entity can be used with later commands in the same buffer, it becomes a real entity on flush
+Entity deferCreateEntity(EcsCommandBuffer* buffer, ComponentMask mask) {
+  Entity pending{ buffer->commandCount, ECS_PENDING_GENERATION };
+  pushCommand(buffer, EcsCommand_Create, pending)->mask = mask;
+  return pending;
+}
+
+void deferDestroyEntity(EcsCommandBuffer* buffer, Entity entity) {
+  pushCommand(buffer, EcsCommand_Destroy, entity);
+}
+
+template<typename T>
+void deferAddComponent(EcsCommandBuffer* buffer, Entity entity, const T& value) {
+  EcsCommand* command = pushCommand(buffer, EcsCommand_AddComponent, entity);
+  command->componentType = ComponentTypeOf<T>::value;
+  u32 offset = alignComponentOffset(buffer->dataSize);
+  if(offset + sizeof(T) > buffer->dataCapacity) {
+    u32 newCapacity = Max(buffer->dataCapacity * 2, offset + (u32)sizeof(T));
+    u8* newData = new u8[newCapacity];
+    memcpy(newData, buffer->data, buffer->dataSize);
+    delete[] buffer->data;
+    buffer->data = newData;
+    buffer->dataCapacity = newCapacity;
+  }
+  memcpy(buffer->data + offset, &value, sizeof(T));
+  buffer->dataSize = offset + sizeof(T);
+  command->dataOffset = offset;
+}
+
+template<typename T>
+void deferRemoveComponent(EcsCommandBuffer* buffer, Entity entity) {
+  pushCommand(buffer, EcsCommand_RemoveComponent, entity)->componentType = ComponentTypeOf<T>::value;
+}
+
+// Applies the commands in the order they were recorded and empties the buffer.
+// Commands on entities that no longer exist are skipped.
+void flushCommandBuffer(EcsWorld* world, EcsCommandBuffer* buffer) {
+  assert(world->iterationDepth == 0 && "ERROR: Command buffers can not be flushed while iterating!");
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Entity* createdEntities = pushArray(tempMemory.arena, buffer->commandCount, Entity); // by command index
+  for(u32 i = 0; i < buffer->commandCount; ++i) {
+    const EcsCommand& command = buffer->commands[i];
+    Entity entity = command.entity;
+    if(command.type != EcsCommand_Create && entity.generation == ECS_PENDING_GENERATION) {
+      assert(entity.value < i && "ERROR: Command targets an entity created later in the buffer!");
+      entity = createdEntities[entity.value];
+    }
+    if(command.type != EcsCommand_Create && !world->entities.contains(entity)) { continue; }
+
+    switch(command.type) {
+      case EcsCommand_Create:
+        createdEntities[i] = createEntity(world, command.mask);
+        break;
+      case EcsCommand_Destroy:
+        destroyEntity(world, entity);
+        break;
+      case EcsCommand_AddComponent:
+        addComponent(world, entity, command.componentType, command.dataOffset != U32_MAX ? buffer->data + command.dataOffset : nullptr);
+        break;
+      case EcsCommand_RemoveComponent:
+        removeComponent(world, entity, command.componentType);
+        break;
+    }
+  }
+  endTempMemory(tempMemory);
+  buffer->commandCount = 0;
+  buffer->dataSize = 0;
+}
+
+// Iteration and structural changes at 1M entities, results are printed to stdout
+void benchmarkEcs() {
+  const u32 entityCount = 1000000;
+  const f32 deltaSeconds = 1.0f / 60.0f;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  auto elapsedMs = [secondsPerCounter](u64 start) { return (getPerformanceCounter() - start) * secondsPerCounter * 1000.0; };
+
+  // baseline: one struct per scene object holding everything any system could want
+  struct SceneObject {
+    glm::mat4 modelMat;
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+    SpriteComponent sprite;
+    StaticMeshComponent mesh;
+    AudioEmitterComponent audioEmitter;
+  };
+  SceneObject* sceneObjects = new SceneObject[entityCount];
+  for(u32 i = 0; i < entityCount; ++i) {
+    sceneObjects[i] = {};
+    sceneObjects[i].sprite.velocity = glm::vec2((f32)(i % 7), 1.0f);
+  }
+
+  EcsWorld world;
+  initEcsWorld(&world, entityCount);
+  EcsCommandBuffer commandBuffer;
+  initCommandBuffer(&commandBuffer, entityCount, (u32)(entityCount * sizeof(AudioEmitterComponent)));
+  Entity* entities = new Entity[entityCount];
+
+  u64 start = getPerformanceCounter();
+  for(u32 i = 0; i < entityCount; ++i) {
+    entities[i] = createEntity(&world, componentMask<SpriteComponent>());
+  }
+  f64 createMs = elapsedMs(start);
+
+  EcsQuery spriteQuery;
+  initQuery(&spriteQuery, componentMask<SpriteComponent>());
+  forEachChunk(&world, &spriteQuery, [](EcsChunkView& view) {
+    SpriteComponent* sprites = view.get<SpriteComponent>();
+    Entity* chunkEntities = view.entities();
+    for(u32 i = 0; i < view.count; ++i) { sprites[i].velocity = glm::vec2((f32)(chunkEntities[i].value % 7), 1.0f); }
+  });
+
+  const u32 repetitions = 20;
+  start = getPerformanceCounter();
+  for(u32 rep = 0; rep < repetitions; ++rep) {
+    for(u32 i = 0; i < entityCount; ++i) {
+      sceneObjects[i].sprite.position += sceneObjects[i].sprite.velocity * deltaSeconds;
+    }
+  }
+  f64 baselineIterateMs = elapsedMs(start) / repetitions;
+
+  start = getPerformanceCounter();
+  for(u32 rep = 0; rep < repetitions; ++rep) {
+    forEachChunk(&world, &spriteQuery, [deltaSeconds](EcsChunkView& view) {
+      SpriteComponent* sprites = view.get<SpriteComponent>();
+      for(u32 i = 0; i < view.count; ++i) { sprites[i].position += sprites[i].velocity * deltaSeconds; }
+    });
+  }
+  f64 iterateMs = elapsedMs(start) / repetitions;
+
+  start = getPerformanceCounter();
+  for(u32 rep = 0; rep < repetitions; ++rep) {
+    parallelForEachChunk(&world, &spriteQuery, [deltaSeconds](EcsChunkView& view) {
+      SpriteComponent* sprites = view.get<SpriteComponent>();
+      for(u32 i = 0; i < view.count; ++i) { sprites[i].position += sprites[i].velocity * deltaSeconds; }
+    });
+  }
+  f64 parallelIterateMs = elapsedMs(start) / repetitions;
+
+  start = getPerformanceCounter();
+  for(u32 i = 0; i < entityCount; ++i) {
+    deferAddComponent(&commandBuffer, entities[i], AudioEmitterComponent{ 0.5f, 0.0f, false });
+  }
+  flushCommandBuffer(&world, &commandBuffer);
+  f64 addMs = elapsedMs(start);
+
+  start = getPerformanceCounter();
+  for(u32 i = 0; i < entityCount; ++i) {
+    deferRemoveComponent<AudioEmitterComponent>(&commandBuffer, entities[i]);
+  }
+  flushCommandBuffer(&world, &commandBuffer);
+  f64 removeMs = elapsedMs(start);
+
+  start = getPerformanceCounter();
+  for(u32 i = 0; i < entityCount; ++i) {
+    deferDestroyEntity(&commandBuffer, entities[i]);
+  }
+  flushCommandBuffer(&world, &commandBuffer);
+  f64 destroyMs = elapsedMs(start);
+  assert(world.entities.count() == 0);
+
+  printf("ECS benchmark (%u entities, %u per chunk)\n", entityCount, world.archetypes[findOrCreateArchetype(&world, componentMask<SpriteComponent>())].chunkCapacity);
+  printf("  iterate sprites: %8.3f ms (scene object structs: %8.3f ms, %u threads: %8.3f ms)\n", iterateMs, baselineIterateMs, jobThreadCount(), parallelIterateMs);
+  printf("  create:          %8.3f ms\n", createMs);
+  printf("  add component:   %8.3f ms (deferred)\n", addMs);
+  printf("  remove component:%8.3f ms (deferred)\n", removeMs);
+  printf("  destroy:         %8.3f ms (deferred)\n", destroyMs);
+
+  delete[] entities;
+  delete[] sceneObjects;
+  deinitCommandBuffer(&commandBuffer);
+  deinitEcsWorld(&world);
+}
\ No newline at end of file
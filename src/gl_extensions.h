@@ -0,0 +1,33 @@
+#pragma once
+
+// glad was generated for the 3.3 core profile. Entry points from newer versions that we
+// opportunistically use are loaded here by hand. Any of these can be null if the driver
+// does not support them, so always check before calling. Some loaders return entry points
+// the context does not support, so they are only loaded from contexts of the version that
+// introduced them.
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// GL 4.2
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount, GLint baseVertex, GLuint baseInstance);
+// GL 4.3
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC glDrawElementsInstancedBaseVertexBaseInstance = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect = nullptr;
+
+inline bool glVersionAtLeast(s32 major, s32 minor) {
+  return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+// Must be called after gladLoadGLLoader(), which reads the context version
+void loadOpenGLExtensions(GLADloadproc load) {
+  if(glVersionAtLeast(4, 2)) {
+    glDrawElementsInstancedBaseVertexBaseInstance = (PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)load("glDrawElementsInstancedBaseVertexBaseInstance");
+  }
+  if(glVersionAtLeast(4, 3)) {
+    glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+  }
+}
\ No newline at end of file
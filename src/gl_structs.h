@@ -25,15 +25,45 @@ struct Mesh {
   GLuint albedoTextureId;
   GLuint normalTextureId;
   glm::vec4 baseColor;
+  Box boundingBox;
+};
+
+struct Skeleton;
+struct AnimationClip;
+
+// glTF node placed in a TransformHierarchy
+struct ModelNode {
+  u32 transform;
+  s32 meshIndex; // -1 for nodes without a mesh
 };
 
 struct Model {
   Mesh* meshes;
   u32 meshCount;
+  ModelNode* nodes; // only loaded when a TransformHierarchy is passed to loadModel()
+  u32 nodeCount;
+  Skeleton* skeleton; // first glTF skin, nullptr for models without one
+  AnimationClip* animations;
+  u32 animationCount;
   Box boundingBox;
   const char* fileName;
 };
 
+// Common vertex format for geometry in a StaticGeometryPool
+struct StaticVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texCoord;
+};
+
+// Sub-allocated range of a StaticGeometryPool's buffers
+struct StaticMeshRange {
+  u32 firstIndex;
+  u32 indexCount;
+  s32 baseVertex;
+  u32 vertexCount;
+};
+
 /* Uniform buffer objects */
 u32 modelViewProjUBOBindingIndex = 0;
 struct ModelViewProjUBO {  // base alignment   // aligned offset
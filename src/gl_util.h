@@ -25,7 +25,8 @@ void drawTriangles(const VertexAtt& vertexAtt)
 
 void deleteVertexAtts(VertexAtt* vertexAtts, u32 count = 1)
 {
-  u32* deleteBufferObjects = new u32[count * 3];
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* deleteBufferObjects = pushArray(tempMemory.arena, count * 3, u32);
   u32* deleteIndexBufferObjects = deleteBufferObjects + count;
   u32* deleteVertexArrays = deleteIndexBufferObjects + count;
   for(u32 i = 0; i < count; i++) {
@@ -38,5 +39,5 @@ void deleteVertexAtts(VertexAtt* vertexAtts, u32 count = 1)
   glDeleteBuffers(count * 2, deleteBufferObjects);
   glDeleteVertexArrays(count, deleteVertexArrays);
 
-  delete[] deleteBufferObjects;
+  endTempMemory(tempMemory);
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+// Pixel post-processing after decode
+// stb_image hands back tightly packed 8-bit rows. These kernels work on those in place or into a new buffer, 16 bytes
+// at a time where SSE is available and one pixel at a time otherwise. sRGB conversions go through lookup tables,
+// a table lookup per byte is cheaper than any SIMD approximation of the transfer function at 8 bits.
+// sRGB to linear has no pass of its own: GL_SRGB textures are decoded by the GPU, premultiplying is the only CPU side
+// user and it looks up the linear values as it goes. An SSE version that skipped opaque blocks and multiplied in
+// 16-bit lanes still lost to the scalar loop, the lookups dominate either way.
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define IMAGE_SIMD_SSSE3 1
+#define IMAGE_SIMD_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_SIMD_SSSE3 0
+#define IMAGE_SIMD_SSE2 1
+#else
+#define IMAGE_SIMD_SSSE3 0
+#define IMAGE_SIMD_SSE2 0
+#endif
+
+#define SRGB_ENCODE_LUT_SIZE 4096 // linear values are looked up with 12 bits
+
+struct SRGBTables {
+  u16 toLinear[256]; // 8-bit sRGB to 16-bit linear
+  u8 toSRGB[SRGB_ENCODE_LUT_SIZE]; // 12-bit linear to 8-bit sRGB
+};
+
+// Built on first use, thread-safe through the static's guarded initialization
+const SRGBTables& srgbTables() {
+  static const SRGBTables tables = [] {
+    SRGBTables t;
+    for(u32 i = 0; i < 256; ++i) {
+      f64 c = i / 255.0;
+      f64 linear = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+      t.toLinear[i] = (u16)(linear * 65535.0 + 0.5);
+    }
+    for(u32 i = 0; i < SRGB_ENCODE_LUT_SIZE; ++i) {
+      f64 linear = i / (f64)(SRGB_ENCODE_LUT_SIZE - 1);
+      f64 c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055;
+      t.toSRGB[i] = (u8)(c * 255.0 + 0.5);
+    }
+    return t;
+  }();
+  return tables;
+}
+
+// Swaps rows top to bottom in place
+void flipImageRows(u8* pixels, s32 width, s32 height, s32 channels) {
+  memory_index rowSize = (memory_index)width * channels;
+  for(s32 row = 0; row < height / 2; ++row) {
+    u8* top = pixels + (row * rowSize);
+    u8* bottom = pixels + ((height - 1 - row) * rowSize);
+    memory_index i = 0;
+#if IMAGE_SIMD_SSE2
+    for(; i + 16 <= rowSize; i += 16) {
+      __m128i a = _mm_loadu_si128((__m128i*)(top + i));
+      __m128i b = _mm_loadu_si128((__m128i*)(bottom + i));
+      _mm_storeu_si128((__m128i*)(top + i), b);
+      _mm_storeu_si128((__m128i*)(bottom + i), a);
+    }
+#endif
+    for(; i < rowSize; ++i) {
+      u8 swap = top[i];
+      top[i] = bottom[i];
+      bottom[i] = swap;
+    }
+  }
+}
+
+// rgba must hold pixelCount * 4 bytes and may not overlap rgb
+void expandRGBToRGBA(const u8* rgb, u8* rgba, memory_index pixelCount) {
+  memory_index i = 0;
+#if IMAGE_SIMD_SSSE3
+  // 4 pixels per 12 byte step, the 16 byte load reads one pixel ahead so the last few go to the scalar loop
+  const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i opaque = _mm_set1_epi32((s32)0xFF000000);
+  for(; i + 6 <= pixelCount; i += 4) {
+    __m128i source = _mm_loadu_si128((const __m128i*)(rgb + (i * 3)));
+    _mm_storeu_si128((__m128i*)(rgba + (i * 4)), _mm_or_si128(_mm_shuffle_epi8(source, spread), opaque));
+  }
+#endif
+  for(; i < pixelCount; ++i) {
+    rgba[i * 4 + 0] = rgb[i * 3 + 0];
+    rgba[i * 4 + 1] = rgb[i * 3 + 1];
+    rgba[i * 4 + 2] = rgb[i * 3 + 2];
+    rgba[i * 4 + 3] = 255;
+  }
+}
+
+// x * a / 255 rounded, exact for all 8-bit x and a
+inline u8 mulDiv255(u32 x, u32 a) {
+  u32 t = x * a + 128;
+  return (u8)((t + (t >> 8)) >> 8);
+}
+
+// Color channels of RGBA pixels scaled by alpha, treating the stored values as linear
+void premultiplyAlpha(u8* rgba, memory_index pixelCount) {
+  memory_index i = 0;
+#if IMAGE_SIMD_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rounding = _mm_set1_epi16(128);
+  const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+  const __m128i alphaKeep = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+  auto premultiplyHalf = [&](__m128i pixels16) { // two pixels as u16 lanes
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_or_si128(_mm_andnot_si128(alphaLane, alpha), alphaKeep); // alpha * 255 / 255 keeps alpha
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels16, alpha), rounding);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+  };
+  for(; i + 4 <= pixelCount; i += 4) {
+    __m128i pixels = _mm_loadu_si128((__m128i*)(rgba + (i * 4)));
+    __m128i low = premultiplyHalf(_mm_unpacklo_epi8(pixels, zero));
+    __m128i high = premultiplyHalf(_mm_unpackhi_epi8(pixels, zero));
+    _mm_storeu_si128((__m128i*)(rgba + (i * 4)), _mm_packus_epi16(low, high));
+  }
+#endif
+  for(u8* pixel = rgba + (i * 4); pixel != rgba + (pixelCount * 4); pixel += 4) {
+    pixel[0] = mulDiv255(pixel[0], pixel[3]);
+    pixel[1] = mulDiv255(pixel[1], pixel[3]);
+    pixel[2] = mulDiv255(pixel[2], pixel[3]);
+  }
+}
+
+// Premultiplies sRGB encoded RGBA pixels in linear space and encodes the result as sRGB again
+void premultiplyAlphaSRGB(u8* rgba, memory_index pixelCount) {
+  const SRGBTables& tables = srgbTables();
+  for(memory_index i = 0; i < pixelCount; ++i) {
+    u8* pixel = rgba + (i * 4);
+    u32 alpha = pixel[3];
+    if(alpha == 255) { continue; }
+    for(u32 c = 0; c < 3; ++c) {
+      u32 linear = (tables.toLinear[pixel[c]] * alpha + 127) / 255; // 16 bits
+      pixel[c] = tables.toSRGB[linear >> (16 - 12)];
+    }
+  }
+}
\ No newline at end of file
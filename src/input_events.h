@@ -0,0 +1,328 @@
+#pragma once
+
+// Input events
+// The platform layer timestamps every key, mouse, gamepad axis and quit event with getPerformanceCounter() the moment it reaches
+// the application and pushes it into a ring. The main thread pumps while it waits on the render thread, so events are
+// stamped within about a millisecond of arriving rather than all at the next poll. Producers (normally only the main
+// thread, but SDL_PushEvent() works from any thread) serialize on a spin lock, the consumer never blocks.
+// Once per frame the ring is drained into an InputEventFrame, so consumers can see everything that happened between two frames in order:
+// taps shorter than a frame, how long within the frame a key was held, and mouse motion for any sub-interval.
+// Keys are identified by scancode, which covers the whole keyboard rather than just the keys bound to actions.
+// Recordings serialize drained frames so a session's input can be played back exactly, replays (replay.h) are
+// recordings that also store a fixed size block of their own data with every frame.
+
+#define INPUT_EVENT_RING_SIZE 1024 // power of two
+#define INPUT_FRAME_MAX_EVENTS 256
+#define INPUT_KEY_COUNT 512 // scancodes
+#define INPUT_RECORDING_MAGIC 0x45494E42 // "BNIE"
+#define INPUT_RECORDING_VERSION 2 // 2: per frame data, keys bound by scancode
+#define INPUT_RECORDING_MAX_FRAME_DATA_SIZE 1024
+
+enum InputEventType : u16 {
+  InputEvent_KeyDown,
+  InputEvent_KeyUp,
+  InputEvent_MouseMotion, // x, y relative motion, positive y is up
+  InputEvent_MouseButtonDown, // code is the button
+  InputEvent_MouseButtonUp,
+  InputEvent_MouseWheel, // x, y scroll amount
+  InputEvent_Quit,
+  InputEvent_GamepadAxisDown, // code is the axis direction that moved past the dead zone, x the axis value
+  InputEvent_GamepadAxisUp, // code is the axis direction that moved back inside the dead zone
+};
+
+struct InputEvent {
+  u64 perfCounter;
+  InputEventType type;
+  u16 scancode;
+  s32 code; // platform key code for key events, button for mouse button events, axis direction for gamepad axis events
+  s32 x;
+  s32 y;
+};
+
+struct InputEventRing {
+  InputEvent events[INPUT_EVENT_RING_SIZE];
+  std::atomic<u32> writeIndex; // only written by producers holding pushLock
+  std::atomic<u32> readIndex; // only written by the consumer
+  std::atomic<u32> droppedCount;
+  std::atomic_flag pushLock = ATOMIC_FLAG_INIT;
+};
+
+// Events that arrived after the previous frame's events were drained, up until endCounter
+struct InputEventFrame {
+  InputEvent events[INPUT_FRAME_MAX_EVENTS];
+  u32 eventCount;
+  u32 droppedCount; // lost to a full ring or a full frame
+  u64 beginCounter;
+  u64 endCounter;
+};
+
+struct KeyboardState {
+  u64 downBits[INPUT_KEY_COUNT / 64];
+};
+
+inline void initInputEventFrame(InputEventFrame* frame) {
+  frame->eventCount = 0;
+  frame->droppedCount = 0;
+  frame->beginCounter = frame->endCounter = getPerformanceCounter();
+}
+
+// Producer side, safe from any thread. False when the ring is full and the event was dropped.
+bool pushInputEvent(InputEventRing* ring, const InputEvent& event) {
+  while(ring->pushLock.test_and_set(std::memory_order_acquire)) {}
+  u32 writeIndex = ring->writeIndex.load(std::memory_order_relaxed);
+  u32 readIndex = ring->readIndex.load(std::memory_order_acquire);
+  bool pushed = writeIndex - readIndex < INPUT_EVENT_RING_SIZE;
+  if(pushed) {
+    ring->events[writeIndex & (INPUT_EVENT_RING_SIZE - 1)] = event;
+    ring->writeIndex.store(writeIndex + 1, std::memory_order_release);
+  } else {
+    ring->droppedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  ring->pushLock.clear(std::memory_order_release);
+  return pushed;
+}
+
+// Consumer side, moves every queued event into the frame. Events that do not fit stay queued for the next frame.
+void drainInputEvents(InputEventRing* ring, InputEventFrame* frame, u64 endCounter) {
+  frame->beginCounter = frame->endCounter;
+  frame->endCounter = endCounter;
+  frame->eventCount = 0;
+  frame->droppedCount = ring->droppedCount.exchange(0, std::memory_order_relaxed);
+
+  u32 readIndex = ring->readIndex.load(std::memory_order_relaxed);
+  u32 writeIndex = ring->writeIndex.load(std::memory_order_acquire);
+  u32 count = Min(writeIndex - readIndex, (u32)INPUT_FRAME_MAX_EVENTS);
+  for(u32 i = 0; i < count; ++i) {
+    frame->events[i] = ring->events[(readIndex + i) & (INPUT_EVENT_RING_SIZE - 1)];
+  }
+  frame->eventCount = count;
+  ring->readIndex.store(readIndex + count, std::memory_order_release);
+}
+
+inline bool keyDown(const KeyboardState& state, u16 scancode) {
+  return (state.downBits[scancode / 64] >> (scancode % 64)) & 1;
+}
+
+inline void setKeyDown(KeyboardState* state, u16 scancode, bool down) {
+  u64 bit = 1ull << (scancode % 64);
+  if(down) {
+    state->downBits[scancode / 64] |= bit;
+  } else {
+    state->downBits[scancode / 64] &= ~bit;
+  }
+}
+
+void updateKeyboardState(KeyboardState* state, const InputEventFrame& frame) {
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    const InputEvent& event = frame.events[i];
+    if(event.type == InputEvent_KeyDown || event.type == InputEvent_KeyUp) {
+      setKeyDown(state, event.scancode, event.type == InputEvent_KeyDown);
+    }
+  }
+}
+
+// Pressed and released again within the frame, which a once per frame snapshot of key states never sees
+bool keyTappedInFrame(const InputEventFrame& frame, u16 scancode) {
+  bool pressed = false;
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    const InputEvent& event = frame.events[i];
+    if(event.scancode != scancode) { continue; }
+    if(event.type == InputEvent_KeyDown) { pressed = true; }
+    else if(event.type == InputEvent_KeyUp && pressed) { return true; }
+  }
+  return false;
+}
+
+// Portion of the frame [0, 1] the key spent down. downAtBegin is the key's state before this frame's events.
+f32 keyHeldFraction(const InputEventFrame& frame, u16 scancode, bool downAtBegin) {
+  if(frame.endCounter <= frame.beginCounter) { return downAtBegin ? 1.0f : 0.0f; }
+  bool down = downAtBegin;
+  u64 downSince = frame.beginCounter;
+  u64 heldCounter = 0;
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    const InputEvent& event = frame.events[i];
+    if(event.scancode != scancode || (event.type != InputEvent_KeyDown && event.type != InputEvent_KeyUp)) { continue; }
+    u64 eventCounter = Clamp(event.perfCounter, frame.beginCounter, frame.endCounter);
+    if(event.type == InputEvent_KeyDown && !down) {
+      down = true;
+      downSince = eventCounter;
+    } else if(event.type == InputEvent_KeyUp && down) {
+      down = false;
+      heldCounter += eventCounter - downSince;
+    }
+  }
+  if(down) { heldCounter += frame.endCounter - downSince; }
+  return (f32)((f64)heldCounter / (f64)(frame.endCounter - frame.beginCounter));
+}
+
+// Relative mouse motion that arrived within [beginCounter, endCounter), for stepping a frame in smaller pieces
+void mouseMotionBetween(const InputEventFrame& frame, u64 beginCounter, u64 endCounter, s32* outX, s32* outY) {
+  *outX = 0;
+  *outY = 0;
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    const InputEvent& event = frame.events[i];
+    if(event.type == InputEvent_MouseMotion && event.perfCounter >= beginCounter && event.perfCounter < endCounter) {
+      *outX += event.x;
+      *outY += event.y;
+    }
+  }
+}
+
+// Recording
+// File: header, then per frame an InputRecordingFrame followed by its events and frameDataSize bytes of frame data.
+// Counters are relative to the first recorded frame's beginCounter so recordings do not depend on the machine's clock.
+struct InputRecordingHeader {
+  u32 magic;
+  u32 version;
+  u64 perfCounterFrequency;
+  u32 frameCount;
+  u32 eventSize;
+  u32 frameDataSize;
+  u32 padding;
+};
+
+struct InputRecordingFrame {
+  u64 beginCounter;
+  u64 endCounter;
+  u32 eventCount;
+  u32 droppedCount;
+};
+
+struct InputEventRecording {
+  u8* data;
+  u64 size;
+  u64 capacity;
+  u32 frameCount;
+  u32 frameDataSize;
+  u64 baseCounter;
+};
+
+struct InputEventPlayback {
+  FILE_HANDLE file;
+  const u8* cursor;
+  const u8* end;
+  u64 perfCounterFrequency;
+  u32 frameCount;
+  u32 frameIndex;
+  u32 frameDataSize;
+};
+
+void initInputEventRecording(InputEventRecording* recording, u32 frameDataSize = 0, u64 capacity = Megabytes(1)) {
+  assert(frameDataSize <= INPUT_RECORDING_MAX_FRAME_DATA_SIZE);
+  recording->data = new u8[capacity];
+  recording->capacity = capacity;
+  recording->size = sizeof(InputRecordingHeader);
+  recording->frameCount = 0;
+  recording->frameDataSize = frameDataSize;
+  recording->baseCounter = 0;
+}
+
+void deinitInputEventRecording(InputEventRecording* recording) {
+  delete[] recording->data;
+  *recording = {}; // clear to zero
+}
+
+internal void appendRecordingBytes(InputEventRecording* recording, const void* bytes, u64 size) {
+  if(recording->size + size > recording->capacity) {
+    u64 newCapacity = Max(recording->capacity * 2, recording->size + size);
+    u8* newData = new u8[newCapacity];
+    memcpy(newData, recording->data, recording->size);
+    delete[] recording->data;
+    recording->data = newData;
+    recording->capacity = newCapacity;
+  }
+  memcpy(recording->data + recording->size, bytes, size);
+  recording->size += size;
+}
+
+// frameData must point at the recording's frameDataSize bytes, or be null when it has none
+void recordInputEventFrame(InputEventRecording* recording, const InputEventFrame& frame, const void* frameData = nullptr) {
+  assert((frameData != nullptr) == (recording->frameDataSize > 0) && "ERROR: Frame data does not match the recording!");
+  if(recording->frameCount == 0) { recording->baseCounter = frame.beginCounter; }
+  InputRecordingFrame recordedFrame{ frame.beginCounter - recording->baseCounter, frame.endCounter - recording->baseCounter,
+                                     frame.eventCount, frame.droppedCount };
+  appendRecordingBytes(recording, &recordedFrame, sizeof(recordedFrame));
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    InputEvent event = frame.events[i];
+    event.perfCounter -= recording->baseCounter;
+    appendRecordingBytes(recording, &event, sizeof(event));
+  }
+  if(recording->frameDataSize > 0) {
+    appendRecordingBytes(recording, frameData, recording->frameDataSize);
+  }
+  recording->frameCount++;
+}
+
+bool saveInputEventRecording(InputEventRecording* recording, const char* fileName) {
+  InputRecordingHeader header{ INPUT_RECORDING_MAGIC, INPUT_RECORDING_VERSION, getPerformanceCounterFrequencyPerSecond(),
+                               recording->frameCount, sizeof(InputEvent), recording->frameDataSize, 0 };
+  memcpy(recording->data, &header, sizeof(header));
+  return writeFile(fileName, recording->data, recording->size);
+}
+
+bool openInputEventPlayback(InputEventPlayback* playback, const char* fileName) {
+  size_t fileSize;
+  if(!openFile(fileName, &playback->file, &fileSize)) { return false; }
+  const u8* bytes = (const u8*)fileBytes(playback->file);
+  InputRecordingHeader header;
+  if(fileSize < sizeof(header)) {
+    closeFile(playback->file);
+    return false;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  if(header.magic != INPUT_RECORDING_MAGIC || header.version != INPUT_RECORDING_VERSION || header.eventSize != sizeof(InputEvent) ||
+     header.frameDataSize > INPUT_RECORDING_MAX_FRAME_DATA_SIZE || header.perfCounterFrequency == 0) {
+    printf("Input recording %s is not a version %u recording\n", fileName, INPUT_RECORDING_VERSION);
+    closeFile(playback->file);
+    return false;
+  }
+  playback->cursor = bytes + sizeof(header);
+  playback->end = bytes + fileSize;
+  playback->perfCounterFrequency = header.perfCounterFrequency;
+  playback->frameCount = header.frameCount;
+  playback->frameIndex = 0;
+  playback->frameDataSize = header.frameDataSize;
+  return true;
+}
+
+void closeInputEventPlayback(InputEventPlayback* playback) {
+  closeFile(playback->file);
+  *playback = {}; // clear to zero
+}
+
+internal bool inputRecordingCorrupt(const InputEventPlayback& playback) {
+  printf("Input recording is corrupt at frame %u of %u, stopping playback\n", playback.frameIndex, playback.frameCount);
+  return false;
+}
+
+// False once every recorded frame has been played, or at the first frame that does not hold together.
+// outFrameData points into the recording at the frame's data, null when the recording has none.
+bool nextInputEventFrame(InputEventPlayback* playback, InputEventFrame* outFrame, const u8** outFrameData = nullptr) {
+  InputRecordingFrame recordedFrame;
+  if(playback->frameIndex == playback->frameCount) { return false; }
+  if((u64)(playback->end - playback->cursor) < sizeof(recordedFrame)) { return inputRecordingCorrupt(*playback); }
+  memcpy(&recordedFrame, playback->cursor, sizeof(recordedFrame));
+  u64 eventBytes = (u64)recordedFrame.eventCount * sizeof(InputEvent);
+  u64 remainingBytes = (u64)(playback->end - playback->cursor) - sizeof(recordedFrame);
+  if(recordedFrame.eventCount > INPUT_FRAME_MAX_EVENTS || remainingBytes < eventBytes + playback->frameDataSize) {
+    return inputRecordingCorrupt(*playback);
+  }
+  playback->cursor += sizeof(recordedFrame);
+  memcpy(outFrame->events, playback->cursor, eventBytes);
+  playback->cursor += eventBytes;
+  if(outFrameData != nullptr) {
+    *outFrameData = playback->frameDataSize > 0 ? playback->cursor : nullptr;
+  }
+  playback->cursor += playback->frameDataSize;
+  for(u32 i = 0; i < recordedFrame.eventCount; ++i) {
+    const InputEvent& event = outFrame->events[i];
+    bool keyEvent = event.type == InputEvent_KeyDown || event.type == InputEvent_KeyUp;
+    if(event.type > InputEvent_GamepadAxisUp || (keyEvent && event.scancode >= INPUT_KEY_COUNT)) { return inputRecordingCorrupt(*playback); }
+  }
+  outFrame->eventCount = recordedFrame.eventCount;
+  outFrame->droppedCount = recordedFrame.droppedCount;
+  outFrame->beginCounter = recordedFrame.beginCounter;
+  outFrame->endCounter = recordedFrame.endCounter;
+  playback->frameIndex++;
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#pragma once
+
+// Input actions
+// Gameplay asks about named actions instead of keys. The default bindings in InputBinding.incl are resolved at compile
+// time into tables indexed by scancode, mouse button and gamepad axis direction, each entry holding the mask of actions
+// bound to it, so an event becomes action state with a single table load. Rebinding at runtime edits the same tables.
+// Gamepad axes act as two buttons each, one per direction, held while the axis is past the dead zone in that direction.
+
+#define INPUT_MOUSE_BUTTON_COUNT 8
+#define INPUT_GAMEPAD_AXIS_COUNT 12 // two directions for each SDL game controller axis
+#define GamepadAxisNegative(axis) ((axis) * 2)
+#define GamepadAxisPositive(axis) ((axis) * 2 + 1)
+
+enum InputAction {
+#define InputAction(name,index) name = 1 << index,
+#include "InputAction.incl"
+#undef InputAction
+};
+
+const InputAction inputActions[] = {
+#define InputAction(name,index) InputAction::name,
+#include "InputAction.incl"
+#undef InputAction
+};
+
+const char* inputActionNames[] = {
+#define InputAction(name,index) #name,
+#include "InputAction.incl"
+#undef InputAction
+};
+
+static_assert(ArrayCount(inputActions) <= sizeof(b32) * 8, "ERROR: Input actions must fit in a b32!");
+
+enum InputDevice : u8 {
+  InputDevice_Key, // code is a scancode
+  InputDevice_MouseButton, // code is the button
+  InputDevice_GamepadAxis, // code is the axis direction, see GamepadAxisNegative()/GamepadAxisPositive()
+};
+
+struct InputMap {
+  b32 keyActions[INPUT_KEY_COUNT];
+  b32 mouseButtonActions[INPUT_MOUSE_BUTTON_COUNT];
+  b32 gamepadAxisActions[INPUT_GAMEPAD_AXIS_COUNT];
+};
+
+struct InputState {
+  b32 down; // actions
+  b32 activated;
+  b32 released;
+  s32 mouseDeltaX;
+  s32 mouseDeltaY; // positive is up, negative is down
+  bool quit;
+  KeyboardState keys; // every scancode, bound or not
+  u32 mouseButtonsDown;
+  u32 gamepadAxesDown; // axis directions past the dead zone
+};
+
+// Table entry of the binding, null when the code is out of range for the device
+constexpr b32* inputBindingActions(InputMap* map, InputDevice device, u16 code) {
+  switch(device) {
+    case InputDevice_Key:
+      assert(code < INPUT_KEY_COUNT && "ERROR: Scancode out of range!");
+      return code < INPUT_KEY_COUNT ? &map->keyActions[code] : nullptr;
+    case InputDevice_MouseButton:
+      assert(code < INPUT_MOUSE_BUTTON_COUNT && "ERROR: Mouse button out of range!");
+      return code < INPUT_MOUSE_BUTTON_COUNT ? &map->mouseButtonActions[code] : nullptr;
+    case InputDevice_GamepadAxis:
+      assert(code < INPUT_GAMEPAD_AXIS_COUNT && "ERROR: Gamepad axis out of range!");
+      return code < INPUT_GAMEPAD_AXIS_COUNT ? &map->gamepadAxisActions[code] : nullptr;
+  }
+  return nullptr;
+}
+
+constexpr void bindInput(InputMap* map, InputAction action, InputDevice device, u16 code) {
+  b32* actions = inputBindingActions(map, device, code);
+  if(actions != nullptr) { *actions |= action; }
+}
+
+constexpr InputMap defaultInputMap() {
+  InputMap map{};
+#define InputBinding(action,device,code) bindInput(&map, InputAction::action, device, code);
+#include "InputBinding.incl"
+#undef InputBinding
+  return map;
+}
+
+global constinit InputMap inputMap = defaultInputMap();
+
+void unbindInput(InputMap* map, InputAction action, InputDevice device, u16 code) {
+  b32* actions = inputBindingActions(map, device, code);
+  if(actions != nullptr) { clearFlags(actions, action); }
+}
+
+void clearInputBindings(InputMap* map, InputAction action) {
+  for(u32 i = 0; i < INPUT_KEY_COUNT; ++i) { clearFlags(&map->keyActions[i], action); }
+  for(u32 i = 0; i < INPUT_MOUSE_BUTTON_COUNT; ++i) { clearFlags(&map->mouseButtonActions[i], action); }
+  for(u32 i = 0; i < INPUT_GAMEPAD_AXIS_COUNT; ++i) { clearFlags(&map->gamepadAxisActions[i], action); }
+}
+
+// Replaces every binding of the action with this one
+void rebindInput(InputMap* map, InputAction action, InputDevice device, u16 code) {
+  clearInputBindings(map, action);
+  bindInput(map, action, device, code);
+}
+
+// False if nothing is bound to the action, keys are reported before mouse buttons, mouse buttons before gamepad axes
+bool firstInputBinding(const InputMap& map, InputAction action, OUT InputDevice* outDevice, OUT u16* outCode) {
+  for(u32 i = 0; i < INPUT_KEY_COUNT; ++i) {
+    if(flagIsSet(map.keyActions[i], action)) {
+      *outDevice = InputDevice_Key;
+      *outCode = (u16)i;
+      return true;
+    }
+  }
+  for(u32 i = 0; i < INPUT_MOUSE_BUTTON_COUNT; ++i) {
+    if(flagIsSet(map.mouseButtonActions[i], action)) {
+      *outDevice = InputDevice_MouseButton;
+      *outCode = (u16)i;
+      return true;
+    }
+  }
+  for(u32 i = 0; i < INPUT_GAMEPAD_AXIS_COUNT; ++i) {
+    if(flagIsSet(map.gamepadAxisActions[i], action)) {
+      *outDevice = InputDevice_GamepadAxis;
+      *outCode = (u16)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* inputBindingName(const InputMap& map, InputAction action) {
+  InputDevice device;
+  u16 code;
+  if(!firstInputBinding(map, action, &device, &code)) { return "Unbound"; }
+  switch(device) {
+    case InputDevice_Key: return scancodeName(code);
+    case InputDevice_MouseButton: return mouseButtonName((u8)code);
+    case InputDevice_GamepadAxis: return gamepadAxisName((u8)code);
+  }
+  return "Unbound";
+}
+
+// Actions bound to any key, mouse button or gamepad axis direction that is currently down
+b32 heldInputActions(const InputMap& map, const InputState& state) {
+  b32 actions = 0;
+  for(u32 word = 0; word < ArrayCount(state.keys.downBits); ++word) {
+    for(u64 bits = state.keys.downBits[word]; bits != 0; bits &= bits - 1) {
+      actions |= map.keyActions[(word * 64) + std::countr_zero(bits)];
+    }
+  }
+  for(u32 bits = state.mouseButtonsDown; bits != 0; bits &= bits - 1) {
+    actions |= map.mouseButtonActions[std::countr_zero(bits)];
+  }
+  for(u32 bits = state.gamepadAxesDown; bits != 0; bits &= bits - 1) {
+    actions |= map.gamepadAxisActions[std::countr_zero(bits)];
+  }
+  return actions;
+}
+
+// Actions bound to the key, mouse button or gamepad axis direction of the event, zero for any other event
+inline b32 inputEventActions(const InputMap& map, const InputEvent& event) {
+  switch(event.type) {
+    case InputEvent_KeyDown:
+    case InputEvent_KeyUp:
+      return map.keyActions[event.scancode];
+    case InputEvent_MouseButtonDown:
+    case InputEvent_MouseButtonUp:
+      return (u32)event.code < INPUT_MOUSE_BUTTON_COUNT ? map.mouseButtonActions[event.code] : 0;
+    case InputEvent_GamepadAxisDown:
+    case InputEvent_GamepadAxisUp:
+      return (u32)event.code < INPUT_GAMEPAD_AXIS_COUNT ? map.gamepadAxisActions[event.code] : 0;
+    default:
+      return 0;
+  }
+}
+
+// Portion of the frame [0, 1] the action spent down, see keyHeldFraction(). A binding released while another binding
+// of the action was also held since before the frame ends the hold early.
+f32 actionHeldFraction(const InputEventFrame& frame, const InputMap& map, InputAction action, bool downAtBegin) {
+  if(frame.endCounter <= frame.beginCounter) { return downAtBegin ? 1.0f : 0.0f; }
+  u32 heldBindings = downAtBegin ? 1 : 0;
+  u64 downSince = frame.beginCounter;
+  u64 heldCounter = 0;
+  for(u32 i = 0; i < frame.eventCount; ++i) {
+    const InputEvent& event = frame.events[i];
+    if(!flagIsSet(inputEventActions(map, event), action)) { continue; }
+    u64 eventCounter = Clamp(event.perfCounter, frame.beginCounter, frame.endCounter);
+    if(event.type == InputEvent_KeyDown || event.type == InputEvent_MouseButtonDown || event.type == InputEvent_GamepadAxisDown) {
+      if(heldBindings++ == 0) { downSince = eventCounter; }
+    } else if(heldBindings > 0 && --heldBindings == 0) {
+      heldCounter += eventCounter - downSince;
+    }
+  }
+  if(heldBindings > 0) { heldCounter += frame.endCounter - downSince; }
+  return (f32)((f64)heldCounter / (f64)(frame.endCounter - frame.beginCounter));
+}
\ No newline at end of file
@@ -0,0 +1,377 @@
+#pragma once
+
+// Job system
+// The main thread plus one worker thread per remaining core. Every thread owns a Chase-Lev deque: it pushes
+// and pops its own jobs at the bottom while idle threads steal from the top. Completion is tracked with
+// JobCounters, and waiting on a counter runs other jobs rather than blocking the thread. Threads outside of the job
+// system, like the render thread, have no deque. Their jobs go through a locked injection queue instead.
+// Every thread works with one job system at a time, the global one unless it is a thread of another instance.
+// source: "Correct and Efficient Work-Stealing for Weak Memory Models", Lê, Pop, Cohen & Zappa Nardelli 2013
+
+#define JOB_DEQUE_CAPACITY 4096 // power of two, pushing more unfinished jobs from one thread first helps finish the oldest
+#define JOB_MAX_THREAD_COUNT 64
+#define JOB_IDLE_SPIN_COUNT 128
+#define JOB_THREAD_INDEX_NONE 0xFFFFFFFF // threads without a deque
+
+typedef void (*JobFunction)(void* data);
+
+// value is the number of unfinished jobs
+struct JobCounter {
+  std::atomic<s32> value{0};
+};
+
+struct Job {
+  JobFunction function;
+  void* data;
+  JobCounter* counter;
+  std::atomic<bool> inFlight;
+};
+
+struct JobDeque {
+  alignas(64) std::atomic<s64> top; // stealing end
+  alignas(64) std::atomic<s64> bottom; // owner end
+  std::atomic<Job*> jobs[JOB_DEQUE_CAPACITY];
+  Job jobPool[JOB_DEQUE_CAPACITY]; // storage for the jobs this thread pushes, used round robin
+  u32 nextPoolIndex;
+};
+
+// Jobs pushed by threads without a deque, taken by any thread
+struct JobInjectionQueue {
+  std::mutex mutex;
+  std::atomic<u32> count; // read without the lock to skip it while empty
+  u32 head; // next to take
+  Job* jobs[JOB_DEQUE_CAPACITY];
+  Job jobPool[JOB_DEQUE_CAPACITY];
+  u32 nextPoolIndex;
+};
+
+struct JobSystem {
+  JobDeque* deques;
+  JobInjectionQueue* injectedJobs;
+  std::thread* workers;
+  u32 threadCount; // including the main thread, 0 when jobs run inline
+  std::atomic<bool> running;
+  std::atomic<s32> queuedJobCount; // pushed but not yet taken, used to put idle workers to sleep
+  std::mutex sleepMutex;
+  std::condition_variable sleepCondition;
+  JobSystem* callerPreviousSystem; // restored on the initializing thread by deinitJobSystem()
+  u32 callerPreviousThreadIndex;
+};
+
+global JobSystem jobSystem;
+thread_local JobSystem* threadJobSystem = &jobSystem;
+thread_local u32 jobThreadIndex = JOB_THREAD_INDEX_NONE; // in threadJobSystem, the initializing thread is 0
+
+internal void pushJob(JobDeque* deque, Job* job) {
+  s64 bottom = deque->bottom.load(std::memory_order_relaxed);
+  assert(bottom - deque->top.load(std::memory_order_acquire) < JOB_DEQUE_CAPACITY && "ERROR: Job deque is full!");
+  deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+  deque->bottom.store(bottom + 1, std::memory_order_release); // publishes the job to stealers
+}
+
+internal Job* popJob(JobDeque* deque) {
+  s64 bottom = deque->bottom.load(std::memory_order_relaxed) - 1;
+  deque->bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  s64 top = deque->top.load(std::memory_order_relaxed);
+  if(top > bottom) { // empty
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  Job* job = deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+  if(top == bottom) { // last job, race stealers for it
+    if(!deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+internal Job* stealJob(JobDeque* deque) {
+  s64 top = deque->top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  s64 bottom = deque->bottom.load(std::memory_order_acquire);
+  if(top >= bottom) {
+    return nullptr;
+  }
+  Job* job = deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+  if(!deque->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr; // lost to the owner or another thief
+  }
+  return job;
+}
+
+// Pool slots are reused round robin, the next one may still be running from JOB_DEQUE_CAPACITY pushes ago
+internal bool poolJobFree(const Job* jobPool, u32 nextPoolIndex) {
+  return !jobPool[nextPoolIndex & (JOB_DEQUE_CAPACITY - 1)].inFlight.load(std::memory_order_acquire);
+}
+
+// Next job slot of a thread's pool, callers wait for poolJobFree() first
+internal Job* claimPoolJob(Job* jobPool, u32* nextPoolIndex, JobFunction function, void* data, JobCounter* counter) {
+  Job* job = jobPool + ((*nextPoolIndex)++ & (JOB_DEQUE_CAPACITY - 1));
+  assert(!job->inFlight.load(std::memory_order_acquire) && "ERROR: Too many unfinished jobs pushed from one thread!");
+  job->function = function;
+  job->data = data;
+  job->counter = counter;
+  job->inFlight.store(true, std::memory_order_relaxed);
+  return job;
+}
+
+internal bool runNextJob();
+
+// Helps run jobs while the queue is full or its next pool slot is still running
+internal void injectJob(JobInjectionQueue* queue, JobFunction function, void* data, JobCounter* counter) {
+  for(;;) {
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      u32 count = queue->count.load(std::memory_order_relaxed);
+      if(count < JOB_DEQUE_CAPACITY && poolJobFree(queue->jobPool, queue->nextPoolIndex)) {
+        queue->jobs[(queue->head + count) & (JOB_DEQUE_CAPACITY - 1)] = claimPoolJob(queue->jobPool, &queue->nextPoolIndex, function, data, counter);
+        queue->count.store(count + 1, std::memory_order_relaxed);
+        return;
+      }
+    }
+    if(!runNextJob()) { std::this_thread::yield(); }
+  }
+}
+
+internal Job* takeInjectedJob(JobInjectionQueue* queue) {
+  if(queue->count.load(std::memory_order_relaxed) == 0) { return nullptr; }
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  u32 count = queue->count.load(std::memory_order_relaxed);
+  if(count == 0) { return nullptr; }
+  Job* job = queue->jobs[queue->head++ & (JOB_DEQUE_CAPACITY - 1)];
+  queue->count.store(count - 1, std::memory_order_relaxed);
+  return job;
+}
+
+internal void executeJob(Job* job) {
+  JobSystem* system = threadJobSystem;
+  system->queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+  job->function(job->data);
+  JobCounter* counter = job->counter;
+  job->inFlight.store(false, std::memory_order_release);
+  counter->value.fetch_sub(1, std::memory_order_release);
+}
+
+// Runs one job from this thread's deque, stolen from another thread or injected, returns false if none were found.
+// Threads without a deque can only steal.
+internal bool runNextJob() {
+  JobSystem* system = threadJobSystem;
+  bool ownsDeque = jobThreadIndex != JOB_THREAD_INDEX_NONE;
+  u32 firstVictim = ownsDeque ? jobThreadIndex : 0;
+  Job* job = ownsDeque ? popJob(system->deques + jobThreadIndex) : nullptr;
+  for(u32 i = ownsDeque ? 1 : 0; job == nullptr && i < system->threadCount; ++i) {
+    job = stealJob(system->deques + ((firstVictim + i) % system->threadCount));
+  }
+  if(job == nullptr) {
+    job = takeInjectedJob(system->injectedJobs);
+  }
+  if(job == nullptr) {
+    return false;
+  }
+  executeJob(job);
+  return true;
+}
+
+internal void jobWorkerMain(JobSystem* system, u32 threadIndex) {
+  threadJobSystem = system;
+  jobThreadIndex = threadIndex;
+  u32 idleSpins = 0;
+  while(system->running.load(std::memory_order_acquire)) {
+    if(runNextJob()) {
+      idleSpins = 0;
+    } else if(++idleSpins < JOB_IDLE_SPIN_COUNT) {
+      std::this_thread::yield();
+    } else {
+      std::unique_lock<std::mutex> lock(system->sleepMutex);
+      system->sleepCondition.wait_for(lock, std::chrono::milliseconds(2), [system]() {
+        return system->queuedJobCount.load(std::memory_order_relaxed) > 0 || !system->running.load(std::memory_order_relaxed);
+      });
+      idleSpins = 0;
+    }
+  }
+}
+
+// threadCount includes the calling thread, which becomes thread 0 of the system until deinitJobSystem().
+// 0 means one thread per core. Systems other than the global one are separate pools, e.g. for benchmarks.
+void initJobSystem(u32 threadCount = 0, JobSystem* system = &jobSystem) {
+  if(threadCount == 0) {
+    threadCount = Max(std::thread::hardware_concurrency(), 1u);
+  }
+  threadCount = Min(threadCount, (u32)JOB_MAX_THREAD_COUNT);
+  system->deques = new JobDeque[threadCount];
+  for(u32 i = 0; i < threadCount; ++i) {
+    JobDeque& deque = system->deques[i];
+    deque.top.store(0);
+    deque.bottom.store(0);
+    deque.nextPoolIndex = 0;
+    for(u32 j = 0; j < JOB_DEQUE_CAPACITY; ++j) { deque.jobPool[j].inFlight.store(false); }
+  }
+  system->injectedJobs = new JobInjectionQueue;
+  system->injectedJobs->count.store(0);
+  system->injectedJobs->head = 0;
+  system->injectedJobs->nextPoolIndex = 0;
+  for(u32 j = 0; j < JOB_DEQUE_CAPACITY; ++j) { system->injectedJobs->jobPool[j].inFlight.store(false); }
+  system->threadCount = threadCount;
+  system->queuedJobCount.store(0);
+  system->running.store(true);
+  system->callerPreviousSystem = threadJobSystem;
+  system->callerPreviousThreadIndex = jobThreadIndex;
+  threadJobSystem = system;
+  jobThreadIndex = 0;
+  system->workers = new std::thread[threadCount - 1];
+  for(u32 i = 1; i < threadCount; ++i) {
+    system->workers[i - 1] = std::thread(jobWorkerMain, system, i);
+  }
+}
+
+// Expects every job to have been waited on, called on the thread that initialized the system
+void deinitJobSystem(JobSystem* system = &jobSystem) {
+  assert(threadJobSystem == system && jobThreadIndex == 0 && "ERROR: Job system deinitialized by a thread other than its thread 0!");
+  system->running.store(false, std::memory_order_release);
+  system->sleepCondition.notify_all();
+  for(u32 i = 0; i + 1 < system->threadCount; ++i) {
+    system->workers[i].join();
+  }
+  delete[] system->workers;
+  delete[] system->deques;
+  delete system->injectedJobs;
+  system->workers = nullptr;
+  system->deques = nullptr;
+  system->injectedJobs = nullptr;
+  system->threadCount = 0;
+  threadJobSystem = system->callerPreviousSystem;
+  jobThreadIndex = system->callerPreviousThreadIndex;
+}
+
+inline u32 jobThreadCount() { return Max(threadJobSystem->threadCount, 1u); }
+
+// Jobs run inline when the job system is not initialized. Safe to call from any thread.
+void runJob(JobFunction function, void* data, JobCounter* counter) {
+  JobSystem* system = threadJobSystem;
+  counter->value.fetch_add(1, std::memory_order_relaxed);
+  if(system->threadCount == 0) {
+    function(data);
+    counter->value.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+
+  system->queuedJobCount.fetch_add(1, std::memory_order_relaxed);
+  if(jobThreadIndex == JOB_THREAD_INDEX_NONE) {
+    injectJob(system->injectedJobs, function, data, counter);
+  } else {
+    JobDeque* deque = system->deques + jobThreadIndex;
+    while(!poolJobFree(deque->jobPool, deque->nextPoolIndex)) { // the deque can't be full while the slot is free
+      if(!runNextJob()) { std::this_thread::yield(); }
+    }
+    pushJob(deque, claimPoolJob(deque->jobPool, &deque->nextPoolIndex, function, data, counter));
+  }
+  system->sleepCondition.notify_one();
+}
+
+// Helps run jobs until the counter reaches zero
+void waitForCounter(JobCounter* counter) {
+  JobSystem* system = threadJobSystem;
+  while(counter->value.load(std::memory_order_acquire) > 0) {
+    if(system->threadCount == 0 || !runNextJob()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Calls body(begin, end) over [0, count) in batches of batchSize indices (or a multiple of it) and waits for all of them
+template <typename Body>
+void parallelFor(u32 count, u32 batchSize, const Body& body) {
+  if(count == 0) { return; }
+  struct Batch {
+    const Body* body;
+    u32 begin;
+    u32 end;
+  };
+  // batches grow by whole multiples when there would be too many for the deque
+  u32 minBatchSize = (count + (JOB_DEQUE_CAPACITY / 2) - 1) / (JOB_DEQUE_CAPACITY / 2);
+  batchSize = Max(batchSize, 1u);
+  batchSize *= (minBatchSize + batchSize - 1) / batchSize;
+  u32 batchCount = (count + batchSize - 1) / batchSize;
+  if(batchCount == 1 || threadJobSystem->threadCount <= 1) {
+    body(0u, count);
+    return;
+  }
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Batch* batches = pushArray(tempMemory.arena, batchCount, Batch);
+  JobCounter counter;
+  for(u32 i = 0; i < batchCount; ++i) {
+    batches[i].body = &body;
+    batches[i].begin = i * batchSize;
+    batches[i].end = Min(batches[i].begin + batchSize, count);
+    runJob([](void* data) {
+      Batch* batch = (Batch*)data;
+      (*batch->body)(batch->begin, batch->end);
+    }, batches + i, &counter);
+  }
+  waitForCounter(&counter);
+  endTempMemory(tempMemory);
+}
+
+// Runs the same workloads with 1 to N threads, results are printed to stdout.
+// Runs on its own job system, so the global one keeps serving everything else. Must not be called from inside a job.
+void benchmarkJobSystem() {
+  const u32 elementCount = 1000000;
+  const u32 repetitions = 10;
+  const u32 maxThreadCount = Max(std::thread::hardware_concurrency(), 1u);
+  const f64 secondsPerCounter = 1.0 / getPerformanceCounterFrequencyPerSecond();
+
+  glm::mat4* parents = new glm::mat4[elementCount];
+  glm::mat4* locals = new glm::mat4[elementCount];
+  glm::mat4* worlds = new glm::mat4[elementCount];
+  Box* localBoxes = new Box[elementCount];
+  Box* worldBoxes = new Box[elementCount];
+  for(u32 i = 0; i < elementCount; ++i) {
+    f32 angle = (f32)i * 0.001f;
+    parents[i] = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3((f32)(i % 100), 0.0f, (f32)(i / 100))), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    locals[i] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(0.5f + (f32)(i % 7) * 0.1f));
+    localBoxes[i] = boxFromMinMax(glm::vec3(-0.5f), glm::vec3(0.5f));
+  }
+
+  JobSystem* scalingJobs = new JobSystem();
+  printf("Job system scaling (%u elements, average of %u runs)\n", elementCount, repetitions);
+  f64 singleThreadMs[2] = {};
+  for(u32 threadCount = 1; threadCount <= maxThreadCount; threadCount = (threadCount == maxThreadCount) ? threadCount + 1 : Min(threadCount * 2, maxThreadCount)) {
+    initJobSystem(threadCount, scalingJobs);
+
+    u64 start = getPerformanceCounter();
+    for(u32 rep = 0; rep < repetitions; ++rep) {
+      parallelFor(elementCount, 4096, [=](u32 begin, u32 end) {
+        for(u32 i = begin; i < end; ++i) { worlds[i] = parents[i] * locals[i]; }
+      });
+    }
+    f64 transformMs = (getPerformanceCounter() - start) * secondsPerCounter * 1000.0 / repetitions;
+
+    start = getPerformanceCounter();
+    for(u32 rep = 0; rep < repetitions; ++rep) {
+      parallelFor(elementCount, 4096, [=](u32 begin, u32 end) {
+        for(u32 i = begin; i < end; ++i) { worldBoxes[i] = transformBox(localBoxes[i], worlds[i]); }
+      });
+    }
+    f64 boxMs = (getPerformanceCounter() - start) * secondsPerCounter * 1000.0 / repetitions;
+
+    if(threadCount == 1) {
+      singleThreadMs[0] = transformMs;
+      singleThreadMs[1] = boxMs;
+    }
+    printf("  %2u threads | transform update %7.3f ms (%4.2fx) | world bounds %7.3f ms (%4.2fx)\n", threadCount,
+           transformMs, singleThreadMs[0] / transformMs, boxMs, singleThreadMs[1] / boxMs);
+    deinitJobSystem(scalingJobs);
+  }
+  printf("  (checksum %f)\n", worldBoxes[elementCount - 1].min.x + worlds[elementCount / 2][3][0]);
+
+  delete scalingJobs;
+  delete[] parents;
+  delete[] locals;
+  delete[] worlds;
+  delete[] localBoxes;
+  delete[] worldBoxes;
+}
\ No newline at end of file
@@ -0,0 +1,289 @@
+#pragma once
+
+// Level of detail
+// LODs are generated at load time with quadric error edge collapse. A collapse moves a vertex onto
+// one of its neighbors, so every LOD reuses the original mesh's vertices and only needs new indices.
+// Vertices that share a position (uv/normal seams) are welded while simplifying so seams can't tear.
+// At runtime an LOD is picked from how much of the screen an object's bounds cover.
+// source: "Surface Simplification Using Quadric Error Metrics", Garland & Heckbert 1997
+
+#define LOD_MAX_COUNT 4
+#define LOD_HYSTERESIS 0.1f // fraction of a threshold the screen size must pass before switching back
+#define LOD1_MAX_SCREEN_SIZE 0.25f // LOD n is allowed below LOD1_MAX_SCREEN_SIZE / 2^(n-1) of the screen's height
+#define LOD_ERROR_PER_LEVEL 0.01f // allowed simplification error per LOD level, relative to the mesh's bounding diagonal
+
+// symmetric 4x4 matrix, only the upper triangle is stored
+struct Quadric {
+  f64 a00, a01, a02, a03;
+  f64      a11, a12, a13;
+  f64           a22, a23;
+  f64                a33;
+  f64 weight;
+};
+
+internal Quadric quadricFromPlane(f64 a, f64 b, f64 c, f64 d, f64 weight) {
+  Quadric q;
+  q.a00 = a * a * weight; q.a01 = a * b * weight; q.a02 = a * c * weight; q.a03 = a * d * weight;
+  q.a11 = b * b * weight; q.a12 = b * c * weight; q.a13 = b * d * weight;
+  q.a22 = c * c * weight; q.a23 = c * d * weight;
+  q.a33 = d * d * weight;
+  q.weight = weight;
+  return q;
+}
+
+internal void addQuadric(Quadric* q, const Quadric& other) {
+  q->a00 += other.a00; q->a01 += other.a01; q->a02 += other.a02; q->a03 += other.a03;
+  q->a11 += other.a11; q->a12 += other.a12; q->a13 += other.a13;
+  q->a22 += other.a22; q->a23 += other.a23;
+  q->a33 += other.a33;
+  q->weight += other.weight;
+}
+
+// weighted average of squared distances to the quadric's planes
+internal f64 quadricError(const Quadric& q, const glm::vec3& v) {
+  f64 x = v.x, y = v.y, z = v.z;
+  f64 error = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x +
+              q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y +
+              q.a22 * z * z + 2.0 * q.a23 * z +
+              q.a33;
+  return q.weight > 0.0 ? fabs(error) / q.weight : 0.0;
+}
+
+internal inline u64 edgeKey(u32 a, u32 b) {
+  return a < b ? (((u64)a << 32) | b) : (((u64)b << 32) | a);
+}
+
+struct EdgeCollapse {
+  f64 error;
+  u32 from;
+  u32 to;
+};
+
+// Writes a simplified version of the triangle list to outIndices (which must hold indexCount indices) and
+// returns its index count. Simplification stops at targetIndexCount or when the next collapse would move the
+// surface further than maxError. The result references the same vertices as the source indices.
+u32 simplifyMesh(const StaticVertex* vertices, u32 vertexCount, const u32* indices, u32 indexCount,
+                 u32 targetIndexCount, f32 maxError, u32* outIndices, f32* outError = nullptr) {
+  assert(indexCount % 3 == 0);
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Arena* arena = tempMemory.arena;
+
+  // weld vertices by position, each vertex maps to the first vertex with the same position
+  u32* weld = pushArray(arena, vertexCount, u32);
+  u32* sortedVertices = pushArray(arena, vertexCount, u32);
+  for(u32 i = 0; i < vertexCount; ++i) { sortedVertices[i] = i; }
+  std::sort(sortedVertices, sortedVertices + vertexCount, [vertices](u32 a, u32 b) {
+    const glm::vec3& pa = vertices[a].position;
+    const glm::vec3& pb = vertices[b].position;
+    return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : (pa.z != pb.z ? pa.z < pb.z : a < b));
+  });
+  for(u32 i = 0; i < vertexCount; ++i) {
+    bool samePositionAsPrevious = i > 0 && vertices[sortedVertices[i]].position == vertices[sortedVertices[i - 1]].position;
+    weld[sortedVertices[i]] = samePositionAsPrevious ? weld[sortedVertices[i - 1]] : sortedVertices[i];
+  }
+
+  // working triangles in welded vertices, alongside the original vertex of each corner
+  u32* workIndices = pushArray(arena, indexCount, u32);
+  u32* workCorners = pushArray(arena, indexCount, u32);
+  u32 workCount = 0;
+  for(u32 i = 0; i < indexCount; i += 3) {
+    u32 a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+    if(a == b || b == c || c == a) { continue; }
+    for(u32 corner = 0; corner < 3; ++corner) {
+      workIndices[workCount + corner] = weld[indices[i + corner]];
+      workCorners[workCount + corner] = indices[i + corner];
+    }
+    workCount += 3;
+  }
+
+  Quadric* quadrics = pushArrayZero(arena, vertexCount, Quadric);
+  for(u32 i = 0; i < workCount; i += 3) {
+    const glm::vec3& p0 = vertices[workIndices[i]].position;
+    const glm::vec3& p1 = vertices[workIndices[i + 1]].position;
+    const glm::vec3& p2 = vertices[workIndices[i + 2]].position;
+    glm::vec3 normal = cross(p1 - p0, p2 - p0);
+    f32 doubleArea = length(normal);
+    if(doubleArea <= 0.0f) { continue; }
+    normal = normal / doubleArea;
+    Quadric q = quadricFromPlane(normal.x, normal.y, normal.z, -dot(normal, p0), doubleArea * 0.5f);
+    for(u32 corner = 0; corner < 3; ++corner) {
+      addQuadric(&quadrics[workIndices[i + corner]], q);
+    }
+  }
+
+  // lock vertices on open or non-manifold edges, collapsing them would eat away at the silhouette
+  bool* locked = pushArrayZero(arena, vertexCount, bool);
+  u64* edges = pushArray(arena, workCount, u64);
+  for(u32 i = 0; i < workCount; i += 3) {
+    edges[i] = edgeKey(workIndices[i], workIndices[i + 1]);
+    edges[i + 1] = edgeKey(workIndices[i + 1], workIndices[i + 2]);
+    edges[i + 2] = edgeKey(workIndices[i + 2], workIndices[i]);
+  }
+  std::sort(edges, edges + workCount);
+  for(u32 runStart = 0; runStart < workCount;) {
+    u32 runEnd = runStart + 1;
+    while(runEnd < workCount && edges[runEnd] == edges[runStart]) { runEnd++; }
+    if(runEnd - runStart != 2) {
+      locked[edges[runStart] >> 32] = true;
+      locked[edges[runStart] & U32_MAX] = true;
+    }
+    runStart = runEnd;
+  }
+
+  u32* collapseTarget = pushArray(arena, vertexCount, u32);
+  bool* touched = pushArray(arena, vertexCount, bool);
+  u32* adjacencyOffsets = pushArray(arena, vertexCount + 1, u32);
+  u32* adjacency = pushArray(arena, indexCount, u32);
+  EdgeCollapse* collapses = pushArray(arena, indexCount, EdgeCollapse);
+  const f64 maxErrorSquared = (f64)maxError * maxError;
+  f64 resultErrorSquared = 0.0;
+
+  while(workCount > targetIndexCount) {
+    // vertex to triangle adjacency of the current triangles
+    memset(adjacencyOffsets, 0, (vertexCount + 1) * sizeof(u32));
+    for(u32 i = 0; i < workCount; ++i) { adjacencyOffsets[workIndices[i] + 1]++; }
+    for(u32 v = 0; v < vertexCount; ++v) { adjacencyOffsets[v + 1] += adjacencyOffsets[v]; }
+    for(u32 i = 0; i < workCount; ++i) {
+      adjacency[adjacencyOffsets[workIndices[i]]++] = i / 3;
+    }
+    for(u32 v = vertexCount; v > 0; --v) { adjacencyOffsets[v] = adjacencyOffsets[v - 1]; }
+    adjacencyOffsets[0] = 0;
+
+    // cheapest direction of every edge
+    u32 collapseCount = 0;
+    for(u32 i = 0; i < workCount; ++i) {
+      u32 a = workIndices[i];
+      u32 b = workIndices[(i % 3 == 2) ? i - 2 : i + 1];
+      if(a > b) { continue; } // every interior edge appears once in each direction
+      Quadric combined = quadrics[a];
+      addQuadric(&combined, quadrics[b]);
+      f64 errorAToB = locked[a] ? DBL_MAX : quadricError(combined, vertices[b].position);
+      f64 errorBToA = locked[b] ? DBL_MAX : quadricError(combined, vertices[a].position);
+      if(errorAToB == DBL_MAX && errorBToA == DBL_MAX) { continue; }
+      EdgeCollapse& collapse = collapses[collapseCount++];
+      collapse.error = Min(errorAToB, errorBToA);
+      collapse.from = errorAToB <= errorBToA ? a : b;
+      collapse.to = errorAToB <= errorBToA ? b : a;
+    }
+    std::sort(collapses, collapses + collapseCount, [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.error < b.error; });
+
+    // greedily apply the cheapest collapses that don't interfere with each other
+    for(u32 v = 0; v < vertexCount; ++v) { collapseTarget[v] = v; }
+    memset(touched, 0, vertexCount * sizeof(bool));
+    u32 trianglesToRemove = (workCount - targetIndexCount + 2) / 3;
+    u32 trianglesRemoved = 0;
+    u32 appliedCount = 0;
+    for(u32 i = 0; i < collapseCount && trianglesRemoved < trianglesToRemove; ++i) {
+      const EdgeCollapse& collapse = collapses[i];
+      if(collapse.error > maxErrorSquared) { break; }
+      if(touched[collapse.from] || touched[collapse.to]) { continue; }
+
+      // reject collapses that flip any of the remaining triangles
+      bool flips = false;
+      u32 collapsedTriangles = 0;
+      const glm::vec3& toPos = vertices[collapse.to].position;
+      for(u32 adj = adjacencyOffsets[collapse.from]; adj < adjacencyOffsets[collapse.from + 1]; ++adj) {
+        const u32* tri = workIndices + (adjacency[adj] * 3);
+        if(tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+          collapsedTriangles++;
+          continue;
+        }
+        u32 corner = tri[0] == collapse.from ? 0 : (tri[1] == collapse.from ? 1 : 2);
+        const glm::vec3& p1 = vertices[tri[(corner + 1) % 3]].position;
+        const glm::vec3& p2 = vertices[tri[(corner + 2) % 3]].position;
+        glm::vec3 before = cross(p1 - vertices[collapse.from].position, p2 - vertices[collapse.from].position);
+        glm::vec3 after = cross(p1 - toPos, p2 - toPos);
+        if(dot(before, after) <= 0.0f) {
+          flips = true;
+          break;
+        }
+      }
+      if(flips) { continue; }
+
+      collapseTarget[collapse.from] = collapse.to;
+      addQuadric(&quadrics[collapse.to], quadrics[collapse.from]);
+      resultErrorSquared = Max(resultErrorSquared, collapse.error);
+      trianglesRemoved += collapsedTriangles;
+      appliedCount++;
+      // everything around the collapse now has stale adjacency and costs
+      for(u32 adj = adjacencyOffsets[collapse.from]; adj < adjacencyOffsets[collapse.from + 1]; ++adj) {
+        const u32* tri = workIndices + (adjacency[adj] * 3);
+        touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+      }
+    }
+
+    if(appliedCount == 0) { break; }
+
+    u32 newCount = 0;
+    for(u32 i = 0; i < workCount; i += 3) {
+      u32 a = collapseTarget[workIndices[i]], b = collapseTarget[workIndices[i + 1]], c = collapseTarget[workIndices[i + 2]];
+      if(a == b || b == c || c == a) { continue; }
+      workIndices[newCount] = a; workIndices[newCount + 1] = b; workIndices[newCount + 2] = c;
+      workCorners[newCount] = workCorners[i]; workCorners[newCount + 1] = workCorners[i + 1]; workCorners[newCount + 2] = workCorners[i + 2];
+      newCount += 3;
+    }
+    workCount = newCount;
+  }
+
+  // unweld, picking the copy of the destination vertex with attributes closest to the corner's original vertex
+  u32* weldCopyOffsets = adjacencyOffsets;
+  u32* weldCopies = adjacency;
+  memset(weldCopyOffsets, 0, (vertexCount + 1) * sizeof(u32));
+  for(u32 v = 0; v < vertexCount; ++v) { weldCopyOffsets[weld[v] + 1]++; }
+  for(u32 v = 0; v < vertexCount; ++v) { weldCopyOffsets[v + 1] += weldCopyOffsets[v]; }
+  for(u32 v = 0; v < vertexCount; ++v) { weldCopies[weldCopyOffsets[weld[v]]++] = v; }
+  for(u32 v = vertexCount; v > 0; --v) { weldCopyOffsets[v] = weldCopyOffsets[v - 1]; }
+  weldCopyOffsets[0] = 0;
+  for(u32 i = 0; i < workCount; ++i) {
+    u32 original = workCorners[i];
+    u32 welded = workIndices[i];
+    if(weld[original] == welded) {
+      outIndices[i] = original;
+      continue;
+    }
+    const StaticVertex& originalVertex = vertices[original];
+    f32 bestDistance = FLT_MAX;
+    u32 best = welded;
+    for(u32 copy = weldCopyOffsets[welded]; copy < weldCopyOffsets[welded + 1]; ++copy) {
+      const StaticVertex& candidate = vertices[weldCopies[copy]];
+      glm::vec2 uvDelta = candidate.texCoord - originalVertex.texCoord;
+      glm::vec3 normalDelta = candidate.normal - originalVertex.normal;
+      f32 distance = dot(uvDelta, uvDelta) + dot(normalDelta, normalDelta);
+      if(distance < bestDistance) {
+        bestDistance = distance;
+        best = weldCopies[copy];
+      }
+    }
+    outIndices[i] = best;
+  }
+
+  if(outError) { *outError = (f32)sqrt(resultErrorSquared); }
+  endTempMemory(tempMemory);
+  return workCount;
+}
+
+// Fraction of the screen's height covered by the bounding sphere of the box, projMat is expected to come from perspective()
+f32 projectedScreenSize(const Box& worldBox, const glm::vec3& cameraPosition, const glm::mat4& projMat) {
+  f32 radius = length(worldBox.diagonal) * 0.5f;
+  f32 distance = length(boxCenter(worldBox) - cameraPosition);
+  if(distance <= radius) { return 1.0f; }
+  return (radius * projMat[1][1]) / distance;
+}
+
+inline f32 lodMaxScreenSize(u32 lod) {
+  return lod == 0 ? FLT_MAX : LOD1_MAX_SCREEN_SIZE / (f32)(1 << (lod - 1));
+}
+
+// An object only leaves its current LOD once its screen size passes the threshold by LOD_HYSTERESIS,
+// so objects sitting near a threshold don't flip between LODs every frame.
+u32 selectLOD(f32 screenSize, u32 currentLOD, u32 lodCount) {
+  assert(lodCount > 0 && lodCount <= LOD_MAX_COUNT);
+  u32 lod = Min(currentLOD, lodCount - 1);
+  while(lod + 1 < lodCount && screenSize < lodMaxScreenSize(lod + 1) * (1.0f - LOD_HYSTERESIS)) {
+    lod++;
+  }
+  while(lod > 0 && screenSize > lodMaxScreenSize(lod) * (1.0f + LOD_HYSTERESIS)) {
+    lod--;
+  }
+  return lod;
+}
\ No newline at end of file
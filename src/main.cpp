@@ -2,42 +2,243 @@
 
 #define INIT_WINDOW_WIDTH 1920
 #define INIT_WINDOW_HEIGHT 1024
-#define INIT_ASPECT (f32)INIT_WINDOW_WIDTH / INIT_WINDOW_HEIGHT
 
-void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle);
+struct SessionOptions {
+  const char* recordFileName; // --record <file>: saves every frame's input and delta to replay later
+  const char* replayFileName; // --replay <file>: drives the scene from a recording, then writes per frame timings
+  bool headless; // --headless: hidden window without v-sync, so replays run as fast as the machine allows
+  f64 fixedTimestepSeconds; // --timestep <seconds>: simulation step while replaying
+  const char* packFileName; // --pack <file>: assets are read from this pack when it exists, loose files otherwise
+  bool benchmarks; // --benchmarks: runs every benchmark without opening a window and exits, e.g. to train PGO builds
+  u32 pixelScale; // --pixel-scale <n>: renders the scene at 1/n of the window resolution and scales it up, 1 is off
+  f32 dynamicResolutionFps; // --dynamic-resolution <fps>: lowers the render resolution to hold this frame rate, 0 is off
+  u32 uiUpdateInterval; // --ui-interval <frames>: rebuilds the UI only every n frames unless there is input for it
+};
+
+void scene(WINDOW_HANDLE windowHandle, GL_CONTEXT_HANDLE glContextHandle, AUDIO_HANDLE audioHandle, const SessionOptions& options);
+void runBenchmarks();
+
+SessionOptions parseSessionOptions(int argc, char* argv[]) {
+  SessionOptions options{};
+  options.fixedTimestepSeconds = REPLAY_DEFAULT_TIMESTEP_SECONDS;
+  options.packFileName = "assets.pack";
+  options.pixelScale = 1;
+  options.uiUpdateInterval = 1;
+  for(int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if(strcmp(argv[i], "--record") == 0 && hasValue) {
+      options.recordFileName = argv[++i];
+    } else if(strcmp(argv[i], "--replay") == 0 && hasValue) {
+      options.replayFileName = argv[++i];
+    } else if(strcmp(argv[i], "--timestep") == 0 && hasValue) {
+      options.fixedTimestepSeconds = atof(argv[++i]);
+    } else if(strcmp(argv[i], "--pack") == 0 && hasValue) {
+      options.packFileName = argv[++i];
+    } else if(strcmp(argv[i], "--headless") == 0) {
+      options.headless = true;
+    } else if(strcmp(argv[i], "--benchmarks") == 0) {
+      options.benchmarks = true;
+    } else if(strcmp(argv[i], "--pixel-scale") == 0 && hasValue) {
+      s32 pixelScale = atoi(argv[++i]);
+      options.pixelScale = (u32)Clamp(pixelScale, 1, PIXEL_SCALE_MAX);
+    } else if(strcmp(argv[i], "--dynamic-resolution") == 0 && hasValue) {
+      f32 fps = (f32)atof(argv[++i]);
+      options.dynamicResolutionFps = Max(fps, 0.0f);
+    } else if(strcmp(argv[i], "--ui-interval") == 0 && hasValue) {
+      s32 uiUpdateInterval = atoi(argv[++i]);
+      options.uiUpdateInterval = (u32)Clamp(uiUpdateInterval, 1, UI_UPDATE_INTERVAL_MAX);
+    } else {
+      printf("Unknown argument: %s\n", argv[i]);
+      printf("Usage: %s [--pack <file>] [--benchmarks] [--pixel-scale <n>] [--dynamic-resolution <fps>] [--ui-interval <frames>] [--record <file>] [--replay <file> [--headless] [--timestep <seconds>]]\n", argv[0]);
+    }
+  }
+  if(options.headless && !options.replayFileName) {
+    printf("--headless is only used with --replay, ignoring it\n");
+    options.headless = false;
+  }
+  if(options.fixedTimestepSeconds <= 0.0) {
+    options.fixedTimestepSeconds = REPLAY_DEFAULT_TIMESTEP_SECONDS;
+  }
+  return options;
+}
 
 int main(int argc, char* argv[]) {
-  WINDOW_HANDLE windowHandle;
-  GL_CONTEXT_HANDLE glContextHandle;
-  initWindow(INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT, &windowHandle, &glContextHandle);
-  AUDIO_HANDLE audioHandle;
-  initAudio(&audioHandle);
-  loadOpenGL();
-  initImgui(windowHandle, glContextHandle);
-  scene(windowHandle, audioHandle);
-  deinitAudio(&audioHandle);
-  deinitWindow(&windowHandle, &glContextHandle);
+  SessionOptions options = parseSessionOptions(argc, argv);
+  initMemory();
+  initJobSystem();
+  initTaskScheduler();
+  initAsyncIo(&assetIo);
+  if(mountPack(options.packFileName)) {
+    printf("Mounted %s\n", options.packFileName);
+  }
+  if(options.benchmarks) {
+    runBenchmarks();
+  } else {
+    WINDOW_HANDLE windowHandle;
+    GL_CONTEXT_HANDLE glContextHandle;
+    initWindow(INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT, &windowHandle, &glContextHandle, options.headless);
+    initInputEvents();
+    AUDIO_HANDLE audioHandle;
+    initAudio(&audioHandle);
+    loadOpenGL();
+    initImgui(windowHandle, glContextHandle);
+    scene(windowHandle, glContextHandle, audioHandle, options);
+    deinitAudio(&audioHandle);
+    deinitInputEvents();
+    deinitWindow(&windowHandle, &glContextHandle);
+  }
+  unmountPack();
+  deinitAsyncIo(&assetIo);
+  deinitTaskScheduler();
+  deinitJobSystem();
+  deinitMemory();
   return 0;
 }
 
+// Everything in the Benchmarks menu, one after another
+void runBenchmarks() {
+  benchmarkBVH();
+  benchmarkGenerationMap();
+  benchmarkJobSystem();
+  benchmarkTasks();
+  benchmarkTransforms();
+  benchmarkEcs();
+  benchmarkAnimation();
+  benchmarkVfs();
+  benchmarkAsyncIo();
+  benchmarkTextureDecode();
+  benchmarkSimdMath();
+  benchmarkTileMap();
+}
+
 struct AppState {
   WINDOW_HANDLE windowHandle;
   AUDIO_HANDLE audioHandle;
   ivec2 windowDimens;
 };
 
-void logV(bool* pOpen, const char* fmt, ...) {
-  va_list argptr;
-  va_start(argptr, fmt);
-  if(*pOpen) {
-    if(ImGui::Begin("General Debug", pOpen)) {
-      ImGui::TextV(fmt, argptr);
-    }ImGui::End();
+// GL objects the render thread needs, all created on the main thread before the render thread starts
+struct SceneRenderState {
+  StaticGeometryPool* staticGeometryPool;
+  Model* quadModel;
+  GLuint staticGeometryShaderId;
+  GLuint spriteShaderId;
+  GLuint debugQuadShaderId;
+  GLuint tileMapShaderId;
+  TileMap* tileMap;
+  GLuint modelViewProjUboId;
+  GLuint posUboId;
+  s32 birdTexIndex;
+  s32 staticGeometryTexIndex;
+  RenderTarget lowResTarget; // pixel art and dynamic resolution modes
+  ivec2 emulatedResolution; // last uploaded to the pos UBO
+  GpuTimer gpuTimer;
+  DynamicResolution dynamicResolution;
+  StatsHud statsHud;
+};
+
+StaticGeometryStats renderSceneFrame(void* renderState, FramePacket* packet) {
+  SceneRenderState* state = (SceneRenderState*)renderState;
+
+  // window resizes reach the GL state through the packet
+  if(packet->emulatedResolution.x != state->emulatedResolution.x || packet->emulatedResolution.y != state->emulatedResolution.y) {
+    glBindBuffer(GL_UNIFORM_BUFFER, state->posUboId);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PosUBO, emulatedWindowRes), sizeof(ivec2), &packet->emulatedResolution);
+    state->emulatedResolution = packet->emulatedResolution;
+  }
+
+  // timings from earlier frames steer this frame's resolution
+  f64 gpuSeconds;
+  while(pollGpuTimer(&state->gpuTimer, &gpuSeconds)) {
+    updateDynamicResolution(&state->dynamicResolution, gpuSeconds, packet->dynamicResolution);
+  }
+  bool timingGpu = beginGpuTimer(&state->gpuTimer);
+
+  bool pixelArt = packet->pixelScale > 1;
+  bool dynamicResolution = !pixelArt && packet->dynamicResolution.enabled;
+  ivec2 dynamicDimens = dynamicRenderDimens(state->dynamicResolution.scale, packet->windowDimens);
+  if(pixelArt) {
+    resizeRenderTarget(&state->lowResTarget, pixelScaledDimens(packet->windowDimens, packet->pixelScale));
+    glBindFramebuffer(GL_FRAMEBUFFER, state->lowResTarget.framebuffer);
+    glViewport(0, 0, state->lowResTarget.dimens.x, state->lowResTarget.dimens.y);
+  } else if(dynamicResolution) {
+    resizeRenderTarget(&state->lowResTarget, packet->windowDimens);
+    glBindFramebuffer(GL_FRAMEBUFFER, state->lowResTarget.framebuffer);
+    glViewport(0, 0, dynamicDimens.x, dynamicDimens.y);
+  } else {
+    glViewport(0, 0, packet->windowDimens.x, packet->windowDimens.y);
+  }
+
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glBindBuffer(GL_UNIFORM_BUFFER, state->modelViewProjUboId);
+  glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ModelViewProjUBO, proj), sizeof(glm::mat4), &packet->projMat);
+  glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ModelViewProjUBO, view), sizeof(glm::mat4), &packet->viewMat);
+
+  // draw tile map, at the far plane so everything else ends up in front of it
+  glUseProgram(state->tileMapShaderId);
+  drawTileMap(state->tileMap, packet->tileMapView, state->tileMapShaderId);
+
+  // draw static geometry
+  glUseProgram(state->staticGeometryShaderId);
+  glDisable(GL_CULL_FACE);
+  setSampler2D(state->staticGeometryShaderId, "albedoTex", state->staticGeometryTexIndex);
+  StaticGeometryStats staticGeometryStats = flushStaticDraws(state->staticGeometryPool, &packet->staticDraws, state->staticGeometryTexIndex);
+  glEnable(GL_CULL_FACE);
+
+  for(u32 i = 0; i < packet->spriteCount; ++i) {
+    // draw debug quad
+    glUseProgram(state->debugQuadShaderId);
+    glBindBuffer(GL_UNIFORM_BUFFER, state->posUboId);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PosUBO, pos), sizeof(glm::vec2), packet->spritePositions + i);
+    drawModel(*state->quadModel);
+
+    // draw sprite
+    glUseProgram(state->spriteShaderId);
+    setSampler2D(state->spriteShaderId, "albedoTex", state->birdTexIndex);
+    drawModel(*state->quadModel);
   }
-  va_end(argptr);
+
+  if(pixelArt) {
+    blitRenderTargetToWindow(state->lowResTarget, packet->windowDimens, packet->pixelScale);
+  } else if(dynamicResolution) {
+    stretchRenderTargetToWindow(state->lowResTarget, dynamicDimens, packet->windowDimens);
+  }
+  if(timingGpu) {
+    endGpuTimer(&state->gpuTimer);
+  }
+
+  // draw the stats HUD and Dear ImGui, always at full resolution
+  drawStatsHud(state->statsHud, packet->statsHudText, packet->windowDimens);
+  renderImGui(&packet->imguiDrawData);
+
+  return staticGeometryStats;
 }
 
-void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
+struct SceneAssets {
+  GLuint textureIds[2]; // seed spirit, bird guy
+  ivec2 textureDimens[2];
+  Model quadModel;
+  std::atomic<bool> loaded;
+};
+
+// Sounds load on a worker, GL objects on the thread that owns the GL context. The model's nodes are added to the
+// transforms, which must not be touched elsewhere until the assets are loaded.
+Task loadSceneAssets(SceneAssets* assets, AUDIO_HANDLE audioHandle, TransformHierarchy* transforms) {
+  co_await toWorkerThread();
+  loadUpSong(audioHandle, "data/sounds/songs/fairy_loop.wav");
+  loadUpSoundEffect(audioHandle, "data/sounds/clips/echo.wav");
+
+  co_await toRenderThread();
+  // load 2d textures
+  const char* texturePaths[] = { "data/textures/seed_spirit.png", "data/textures/bird_guy.png" };
+  load2DTextures(texturePaths, ArrayCount(texturePaths), assets->textureIds, assets->textureDimens, LoadTextureFlags::CHUNKY_PIXELS);
+  // load model (w/ vertex attributes and node tree) through a gltf file
+  loadModel("data/models/quad.glb", &assets->quadModel, transforms);
+  assets->loaded.store(true, std::memory_order_release);
+}
+
+void scene(WINDOW_HANDLE windowHandle, GL_CONTEXT_HANDLE glContextHandle, AUDIO_HANDLE audioHandle, const SessionOptions& options) {
+  u64 startupReadSyscalls = readSyscallCount();
   AppState appState{};
   appState.windowHandle = windowHandle;
   appState.audioHandle = audioHandle;
@@ -46,37 +247,69 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
 
   getWindowDimens(windowHandle, &appState.windowDimens);
   ivec2 tileSize{128, 128};
-  ivec2 emulatedSpriteResolution{appState.windowDimens.x / tileSize.x, appState.windowDimens.y / tileSize.y};
+  ivec2 emulatedSpriteResolution{Max(appState.windowDimens.x / tileSize.x, 1), Max(appState.windowDimens.y / tileSize.y, 1)};
+  u32 pixelScale = options.pixelScale;
+  DynamicResolutionSettings dynamicResolutionSettings{};
+  dynamicResolutionSettings.enabled = options.dynamicResolutionFps > 0.0f;
+  dynamicResolutionSettings.targetFrameMs = 1000.0f / (dynamicResolutionSettings.enabled ? options.dynamicResolutionFps : 60.0f);
+  dynamicResolutionSettings.minScale = 0.5f;
+  dynamicResolutionSettings.maxScale = 1.0f;
+
+  // replays take their input from the file, the real mouse is left alone
+  ReplayPlayback replayPlayback{};
+  bool replaying = options.replayFileName && openReplayPlayback(&replayPlayback, options.replayFileName);
+  if(options.replayFileName && !replaying) {
+    printf("Could not open replay %s\n", options.replayFileName);
+  }
 
   bool hiddenMouse = false;
-  hideMouse(hiddenMouse);
+  if(!replaying) { hideMouse(hiddenMouse); }
 
-  // load 2d textures
-  GLuint spiritTexture, birdTexture;
-  ivec2 spiritTexDimens, birdTexDimens;
-  load2DTexture("data/textures/seed_spirit.png", &spiritTexture, &spiritTexDimens.x, &spiritTexDimens.y, LoadTextureFlags::CHUNKY_PIXELS);
-  load2DTexture("data/textures/bird_guy.png", &birdTexture, &birdTexDimens.x, &birdTexDimens.y, LoadTextureFlags::CHUNKY_PIXELS);
-
-  // load sounds
-  loadUpSong(audioHandle, "data/sounds/songs/fairy_loop.wav");
-  loadUpSoundEffect(audioHandle, "data/sounds/clips/echo.wav");
+  const f32 soundEffectCooldownSeconds = 0.25f;
 
+  // static geometry shares one set of buffers and is drawn through indirect draw commands
+  StaticGeometryPool staticGeometryPool;
+  initStaticGeometryPool(&staticGeometryPool, 1 << 16, 1 << 18, 1024);
   // load simple vertex attributes for cube
-  VertexAtt cubeVertAtt = initializeCubePosNormTexVertexAttBuffers();
+  StaticMeshRange cubeLODs[LOD_MAX_COUNT];
+  u32 cubeLODCount = addStaticMeshWithLODs(&staticGeometryPool,
+                                           (const StaticVertex*)cubePosTexNormAttributes, ArrayCount(cubePosTexNormAttributes) / 8,
+                                           cubeAttributeIndices, ArrayCount(cubeAttributeIndices),
+                                           LOD_MAX_COUNT, cubeLODs);
+  const Box cubeMeshBox = boxFromMinMax(glm::vec3(-0.5f), glm::vec3(0.5f));
   // setup cube's initial model matrix
   glm::vec3 cubePosition = glm::vec3{0.0f, 0.0f, 0.0f};
   glm::vec3 cubeScale = glm::vec3(1.5f);
   glm::vec3 cubeInitRotationAxis = glm::vec3(1.0f, 1.0f, 1.0f);
   glm::vec3 cubeActiveRotationAxis = worldUp;
   f64 cubeActiveRotationPerSecond = Radians(20.0f);
-  glm::mat4 cubeScaleRotationMat = glm::rotate(glm::scale(glm::mat4(), cubeScale),  Radians(-45.0f), cubeInitRotationAxis);
-  glm::mat4 cubeTranslationMat = glm::translate(glm::mat4(), cubePosition);
-
-  // load model (w/ vertex attributes) through a gltf file
-  Model quadModel;
-  loadModel("data/models/quad.glb", &quadModel);
+  glm::quat cubeInitRotation = glm::angleAxis(Radians(-45.0f), normalize(cubeInitRotationAxis));
+  // object transforms, world matrices are recomputed once per frame for whatever moved
+  TransformHierarchy sceneTransforms;
+  initTransformHierarchy(&sceneTransforms, 1024);
+  u32 cubeTransform = addTransform(&sceneTransforms, TRANSFORM_NO_PARENT, cubePosition, cubeInitRotation, cubeScale);
+  // scene objects are entities, systems run over queries of their components
+  EcsWorld world;
+  initEcsWorld(&world, 1024);
+  Entity cubeEntity = createEntity(&world, componentMask<TransformComponent, SpinComponent, StaticMeshComponent>());
+  getComponent<TransformComponent>(&world, cubeEntity)->node = cubeTransform;
+  *getComponent<SpinComponent>(&world, cubeEntity) = SpinComponent{ cubeInitRotation, cubeActiveRotationAxis, (f32)cubeActiveRotationPerSecond };
+
+  // sounds, textures and the quad model load on a task. Until the render thread starts the GL context is current on
+  // this thread, so this thread resumes the task's GL work while it waits.
+  SceneAssets sceneAssets{};
+  spawnTask(loadSceneAssets(&sceneAssets, audioHandle, &sceneTransforms));
+  while(!sceneAssets.loaded.load(std::memory_order_acquire)) {
+    waitForCounter(&taskScheduler.workerJobs);
+    runRenderThreadTasks();
+  }
+  Model& quadModel = sceneAssets.quadModel;
+  GLuint spiritTexture = sceneAssets.textureIds[0], birdTexture = sceneAssets.textureIds[1];
+  ivec2 birdTexDimens = sceneAssets.textureDimens[1];
+  updateTransforms(&sceneTransforms);
   // setup quad's initial model matrix
-  glm::vec2 spritePosition = glm::vec2{(f32)emulatedSpriteResolution.x * 0.5f, (f32)emulatedSpriteResolution.y * 0.5f};
+  Entity spriteEntity = createEntity(&world, componentMask<SpriteComponent>());
+  getComponent<SpriteComponent>(&world, spriteEntity)->position = glm::vec2{(f32)emulatedSpriteResolution.x * 0.5f, (f32)emulatedSpriteResolution.y * 0.5f};
   f32 qScale = 0.2f;
   glm::vec3 quadScale = glm::vec3(qScale);
   glm::mat4 quadScaleMat = glm::scale(glm::mat4(), quadScale);
@@ -87,10 +320,11 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
   glm::vec3 cameraPosition = glm::vec3{0.0f, 0.0f, -5.0f};
   Camera camera;
   lookAt(cameraPosition, cubePosition, &camera);
-  glm::mat4 projMat = perspective(fieldOfView(13.5f, 25.0f), INIT_ASPECT, 0.01f, 100.0f);
+  const f32 cameraFieldOfView = fieldOfView(13.5f, 25.0f);
+  glm::mat4 projMat = perspective(cameraFieldOfView, (f32)appState.windowDimens.x / appState.windowDimens.y, 0.01f, 100.0f);
 
-  ShaderProgram texShaderProgram = createShaderProgram("shaders/pos.vert", "shaders/texture.frag");
-  glUseProgram(texShaderProgram.id);
+  ShaderProgram staticGeometryShaderProgram = createShaderProgram("shaders/static_geometry.vert", "shaders/texture.frag");
+  glUseProgram(staticGeometryShaderProgram.id);
 
   // Create uniform buffer object for model-view-projection matrices=
   // - generate id for view-model-proj buffer
@@ -138,27 +372,186 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
   glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
 
   // bind our 2d textures to specific active indices
-  s32 spiritTexIndex = 0, birdTexIndex = 1;
+  s32 spiritTexIndex = 0, birdTexIndex = 1, staticGeometryTexIndex = 2;
   bindActiveTexture2d(spiritTexIndex, spiritTexture);
   bindActiveTexture2d(birdTexIndex, birdTexture);
 
+  // million tile map behind the scene, chunks are baked as they first come on screen
+  const ivec2 tileAtlasDimens{4, 4};
+  const u32 tileAtlasTilePixels = 16;
+  const u16 trailTile = (u16)(tileAtlasDimens.x * tileAtlasDimens.y); // last tile of the atlas, the rest are ground
+  TileMap tileMap;
+  initTileMap(&tileMap, 1024, 1024);
+  generateTileMap(&tileMap, trailTile - 1, 1);
+  GLuint tileAtlasTexture;
+  {
+    TempMemory tempMemory = beginTempMemory(threadTempArena());
+    u8* atlasPixels = pushArray(tempMemory.arena, tileAtlasDimens.x * tileAtlasDimens.y * tileAtlasTilePixels * tileAtlasTilePixels * 4, u8);
+    generateTileAtlas(tileAtlasDimens, tileAtlasTilePixels, atlasPixels);
+    load2DTexture(atlasPixels, 4, tileAtlasDimens.x * tileAtlasTilePixels, tileAtlasDimens.y * tileAtlasTilePixels, &tileAtlasTexture, LoadTextureFlags::CHUNKY_PIXELS);
+    endTempMemory(tempMemory);
+  }
+  s32 tileAtlasTexIndex = 3;
+  bindActiveTexture2d(tileAtlasTexIndex, tileAtlasTexture);
+  ShaderProgram tileMapShaderProgram = createShaderProgram("shaders/tilemap.vert", "shaders/texture.frag");
+  glUseProgram(tileMapShaderProgram.id);
+  setSampler2D(tileMapShaderProgram.id, "albedoTex", tileAtlasTexIndex);
+  glUniform2i(glGetUniformLocation(tileMapShaderProgram.id, "atlasDimens"), tileAtlasDimens.x, tileAtlasDimens.y);
+  setUniform(tileMapShaderProgram.id, "atlasTexelInset", 0.5f / tileAtlasTilePixels);
+  glm::vec2 maxTileMapViewOrigin = glm::vec2((f32)(tileMap.width - emulatedSpriteResolution.x), (f32)(tileMap.height - emulatedSpriteResolution.y));
+  glm::vec2 tileMapViewOrigin = maxTileMapViewOrigin * 0.5f;
+
   const f32 cameraWalkMoveSpeedPerSecond = 0.8f;
   const f32 cameraRunMoveSpeedPerSecond = cameraWalkMoveSpeedPerSecond * 3.0f;
   const f32 cameraPitchRotationSpeedPerSecond = 0.04f;
   const f32 cameraYawRotationSpeedPerSecond = 0.04f;
 
+  // world space bounds of static geometry tested against the camera frustum each frame
+  CullingBoxes cullingBoxes;
+  initCullingBoxes(&cullingBoxes, staticGeometryPool.drawCapacity);
+  CullStats cullStats{};
+
+  // each simulated frame is recorded into a packet that is drawn on the render thread (or on this thread when it is off)
+  SceneRenderState sceneRenderState;
+  sceneRenderState.staticGeometryPool = &staticGeometryPool;
+  sceneRenderState.quadModel = &quadModel;
+  sceneRenderState.staticGeometryShaderId = staticGeometryShaderProgram.id;
+  sceneRenderState.spriteShaderId = spriteShaderProgram.id;
+  sceneRenderState.debugQuadShaderId = debugQuadShaderProgram.id;
+  sceneRenderState.tileMapShaderId = tileMapShaderProgram.id;
+  sceneRenderState.tileMap = &tileMap;
+  sceneRenderState.modelViewProjUboId = modelViewProjUboId;
+  sceneRenderState.posUboId = posUboId;
+  sceneRenderState.birdTexIndex = birdTexIndex;
+  sceneRenderState.staticGeometryTexIndex = staticGeometryTexIndex;
+  sceneRenderState.lowResTarget = {};
+  sceneRenderState.emulatedResolution = emulatedSpriteResolution;
+  initGpuTimer(&sceneRenderState.gpuTimer);
+  initDynamicResolution(&sceneRenderState.dynamicResolution);
+  ShaderProgram statsHudShaderProgram = createShaderProgram("shaders/stats_hud.vert", "shaders/stats_hud.frag");
+  initStatsHud(&sceneRenderState.statsHud, statsHudShaderProgram.id);
+  Renderer renderer;
+  initRenderer(&renderer, windowHandle, glContextHandle, renderSceneFrame, &sceneRenderState, staticGeometryPool.drawCapacity);
+  bool renderThreadEnabled = true;
+  setRenderThreadEnabled(&renderer, renderThreadEnabled);
+
+  // scene query structure, used to pick what is under the crosshair
+  BVH sceneBVH;
+  initBVH(&sceneBVH, staticGeometryPool.drawCapacity);
+  u32 cubeBVHObject = addBVHObject(&sceneBVH, transformBox(cubeMeshBox, worldMat(sceneTransforms, cubeTransform)));
+  buildBVH(&sceneBVH);
+  StaticMeshComponent* cubeMesh = getComponent<StaticMeshComponent>(&world, cubeEntity);
+  memcpy(cubeMesh->lods, cubeLODs, sizeof(cubeLODs));
+  cubeMesh->lodCount = cubeLODCount;
+  cubeMesh->albedoTextureId = spiritTexture;
+  cubeMesh->meshBox = cubeMeshBox;
+  cubeMesh->bvhObject = cubeBVHObject;
+
+  Entity audioEntity = createEntity(&world, componentMask<AudioEmitterComponent>());
+  getComponent<AudioEmitterComponent>(&world, audioEntity)->cooldownSeconds = soundEffectCooldownSeconds;
+
+  EcsQuery spinQuery, staticMeshQuery, spriteQuery, audioEmitterQuery;
+  initQuery(&spinQuery, componentMask<TransformComponent, SpinComponent>());
+  initQuery(&staticMeshQuery, componentMask<TransformComponent, StaticMeshComponent>());
+  initQuery(&spriteQuery, componentMask<SpriteComponent>());
+  initQuery(&audioEmitterQuery, componentMask<AudioEmitterComponent>());
+
   InputState inputState{};
-  bool showNavBar = true, showDemoWindow = false, showFPS = true, showDebug = true, playMusic = false;
+  InputEventFrame inputEvents; // everything that happened since the last frame, timestamped
+  initInputEventFrame(&inputEvents);
+  InputEventRecording inputRecording{};
+  bool recordingInput = false;
+  InputEventRecording replayRecording{};
+  if(options.recordFileName) {
+    initReplayRecording(&replayRecording);
+  }
+  ReplayTimings replayTimings{};
+  if(replaying) {
+    initReplayTimings(&replayTimings, replayFrameCount(replayPlayback));
+  }
+  f64 replaySeconds = 0.0;
+  bool showNavBar = true, showDemoWindow = false, showStatsHud = true, showDebug = true, showControls = false, playMusic = false, lodEnabled = true;
+  InputAction rebindingAction = (InputAction)0; // waiting on a key or mouse button press to bind to it
   RingSampler fpsSampler = RingSampler();
+  UiThrottle uiThrottle;
+  initUiThrottle(&uiThrottle, options.uiUpdateInterval);
+  DebugLog debugLog;
+  clearDebugLog(&debugLog);
   Stopwatch stopwatch{};
   reset(&stopwatch);
-  while(!inputState.quit && !flagIsSet(inputState.released, InputType::ESC)) {
+  auto toggleInputRecording = [&]() {
+    recordingInput = !recordingInput;
+    if(recordingInput) {
+      initInputEventRecording(&inputRecording);
+    } else {
+      const char* recordingFileName = "input_events.rec";
+      if(saveInputEventRecording(&inputRecording, recordingFileName)) {
+        printf("Recorded %u frames of input to %s\n", inputRecording.frameCount, recordingFileName);
+      }
+      deinitInputEventRecording(&inputRecording);
+    }
+  };
+
+  printVfsStats("Startup asset I/O", startupReadSyscalls);
+  printAsyncIoStats(assetIo, "Startup async reads");
+
+  while(!inputState.quit && !flagIsSet(inputState.released, InputAction::Quit)) {
     lap(&stopwatch);
-    getKeyboardInput(&inputState);
+    b32 prevActionsDown = inputState.down;
+    u64 frameBeginCounter = getPerformanceCounter();
+    f64 recordedDeltaSeconds = stopwatch.deltaSeconds;
+    if(replaying) {
+      // still poll so the window stays responsive and can be closed
+      InputState liveInputState{};
+      getKeyboardInput(&liveInputState);
+      if(liveInputState.quit || !nextReplayFrame(&replayPlayback, &inputState, &inputEvents, &recordedDeltaSeconds)) { break; }
+      replaySeconds += options.fixedTimestepSeconds;
+      stopwatch.deltaSeconds = options.fixedTimestepSeconds;
+      stopwatch.totalElapsedSeconds = replaySeconds;
+    }
+    MemoryFrameStats memoryStats = beginFrameMemory(); // previous frame's allocations
+
+    // everything sized from the window follows it when it is resized, a minimized window keeps its last size
+    ivec2 windowDimens;
+    getWindowDimens(windowHandle, &windowDimens);
+    bool windowResized = (windowDimens.x != appState.windowDimens.x || windowDimens.y != appState.windowDimens.y) && windowDimens.x > 0 && windowDimens.y > 0;
+    if(windowResized) {
+      appState.windowDimens = windowDimens;
+      emulatedSpriteResolution = ivec2{Max(windowDimens.x / tileSize.x, 1), Max(windowDimens.y / tileSize.y, 1)};
+      projMat = perspective(cameraFieldOfView, (f32)windowDimens.x / windowDimens.y, 0.01f, 100.0f);
+      maxTileMapViewOrigin = glm::vec2((f32)(tileMap.width - emulatedSpriteResolution.x), (f32)(tileMap.height - emulatedSpriteResolution.y));
+    }
+    runScheduledTasks(stopwatch.totalElapsedSeconds);
+    u64 inputPerfCounter = getPerformanceCounter();
+    if(!replaying) {
+      getKeyboardInput(&inputState, &inputEvents);
+    }
+    if(options.recordFileName) {
+      recordReplayFrame(&replayRecording, inputState, inputEvents, stopwatch.deltaSeconds);
+    }
+    if(recordingInput) {
+      recordInputEventFrame(&inputRecording, inputEvents);
+    }
+    if(rebindingAction != 0 && !replaying) {
+      for(u32 i = 0; i < inputEvents.eventCount; ++i) {
+        const InputEvent& event = inputEvents.events[i];
+        if(event.type == InputEvent_KeyDown) {
+          rebindInput(&inputMap, rebindingAction, InputDevice_Key, event.scancode);
+        } else if(event.type == InputEvent_MouseButtonDown && (u32)event.code < INPUT_MOUSE_BUTTON_COUNT) {
+          rebindInput(&inputMap, rebindingAction, InputDevice_MouseButton, (u16)event.code);
+        } else if(event.type == InputEvent_GamepadAxisDown && (u32)event.code < INPUT_GAMEPAD_AXIS_COUNT) {
+          rebindInput(&inputMap, rebindingAction, InputDevice_GamepadAxis, (u16)event.code);
+        } else {
+          continue;
+        }
+        rebindingAction = (InputAction)0;
+        break;
+      }
+    }
 
     auto toggleMouseAndCameraControl = [&]() {
       hiddenMouse = !hiddenMouse;
-      hideMouse(hiddenMouse);
+      if(!replaying) { hideMouse(hiddenMouse); }
     };
 
     auto toggleMusic = [&]() {
@@ -167,28 +560,32 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
     };
 
     // Toggle mouse capture
-    if(flagIsSet(inputState.released, InputType::TAB)) {
+    if(flagIsSet(inputState.released, InputAction::ToggleMouseCapture)) {
       toggleMouseAndCameraControl();
     }
 
     // Toggle nav bar
-    if(flagIsSet(inputState.released, InputType::ALT)) {
+    if(flagIsSet(inputState.released, InputAction::ToggleNavBar)) {
       showNavBar = !showNavBar;
     }
 
     // Toggle music
-    if(flagIsSet(inputState.released, InputType::Q)) {
+    if(flagIsSet(inputState.released, InputAction::ToggleMusic)) {
       toggleMusic();
     }
 
-    if(flagIsSet(inputState.released, InputType::E)) {
-      playSoundEffect(audioHandle);
+    auto triggerSoundEffect = [&]() {
+      getComponent<AudioEmitterComponent>(&world, audioEntity)->triggered = true;
+    };
+
+    if(flagIsSet(inputState.released, InputAction::PlaySoundEffect)) {
+      triggerSoundEffect();
     }
 
     // Update camera
-    const f32 cameraMoveSpeedPerSecond = flagIsSet(inputState.down, InputType::SHIFT) ? cameraRunMoveSpeedPerSecond : cameraWalkMoveSpeedPerSecond;
-    f32 forwardDeltaUnits = static_cast<f32>(stopwatch.deltaSeconds * cameraMoveSpeedPerSecond * (flagIsSet(inputState.down, InputType::W) - flagIsSet(inputState.down, InputType::S)));
-    f32 rightDeltaUnits = static_cast<f32>(stopwatch.deltaSeconds * cameraMoveSpeedPerSecond * (flagIsSet(inputState.down, InputType::D) - flagIsSet(inputState.down, InputType::A)));
+    const f32 cameraMoveSpeedPerSecond = flagIsSet(inputState.down, InputAction::Run) ? cameraRunMoveSpeedPerSecond : cameraWalkMoveSpeedPerSecond;
+    f32 forwardDeltaUnits = static_cast<f32>(stopwatch.deltaSeconds * cameraMoveSpeedPerSecond * (flagIsSet(inputState.down, InputAction::MoveForward) - flagIsSet(inputState.down, InputAction::MoveBack)));
+    f32 rightDeltaUnits = static_cast<f32>(stopwatch.deltaSeconds * cameraMoveSpeedPerSecond * (flagIsSet(inputState.down, InputAction::MoveRight) - flagIsSet(inputState.down, InputAction::MoveLeft)));
     glm::vec3 cameraPosDelta = glm::vec3(
             forwardDeltaUnits * camera.forward.x + rightDeltaUnits * camera.right.x,
             0.0f,
@@ -199,72 +596,126 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
     f32 cameraYawDelta = hiddenMouse ? static_cast<f32>(stopwatch.deltaSeconds * cameraYawRotationSpeedPerSecond * -inputState.mouseDeltaX) : 0.0f;
     glm::mat4 viewMat = updateCamera(&camera, glm::vec3(cameraPosDelta), cameraPitchDelta, cameraYawDelta);
 
-    // Use keyboard input to move our quad
-    const f32 spriteMoveSpeedPerSecond = flagIsSet(inputState.down, InputType::SHIFT) ? spriteRunTilesPerSecond : spriteWalkTilesPerSecond;
-    glm::vec2 spriteDelta = glm::vec2(
-            stopwatch.deltaSeconds * spriteMoveSpeedPerSecond * static_cast<f32>(flagIsSet(inputState.down, InputType::RIGHT) - flagIsSet(inputState.down, InputType::LEFT)),
-            stopwatch.deltaSeconds * spriteMoveSpeedPerSecond * static_cast<f32>(flagIsSet(inputState.down, InputType::UP) - flagIsSet(inputState.down, InputType::DOWN))
+    // Use keyboard input to move our quad, scaled by how much of the frame each key was actually held
+    const f32 spriteMoveSpeedPerSecond = flagIsSet(inputState.down, InputAction::Run) ? spriteRunTilesPerSecond : spriteWalkTilesPerSecond;
+    auto heldFraction = [&](InputAction action) { return actionHeldFraction(inputEvents, inputMap, action, flagIsSet(prevActionsDown, action)); };
+    getComponent<SpriteComponent>(&world, spriteEntity)->velocity = glm::vec2(
+            spriteMoveSpeedPerSecond * (heldFraction(InputAction::SpriteRight) - heldFraction(InputAction::SpriteLeft)),
+            spriteMoveSpeedPerSecond * (heldFraction(InputAction::SpriteUp) - heldFraction(InputAction::SpriteDown))
             );
-    spritePosition += spriteDelta;
-    spritePosition.x = Clamp(spritePosition.x, 0.5f, emulatedSpriteResolution.x - 0.5f);
-    spritePosition.y = Clamp(spritePosition.y, 0.5f, emulatedSpriteResolution.y - 0.5f);
-
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glBindBuffer(GL_UNIFORM_BUFFER, modelViewProjUboId);
-    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ModelViewProjUBO, view), sizeof(glm::mat4), &viewMat);
-
-    // draw cube
-    glUseProgram(texShaderProgram.id);
-    glm::mat4 cubeFrameModelMat = cubeTranslationMat * glm::rotate(cubeScaleRotationMat, static_cast<f32>(cubeActiveRotationPerSecond * stopwatch.totalElapsedSeconds), cubeActiveRotationAxis);
-    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ModelViewProjUBO, model), sizeof(glm::mat4), &cubeFrameModelMat);
-    glDisable(GL_CULL_FACE);
-    setSampler2D(texShaderProgram.id, "albedoTex", spiritTexIndex);
-    drawTriangles(cubeVertAtt);
-    glEnable(GL_CULL_FACE);
 
-    // draw debug quad
-    glUseProgram(debugQuadShaderProgram.id);
-    glBindBuffer(GL_UNIFORM_BUFFER, posUboId);
-    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PosUBO, pos), sizeof(glm::vec2), &spritePosition);
-    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PosUBO, pos), sizeof(glm::vec2), &spritePosition);
-    drawModel(quadModel);
+    // simulate
+    updateSpriteSystem(&world, &spriteQuery, stopwatch.deltaSeconds, emulatedSpriteResolution);
 
-    // draw sprite
-    glUseProgram(spriteShaderProgram.id);
-    glBindBuffer(GL_UNIFORM_BUFFER, posUboId);
-    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PosUBO, pos), sizeof(glm::vec2), &spritePosition);
-    setSampler2D(spriteShaderProgram.id, "albedoTex", birdTexIndex);
-    drawModel(quadModel);
-
-    // draw Dear ImGui
-    newFrameImGui();
-    {
+    // a sprite pushing against the edge of the screen scrolls the tile map, and leaves a trail of tiles wherever it goes
+    const SpriteComponent* sprite = getComponent<SpriteComponent>(&world, spriteEntity);
+    auto edgeScroll = [](f32 position, f32 velocity, f32 maxPosition) {
+      return ((position <= 0.5f && velocity < 0.0f) || (position >= maxPosition - 0.5f && velocity > 0.0f)) ? velocity : 0.0f;
+    };
+    tileMapViewOrigin += glm::vec2(edgeScroll(sprite->position.x, sprite->velocity.x, (f32)emulatedSpriteResolution.x),
+                                   edgeScroll(sprite->position.y, sprite->velocity.y, (f32)emulatedSpriteResolution.y)) * (f32)stopwatch.deltaSeconds;
+    tileMapViewOrigin.x = Clamp(tileMapViewOrigin.x, 0.0f, maxTileMapViewOrigin.x);
+    tileMapViewOrigin.y = Clamp(tileMapViewOrigin.y, 0.0f, maxTileMapViewOrigin.y);
+    glm::vec2 spriteMapPosition = tileMapViewOrigin + sprite->position;
+    setTile(&tileMap, (u32)spriteMapPosition.x, (u32)spriteMapPosition.y, trailTile);
+    updateTransformSystem(&world, &spinQuery, &sceneTransforms, stopwatch.totalElapsedSeconds);
+    updateAudioEmitterSystem(&world, &audioEmitterQuery, audioHandle, stopwatch.deltaSeconds);
+
+    FramePacket* framePacket = beginFramePacket(&renderer, inputPerfCounter);
+    framePacket->viewMat = viewMat;
+    framePacket->projMat = projMat;
+    framePacket->windowDimens = appState.windowDimens;
+    framePacket->emulatedResolution = emulatedSpriteResolution;
+    framePacket->pixelScale = pixelScale;
+    framePacket->dynamicResolution = dynamicResolutionSettings;
+    framePacket->spriteCount = renderSpriteSystem(&world, &spriteQuery, framePacket->spritePositions, FRAME_PACKET_MAX_SPRITES);
+    tileMapView(tileMap, tileMapViewOrigin, emulatedSpriteResolution, &framePacket->tileMapView);
+
+    // record static geometry
+    u32 fullDetailTriangleCount = renderStaticMeshSystem(&world, &staticMeshQuery, sceneTransforms, &cullingBoxes, frustumFromProjView(projMat * viewMat),
+                                                         camera.origin, projMat, lodEnabled, &sceneBVH, &framePacket->staticDraws, &cullStats);
+    refitBVH(&sceneBVH);
+    u32 crosshairObject;
+    f32 crosshairDistance;
+    bool crosshairHit = raycastBVH(sceneBVH, screenPointToRay(camera, projMat, glm::vec2(0.0f)), &crosshairObject, &crosshairDistance);
+
+    // record Dear ImGui, frames between UI updates reuse the last draw data
+    u64 uiBeginCounter = getPerformanceCounter();
+    if(uiNeedsUpdate(&uiThrottle, inputEvents, !hiddenMouse) || windowResized) {
+      newFrameImGui();
       if(showNavBar) {
         if (ImGui::BeginMainMenuBar())
         {
           if (ImGui::BeginMenu("Edit"))
           {
-            if (ImGui::MenuItem("Toggle Camera/Mouse", "Tab")) {
+            if (ImGui::MenuItem("Toggle Camera/Mouse", inputBindingName(inputMap, InputAction::ToggleMouseCapture))) {
               toggleMouseAndCameraControl();
             }
-            if (ImGui::MenuItem("Toggle Music", "Q")) {
+            if (ImGui::MenuItem("Toggle Music", inputBindingName(inputMap, InputAction::ToggleMusic))) {
               toggleMusic();
             }
-            if (ImGui::MenuItem("Play Sound Effect", "E")) {
-              playSoundEffect(audioHandle);
+            if (ImGui::MenuItem("Play Sound Effect", inputBindingName(inputMap, InputAction::PlaySoundEffect))) {
+              triggerSoundEffect();
+            }
+            if (ImGui::MenuItem("Record Input Events", nullptr, recordingInput)) {
+              toggleInputRecording();
             }
             ImGui::EndMenu();
           }
           if (ImGui::BeginMenu("View"))
           {
-            if(ImGui::MenuItem("Navigation Bar", "Alt")) {
+            if(ImGui::MenuItem("Navigation Bar", inputBindingName(inputMap, InputAction::ToggleNavBar))) {
               showNavBar = !showNavBar;
             }
             if (ImGui::MenuItem("Demo Window", nullptr)) {
               showDemoWindow = !showDemoWindow;
             }
-            if (ImGui::MenuItem("FPS", nullptr)) {
-              showFPS = !showFPS;
+            if (ImGui::MenuItem("Stats HUD", nullptr, showStatsHud)) {
+              showStatsHud = !showStatsHud;
+            }
+            if (ImGui::MenuItem("Controls", nullptr, showControls)) {
+              showControls = !showControls;
+            }
+            if (ImGui::BeginMenu("Pixel Scale")) {
+              for(u32 scale = 1; scale <= PIXEL_SCALE_MAX; ++scale) {
+                char label[8];
+                snprintf(label, sizeof(label), "%ux", scale);
+                if (ImGui::MenuItem(scale == 1 ? "Off" : label, nullptr, pixelScale == scale)) {
+                  pixelScale = scale;
+                }
+              }
+              ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Dynamic Resolution")) {
+              if (ImGui::MenuItem("Enabled", nullptr, dynamicResolutionSettings.enabled, pixelScale == 1)) {
+                dynamicResolutionSettings.enabled = !dynamicResolutionSettings.enabled;
+              }
+              const u32 targetFpsOptions[] = { 30, 60, 120 };
+              for(u32 targetFps : targetFpsOptions) {
+                char label[16];
+                snprintf(label, sizeof(label), "Target %u fps", targetFps);
+                f32 targetFrameMs = 1000.0f / (f32)targetFps;
+                if (ImGui::MenuItem(label, nullptr, fabsf(dynamicResolutionSettings.targetFrameMs - targetFrameMs) < 0.01f)) {
+                  dynamicResolutionSettings.targetFrameMs = targetFrameMs;
+                }
+              }
+              ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("UI Update Rate")) {
+              for(u32 interval = 1; interval <= UI_UPDATE_INTERVAL_MAX; interval *= 2) {
+                char label[24];
+                snprintf(label, sizeof(label), "Every %u Frames", interval);
+                if (ImGui::MenuItem(interval == 1 ? "Every Frame" : label, nullptr, uiThrottle.interval == interval)) {
+                  uiThrottle.interval = interval;
+                }
+              }
+              ImGui::EndMenu();
+            }
+            if (ImGui::MenuItem("Level of Detail", nullptr, lodEnabled)) {
+              lodEnabled = !lodEnabled;
+            }
+            if (ImGui::MenuItem("Render Thread", nullptr, renderThreadEnabled)) {
+              renderThreadEnabled = !renderThreadEnabled; // applied once this frame's packet is submitted
             }
             if (ImGui::MenuItem("Toggle Music", nullptr)) {
               playMusic = !playMusic;
@@ -272,28 +723,147 @@ void scene(WINDOW_HANDLE windowHandle, AUDIO_HANDLE audioHandle) {
             }
             ImGui::EndMenu();
           }
+          if (ImGui::BeginMenu("Benchmarks")) // results are printed to stdout
+          {
+            if (ImGui::MenuItem("BVH vs Brute Force", nullptr)) {
+              benchmarkBVH();
+            }
+            if (ImGui::MenuItem("Generation Map vs unordered_map", nullptr)) {
+              benchmarkGenerationMap();
+            }
+            if (ImGui::MenuItem("Job System Scaling", nullptr)) {
+              benchmarkJobSystem();
+            }
+            if (ImGui::MenuItem("Coroutine Tasks", nullptr)) {
+              benchmarkTasks();
+            }
+            if (ImGui::MenuItem("Transform Hierarchy", nullptr)) {
+              benchmarkTransforms();
+            }
+            if (ImGui::MenuItem("Entity Component Store", nullptr)) {
+              benchmarkEcs();
+            }
+            if (ImGui::MenuItem("Skeletal Animation", nullptr)) {
+              benchmarkAnimation();
+            }
+            if (ImGui::MenuItem("Virtual File System", nullptr)) {
+              benchmarkVfs();
+            }
+            if (ImGui::MenuItem("Async File Reads", nullptr)) {
+              benchmarkAsyncIo();
+            }
+            if (ImGui::MenuItem("Texture Decode", nullptr)) {
+              benchmarkTextureDecode();
+            }
+            if (ImGui::MenuItem("SIMD Math", nullptr)) {
+              benchmarkSimdMath();
+            }
+            if (ImGui::MenuItem("Tile Map", nullptr)) {
+              benchmarkTileMap();
+            }
+            ImGui::EndMenu();
+          }
           ImGui::EndMainMenuBar();
         }
       }
       if(showDemoWindow) {
         ImGui::ShowDemoWindow(&showDemoWindow);
       }
-      fpsSampler.addValue(stopwatch.deltaSeconds);
-      const ImGuiWindowFlags textNoFrills = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoResize;
-      if(showFPS){
-        if(ImGui::Begin("FPS", &showFPS, textNoFrills)) {
-          ImGui::Text("%5.1f ms | %3.1f fps", fpsSampler.average() * 1000.0, 1.0 / fpsSampler.average());
+      if(showControls) {
+        if(ImGui::Begin("Controls", &showControls)) {
+          for(u32 i = 0; i < ArrayCount(inputActions); ++i) {
+            ImGui::PushID(i);
+            ImGui::Text("%-20s", inputActionNames[i]);
+            ImGui::SameLine();
+            if(ImGui::Button(rebindingAction == inputActions[i] ? "Press a key..." : inputBindingName(inputMap, inputActions[i]))) {
+              rebindingAction = inputActions[i];
+            }
+            ImGui::PopID();
+          }
+          if(ImGui::Button("Reset to Defaults")) {
+            inputMap = defaultInputMap();
+            rebindingAction = (InputAction)0;
+          }
         }ImGui::End();
       }
+      if(showDebug) {
+        clearDebugLog(&debugLog);
+        const glm::vec2& spritePosition = getComponent<SpriteComponent>(&world, spriteEntity)->position;
+        logV(&debugLog, "Pos: {X = %2.2f, Y = %2.2f}", spritePosition.x, spritePosition.y);
+        logV(&debugLog, "Input events: %u | dropped: %u%s", inputEvents.eventCount, inputEvents.droppedCount, recordingInput ? " | recording" : "");
+        logV(&debugLog, "Entities: %u | archetypes: %u", entityCount(world), world.archetypeCount);
+        RenderStats frameRenderStats = renderStats(&renderer);
+        logV(&debugLog, "Static draws: %u | buckets: %u | GL draw calls: %u",
+             frameRenderStats.staticGeometry.drawCount, frameRenderStats.staticGeometry.bucketCount, frameRenderStats.staticGeometry.glDrawCallCount);
+        logV(&debugLog, "Triangles: %u (LOD off: %u)", frameRenderStats.staticGeometry.triangleCount, fullDetailTriangleCount);
+        logV(&debugLog, "Render thread: %s | input to swap: %.2f ms | render: %.1f fps | dropped packets: %llu",
+             renderThreadEnabled ? "on" : "off", frameRenderStats.inputToSwapSeconds * 1000.0, frameRenderStats.framesPerSecond, frameRenderStats.droppedCount);
+        f32 renderScale = sceneRenderState.dynamicResolution.publishedScale.load();
+        ivec2 renderDimens = pixelScale > 1 ? pixelScaledDimens(appState.windowDimens, pixelScale) :
+                             dynamicResolutionSettings.enabled ? dynamicRenderDimens(renderScale, appState.windowDimens) : appState.windowDimens;
+        logV(&debugLog, "Render resolution: %d x %d | window: %d x %d", renderDimens.x, renderDimens.y, appState.windowDimens.x, appState.windowDimens.y);
+        logV(&debugLog, "GPU frame: %.2f ms | dynamic resolution: %s (target %.1f ms, scale %.2f)", sceneRenderState.dynamicResolution.publishedGpuMs.load(),
+             dynamicResolutionSettings.enabled && pixelScale == 1 ? "on" : "off", dynamicResolutionSettings.targetFrameMs, renderScale);
+        logV(&debugLog, "Tile map: %u / %u chunks on screen | chunk bakes: %u", framePacket->tileMapView.chunkCount,
+             tileMap.chunkColumns * tileMap.chunkRows, tileMap.bakeCount.load());
+        logV(&debugLog, "Culled: %u / %u | %.3f ms", cullStats.culledCount, cullStats.testedCount, cullStats.cullSeconds * 1000.0);
+        logV(&debugLog, "Memory allocs/high water (KB): permanent %u/%llu | frame %u/%llu | temp %u/%llu",
+             memoryStats.permanent.allocationCount, (u64)(memoryStats.permanent.highWaterMark / Kilobytes(1)),
+             memoryStats.frame.allocationCount, (u64)(memoryStats.frame.highWaterMark / Kilobytes(1)),
+             memoryStats.temp.allocationCount, (u64)(memoryStats.temp.highWaterMark / Kilobytes(1)));
+        if(crosshairHit) {
+          logV(&debugLog, "Crosshair: %s (%.2f units)", crosshairObject == cubeBVHObject ? "cube" : "unknown", crosshairDistance);
+        } else {
+          logV(&debugLog, "Crosshair: nothing");
+        }
+        logV(&debugLog, "UI: %.3f ms per frame | rebuilt at least every %u frames", uiThrottle.cpuSeconds * 1000.0, uiThrottle.interval);
+        submitDebugLog(debugLog, "General Debug", &showDebug);
+      }
+      recordImGuiDrawData(framePacket, endFrameImGui());
+    } else {
+      recordImGuiDrawData(framePacket, ImGui::GetDrawData());
+    }
+    endUiFrame(&uiThrottle, uiBeginCounter);
 
-      logV(&showDebug, "Pos: {X = %2.2f, Y = %2.2f}", spritePosition.x, spritePosition.y);
+    // stats HUD, drawn without ImGui so it stays current between UI updates
+    fpsSampler.addValue(stopwatch.deltaSeconds);
+    if(showStatsHud) {
+      snprintf(framePacket->statsHudText, STATS_HUD_MAX_CHARS, "%5.1f ms %5.1f fps\nrender %5.1f fps\nui %6.3f ms",
+               fpsSampler.average() * 1000.0, 1.0 / fpsSampler.average(), renderStats(&renderer).framesPerSecond, uiThrottle.cpuSeconds * 1000.0);
     }
-    renderImGui();
 
-    swapBuffers(windowHandle);
+    submitFramePacket(&renderer, framePacket);
+    setRenderThreadEnabled(&renderer, renderThreadEnabled);
+    if(replaying) {
+      addReplayTiming(&replayTimings, (f64)(getPerformanceCounter() - frameBeginCounter) / (f64)getPerformanceCounterFrequencyPerSecond(), recordedDeltaSeconds);
+    }
+  }
+
+  deinitRenderer(&renderer); // GL context is current on this thread again
+  deinitRenderTarget(&sceneRenderState.lowResTarget);
+  deinitGpuTimer(&sceneRenderState.gpuTimer);
+  deinitStatsHud(&sceneRenderState.statsHud);
+  if(recordingInput) {
+    toggleInputRecording(); // saves what was recorded so far
+  }
+  if(options.recordFileName) {
+    if(saveInputEventRecording(&replayRecording, options.recordFileName)) {
+      printf("Recorded %u frames to replay from %s\n", replayRecording.frameCount, options.recordFileName);
+    }
+    deinitInputEventRecording(&replayRecording);
+  }
+  if(replaying) {
+    saveReplayTimings(replayTimings, options.replayFileName);
+    deinitReplayTimings(&replayTimings);
+    closeReplayPlayback(&replayPlayback);
   }
 
   // cleanup vertex attributes/models
-  deleteVertexAtts(&cubeVertAtt);
   deleteModels(&quadModel);
+  deinitStaticGeometryPool(&staticGeometryPool);
+  deinitTileMap(&tileMap);
+  deinitCullingBoxes(&cullingBoxes);
+  deinitBVH(&sceneBVH);
+  deinitTransformHierarchy(&sceneTransforms);
+  deinitEcsWorld(&world);
 }
\ No newline at end of file
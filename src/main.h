@@ -12,25 +12,87 @@
 #include "tinygltf/tiny_gltf.h"
 
 #include <cassert>
+#include <cfloat>
+#include <algorithm>
+#include <new>
 #include <iostream>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
+#include <cerrno>
+#include <bit>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
 
 #define GLM_FORCE_LEFT_HANDED
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/rotate_vector.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 #include "types.h"
+#include "gl_extensions.h"
 #include "platform.h"
 #include "util.h"
+#include "memory.h"
+#include "jobs.h"
+#include "input_events.h"
+#include "input_map.h"
+#include "replay.h"
+#include "pack_format.h"
+#include "async_io.h"
+#include "vfs.h"
+#include "tasks.h"
 #include "platform.cpp"
 #include "gl_structs.h"
 #include "gl_util.h"
+#include "image_ops.h"
 #include "texture.h"
+#include "render_target.h"
+#include "dynamic_resolution.h"
+#include "debug_overlay.h"
+#include "mesh_optimize.h"
+#include "transform.h"
+#include "animation.h"
 #include "model.h"
+#include "lod.h"
+#include "static_geometry.h"
+#include "tilemap.h"
+#include "render_thread.h"
+#include "culling.h"
 #include "shader_program.h"
 #include "simple_vertex_atts.h"
 const glm::vec3 worldUp{0.0f, 1.0f, 0.0f};
+#include "simd_math.h"
 #include "camera.h"
-
-#define OUT
\ No newline at end of file
+#include "bvh.h"
+#include "components.h"
+#include "ecs.h"
+#include "systems.h"
\ No newline at end of file
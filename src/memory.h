@@ -0,0 +1,151 @@
+#pragma once
+
+// Arena allocators
+// - permanent arena: lives as long as the application, individual allocations are never freed
+// - frame arena: linear scratch memory that is reset at the start of every frame
+// - temp arenas: one per thread, scoped with beginTempMemory()/endTempMemory() markers
+// Arenas reserve their whole size up front and commit it in ARENA_COMMIT_SIZE steps as it is first used.
+
+#define PERMANENT_ARENA_SIZE Megabytes(64)
+#define FRAME_ARENA_SIZE Megabytes(16)
+#define TEMP_ARENA_SIZE Megabytes(128) // import time mesh processing is the largest user
+#define ARENA_DEFAULT_ALIGNMENT 16
+#define ARENA_COMMIT_SIZE Kilobytes(256) // multiple of the page size
+
+struct Arena {
+  u8* base;
+  memory_index size;
+  memory_index used;
+  memory_index committed;
+  const char* name;
+
+  // stats since the last resetArenaStats()
+  u32 allocationCount;
+  memory_index highWaterMark;
+};
+
+struct TempMemory {
+  Arena* arena;
+  memory_index used;
+};
+
+struct ArenaStats {
+  u32 allocationCount;
+  memory_index highWaterMark;
+  memory_index size;
+};
+
+struct MemoryFrameStats {
+  ArenaStats permanent;
+  ArenaStats frame;
+  ArenaStats temp; // calling thread's temp arena
+};
+
+void initArena(Arena* arena, memory_index size, const char* name) {
+  *arena = {};
+  arena->base = (u8*)reserveMemory(size);
+  assert(arena->base != nullptr && "ERROR: Could not reserve arena memory!");
+  arena->size = size;
+  arena->name = name;
+}
+
+void deinitArena(Arena* arena) {
+  if(arena->base != nullptr) {
+    releaseMemory(arena->base, arena->size);
+  }
+  *arena = {}; // clear to zero
+}
+
+void* pushSize(Arena* arena, memory_index size, memory_index alignment = ARENA_DEFAULT_ALIGNMENT) {
+  memory_index alignedUsed = (arena->used + (alignment - 1)) & ~(alignment - 1);
+  assert(alignedUsed + size <= arena->size && "ERROR: Arena is out of memory!");
+  if(alignedUsed + size > arena->committed) {
+    memory_index commitEnd = (alignedUsed + size + ARENA_COMMIT_SIZE - 1) & ~(memory_index)(ARENA_COMMIT_SIZE - 1);
+    memory_index committed = Min(commitEnd, arena->size);
+    bool commitSucceeded = commitMemory(arena->base + arena->committed, committed - arena->committed);
+    assert(commitSucceeded && "ERROR: Could not commit arena memory!");
+    (void)commitSucceeded;
+    arena->committed = committed;
+  }
+  void* result = arena->base + alignedUsed;
+  arena->used = alignedUsed + size;
+  arena->allocationCount++;
+  arena->highWaterMark = Max(arena->highWaterMark, arena->used);
+  return result;
+}
+
+void* pushSizeZero(Arena* arena, memory_index size, memory_index alignment = ARENA_DEFAULT_ALIGNMENT) {
+  void* result = pushSize(arena, size, alignment);
+  memset(result, 0, size);
+  return result;
+}
+
+#define pushStruct(arena, type) (type*)pushSize(arena, sizeof(type), alignof(type))
+#define pushArray(arena, count, type) (type*)pushSize(arena, (memory_index)(count) * sizeof(type), alignof(type))
+#define pushArrayZero(arena, count, type) (type*)pushSizeZero(arena, (memory_index)(count) * sizeof(type), alignof(type))
+
+inline void resetArena(Arena* arena) { arena->used = 0; }
+
+inline void resetArenaStats(Arena* arena) {
+  arena->allocationCount = 0;
+  arena->highWaterMark = arena->used;
+}
+
+inline ArenaStats arenaStats(const Arena& arena) {
+  return ArenaStats{ arena.allocationCount, arena.highWaterMark, arena.size };
+}
+
+// Everything pushed after beginTempMemory() is released by the matching endTempMemory()
+inline TempMemory beginTempMemory(Arena* arena) {
+  return TempMemory{ arena, arena->used };
+}
+
+inline void endTempMemory(TempMemory tempMemory) {
+  assert(tempMemory.arena->used >= tempMemory.used && "ERROR: Temp memory markers ended out of order!");
+  tempMemory.arena->used = tempMemory.used;
+}
+
+global Arena permanentArena;
+global Arena frameArena;
+
+struct ThreadTempArena {
+  Arena arena;
+  ~ThreadTempArena() { deinitArena(&arena); }
+};
+thread_local ThreadTempArena threadTempArenaStorage;
+
+// Address space is reserved the first time a thread asks for its temp arena
+Arena* threadTempArena() {
+  Arena* arena = &threadTempArenaStorage.arena;
+  if(arena->base == nullptr) {
+    initArena(arena, TEMP_ARENA_SIZE, "temp");
+  }
+  return arena;
+}
+
+void initMemory() {
+  initArena(&permanentArena, PERMANENT_ARENA_SIZE, "permanent");
+  initArena(&frameArena, FRAME_ARENA_SIZE, "frame");
+}
+
+void deinitMemory() {
+  deinitArena(&permanentArena);
+  deinitArena(&frameArena);
+}
+
+// Resets the frame arena and returns what the previous frame allocated
+MemoryFrameStats beginFrameMemory() {
+  Arena* tempArena = threadTempArena();
+  assert(tempArena->used == 0 && "ERROR: Temp memory was not released before the end of the frame!");
+
+  MemoryFrameStats stats;
+  stats.permanent = arenaStats(permanentArena);
+  stats.frame = arenaStats(frameArena);
+  stats.temp = arenaStats(*tempArena);
+
+  resetArena(&frameArena);
+  resetArenaStats(&frameArena);
+  resetArenaStats(&permanentArena);
+  resetArenaStats(tempArena);
+  return stats;
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+#pragma once
+
+// Import-time mesh optimization
+// 1. Post-transform vertex cache: triangles are reordered with Tipsify so recently transformed vertices get reused
+// 2. Overdraw: Tipsify's output is split into clusters at its dead ends, clusters facing away from the mesh's
+//    center are drawn first so they are more likely to occlude the rest
+// 3. Vertex fetch: vertices are reordered (and unused ones dropped) to the order the indices first reference them
+// source: "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", Sander, Nehab & Barczak 2007
+
+#define VERTEX_CACHE_SIZE 16 // FIFO entries used to simulate the post-transform cache
+
+struct VertexCacheStats {
+  f32 acmr; // average cache miss ratio: transformed vertices per triangle, 0.5 is ideal for large grids, 3.0 is worst
+  f32 atvr; // average transform to vertex ratio: 1.0 is ideal
+  u32 vertexShaderInvocations;
+};
+
+VertexCacheStats analyzeVertexCache(const u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize = VERTEX_CACHE_SIZE) {
+  // a vertex is in the FIFO cache if fewer than cacheSize misses happened since it was last inserted
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* insertedAt = pushArray(tempMemory.arena, vertexCount, u32);
+  bool* referenced = pushArrayZero(tempMemory.arena, vertexCount, bool);
+  u32 misses = 0;
+  u32 uniqueVertices = 0;
+  for(u32 i = 0; i < indexCount; ++i) {
+    u32 v = indices[i];
+    if(!referenced[v]) {
+      referenced[v] = true;
+      uniqueVertices++;
+      insertedAt[v] = misses++;
+    } else if(misses - insertedAt[v] >= cacheSize) {
+      insertedAt[v] = misses++;
+    }
+  }
+  endTempMemory(tempMemory);
+
+  VertexCacheStats stats;
+  stats.vertexShaderInvocations = misses;
+  stats.acmr = indexCount > 0 ? misses / (indexCount / 3.0f) : 0.0f;
+  stats.atvr = uniqueVertices > 0 ? misses / (f32)uniqueVertices : 0.0f;
+  return stats;
+}
+
+// Reorders triangles in place for vertex cache locality and then for overdraw. positions are 3 floats per vertex,
+// positionStrideInFloats apart.
+void optimizeTriangleOrder(u32* indices, u32 indexCount, u32 vertexCount, const f32* positions, u32 positionStrideInFloats, u32 cacheSize = VERTEX_CACHE_SIZE) {
+  u32 triangleCount = indexCount / 3;
+  if(triangleCount == 0) { return; }
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  Arena* arena = tempMemory.arena;
+
+  // vertex to triangle adjacency
+  u32* liveTriangles = pushArrayZero(arena, vertexCount, u32);
+  for(u32 i = 0; i < indexCount; ++i) { liveTriangles[indices[i]]++; }
+  u32* adjacencyOffsets = pushArray(arena, vertexCount + 1, u32);
+  adjacencyOffsets[0] = 0;
+  for(u32 v = 0; v < vertexCount; ++v) { adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v]; }
+  u32* adjacency = pushArray(arena, indexCount, u32);
+  u32* adjacencyFill = pushArray(arena, vertexCount, u32);
+  memcpy(adjacencyFill, adjacencyOffsets, vertexCount * sizeof(u32));
+  for(u32 i = 0; i < indexCount; ++i) { adjacency[adjacencyFill[indices[i]]++] = i / 3; }
+
+  u32* cacheTime = pushArrayZero(arena, vertexCount, u32);
+  bool* emitted = pushArrayZero(arena, triangleCount, bool);
+  u32* deadEndStack = pushArray(arena, indexCount, u32);
+  u32 deadEndCount = 0;
+  u32* candidates = pushArray(arena, indexCount, u32);
+  u32* orderedTriangles = pushArray(arena, triangleCount, u32);
+  u32 orderedCount = 0;
+  u32* clusterStarts = pushArray(arena, triangleCount + 1, u32);
+  u32 clusterCount = 0;
+
+  u32 timestamp = cacheSize + 1;
+  u32 scanCursor = 0;
+  s64 fanningVertex = 0;
+  while(liveTriangles[fanningVertex] == 0 && fanningVertex + 1 < vertexCount) { fanningVertex++; }
+  clusterStarts[clusterCount++] = 0;
+  while(fanningVertex >= 0) {
+    u32 candidateCount = 0;
+    for(u32 adj = adjacencyOffsets[fanningVertex]; adj < adjacencyOffsets[fanningVertex + 1]; ++adj) {
+      u32 triangle = adjacency[adj];
+      if(emitted[triangle]) { continue; }
+      for(u32 corner = 0; corner < 3; ++corner) {
+        u32 v = indices[triangle * 3 + corner];
+        deadEndStack[deadEndCount++] = v;
+        candidates[candidateCount++] = v;
+        liveTriangles[v]--;
+        if(timestamp - cacheTime[v] > cacheSize) {
+          cacheTime[v] = timestamp++;
+        }
+      }
+      emitted[triangle] = true;
+      orderedTriangles[orderedCount++] = triangle;
+    }
+
+    // next fanning vertex: the candidate that will still be in the cache after its remaining triangles are emitted
+    s64 next = -1;
+    s32 bestPriority = -1;
+    for(u32 i = 0; i < candidateCount; ++i) {
+      u32 v = candidates[i];
+      if(liveTriangles[v] == 0) { continue; }
+      s32 priority = 0;
+      if(timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+        priority = (s32)(timestamp - cacheTime[v]);
+      }
+      if(priority > bestPriority) {
+        bestPriority = priority;
+        next = v;
+      }
+    }
+    if(next < 0) {
+      // dead end, which is also where clusters are split for overdraw sorting
+      while(deadEndCount > 0 && next < 0) {
+        u32 v = deadEndStack[--deadEndCount];
+        if(liveTriangles[v] > 0) { next = v; }
+      }
+      while(next < 0 && scanCursor < vertexCount) {
+        if(liveTriangles[scanCursor] > 0) { next = scanCursor; }
+        scanCursor++;
+      }
+      if(next >= 0 && orderedCount > clusterStarts[clusterCount - 1]) {
+        clusterStarts[clusterCount++] = orderedCount;
+      }
+    }
+    fanningVertex = next;
+  }
+  assert(orderedCount == triangleCount);
+  if(clusterStarts[clusterCount - 1] == orderedCount) { clusterCount--; }
+  clusterStarts[clusterCount] = orderedCount;
+
+  // sort clusters by how much they face away from the mesh's center
+  glm::vec3 meshCentroid{0.0f};
+  for(u32 v = 0; v < vertexCount; ++v) {
+    const f32* p = positions + (v * positionStrideInFloats);
+    meshCentroid += glm::vec3(p[0], p[1], p[2]);
+  }
+  meshCentroid = meshCentroid / (f32)Max(vertexCount, 1u);
+  f32* clusterSortKeys = pushArray(arena, clusterCount, f32);
+  u32* clusterOrder = pushArray(arena, clusterCount, u32);
+  for(u32 cluster = 0; cluster < clusterCount; ++cluster) {
+    glm::vec3 areaWeightedCentroid{0.0f};
+    glm::vec3 areaWeightedNormal{0.0f};
+    f32 totalArea = 0.0f;
+    for(u32 i = clusterStarts[cluster]; i < clusterStarts[cluster + 1]; ++i) {
+      const u32* tri = indices + (orderedTriangles[i] * 3);
+      const f32* p0 = positions + (tri[0] * positionStrideInFloats);
+      const f32* p1 = positions + (tri[1] * positionStrideInFloats);
+      const f32* p2 = positions + (tri[2] * positionStrideInFloats);
+      glm::vec3 v0(p0[0], p0[1], p0[2]), v1(p1[0], p1[1], p1[2]), v2(p2[0], p2[1], p2[2]);
+      glm::vec3 normal = cross(v1 - v0, v2 - v0); // length is twice the area
+      f32 area = length(normal) * 0.5f;
+      areaWeightedNormal += normal;
+      areaWeightedCentroid += (v0 + v1 + v2) * (area / 3.0f);
+      totalArea += area;
+    }
+    glm::vec3 clusterCentroid = totalArea > 0.0f ? areaWeightedCentroid / totalArea : glm::vec3(0.0f);
+    f32 normalLength = length(areaWeightedNormal);
+    glm::vec3 clusterNormal = normalLength > 0.0f ? areaWeightedNormal / normalLength : glm::vec3(0.0f);
+    clusterSortKeys[cluster] = dot(clusterCentroid - meshCentroid, clusterNormal);
+    clusterOrder[cluster] = cluster;
+  }
+  std::stable_sort(clusterOrder, clusterOrder + clusterCount, [clusterSortKeys](u32 a, u32 b) {
+    return clusterSortKeys[a] > clusterSortKeys[b];
+  });
+
+  u32* result = deadEndStack; // no longer needed, large enough for every index
+  u32 resultCount = 0;
+  for(u32 i = 0; i < clusterCount; ++i) {
+    u32 cluster = clusterOrder[i];
+    for(u32 t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; ++t) {
+      memcpy(result + resultCount, indices + (orderedTriangles[t] * 3), 3 * sizeof(u32));
+      resultCount += 3;
+    }
+  }
+  memcpy(indices, result, triangleCount * 3 * sizeof(u32));
+
+  endTempMemory(tempMemory);
+
+}
+
+// Rewrites indices so vertices are numbered in the order they are first referenced.
+// outRemap maps old vertex to new vertex (U32_MAX for unreferenced vertices). Returns the new vertex count.
+u32 optimizeVertexFetchRemap(u32* indices, u32 indexCount, u32 vertexCount, u32* outRemap) {
+  memset(outRemap, 0xFF, vertexCount * sizeof(u32));
+  u32 newVertexCount = 0;
+  for(u32 i = 0; i < indexCount; ++i) {
+    u32& remapped = outRemap[indices[i]];
+    if(remapped == U32_MAX) {
+      remapped = newVertexCount++;
+    }
+    indices[i] = remapped;
+  }
+  return newVertexCount;
+}
+
+// dst must not overlap src
+void remapVertices(void* dst, const void* src, u32 vertexCount, u32 vertexSizeInBytes, const u32* remap) {
+  for(u32 v = 0; v < vertexCount; ++v) {
+    if(remap[v] != U32_MAX) {
+      memcpy((u8*)dst + ((memory_index)remap[v] * vertexSizeInBytes), (const u8*)src + ((memory_index)v * vertexSizeInBytes), vertexSizeInBytes);
+    }
+  }
+}
+
+void narrowIndices(u16* dst, const u32* src, u32 indexCount) {
+  for(u32 i = 0; i < indexCount; ++i) {
+    assert(src[i] <= 0xFFFF);
+    dst[i] = (u16)src[i];
+  }
+}
+
+// Runs all three optimizations over interleaved static vertices in place, returns the new vertex count
+u32 optimizeStaticMesh(StaticVertex* vertices, u32 vertexCount, u32* indices, u32 indexCount) {
+  optimizeTriangleOrder(indices, indexCount, vertexCount, (const f32*)vertices + (offsetof(StaticVertex, position) / sizeof(f32)), sizeof(StaticVertex) / sizeof(f32));
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* remap = pushArray(tempMemory.arena, vertexCount, u32);
+  u32 newVertexCount = optimizeVertexFetchRemap(indices, indexCount, vertexCount, remap);
+  StaticVertex* sourceVertices = pushArray(tempMemory.arena, vertexCount, StaticVertex);
+  memcpy(sourceVertices, vertices, vertexCount * sizeof(StaticVertex));
+  remapVertices(vertices, sourceVertices, vertexCount, sizeof(StaticVertex), remap);
+  endTempMemory(tempMemory);
+  return newVertexCount;
+}
+
+void printVertexCacheStats(const char* meshName, u32 meshIndex, const VertexCacheStats& before, const VertexCacheStats& after) {
+  printf("%s [mesh %u]: ACMR %.3f -> %.3f | ATVR %.3f -> %.3f | vertex shader invocations %u -> %u\n",
+         meshName, meshIndex, before.acmr, after.acmr, before.atvr, after.atvr, before.vertexShaderInvocations, after.vertexShaderInvocations);
+}
\ No newline at end of file
@@ -1,5 +1,51 @@
 #pragma once
 
+// Copies a float accessor into a strided destination. Components beyond numComponents are left untouched.
+internal void copyGLTFAccessorFloats(const tinygltf::Model& gltfModel, s32 accessorIndex, u32 numComponents, f32* dst, u32 dstStrideInFloats) {
+  const tinygltf::Accessor& accessor = gltfModel.accessors[accessorIndex];
+  assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+  assert((u32)tinygltf::GetNumComponentsInType(accessor.type) == numComponents);
+  const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
+  const u8* src = gltfModel.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+  u64 srcStride = bufferView.byteStride != 0 ? bufferView.byteStride : numComponents * sizeof(f32);
+  for(u64 i = 0; i < accessor.count; ++i) {
+    memcpy(dst + (i * dstStrideInFloats), src + (i * srcStride), numComponents * sizeof(f32));
+  }
+}
+
+internal void copyGLTFAccessorIndices(const tinygltf::Model& gltfModel, s32 accessorIndex, u32* dst) {
+  const tinygltf::Accessor& accessor = gltfModel.accessors[accessorIndex];
+  const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
+  const u8* src = gltfModel.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+  switch(accessor.componentType) {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      for(u64 i = 0; i < accessor.count; ++i) { dst[i] = src[i]; }
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      for(u64 i = 0; i < accessor.count; ++i) { dst[i] = ((const u16*)src)[i]; }
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      memcpy(dst, src, accessor.count * sizeof(u32));
+      break;
+    default:
+      assert(false);
+  }
+}
+
+// Reads integer or normalized integer accessors as floats, for glTF data that may have been quantized
+internal f32 readGLTFAccessorComponent(const u8* element, s32 componentType, u32 component) {
+  switch(componentType) {
+    case TINYGLTF_COMPONENT_TYPE_FLOAT: return ((const f32*)element)[component];
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return ((const u8*)element)[component] / 255.0f;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return ((const u16*)element)[component] / 65535.0f;
+    case TINYGLTF_COMPONENT_TYPE_BYTE: return Max(((const s8*)element)[component] / 127.0f, -1.0f);
+    case TINYGLTF_COMPONENT_TYPE_SHORT: return Max(((const s16*)element)[component] / 32767.0f, -1.0f);
+    default:
+      assert(false);
+      return 0.0f;
+  }
+}
+
 void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
 {
   struct gltfAttributeMetadata {
@@ -17,7 +63,7 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
 
   model->meshCount = (u32)gltfModel->meshes.size();
   assert(model->meshCount != 0);
-  model->meshes = new Mesh[model->meshCount];
+  model->meshes = pushArray(&permanentArena, model->meshCount, Mesh);
   std::vector<tinygltf::Accessor>* gltfAccessors = &gltfModel->accessors;
   std::vector<tinygltf::BufferView>* gltfBufferViews = &gltfModel->bufferViews;
 
@@ -46,8 +92,9 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
     gltfAttributeMetadata positionAttribute = populateAttributeMetadata(positionIndexKeyString, gltfPrimitive);
     f64* minValues = gltfModel->accessors[positionAttribute.accessorIndex].minValues.data();
     f64* maxValues = gltfModel->accessors[positionAttribute.accessorIndex].maxValues.data();
-    model->boundingBox.min = {(f32)minValues[0], (f32)minValues[1], (f32)minValues[2]};
-    model->boundingBox.diagonal = glm::vec3{(f32)maxValues[0], (f32)maxValues[1], (f32)maxValues[2]} - model->boundingBox.min;
+    mesh->boundingBox = boxFromMinMax(glm::vec3{(f32)minValues[0], (f32)minValues[1], (f32)minValues[2]},
+                                      glm::vec3{(f32)maxValues[0], (f32)maxValues[1], (f32)maxValues[2]});
+    model->boundingBox = (i == 0) ? mesh->boundingBox : mergeBoxes(model->boundingBox, mesh->boundingBox);
 
     b32 normalAttributesAvailable = gltfPrimitive.attributes.find(normalIndexKeyString) != gltfPrimitive.attributes.end();
     gltfAttributeMetadata normalAttribute{};
@@ -70,18 +117,48 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
     u32 indicesAccessorIndex = gltfPrimitive.indices;
     tinygltf::BufferView indicesGLTFBufferView = gltfBufferViews->at(gltfAccessors->at(indicesAccessorIndex).bufferView);
     u32 indicesGLTFBufferIndex = indicesGLTFBufferView.buffer;
-    u64 indicesGLTFBufferByteOffset = indicesGLTFBufferView.byteOffset;
-    u64 indicesGLTFBufferByteLength = indicesGLTFBufferView.byteLength;
 
     u64 minOffset = Min(positionAttribute.bufferByteOffset, Min(texture0Attribute.bufferByteOffset, normalAttribute.bufferByteOffset));
     u8* vertexAttributeDataOffset = gltfModel->buffers[indicesGLTFBufferIndex].data.data() + minOffset;
-    u8* indicesDataOffset = gltfModel->buffers[indicesGLTFBufferIndex].data.data() + indicesGLTFBufferByteOffset;
 
     mesh->vertexAtt.indexCount = u32(gltfAccessors->at(indicesAccessorIndex).count);
-    mesh->vertexAtt.indexTypeSizeInBytes = tinygltf::GetComponentSizeInBytes(gltfAccessors->at(indicesAccessorIndex).componentType);
     // TODO: Handle the possibility of the three attributes not being side-by-side in the buffer
     u64 sizeOfAttributeData = positionAttribute.bufferByteLength + normalAttribute.bufferByteLength + texture0Attribute.bufferByteLength;
     assert(gltfModel->buffers[vertexAttBufferIndex].data.size() >= sizeOfAttributeData);
+
+    // reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch before uploading
+    u32 vertexCount = (u32)gltfAccessors->at(positionAttribute.accessorIndex).count;
+    TempMemory tempMemory = beginTempMemory(threadTempArena());
+    u32* indices = pushArray(tempMemory.arena, mesh->vertexAtt.indexCount, u32);
+    copyGLTFAccessorIndices(*gltfModel, indicesAccessorIndex, indices);
+    VertexCacheStats cacheStatsBefore = analyzeVertexCache(indices, mesh->vertexAtt.indexCount, vertexCount);
+    optimizeTriangleOrder(indices, mesh->vertexAtt.indexCount, vertexCount,
+                          (const f32*)(vertexAttributeDataOffset + (positionAttribute.bufferByteOffset - minOffset)), positionAttribute.numComponents);
+    u32* vertexRemap = pushArray(tempMemory.arena, vertexCount, u32);
+    u32 referencedVertexCount = optimizeVertexFetchRemap(indices, mesh->vertexAtt.indexCount, vertexCount, vertexRemap);
+    u8* vertexAttributeData = pushArray(tempMemory.arena, sizeOfAttributeData, u8);
+    memcpy(vertexAttributeData, vertexAttributeDataOffset, sizeOfAttributeData);
+    gltfAttributeMetadata* attributes[] = { &positionAttribute, normalAttributesAvailable ? &normalAttribute : nullptr, texture0AttributesAvailable ? &texture0Attribute : nullptr };
+    for(u32 attributeIndex = 0; attributeIndex < ArrayCount(attributes); ++attributeIndex) {
+      if(attributes[attributeIndex] == nullptr) { continue; }
+      u64 attributeOffset = attributes[attributeIndex]->bufferByteOffset - minOffset;
+      remapVertices(vertexAttributeData + attributeOffset, vertexAttributeDataOffset + attributeOffset,
+                    vertexCount, attributes[attributeIndex]->numComponents * sizeof(f32), vertexRemap);
+    }
+    VertexCacheStats cacheStatsAfter = analyzeVertexCache(indices, mesh->vertexAtt.indexCount, vertexCount);
+    printVertexCacheStats(model->fileName, i, cacheStatsBefore, cacheStatsAfter);
+
+    // 16-bit indices whenever every vertex is addressable with them
+    u16* shortIndices = nullptr;
+    void* indexData = indices;
+    mesh->vertexAtt.indexTypeSizeInBytes = sizeof(u32);
+    if(referencedVertexCount <= (U16_MAX + 1)) {
+      shortIndices = pushArray(tempMemory.arena, mesh->vertexAtt.indexCount, u16);
+      narrowIndices(shortIndices, indices, mesh->vertexAtt.indexCount);
+      indexData = shortIndices;
+      mesh->vertexAtt.indexTypeSizeInBytes = sizeof(u16);
+    }
+
     const u32 positionAttributeIndex = 0;
     const u32 normalAttributeIndex = 1;
     const u32 texture0AttributeIndex = 2;
@@ -94,7 +171,7 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexAtt.bufferObject);
     glBufferData(GL_ARRAY_BUFFER,
                  sizeOfAttributeData,
-                 vertexAttributeDataOffset,
+                 vertexAttributeData,
                  GL_STATIC_DRAW);
 
     // set the vertex attributes (position and texture)
@@ -131,13 +208,15 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
 
     // bind element buffer object to give indices
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->vertexAtt.indexObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesGLTFBufferByteLength, indicesDataOffset, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->vertexAtt.indexCount * mesh->vertexAtt.indexTypeSizeInBytes, indexData, GL_STATIC_DRAW);
 
     // unbind VBO & VAO
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+    endTempMemory(tempMemory);
+
     s32 gltfMaterialIndex = gltfPrimitive.material;
     if(gltfMaterialIndex >= 0) {
       tinygltf::Material gltfMaterial = gltfModel->materials[gltfMaterialIndex];
@@ -174,32 +253,297 @@ void initializeModelVertexData(tinygltf::Model* gltfModel, Model* model)
   }
 }
 
-void loadModel(const char* filePath, Model* returnModel) {
+bool loadGLTF(const char* filePath, tinygltf::Model* gltfModel) {
   tinygltf::TinyGLTF loader;
   std::string err;
   std::string warn;
-  tinygltf::Model tinyGLTFModel;
 
-  //bool ret = loader.LoadASCIIFromFile(&tinyGLTFModel, &err, &warn, filePath); // for .gltf
-  bool ret = loader.LoadBinaryFromFile(&tinyGLTFModel, &err, &warn, filePath); // for binary glTF(.glb)
+  // binary glTF(.glb) only, the whole model is in one file
+  AssetFile modelFile;
+  if(!openAsset(filePath, &modelFile)) { return false; }
+  const char* lastSlash = strrchr(filePath, '/');
+  std::string baseDir = lastSlash ? std::string(filePath, lastSlash - filePath) : std::string();
+  bool ret = loader.LoadBinaryFromMemory(gltfModel, &err, &warn, modelFile.bytes, (u32)modelFile.size, baseDir);
+  closeAsset(&modelFile);
 
   if (!warn.empty()) {
     printf("Warning: %s\n", warn.c_str());
-    return;
+    return false;
   }
 
   if (!err.empty()) {
     printf("Error: %s\n", err.c_str());
-    return;
+    return false;
   }
 
   if (!ret) {
     printf("Failed to parse glTF\n");
+    return false;
+  }
+
+  return true;
+}
+
+// Node's local transform from either its matrix or its translation/rotation/scale
+internal void readGLTFNodeTransform(const tinygltf::Node& gltfNode, glm::vec3* outTranslation, glm::quat* outRotation, glm::vec3* outScale) {
+  *outTranslation = glm::vec3(0.0f);
+  *outRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  *outScale = glm::vec3(1.0f);
+  if(gltfNode.matrix.size() == 16) {
+    glm::mat4 mat;
+    for(u32 i = 0; i < 16; ++i) { mat[i / 4][i % 4] = (f32)gltfNode.matrix[i]; }
+    decomposeTransform(mat, outTranslation, outRotation, outScale);
+    return;
+  }
+  if(gltfNode.translation.size() == 3) {
+    *outTranslation = glm::vec3((f32)gltfNode.translation[0], (f32)gltfNode.translation[1], (f32)gltfNode.translation[2]);
+  }
+  if(gltfNode.rotation.size() == 4) { // stored x, y, z, w
+    *outRotation = glm::quat((f32)gltfNode.rotation[3], (f32)gltfNode.rotation[0], (f32)gltfNode.rotation[1], (f32)gltfNode.rotation[2]);
+  }
+  if(gltfNode.scale.size() == 3) {
+    *outScale = glm::vec3((f32)gltfNode.scale[0], (f32)gltfNode.scale[1], (f32)gltfNode.scale[2]);
+  }
+}
+
+// Adds the node trees of the glTF's default scene to the hierarchy, breadth first so parents precede children.
+// Scene roots are parented to parentTransform. outNodes must hold gltfModel.nodes.size() entries.
+// Returns the number of nodes added.
+u32 loadGLTFNodes(const tinygltf::Model& gltfModel, TransformHierarchy* transforms, u32 parentTransform, ModelNode* outNodes) {
+  u32 gltfNodeCount = (u32)gltfModel.nodes.size();
+  if(gltfNodeCount == 0) { return 0; }
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* queue = pushArray(tempMemory.arena, gltfNodeCount, u32);
+  u32* queueParents = pushArray(tempMemory.arena, gltfNodeCount, u32);
+  u32 queueTail = 0;
+  if(!gltfModel.scenes.empty()) {
+    const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene >= 0 ? gltfModel.defaultScene : 0];
+    for(s32 rootNode : scene.nodes) {
+      queue[queueTail] = rootNode;
+      queueParents[queueTail++] = parentTransform;
+    }
+  } else {
+    // no scenes, every node that is nobody's child is a root
+    bool* isChild = pushArrayZero(tempMemory.arena, gltfNodeCount, bool);
+    for(const tinygltf::Node& gltfNode : gltfModel.nodes) {
+      for(s32 child : gltfNode.children) { isChild[child] = true; }
+    }
+    for(u32 i = 0; i < gltfNodeCount; ++i) {
+      if(!isChild[i]) {
+        queue[queueTail] = i;
+        queueParents[queueTail++] = parentTransform;
+      }
+    }
+  }
+
+  u32 nodeCount = 0;
+  for(u32 queueHead = 0; queueHead < queueTail; ++queueHead) {
+    const tinygltf::Node& gltfNode = gltfModel.nodes[queue[queueHead]];
+    glm::vec3 translation, scale;
+    glm::quat rotation;
+    readGLTFNodeTransform(gltfNode, &translation, &rotation, &scale);
+
+    ModelNode* node = outNodes + nodeCount++;
+    node->transform = addTransform(transforms, queueParents[queueHead], translation, rotation, scale);
+    node->meshIndex = gltfNode.mesh;
+    for(s32 child : gltfNode.children) {
+      assert(queueTail < gltfNodeCount && "ERROR: glTF node has more than one parent!");
+      queue[queueTail] = child;
+      queueParents[queueTail++] = node->transform;
+    }
+  }
+
+  endTempMemory(tempMemory);
+  return nodeCount;
+}
+
+// Joints are reordered parents first, paletteIndices keeps their position in the skin for JOINTS_0
+void loadGLTFSkeleton(const tinygltf::Model& gltfModel, s32 skinIndex, Skeleton* skeleton) {
+  const tinygltf::Skin& skin = gltfModel.skins[skinIndex];
+  u32 jointCount = (u32)skin.joints.size();
+  skeleton->jointCount = jointCount;
+  skeleton->parents = pushArray(&permanentArena, jointCount, u32);
+  skeleton->paletteIndices = pushArray(&permanentArena, jointCount, u32);
+  skeleton->gltfNodes = pushArray(&permanentArena, jointCount, s32);
+  skeleton->inverseBindMats = pushArray(&permanentArena, jointCount, glm::mat4);
+  skeleton->bindPose = pushArray(&permanentArena, jointCount, JointPose);
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32 gltfNodeCount = (u32)gltfModel.nodes.size();
+  u32* nodeToSkinJoint = pushArray(tempMemory.arena, gltfNodeCount, u32);
+  u32* nodeParents = pushArray(tempMemory.arena, gltfNodeCount, u32);
+  for(u32 i = 0; i < gltfNodeCount; ++i) {
+    nodeToSkinJoint[i] = ANIMATION_NO_JOINT;
+    nodeParents[i] = U32_MAX;
+  }
+  for(u32 i = 0; i < gltfNodeCount; ++i) {
+    for(s32 child : gltfModel.nodes[i].children) { nodeParents[child] = i; }
+  }
+  for(u32 i = 0; i < jointCount; ++i) { nodeToSkinJoint[skin.joints[i]] = i; }
+
+  // parent = closest ancestor that is part of the skin, depth orders parents first
+  u32* skinParents = pushArray(tempMemory.arena, jointCount, u32);
+  u32* depths = pushArray(tempMemory.arena, jointCount, u32);
+  u32* order = pushArray(tempMemory.arena, jointCount, u32);
+  for(u32 i = 0; i < jointCount; ++i) {
+    skinParents[i] = ANIMATION_NO_JOINT;
+    depths[i] = 0;
+    for(u32 node = nodeParents[skin.joints[i]]; node != U32_MAX; node = nodeParents[node]) {
+      if(nodeToSkinJoint[node] != ANIMATION_NO_JOINT) {
+        if(skinParents[i] == ANIMATION_NO_JOINT) { skinParents[i] = nodeToSkinJoint[node]; }
+        depths[i]++;
+      }
+    }
+    order[i] = i;
+  }
+  std::stable_sort(order, order + jointCount, [depths](u32 a, u32 b) { return depths[a] < depths[b]; });
+  u32* skinToJoint = pushArray(tempMemory.arena, jointCount, u32);
+  for(u32 joint = 0; joint < jointCount; ++joint) { skinToJoint[order[joint]] = joint; }
+
+  glm::mat4* inverseBindMats = pushArray(tempMemory.arena, jointCount, glm::mat4);
+  if(skin.inverseBindMatrices >= 0) {
+    copyGLTFAccessorFloats(gltfModel, skin.inverseBindMatrices, 16, (f32*)inverseBindMats, 16);
+  } else {
+    for(u32 i = 0; i < jointCount; ++i) { inverseBindMats[i] = glm::mat4(); }
+  }
+
+  for(u32 joint = 0; joint < jointCount; ++joint) {
+    u32 skinJoint = order[joint];
+    const tinygltf::Node& gltfNode = gltfModel.nodes[skin.joints[skinJoint]];
+    skeleton->parents[joint] = skinParents[skinJoint] == ANIMATION_NO_JOINT ? ANIMATION_NO_JOINT : skinToJoint[skinParents[skinJoint]];
+    skeleton->paletteIndices[joint] = skinJoint;
+    skeleton->gltfNodes[joint] = skin.joints[skinJoint];
+    skeleton->inverseBindMats[joint] = inverseBindMats[skinJoint];
+    readGLTFNodeTransform(gltfNode, &skeleton->bindPose[joint].translation, &skeleton->bindPose[joint].rotation, &skeleton->bindPose[joint].scale);
+  }
+  endTempMemory(tempMemory);
+}
+
+// Keyframes of one animation sampler. Cubic spline outputs hold in-tangent, value, out-tangent triplets and only
+// the values are kept. outValues holds numComponents floats per key and may be nullptr to only count keys.
+internal u32 readGLTFSamplerKeys(const tinygltf::Model& gltfModel, const tinygltf::AnimationSampler& sampler, u32 numComponents, f32* outTimes, f32* outValues) {
+  const tinygltf::Accessor& inputAccessor = gltfModel.accessors[sampler.input];
+  u32 keyCount = (u32)inputAccessor.count;
+  if(outTimes == nullptr) { return keyCount; }
+  copyGLTFAccessorFloats(gltfModel, sampler.input, 1, outTimes, 1);
+
+  const tinygltf::Accessor& outputAccessor = gltfModel.accessors[sampler.output];
+  assert((u32)tinygltf::GetNumComponentsInType(outputAccessor.type) == numComponents);
+  const tinygltf::BufferView& bufferView = gltfModel.bufferViews[outputAccessor.bufferView];
+  const u8* src = gltfModel.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + outputAccessor.byteOffset;
+  u64 srcStride = bufferView.byteStride != 0 ? bufferView.byteStride : numComponents * tinygltf::GetComponentSizeInBytes(outputAccessor.componentType);
+  bool cubicSpline = sampler.interpolation == "CUBICSPLINE";
+  for(u32 key = 0; key < keyCount; ++key) {
+    const u8* element = src + ((cubicSpline ? (key * 3) + 1 : key) * srcStride);
+    for(u32 component = 0; component < numComponents; ++component) {
+      outValues[(key * numComponents) + component] = readGLTFAccessorComponent(element, outputAccessor.componentType, component);
+    }
+  }
+  return keyCount;
+}
+
+// Loads every glTF animation as a clip for the skeleton, channels targeting nodes outside of it are ignored.
+// Returns the number of clips, stored in the permanent arena.
+u32 loadGLTFAnimations(const tinygltf::Model& gltfModel, const Skeleton& skeleton, AnimationClip** outClips) {
+  u32 clipCount = (u32)gltfModel.animations.size();
+  *outClips = nullptr;
+  if(clipCount == 0) { return 0; }
+  AnimationClip* clips = pushArray(&permanentArena, clipCount, AnimationClip);
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* nodeToJoint = pushArray(tempMemory.arena, gltfModel.nodes.size(), u32);
+  for(u32 i = 0; i < gltfModel.nodes.size(); ++i) { nodeToJoint[i] = ANIMATION_NO_JOINT; }
+  for(u32 joint = 0; joint < skeleton.jointCount; ++joint) { nodeToJoint[skeleton.gltfNodes[joint]] = joint; }
+
+  for(u32 clipIndex = 0; clipIndex < clipCount; ++clipIndex) {
+    const tinygltf::Animation& animation = gltfModel.animations[clipIndex];
+    AnimationClip* clip = clips + clipIndex;
+    *clip = {};
+    char* name = pushArray(&permanentArena, animation.name.size() + 1, char);
+    memcpy(name, animation.name.c_str(), animation.name.size() + 1);
+    clip->name = name;
+    clip->jointCount = skeleton.jointCount;
+    clip->tracks = pushArrayZero(&permanentArena, skeleton.jointCount * ANIMATION_TRACKS_PER_JOINT, AnimationTrack);
+
+    // size the packed arrays, then fill them
+    for(u32 pass = 0; pass < 2; ++pass) {
+      if(pass == 1) {
+        clip->keyTimes = pushArray(&permanentArena, clip->keyTimeCount, f32);
+        clip->vectorKeys = pushArray(&permanentArena, clip->vectorKeyCount, glm::vec3);
+        clip->rotationKeys = pushArray(&permanentArena, clip->rotationKeyCount, QuantizedQuat);
+        clip->keyTimeCount = clip->vectorKeyCount = clip->rotationKeyCount = 0;
+      }
+      for(const tinygltf::AnimationChannel& channel : animation.channels) {
+        if(channel.target_node < 0 || nodeToJoint[channel.target_node] == ANIMATION_NO_JOINT) { continue; }
+        u32 trackIndex;
+        if(channel.target_path == "translation") { trackIndex = 0; }
+        else if(channel.target_path == "rotation") { trackIndex = 1; }
+        else if(channel.target_path == "scale") { trackIndex = 2; }
+        else { continue; } // morph target weights
+
+        const tinygltf::AnimationSampler& sampler = animation.samplers[channel.sampler];
+        AnimationTrack* track = clip->tracks + (nodeToJoint[channel.target_node] * ANIMATION_TRACKS_PER_JOINT) + trackIndex;
+        u32 numComponents = trackIndex == 1 ? 4 : 3;
+        if(pass == 0) {
+          u32 keyCount = readGLTFSamplerKeys(gltfModel, sampler, numComponents, nullptr, nullptr);
+          clip->keyTimeCount += keyCount;
+          if(trackIndex == 1) { clip->rotationKeyCount += keyCount; } else { clip->vectorKeyCount += keyCount; }
+          continue;
+        }
+
+        track->firstTime = clip->keyTimeCount;
+        track->firstValue = trackIndex == 1 ? clip->rotationKeyCount : clip->vectorKeyCount;
+        track->interpolation = sampler.interpolation == "STEP" ? AnimationInterpolation_Step : AnimationInterpolation_Linear;
+        TempMemory valuesMemory = beginTempMemory(tempMemory.arena);
+        u32 maxKeyCount = readGLTFSamplerKeys(gltfModel, sampler, numComponents, nullptr, nullptr);
+        f32* values = pushArray(valuesMemory.arena, maxKeyCount * numComponents, f32);
+        track->keyCount = readGLTFSamplerKeys(gltfModel, sampler, numComponents, clip->keyTimes + track->firstTime, values);
+        for(u32 key = 0; key < track->keyCount; ++key) {
+          const f32* value = values + (key * numComponents);
+          if(trackIndex == 1) { // stored x, y, z, w
+            clip->rotationKeys[clip->rotationKeyCount++] = quantizeQuat(glm::quat(value[3], value[0], value[1], value[2]));
+          } else {
+            clip->vectorKeys[clip->vectorKeyCount++] = glm::vec3(value[0], value[1], value[2]);
+          }
+        }
+        clip->keyTimeCount += track->keyCount;
+        if(track->keyCount != 0) {
+          clip->durationSeconds = Max(clip->durationSeconds, clip->keyTimes[track->firstTime + track->keyCount - 1]);
+        }
+        endTempMemory(valuesMemory);
+      }
+    }
+  }
+  endTempMemory(tempMemory);
+  return clipCount;
+}
+
+// When transforms is provided the glTF's node tree is added to it under parentTransform
+void loadModel(const char* filePath, Model* returnModel, TransformHierarchy* transforms = nullptr, u32 parentTransform = TRANSFORM_NO_PARENT) {
+  tinygltf::Model tinyGLTFModel;
+  if(!loadGLTF(filePath, &tinyGLTFModel)) {
     return;
   }
 
   returnModel->fileName = filePath;
   initializeModelVertexData(&tinyGLTFModel, returnModel);
+
+  returnModel->nodes = nullptr;
+  returnModel->nodeCount = 0;
+  if(transforms != nullptr && !tinyGLTFModel.nodes.empty()) {
+    returnModel->nodes = pushArray(&permanentArena, tinyGLTFModel.nodes.size(), ModelNode);
+    returnModel->nodeCount = loadGLTFNodes(tinyGLTFModel, transforms, parentTransform, returnModel->nodes);
+  }
+
+  returnModel->skeleton = nullptr;
+  returnModel->animations = nullptr;
+  returnModel->animationCount = 0;
+  if(!tinyGLTFModel.skins.empty()) {
+    returnModel->skeleton = pushArray(&permanentArena, 1, Skeleton);
+    loadGLTFSkeleton(tinyGLTFModel, 0, returnModel->skeleton);
+    returnModel->animationCount = loadGLTFAnimations(tinyGLTFModel, *returnModel->skeleton, &returnModel->animations);
+  }
 }
 
 void drawModel(const Model& model) {
@@ -209,26 +553,35 @@ void drawModel(const Model& model) {
   }
 }
 
+// NOTE: Mesh arrays live in the permanent arena and are not reclaimed
 void deleteModels(Model* models, u32 count = 1) {
-  std::vector<VertexAtt> vertexAtts;
-  std::vector<GLuint> textureData;
+  u32 totalMeshCount = 0;
+  for(u32 i = 0; i < count; ++i) {
+    totalMeshCount += models[i].meshCount;
+  }
+
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  VertexAtt* vertexAtts = pushArray(tempMemory.arena, totalMeshCount, VertexAtt);
+  GLuint* textureData = pushArray(tempMemory.arena, totalMeshCount * 2, GLuint);
+  u32 vertexAttCount = 0;
+  u32 textureCount = 0;
 
   for(u32 i = 0; i < count; ++i) {
     Model* modelPtr = models + i;
-    for(u32 i = 0; i < modelPtr->meshCount; ++i) {
-      Mesh* meshPtr = modelPtr->meshes;
-      vertexAtts.push_back(meshPtr->vertexAtt);
+    for(u32 meshIndex = 0; meshIndex < modelPtr->meshCount; ++meshIndex) {
+      Mesh* meshPtr = modelPtr->meshes + meshIndex;
+      vertexAtts[vertexAttCount++] = meshPtr->vertexAtt;
       if(meshPtr->normalTextureId != TEXTURE_ID_NO_TEXTURE) {
-        textureData.push_back(meshPtr->normalTextureId);
+        textureData[textureCount++] = meshPtr->normalTextureId;
       }
       if(meshPtr->albedoTextureId != TEXTURE_ID_NO_TEXTURE) {
-        textureData.push_back(meshPtr->albedoTextureId);
+        textureData[textureCount++] = meshPtr->albedoTextureId;
       }
     }
-    delete[] modelPtr->meshes;
     *modelPtr = {}; // clear model to zero
   }
 
-  deleteVertexAtts(vertexAtts.data(), (u32)vertexAtts.size());
-  glDeleteTextures((GLsizei)textureData.size(), textureData.data());
+  deleteVertexAtts(vertexAtts, vertexAttCount);
+  glDeleteTextures((GLsizei)textureCount, textureData);
+  endTempMemory(tempMemory);
 }
\ No newline at end of file
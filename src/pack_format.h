@@ -0,0 +1,182 @@
+#pragma once
+
+// Pack files
+// A pack holds many assets in a single file: a header, every entry's bytes aligned to the header's entry alignment,
+// then a directory of PackEntry sorted by path hash followed by the entries' paths. Entries are stored either as is,
+// so they can be used straight out of a memory mapped pack, or as LZ4 blocks when that saves enough space.
+// Only depends on types.h so the packer can share it.
+
+#define PACK_MAGIC 0x4B504E42 // "BNPK"
+#define PACK_VERSION 1
+#define PACK_DEFAULT_ENTRY_ALIGNMENT 64
+
+enum PackCompression : u8 {
+  PackCompression_None,
+  PackCompression_LZ4, // LZ4 block format, no frame
+};
+
+struct PackHeader {
+  u32 magic;
+  u32 version;
+  u32 entryCount;
+  u32 entryAlignment;
+  u64 directoryOffset; // entryCount PackEntry, sorted by pathHash
+  u64 pathsOffset;
+  u64 pathsSize;
+};
+
+struct PackEntry {
+  u64 pathHash;
+  u64 offset;
+  u64 storedSize;
+  u64 size;
+  u32 pathOffset; // relative to pathsOffset, not null terminated
+  u16 pathLength;
+  PackCompression compression;
+  u8 padding;
+};
+
+// FNV-1a, backslashes hash like forward slashes so Windows style paths find the same entry
+inline u64 hashPackPath(const char* path, u32 length) {
+  u64 hash = 0xcbf29ce484222325ull;
+  for(u32 i = 0; i < length; ++i) {
+    char c = path[i] == '\\' ? '/' : path[i];
+    hash = (hash ^ (u8)c) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+inline bool packPathsEqual(const char* a, const char* b, u32 length) {
+  for(u32 i = 0; i < length; ++i) {
+    char ca = a[i] == '\\' ? '/' : a[i];
+    char cb = b[i] == '\\' ? '/' : b[i];
+    if(ca != cb) { return false; }
+  }
+  return true;
+}
+
+// LZ4 block format
+// Sequences of [token][literal length bytes][literals][u16 offset][match length bytes]. The high nibble of the token
+// is the literal count and the low nibble the match length minus 4, a nibble of 15 continues in 255 valued bytes.
+// The last sequence is literals only. Matches must end 5 bytes before the end of the block, and may not start
+// within the last 12 bytes.
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_SEARCH_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 16
+
+inline u64 lz4CompressBound(u64 size) {
+  return size + (size / 255) + 16;
+}
+
+internal inline u32 lz4Read32(const u8* p) {
+  u32 value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+internal inline u8* lz4WriteLength(u8* out, u64 length) {
+  while(length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = (u8)length;
+  return out;
+}
+
+// Greedy single probe compressor. dst must hold lz4CompressBound(srcSize) bytes, hashTable (1 << LZ4_HASH_BITS) u32s.
+// Returns the compressed size.
+u64 lz4Compress(const u8* src, u64 srcSize, u8* dst, u32* hashTable) {
+  memset(hashTable, 0, sizeof(u32) * (1 << LZ4_HASH_BITS));
+  auto hash = [](u32 sequence) { return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS); };
+  const u8* in = src;
+  const u8* literalStart = src;
+  const u8* matchLimit = srcSize > LZ4_MATCH_SEARCH_LIMIT ? src + srcSize - LZ4_MATCH_SEARCH_LIMIT : src;
+  const u8* matchEnd = srcSize > LZ4_LAST_LITERALS ? src + srcSize - LZ4_LAST_LITERALS : src;
+  u8* out = dst;
+
+  while(in < matchLimit) {
+    u32 sequence = lz4Read32(in);
+    u32 h = hash(sequence);
+    const u8* candidate = src + hashTable[h];
+    hashTable[h] = (u32)(in - src);
+    if(candidate >= in || (u64)(in - candidate) > LZ4_MAX_OFFSET || lz4Read32(candidate) != sequence) {
+      ++in;
+      continue;
+    }
+    // extend backwards into pending literals, then forwards
+    while(in > literalStart && candidate > src && in[-1] == candidate[-1]) {
+      --in;
+      --candidate;
+    }
+    const u8* matchStart = in;
+    in += LZ4_MIN_MATCH;
+    candidate += LZ4_MIN_MATCH;
+    while(in < matchEnd && *in == *candidate) {
+      ++in;
+      ++candidate;
+    }
+
+    u64 literalLength = matchStart - literalStart;
+    u64 matchLength = (in - matchStart) - LZ4_MIN_MATCH;
+    u8* token = out++;
+    *token = (u8)(((Min(literalLength, 15ull)) << 4) | (Min(matchLength, 15ull)));
+    if(literalLength >= 15) { out = lz4WriteLength(out, literalLength - 15); }
+    memcpy(out, literalStart, literalLength);
+    out += literalLength;
+    u16 offset = (u16)(in - candidate);
+    memcpy(out, &offset, sizeof(offset)); // little endian
+    out += sizeof(offset);
+    if(matchLength >= 15) { out = lz4WriteLength(out, matchLength - 15); }
+    literalStart = in;
+  }
+
+  u64 literalLength = (src + srcSize) - literalStart;
+  *out++ = (u8)((Min(literalLength, 15ull)) << 4);
+  if(literalLength >= 15) { out = lz4WriteLength(out, literalLength - 15); }
+  memcpy(out, literalStart, literalLength);
+  out += literalLength;
+  return out - dst;
+}
+
+// Returns false for malformed input or output that does not decompress to exactly dstSize bytes
+bool lz4Decompress(const u8* src, u64 srcSize, u8* dst, u64 dstSize) {
+  const u8* in = src;
+  const u8* inEnd = src + srcSize;
+  u8* out = dst;
+  u8* outEnd = dst + dstSize;
+  auto readLength = [&in, inEnd](u64* length) {
+    u8 byte;
+    do {
+      if(in == inEnd) { return false; }
+      byte = *in++;
+      *length += byte;
+    } while(byte == 255);
+    return true;
+  };
+
+  while(in < inEnd) {
+    u8 token = *in++;
+    u64 literalLength = token >> 4;
+    if(literalLength == 15 && !readLength(&literalLength)) { return false; }
+    if(literalLength > (u64)(inEnd - in) || literalLength > (u64)(outEnd - out)) { return false; }
+    memcpy(out, in, literalLength);
+    in += literalLength;
+    out += literalLength;
+    if(in == inEnd) { break; } // last sequence has no match
+
+    if(inEnd - in < 2) { return false; }
+    u16 offset;
+    memcpy(&offset, in, sizeof(offset));
+    in += sizeof(offset);
+    u64 matchLength = token & 15;
+    if(matchLength == 15 && !readLength(&matchLength)) { return false; }
+    matchLength += LZ4_MIN_MATCH;
+    if(offset == 0 || offset > (u64)(out - dst) || matchLength > (u64)(outEnd - out)) { return false; }
+    const u8* match = out - offset;
+    for(u64 i = 0; i < matchLength; ++i) { out[i] = match[i]; } // matches may overlap the bytes they produce
+    out += matchLength;
+  }
+  return out == outEnd;
+}
\ No newline at end of file
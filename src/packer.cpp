@@ -0,0 +1,167 @@
+// Packer
+// Builds a pack from directories and files of loose assets, see pack_format.h for the layout.
+// Paths are stored as given, relative to the working directory, so run it from the root like the application:
+//   packer assets.pack data shaders --lz4
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "types.h"
+#include "pack_format.h"
+
+struct PackInput {
+  std::string path;
+  u8* bytes;
+  u64 size;
+  PackEntry entry;
+};
+
+internal bool readWholeFile(const char* fileName, u8** outBytes, u64* outSize) {
+  FILE* file = fopen(fileName, "rb");
+  if(file == nullptr) { return false; }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  *outBytes = new u8[size > 0 ? size : 1];
+  *outSize = (u64)size;
+  bool success = size >= 0 && fread(*outBytes, 1, (size_t)size, file) == (size_t)size;
+  fclose(file);
+  return success;
+}
+
+internal void writePadding(FILE* file, u64* offset, u64 alignment) {
+  const u8 zeros[256] = {};
+  u64 alignedOffset = (*offset + alignment - 1) & ~(alignment - 1);
+  while(*offset < alignedOffset) {
+    u64 count = Min(alignedOffset - *offset, (u64)sizeof(zeros));
+    fwrite(zeros, 1, count, file);
+    *offset += count;
+  }
+}
+
+internal void printUsage() {
+  printf("Usage: packer <output.pack> <file or directory>... [--lz4] [--align <power of two bytes>]\n");
+  printf("  --lz4    store entries as LZ4 blocks when that saves at least 1/16 of their size\n");
+  printf("  --align  entry alignment, %u by default\n", PACK_DEFAULT_ENTRY_ALIGNMENT);
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 3) {
+    printUsage();
+    return 1;
+  }
+  const char* outputFileName = argv[1];
+  bool compress = false;
+  u64 alignment = PACK_DEFAULT_ENTRY_ALIGNMENT;
+  std::vector<PackInput> inputs;
+  for(int i = 2; i < argc; ++i) {
+    if(strcmp(argv[i], "--lz4") == 0) {
+      compress = true;
+    } else if(strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+      alignment = strtoull(argv[++i], nullptr, 10);
+      if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        printUsage();
+        return 1;
+      }
+    } else if(std::filesystem::is_directory(argv[i])) {
+      for(const auto& dirEntry : std::filesystem::recursive_directory_iterator(argv[i])) {
+        if(dirEntry.is_regular_file()) {
+          inputs.push_back(PackInput{ dirEntry.path().generic_string() });
+        }
+      }
+    } else if(std::filesystem::is_regular_file(argv[i])) {
+      inputs.push_back(PackInput{ std::filesystem::path(argv[i]).generic_string() });
+    } else {
+      printf("Skipping %s, not a file or directory\n", argv[i]);
+    }
+  }
+  if(inputs.empty()) {
+    printf("Nothing to pack\n");
+    return 1;
+  }
+
+  u32* hashTable = new u32[1 << LZ4_HASH_BITS];
+  u64 pathsSize = 0;
+  for(PackInput& input : inputs) {
+    if(!readWholeFile(input.path.c_str(), &input.bytes, &input.size)) {
+      printf("Could not read %s\n", input.path.c_str());
+      return 1;
+    }
+    assert(input.path.size() <= U16_MAX && "ERROR: Path is too long for a pack entry!");
+    input.entry = {};
+    input.entry.pathHash = hashPackPath(input.path.c_str(), (u32)input.path.size());
+    input.entry.pathOffset = (u32)pathsSize;
+    input.entry.pathLength = (u16)input.path.size();
+    input.entry.size = input.size;
+    input.entry.storedSize = input.size;
+    input.entry.compression = PackCompression_None;
+    pathsSize += input.path.size();
+
+    if(compress && input.size > 0) {
+      u8* compressed = new u8[lz4CompressBound(input.size)];
+      u64 compressedSize = lz4Compress(input.bytes, input.size, compressed, hashTable);
+      if(compressedSize <= input.size - (input.size / 16)) {
+        delete[] input.bytes;
+        input.bytes = compressed;
+        input.entry.storedSize = compressedSize;
+        input.entry.compression = PackCompression_LZ4;
+      } else {
+        delete[] compressed;
+      }
+    }
+  }
+  delete[] hashTable;
+
+  FILE* file = fopen(outputFileName, "wb");
+  if(file == nullptr) {
+    printf("Could not open %s for writing\n", outputFileName);
+    return 1;
+  }
+  PackHeader header{};
+  header.magic = PACK_MAGIC;
+  header.version = PACK_VERSION;
+  header.entryCount = (u32)inputs.size();
+  header.entryAlignment = (u32)alignment;
+  fwrite(&header, sizeof(header), 1, file); // rewritten once the offsets are known
+  u64 offset = sizeof(header);
+  u64 looseSize = 0;
+  for(PackInput& input : inputs) {
+    writePadding(file, &offset, alignment);
+    input.entry.offset = offset;
+    fwrite(input.bytes, 1, input.entry.storedSize, file);
+    offset += input.entry.storedSize;
+    looseSize += input.size;
+    printf("%-48s %10llu -> %10llu%s\n", input.path.c_str(), (unsigned long long)input.size,
+           (unsigned long long)input.entry.storedSize, input.entry.compression == PackCompression_LZ4 ? " lz4" : "");
+  }
+
+  // directory sorted by hash for binary search, paths stay in input order
+  writePadding(file, &offset, alignof(PackEntry));
+  header.directoryOffset = offset;
+  std::vector<PackEntry> directory;
+  for(const PackInput& input : inputs) { directory.push_back(input.entry); }
+  std::sort(directory.begin(), directory.end(), [](const PackEntry& a, const PackEntry& b) { return a.pathHash < b.pathHash; });
+  fwrite(directory.data(), sizeof(PackEntry), directory.size(), file);
+  offset += sizeof(PackEntry) * directory.size();
+  header.pathsOffset = offset;
+  header.pathsSize = pathsSize;
+  for(const PackInput& input : inputs) {
+    fwrite(input.path.data(), 1, input.path.size(), file);
+  }
+  offset += pathsSize;
+  fseek(file, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, file);
+  bool success = ferror(file) == 0;
+  fclose(file);
+
+  for(PackInput& input : inputs) { delete[] input.bytes; }
+  printf("%s: %u entries, %llu bytes of loose files in %llu bytes\n", outputFileName, header.entryCount,
+         (unsigned long long)looseSize, (unsigned long long)offset);
+  return success ? 0 : 1;
+}
\ No newline at end of file
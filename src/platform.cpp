@@ -7,24 +7,26 @@ void loadOpenGL() {
     std::cout << "Failed to initialize GLAD!" << std::endl;
     exit(-1);
   }
+  loadOpenGLExtensions((GLADloadproc)SDL_GL_GetProcAddress);
 }
 
 /* Window */
-void initWindow(s32 width, s32 height, WINDOW_HANDLE* windowHandle, GL_CONTEXT_HANDLE* glContextHandle) {
-  SDL_Init(SDL_INIT_VIDEO);
+// Headless windows are hidden and skip v-sync. A GL context still needs a window behind it.
+void initWindow(s32 width, s32 height, WINDOW_HANDLE* windowHandle, GL_CONTEXT_HANDLE* glContextHandle, bool headless) {
+  SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
   SDL_Window* window = SDL_CreateWindow(
           "bootstrap",
           SDL_WINDOWPOS_UNDEFINED,
           SDL_WINDOWPOS_UNDEFINED,
           width,
           height,
-          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
+          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI | (headless ? SDL_WINDOW_HIDDEN : 0)
   );
   SDL_CaptureMouse(SDL_TRUE);
 
   SDL_GLContext context = SDL_GL_CreateContext(window);
   SDL_GL_MakeCurrent(window, context);
-  SDL_GL_SetSwapInterval(1); // enable v-sync
+  SDL_GL_SetSwapInterval(headless ? 0 : 1); // enable v-sync
 
   *windowHandle = window;
   *glContextHandle = context;
@@ -42,6 +44,13 @@ inline void swapBuffers(WINDOW_HANDLE window) {
   SDL_GL_SwapWindow((SDL_Window*)window);
 }
 
+// A context can only be current on one thread at a time, pass nullptr to release it from the calling thread
+void makeGLContextCurrent(WINDOW_HANDLE window, GL_CONTEXT_HANDLE glContextHandle) {
+  if(SDL_GL_MakeCurrent((SDL_Window*)window, (SDL_GLContext)glContextHandle) != 0) {
+    fprintf(stderr, "Could not make the GL context current: %s\n", SDL_GetError());
+  }
+}
+
 void getWindowDimens(WINDOW_HANDLE window, ivec2* dimens) {
   return getWindowDimens(window, &dimens->x, &dimens->y);
 }
@@ -54,60 +63,237 @@ void getWindowDimens(WINDOW_HANDLE window, s32* width, s32* height) {
 inline void hideMouse(bool hide) { SDL_SetRelativeMouseMode(hide ? SDL_TRUE : SDL_FALSE); }
 
 /* INPUT */
-void getKeyboardInput(InputState* prevState) {
-  prevState->activated = 0;
-  prevState->released = 0;
+#define INPUT_GAMEPAD_AXIS_PRESS_VALUE 16384 // an axis direction goes down past this
+#define INPUT_GAMEPAD_AXIS_RELEASE_VALUE 12288 // and back up within this, so noise around the dead zone does not chatter
+
+global InputEventRing inputEventRing;
+global u32 gamepadAxesPastDeadZone; // axis directions, only touched by the main thread which pumps controller events
+
+// Turns an axis value into down and up events for its two directions as they cross the dead zone.
+// Every open controller feeds the same axis directions.
+internal void pushGamepadAxisEvents(InputEventRing* ring, u64 perfCounter, u8 axis, s32 value) {
+  const u8 directions[] = {(u8)GamepadAxisNegative(axis), (u8)GamepadAxisPositive(axis)};
+  const s32 directionValues[] = {-value, value};
+  for(u32 i = 0; i < ArrayCount(directions); ++i) {
+    u32 bit = 1u << directions[i];
+    bool wasDown = (gamepadAxesPastDeadZone & bit) != 0;
+    bool down = directionValues[i] >= (wasDown ? INPUT_GAMEPAD_AXIS_RELEASE_VALUE : INPUT_GAMEPAD_AXIS_PRESS_VALUE);
+    if(down == wasDown) { continue; }
+    gamepadAxesPastDeadZone ^= bit;
+    InputEvent event{};
+    event.perfCounter = perfCounter;
+    event.type = down ? InputEvent_GamepadAxisDown : InputEvent_GamepadAxisUp;
+    event.code = directions[i];
+    event.x = value;
+    pushInputEvent(ring, event);
+  }
+}
 
-  SDL_Event event;
-  while( SDL_PollEvent( &event ) ){
-    ImGui_ImplSDL2_ProcessEvent(&event);
+// Called by SDL as events are queued. SDL2 stamps events with the time they are queued as well, so input is only
+// stamped close to when it happened if the main thread pumps often, see pumpInputEvents(). Events pushed with
+// SDL_PushEvent() from other threads also come through here.
+internal int sdlInputEventWatch(void* userdata, SDL_Event* sdlEvent) {
+  InputEventRing* ring = (InputEventRing*)userdata;
+  InputEvent event{};
+  event.perfCounter = getPerformanceCounter();
+  switch(sdlEvent->type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      if(sdlEvent->key.repeat) { return 0; } // not a change in state
+      event.type = sdlEvent->type == SDL_KEYDOWN ? InputEvent_KeyDown : InputEvent_KeyUp;
+      event.scancode = (u16)sdlEvent->key.keysym.scancode;
+      event.code = sdlEvent->key.keysym.sym;
+      break;
+    case SDL_MOUSEMOTION:
+      event.type = InputEvent_MouseMotion;
+      event.x = sdlEvent->motion.xrel;
+      event.y = -sdlEvent->motion.yrel;
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      event.type = sdlEvent->type == SDL_MOUSEBUTTONDOWN ? InputEvent_MouseButtonDown : InputEvent_MouseButtonUp;
+      event.code = sdlEvent->button.button;
+      break;
+    case SDL_MOUSEWHEEL:
+      event.type = InputEvent_MouseWheel;
+      event.x = sdlEvent->wheel.x;
+      event.y = sdlEvent->wheel.y;
+      break;
+    case SDL_QUIT:
+      event.type = InputEvent_Quit;
+      break;
+    case SDL_CONTROLLERAXISMOTION:
+      if(sdlEvent->caxis.axis < SDL_CONTROLLER_AXIS_MAX) {
+        pushGamepadAxisEvents(ring, event.perfCounter, sdlEvent->caxis.axis, sdlEvent->caxis.value);
+      }
+      return 0;
+    case SDL_CONTROLLERDEVICEREMOVED: // no motion back to rest will follow
+      for(u8 axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; ++axis) {
+        pushGamepadAxisEvents(ring, event.perfCounter, axis, 0);
+      }
+      return 0;
+    default:
+      return 0;
+  }
+  pushInputEvent(ring, event);
+  return 0;
+}
+
+void initInputEvents() {
+  gamepadAxesPastDeadZone = 0;
+  inputEventRing.writeIndex = 0;
+  inputEventRing.readIndex = 0;
+  inputEventRing.droppedCount = 0;
+  SDL_AddEventWatch(sdlInputEventWatch, &inputEventRing);
+}
+
+void deinitInputEvents() {
+  SDL_DelEventWatch(sdlInputEventWatch, &inputEventRing);
+}
 
-    /* We are only worried about SDL_KEYDOWN and SDL_KEYUP events */
-    switch( event.type ){
-      case SDL_KEYDOWN:
-        switch( event.key.keysym.sym ){
-#define InputType(name,index,sdlCode) \
-          case sdlCode:               \
-            setFlags(&prevState->activated, InputType::##name); \
-            break;
-#include "InputType.incl"
-#undef InputType
-          default:
-            break;
+// Folds a frame of events into the per frame action masks, each key, mouse button or gamepad axis event is one inputMap load.
+// An action is released once none of its bindings are held.
+void applyInputEvents(InputState* prevState, const InputEventFrame& eventFrame) {
+  prevState->activated = 0;
+  prevState->released = 0;
+  prevState->mouseDeltaX = 0;
+  prevState->mouseDeltaY = 0;
+
+  b32 down = heldInputActions(inputMap, *prevState); // picks up rebinding since the last frame
+  auto press = [&](b32 actions) {
+    setFlags(&prevState->activated, actions & ~down);
+    setFlags(&down, actions);
+  };
+  auto release = [&](b32 actions) {
+    if(actions == 0) { return; }
+    b32 stillHeld = heldInputActions(inputMap, *prevState) & actions;
+    setFlags(&prevState->released, actions & ~stillHeld);
+    clearFlags(&down, actions & ~stillHeld);
+  };
+
+  for(u32 i = 0; i < eventFrame.eventCount; ++i) {
+    const InputEvent& event = eventFrame.events[i];
+    switch(event.type) {
+      case InputEvent_KeyDown:
+        setKeyDown(&prevState->keys, event.scancode, true);
+        press(inputMap.keyActions[event.scancode]);
+        break;
+      case InputEvent_KeyUp:
+        setKeyDown(&prevState->keys, event.scancode, false);
+        release(inputMap.keyActions[event.scancode]);
+        break;
+      case InputEvent_MouseButtonDown:
+        if((u32)event.code < INPUT_MOUSE_BUTTON_COUNT) {
+          prevState->mouseButtonsDown |= 1u << event.code;
+          press(inputMap.mouseButtonActions[event.code]);
         }
         break;
-      case SDL_KEYUP:
-        switch( event.key.keysym.sym ){
-#define InputType(name,index,sdlCode) \
-          case sdlCode:               \
-            setFlags(&prevState->released, InputType::##name); \
-            break;
-#include "InputType.incl"
-#undef InputType
-          default:
-            break;
+      case InputEvent_MouseButtonUp:
+        if((u32)event.code < INPUT_MOUSE_BUTTON_COUNT) {
+          prevState->mouseButtonsDown &= ~(1u << event.code);
+          release(inputMap.mouseButtonActions[event.code]);
         }
         break;
-      case SDL_QUIT:
+      case InputEvent_GamepadAxisDown:
+        if((u32)event.code < INPUT_GAMEPAD_AXIS_COUNT) {
+          prevState->gamepadAxesDown |= 1u << event.code;
+          press(inputMap.gamepadAxisActions[event.code]);
+        }
+        break;
+      case InputEvent_GamepadAxisUp:
+        if((u32)event.code < INPUT_GAMEPAD_AXIS_COUNT) {
+          prevState->gamepadAxesDown &= ~(1u << event.code);
+          release(inputMap.gamepadAxisActions[event.code]);
+        }
+        break;
+      case InputEvent_MouseMotion:
+        prevState->mouseDeltaX += event.x;
+        prevState->mouseDeltaY += event.y;
+        break;
+      case InputEvent_Quit:
         prevState->quit = true;
         break;
-      case SDL_MOUSEMOTION:
       default:
         break;
     }
   }
 
-  SDL_GetRelativeMouseState(&prevState->mouseDeltaX, &prevState->mouseDeltaY);
-  prevState->mouseDeltaY = -prevState->mouseDeltaY;
+  prevState->down = down;
+}
+
+// Queues pending OS events, which stamps them and pushes them into the event ring, without handing them to anyone.
+// Must be called on the main thread. Calling it while the main thread would otherwise wait keeps the timestamps
+// of the next frame's events close to when they happened.
+void pumpInputEvents() {
+  SDL_PumpEvents();
+}
+
+// Pumps SDL, which fills the event ring, then hands this frame's events to outEventFrame when provided.
+// Game controllers are opened as they connect, SDL also reports the ones already connected at startup this way.
+void getKeyboardInput(InputState* prevState, InputEventFrame* outEventFrame) {
+  SDL_Event event;
+  while( SDL_PollEvent( &event ) ){
+    if(event.type == SDL_CONTROLLERDEVICEADDED) {
+      if(SDL_GameControllerOpen(event.cdevice.which) == nullptr) {
+        fprintf(stderr, "Could not open game controller %d: %s\n", event.cdevice.which, SDL_GetError());
+      }
+    } else if(event.type == SDL_CONTROLLERDEVICEREMOVED) {
+      SDL_GameControllerClose(SDL_GameControllerFromInstanceID(event.cdevice.which));
+    }
+    ImGui_ImplSDL2_ProcessEvent(&event);
+  }
+
+  thread_local InputEventFrame localEventFrame; // keeps beginCounter chained when the caller does not want the events
+  InputEventFrame* eventFrame = outEventFrame != nullptr ? outEventFrame : &localEventFrame;
+  drainInputEvents(&inputEventRing, eventFrame, getPerformanceCounter());
+  applyInputEvents(prevState, *eventFrame);
+}
+
+static_assert(INPUT_KEY_COUNT >= SDL_NUM_SCANCODES, "ERROR: Keyboard state must cover every SDL scancode!");
+static_assert(INPUT_GAMEPAD_AXIS_COUNT == SDL_CONTROLLER_AXIS_MAX * 2, "ERROR: Gamepad axis directions must cover every SDL controller axis!");
+
+const char* scancodeName(u16 scancode) {
+  const char* name = SDL_GetScancodeName((SDL_Scancode)scancode);
+  return name[0] != '\0' ? name : "Unknown Key";
+}
+
+const char* mouseButtonName(u8 button) {
+  switch(button) {
+    case SDL_BUTTON_LEFT: return "Left Mouse";
+    case SDL_BUTTON_MIDDLE: return "Middle Mouse";
+    case SDL_BUTTON_RIGHT: return "Right Mouse";
+    case SDL_BUTTON_X1: return "Mouse 4";
+    case SDL_BUTTON_X2: return "Mouse 5";
+    default: return "Unknown Mouse Button";
+  }
+}
 
-  setFlags(&prevState->down, prevState->activated);
-  clearFlags(&prevState->down, prevState->released);
+const char* gamepadAxisName(u8 axisDirection) {
+  switch(axisDirection) {
+    case GamepadAxisNegative(SDL_CONTROLLER_AXIS_LEFTX): return "Left Stick Left";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_LEFTX): return "Left Stick Right";
+    case GamepadAxisNegative(SDL_CONTROLLER_AXIS_LEFTY): return "Left Stick Up";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_LEFTY): return "Left Stick Down";
+    case GamepadAxisNegative(SDL_CONTROLLER_AXIS_RIGHTX): return "Right Stick Left";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_RIGHTX): return "Right Stick Right";
+    case GamepadAxisNegative(SDL_CONTROLLER_AXIS_RIGHTY): return "Right Stick Up";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_RIGHTY): return "Right Stick Down";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_TRIGGERLEFT): return "Left Trigger";
+    case GamepadAxisPositive(SDL_CONTROLLER_AXIS_TRIGGERRIGHT): return "Right Trigger";
+    default: return "Unknown Gamepad Axis";
+  }
 }
 
 /* FILE */
-void openFile(const char* fileName, FILE_HANDLE* outFile, size_t* readInBytes) {
+// Reads the whole file, false when it cannot be read and outFile is left null
+bool openFile(const char* fileName, FILE_HANDLE* outFile, size_t* readInBytes) {
   *outFile = SDL_LoadFile(fileName, readInBytes);
-  assert(*outFile != nullptr);
+  if(*outFile == nullptr) {
+    fprintf(stderr, "Could not open %s: %s\n", fileName, SDL_GetError());
+    *readInBytes = 0;
+    return false;
+  }
+  return true;
 }
 
 const char* fileBytes(FILE_HANDLE file) {
@@ -118,6 +304,117 @@ void closeFile(FILE_HANDLE file) {
   SDL_free(file);
 }
 
+bool writeFile(const char* fileName, const void* data, size_t sizeInBytes) {
+  SDL_RWops* file = SDL_RWFromFile(fileName, "wb");
+  if(file == nullptr) {
+    fprintf(stderr, "Could not open %s for writing: %s\n", fileName, SDL_GetError());
+    return false;
+  }
+  bool success = SDL_RWwrite(file, data, 1, sizeInBytes) == sizeInBytes;
+  SDL_RWclose(file);
+  return success;
+}
+
+// Pages are only read in as they are touched. False if the file can't be opened or is empty.
+#ifdef _WIN32
+bool mapFile(const char* fileName, MappedFile* outFile) {
+  *outFile = {};
+  HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE) { return false; }
+  LARGE_INTEGER fileSize;
+  HANDLE mapping = nullptr;
+  if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+  CloseHandle(file); // the mapping keeps the file open
+  if(mapping == nullptr) { return false; }
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if(data == nullptr) {
+    CloseHandle(mapping);
+    return false;
+  }
+  outFile->data = (const u8*)data;
+  outFile->size = (size_t)fileSize.QuadPart;
+  outFile->platformHandle = mapping;
+  return true;
+}
+
+void unmapFile(MappedFile* file) {
+  UnmapViewOfFile(file->data);
+  CloseHandle((HANDLE)file->platformHandle);
+  *file = {};
+}
+#else
+bool mapFile(const char* fileName, MappedFile* outFile) {
+  *outFile = {};
+  int file = open(fileName, O_RDONLY);
+  if(file < 0) { return false; }
+  struct stat fileStat;
+  void* data = MAP_FAILED;
+  if(fstat(file, &fileStat) == 0 && fileStat.st_size > 0) {
+    data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  }
+  close(file); // the mapping keeps the file open
+  if(data == MAP_FAILED) { return false; }
+  outFile->data = (const u8*)data;
+  outFile->size = (size_t)fileStat.st_size;
+  return true;
+}
+
+void unmapFile(MappedFile* file) {
+  munmap((void*)file->data, file->size);
+  *file = {};
+}
+#endif
+
+// Read calls the process has made so far, 0 where the platform does not count them
+u64 readSyscallCount() {
+#if defined(_WIN32)
+  IO_COUNTERS counters;
+  return GetProcessIoCounters(GetCurrentProcess(), &counters) ? counters.ReadOperationCount : 0;
+#elif defined(__linux__)
+  FILE* io = fopen("/proc/self/io", "r");
+  if(io == nullptr) { return 0; }
+  char line[128];
+  unsigned long long count = 0;
+  while(fgets(line, sizeof(line), io) != nullptr) {
+    if(sscanf(line, "syscr: %llu", &count) == 1) { break; }
+  }
+  fclose(io);
+  return count;
+#else
+  return 0;
+#endif
+}
+
+/* MEMORY */
+// Reserved pages cost no memory until they are committed
+void* reserveMemory(size_t size) {
+#ifdef _WIN32
+  return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+  void* address = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return address == MAP_FAILED ? nullptr : address;
+#endif
+}
+
+bool commitMemory(void* address, size_t size) {
+#ifdef _WIN32
+  return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+  return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void releaseMemory(void* address, size_t size) {
+#ifdef _WIN32
+  (void)size;
+  VirtualFree(address, 0, MEM_RELEASE);
+#else
+  munmap(address, size);
+#endif
+}
+
 /* AUDIO: Currently only supports WAV */
 enum AudioFlags {
   ACTIVE = 1 << 0,
@@ -234,9 +531,12 @@ void loadUpSong(AUDIO_HANDLE handle, const char* fileName) {
     SDL_FreeWAV(song.buffer);
   }
 
-  if (SDL_LoadWAV(fileName, &song.audioSpec, &song.buffer, &song.length) == nullptr) {
+  AssetFile wavFile;
+  openAsset(fileName, &wavFile);
+  if (SDL_LoadWAV_RW(SDL_RWFromConstMem(wavFile.bytes, (int)wavFile.size), 1, &song.audioSpec, &song.buffer, &song.length) == nullptr) {
     fprintf(stderr, "Could not open wav sound file (%s fileName): %s\n", fileName, SDL_GetError());
   }
+  closeAsset(&wavFile);
 
   // TODO: Potentially adjust some aspect of the audio spec for device
 
@@ -263,9 +563,12 @@ void loadUpSoundEffect(AUDIO_HANDLE handle, const char* fileName) {
     SDL_FreeWAV(soundEffect.buffer);
   }
 
-  if (SDL_LoadWAV(fileName, &soundEffect.audioSpec, &soundEffect.buffer, &soundEffect.length) == nullptr) {
+  AssetFile wavFile;
+  openAsset(fileName, &wavFile);
+  if (SDL_LoadWAV_RW(SDL_RWFromConstMem(wavFile.bytes, (int)wavFile.size), 1, &soundEffect.audioSpec, &soundEffect.buffer, &soundEffect.length) == nullptr) {
     fprintf(stderr, "Could not open wav sound file (%s fileName): %s\n", fileName, SDL_GetError());
   }
+  closeAsset(&wavFile);
 
   // TODO: Potentially adjust some aspect of the audio spec for device
 
@@ -301,15 +604,27 @@ void initImgui(WINDOW_HANDLE windowHandle, GL_CONTEXT_HANDLE glContextHandle) {
   // Setup Platform/Renderer bindings
   ImGui_ImplSDL2_InitForOpenGL((SDL_Window*)windowHandle, (SDL_GLContext*)glContextHandle);
   ImGui_ImplOpenGL3_Init(nullptr);
+  // The GL backend's NewFrame only creates its device objects (shaders, font texture) when they are missing.
+  // Doing that once here, while the context is current, keeps every later ImGui frame free of GL calls
+  // so it can be built on a thread that does not own the context.
+  ImGui_ImplOpenGL3_NewFrame();
 }
 
+// No GL calls, must be called on the thread that polls input
 void newFrameImGui() {
-  ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
 }
 
-void renderImGui() {
+// Finalizes the frame's draw lists, which stay valid until the next newFrameImGui()
+ImDrawData* endFrameImGui() {
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  return ImGui::GetDrawData();
+}
+
+// Must be called on the thread that owns the GL context. May overlap the next ImGui frame on another thread: the GL
+// backend reads only drawData and its own state, which it finds through io.BackendRendererUserData. That is written by
+// ImGui_ImplOpenGL3_Init() alone, nothing in ImGui::NewFrame() touches it.
+void renderImGui(ImDrawData* drawData) {
+  ImGui_ImplOpenGL3_RenderDrawData(drawData);
 }
\ No newline at end of file
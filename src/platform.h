@@ -5,38 +5,50 @@ typedef void* FILE_HANDLE;
 typedef void* GL_CONTEXT_HANDLE;
 typedef void* AUDIO_HANDLE;
 
-enum InputType {
-#define InputType(name,index,sdlCode) name = 1 << index,
-#include "InputType.incl"
-#undef InputType
-};
+struct InputState;
+struct InputEventFrame;
 
-struct InputState {
-  b32 down;
-  b32 activated;
-  b32 released;
-  s32 mouseDeltaX;
-  s32 mouseDeltaY; // positive is up, negative is down
-  bool quit;
+// Read only view of a whole file
+struct MappedFile {
+  const u8* data;
+  size_t size;
+  void* platformHandle;
 };
 
 /* OpenGL */
 void loadOpenGL();
 
 /* WINDOW */
-void initWindow(u32 width, u32 height, OUT WINDOW_HANDLE* windowHandle, OUT GL_CONTEXT_HANDLE* glContextHandle);
+void initWindow(s32 width, s32 height, OUT WINDOW_HANDLE* windowHandle, OUT GL_CONTEXT_HANDLE* glContextHandle, bool headless = false);
 void deinitWindow(WINDOW_HANDLE* window, GL_CONTEXT_HANDLE* glContextHandle);
 inline void swapBuffers(WINDOW_HANDLE window);
+void makeGLContextCurrent(WINDOW_HANDLE window, GL_CONTEXT_HANDLE glContextHandle);
 void getWindowDimens(WINDOW_HANDLE window, OUT ivec2* dimens);
 void getWindowDimens(WINDOW_HANDLE window, OUT s32* width, OUT s32* height);
 
 /* INPUT */
-void getKeyboardInput(InputState* prevState);
+void initInputEvents();
+void deinitInputEvents();
+void getKeyboardInput(InputState* prevState, InputEventFrame* outEventFrame = nullptr);
+void pumpInputEvents();
+void applyInputEvents(InputState* prevState, const InputEventFrame& eventFrame);
+const char* scancodeName(u16 scancode);
+const char* mouseButtonName(u8 button);
+const char* gamepadAxisName(u8 axisDirection);
 
 /* FILE */
-void openFile(const char* fileName, OUT FILE_HANDLE* outFile, OUT size_t* readInBytes);
+bool openFile(const char* fileName, OUT FILE_HANDLE* outFile, OUT size_t* readInBytes);
 const char* fileBytes(FILE_HANDLE file);
 void closeFile(FILE_HANDLE file);
+bool writeFile(const char* fileName, const void* data, size_t sizeInBytes);
+bool mapFile(const char* fileName, OUT MappedFile* outFile);
+void unmapFile(MappedFile* file);
+u64 readSyscallCount();
+
+/* MEMORY */
+void* reserveMemory(size_t size); // address space only, nullptr on failure
+bool commitMemory(void* address, size_t size);
+void releaseMemory(void* address, size_t size);
 
 /* AUDIO: Currently only supports WAV */
 void initAudio(AUDIO_HANDLE* handle);
@@ -53,4 +65,5 @@ u64 getPerformanceCounterFrequencyPerSecond();
 /* IMGUI */
 void initImgui(WINDOW_HANDLE windowHandle, GL_CONTEXT_HANDLE glContextHandle);
 void newFrameImGui();
-void renderImGui();
\ No newline at end of file
+ImDrawData* endFrameImGui();
+void renderImGui(ImDrawData* drawData);
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+// Low resolution render target
+// Pixel art mode draws the scene into an offscreen framebuffer a whole number of times smaller than the window and
+// blits it up with nearest filtering, so every rendered pixel becomes a square block on screen and fragment shading
+// shrinks by the square of the scale. The image is centered when the window is not a multiple of the scale.
+// Dynamic resolution instead renders into the corner of a window sized target and stretches that over the window.
+
+#define PIXEL_SCALE_MAX 8
+
+struct RenderTarget {
+  GLuint framebuffer;
+  GLuint colorTexture;
+  GLuint depthRenderbuffer;
+  ivec2 dimens;
+};
+
+// (Re)allocates the target's storage, creating it on first use. Does nothing when the dimensions are unchanged.
+void resizeRenderTarget(RenderTarget* target, ivec2 dimens) {
+  if(target->framebuffer != 0 && target->dimens.x == dimens.x && target->dimens.y == dimens.y) { return; }
+  if(target->framebuffer == 0) {
+    glGenFramebuffers(1, &target->framebuffer);
+    glGenTextures(1, &target->colorTexture);
+    glGenRenderbuffers(1, &target->depthRenderbuffer);
+  }
+  target->dimens = dimens;
+
+  glBindTexture(GL_TEXTURE_2D, target->colorTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, dimens.x, dimens.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, target->depthRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, dimens.x, dimens.y);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->colorTexture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->depthRenderbuffer);
+  assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE && "ERROR: Render target framebuffer is incomplete!");
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void deinitRenderTarget(RenderTarget* target) {
+  if(target->framebuffer != 0) {
+    glDeleteFramebuffers(1, &target->framebuffer);
+    glDeleteTextures(1, &target->colorTexture);
+    glDeleteRenderbuffers(1, &target->depthRenderbuffer);
+  }
+  *target = {}; // clear to zero
+}
+
+// Largest size that scales up to fit within the window, at least one pixel
+inline ivec2 pixelScaledDimens(ivec2 windowDimens, u32 pixelScale) {
+  return ivec2{ Max(windowDimens.x / (s32)pixelScale, 1), Max(windowDimens.y / (s32)pixelScale, 1) };
+}
+
+// Integer scaled blit into the default framebuffer, centered. Clears the default framebuffer's borders first.
+void blitRenderTargetToWindow(const RenderTarget& target, ivec2 windowDimens, u32 pixelScale) {
+  ivec2 scaledDimens{ target.dimens.x * (s32)pixelScale, target.dimens.y * (s32)pixelScale };
+  ivec2 offset{ (windowDimens.x - scaledDimens.x) / 2, (windowDimens.y - scaledDimens.y) / 2 };
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, windowDimens.x, windowDimens.y);
+  if(offset.x != 0 || offset.y != 0) {
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+  glBlitFramebuffer(0, 0, target.dimens.x, target.dimens.y,
+                    offset.x, offset.y, offset.x + scaledDimens.x, offset.y + scaledDimens.y,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+// Stretches the bottom left sourceDimens of the target over the whole default framebuffer with bilinear filtering
+void stretchRenderTargetToWindow(const RenderTarget& target, ivec2 sourceDimens, ivec2 windowDimens) {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, windowDimens.x, windowDimens.y);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+  glBlitFramebuffer(0, 0, sourceDimens.x, sourceDimens.y, 0, 0, windowDimens.x, windowDimens.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
\ No newline at end of file
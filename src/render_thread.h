@@ -0,0 +1,282 @@
+#pragma once
+
+// Render thread
+// The main thread polls input, simulates and records everything a frame needs into an immutable FramePacket.
+// A render thread that owns the GL context turns packets into GL calls and swaps. Packets are triple buffered:
+// one being recorded, one waiting and one being drawn. Submitting waits until the render thread picks the packet up,
+// so the simulation records at most one frame ahead of the frame being drawn and is paced by the swap. Should a packet
+// still be waiting anyway it is replaced (mailbox), so the render thread always draws the most recent input.
+// With the render thread disabled the same packets are drawn on the main thread right after they are recorded,
+// which keeps the single threaded loop around to measure against.
+
+#define FRAME_PACKET_COUNT 3
+#define RENDER_STATS_SMOOTHING 0.05 // weight of the newest frame in the running averages
+#define FRAME_PACKET_MAX_SPRITES 64
+#define FRAME_PACKET_SUBMIT_PUMP_MS 1 // input is pumped this often while waiting for the pickup
+
+struct FramePacket {
+  u64 frameIndex;
+  u64 inputPerfCounter; // when the input this frame reacts to was sampled
+  glm::mat4 viewMat;
+  glm::mat4 projMat;
+  ivec2 windowDimens;
+  ivec2 emulatedResolution; // in tiles
+  u32 pixelScale; // scene is drawn at 1/pixelScale of the window and scaled up when above 1
+  DynamicResolutionSettings dynamicResolution; // ignored in pixel art mode
+  glm::vec2 spritePositions[FRAME_PACKET_MAX_SPRITES];
+  u32 spriteCount;
+  TileMapView tileMapView;
+  StaticDrawList staticDraws;
+  char statsHudText[STATS_HUD_MAX_CHARS]; // empty when the HUD is hidden
+
+  // ImGui's draw lists are overwritten every ImGui frame, the packet keeps its own copies. The lists and their
+  // buffers stay allocated from frame to frame and are only grown.
+  ImDrawData imguiDrawData; // CmdLists points at imguiDrawLists
+  ImDrawList** imguiDrawLists;
+  u32 imguiDrawListCount; // allocated, CmdListsCount of them are in use
+  u32 imguiDrawListCapacity;
+};
+
+// Issues the GL calls for one packet, the renderer swaps afterwards
+typedef StaticGeometryStats (*RenderFrameFunction)(void* renderState, FramePacket* packet);
+
+struct RenderStats {
+  StaticGeometryStats staticGeometry; // most recently drawn packet
+  f64 inputToSwapSeconds; // running average, from input sampling until the swap that shows it returns
+  f64 framesPerSecond; // running average of swaps per second
+  u64 renderedCount;
+  u64 droppedCount; // packets replaced before the render thread got to them
+};
+
+struct Renderer {
+  WINDOW_HANDLE window;
+  GL_CONTEXT_HANDLE glContext;
+  RenderFrameFunction renderFrame;
+  void* renderState;
+
+  FramePacket packets[FRAME_PACKET_COUNT];
+  s32 recordingIndex; // -1 when unused
+  s32 waitingIndex;
+  s32 drawingIndex;
+  u64 nextFrameIndex;
+
+  std::mutex mutex; // guards the indices above, stats and quit
+  std::condition_variable condition;
+  std::thread thread;
+  bool threaded;
+  bool quit;
+
+  RenderStats stats;
+  u64 lastSwapPerfCounter;
+};
+
+internal void clearImGuiDrawData(FramePacket* packet) {
+  packet->imguiDrawData = ImDrawData();
+  packet->imguiDrawData.CmdLists = packet->imguiDrawLists;
+}
+
+internal void freeImGuiDrawLists(FramePacket* packet) {
+  for(u32 i = 0; i < packet->imguiDrawListCount; ++i) {
+    IM_DELETE(packet->imguiDrawLists[i]);
+  }
+  delete[] packet->imguiDrawLists;
+  packet->imguiDrawLists = nullptr;
+  packet->imguiDrawListCount = 0;
+  packet->imguiDrawListCapacity = 0;
+  clearImGuiDrawData(packet);
+}
+
+// Only allocates when the destination has to grow
+template <typename T>
+internal void copyImVector(ImVector<T>* dst, const ImVector<T>& src) {
+  dst->resize(src.Size);
+  if(src.Size > 0) { memcpy(dst->Data, src.Data, src.size_in_bytes()); }
+}
+
+void initRenderer(Renderer* renderer, WINDOW_HANDLE window, GL_CONTEXT_HANDLE glContext,
+                  RenderFrameFunction renderFrame, void* renderState, u32 staticDrawCapacity) {
+  renderer->window = window;
+  renderer->glContext = glContext;
+  renderer->renderFrame = renderFrame;
+  renderer->renderState = renderState;
+  for(u32 i = 0; i < FRAME_PACKET_COUNT; ++i) {
+    FramePacket* packet = renderer->packets + i;
+    *packet = {};
+    initStaticDrawList(&packet->staticDraws, staticDrawCapacity);
+    packet->imguiDrawData.CmdLists = packet->imguiDrawLists;
+  }
+  renderer->recordingIndex = -1;
+  renderer->waitingIndex = -1;
+  renderer->drawingIndex = -1;
+  renderer->nextFrameIndex = 0;
+  renderer->threaded = false;
+  renderer->quit = false;
+  renderer->stats = {};
+  renderer->lastSwapPerfCounter = 0;
+}
+
+// Resumes tasks waiting on toRenderThread(), draws, swaps and updates stats. Called by whichever thread owns the
+// GL context.
+internal void drawFramePacket(Renderer* renderer, FramePacket* packet) {
+  runRenderThreadTasks();
+  StaticGeometryStats staticGeometryStats = renderer->renderFrame(renderer->renderState, packet);
+  swapBuffers(renderer->window);
+
+  // swap returning is the closest thing to photons the application can observe
+  u64 swapPerfCounter = getPerformanceCounter();
+  f64 perfCounterFrequency = (f64)getPerformanceCounterFrequencyPerSecond();
+  f64 inputToSwapSeconds = (f64)(swapPerfCounter - packet->inputPerfCounter) / perfCounterFrequency;
+
+  std::lock_guard<std::mutex> lock(renderer->mutex);
+  RenderStats* stats = &renderer->stats;
+  stats->staticGeometry = staticGeometryStats;
+  if(stats->renderedCount == 0) {
+    stats->inputToSwapSeconds = inputToSwapSeconds;
+  } else {
+    stats->inputToSwapSeconds += (inputToSwapSeconds - stats->inputToSwapSeconds) * RENDER_STATS_SMOOTHING;
+    f64 framesPerSecond = perfCounterFrequency / (f64)Max(swapPerfCounter - renderer->lastSwapPerfCounter, (u64)1);
+    stats->framesPerSecond = (stats->renderedCount == 1) ? framesPerSecond :
+                             stats->framesPerSecond + (framesPerSecond - stats->framesPerSecond) * RENDER_STATS_SMOOTHING;
+  }
+  stats->renderedCount++;
+  renderer->lastSwapPerfCounter = swapPerfCounter;
+}
+
+internal void renderThreadMain(Renderer* renderer) {
+  makeGLContextCurrent(renderer->window, renderer->glContext);
+  while(true) {
+    FramePacket* packet;
+    {
+      std::unique_lock<std::mutex> lock(renderer->mutex);
+      renderer->condition.wait(lock, [renderer]() { return renderer->waitingIndex >= 0 || renderer->quit; });
+      if(renderer->waitingIndex < 0) { break; } // quit, only once the waiting packet has been drawn
+      renderer->drawingIndex = renderer->waitingIndex;
+      renderer->waitingIndex = -1;
+      packet = renderer->packets + renderer->drawingIndex;
+    }
+    renderer->condition.notify_all(); // simulation may be waiting for the pickup
+
+    drawFramePacket(renderer, packet);
+
+    std::lock_guard<std::mutex> lock(renderer->mutex);
+    renderer->drawingIndex = -1;
+  }
+  makeGLContextCurrent(renderer->window, nullptr);
+}
+
+// Hands the GL context between the calling thread and the render thread. Must be called by the thread that
+// records packets, between submitFramePacket() and the next beginFramePacket().
+void setRenderThreadEnabled(Renderer* renderer, bool enabled) {
+  if(enabled == renderer->threaded) { return; }
+  if(enabled) {
+    makeGLContextCurrent(renderer->window, nullptr);
+    renderer->quit = false;
+    renderer->threaded = true;
+    renderer->thread = std::thread(renderThreadMain, renderer);
+  } else {
+    {
+      std::lock_guard<std::mutex> lock(renderer->mutex);
+      renderer->quit = true;
+    }
+    renderer->condition.notify_all();
+    renderer->thread.join();
+    renderer->threaded = false;
+    makeGLContextCurrent(renderer->window, renderer->glContext);
+  }
+}
+
+// Stops the render thread, leaving the GL context current on the calling thread
+void deinitRenderer(Renderer* renderer) {
+  setRenderThreadEnabled(renderer, false);
+  for(u32 i = 0; i < FRAME_PACKET_COUNT; ++i) {
+    FramePacket* packet = renderer->packets + i;
+    freeImGuiDrawLists(packet);
+    deinitStaticDrawList(&packet->staticDraws);
+  }
+}
+
+// Returns an empty packet that is neither waiting nor being drawn
+FramePacket* beginFramePacket(Renderer* renderer, u64 inputPerfCounter) {
+  assert(renderer->recordingIndex < 0 && "ERROR: Previous frame packet was never submitted!");
+  {
+    std::lock_guard<std::mutex> lock(renderer->mutex);
+    for(s32 i = 0; i < FRAME_PACKET_COUNT; ++i) {
+      if(i != renderer->waitingIndex && i != renderer->drawingIndex) {
+        renderer->recordingIndex = i;
+        break;
+      }
+    }
+  }
+  assert(renderer->recordingIndex >= 0);
+
+  FramePacket* packet = renderer->packets + renderer->recordingIndex;
+  packet->frameIndex = renderer->nextFrameIndex++;
+  packet->inputPerfCounter = inputPerfCounter;
+  packet->spriteCount = 0;
+  packet->tileMapView.chunkCount = 0;
+  packet->statsHudText[0] = '\0';
+  clearStaticDrawList(&packet->staticDraws);
+  clearImGuiDrawData(packet);
+  return packet;
+}
+
+// Copies ImGui's finalized draw data into the packet's draw lists
+void recordImGuiDrawData(FramePacket* packet, const ImDrawData* drawData) {
+  clearImGuiDrawData(packet);
+  if(drawData == nullptr || !drawData->Valid) { return; }
+
+  u32 drawListCount = (u32)drawData->CmdListsCount;
+  if(drawListCount > packet->imguiDrawListCapacity) {
+    packet->imguiDrawListCapacity = Max(drawListCount, packet->imguiDrawListCapacity * 2);
+    ImDrawList** drawLists = new ImDrawList*[packet->imguiDrawListCapacity];
+    for(u32 i = 0; i < packet->imguiDrawListCount; ++i) { drawLists[i] = packet->imguiDrawLists[i]; }
+    delete[] packet->imguiDrawLists;
+    packet->imguiDrawLists = drawLists;
+  }
+  for(; packet->imguiDrawListCount < drawListCount; ++packet->imguiDrawListCount) {
+    packet->imguiDrawLists[packet->imguiDrawListCount] = IM_NEW(ImDrawList)(drawData->CmdLists[0]->_Data);
+  }
+  for(u32 i = 0; i < drawListCount; ++i) {
+    const ImDrawList* source = drawData->CmdLists[i];
+    ImDrawList* drawList = packet->imguiDrawLists[i];
+    copyImVector(&drawList->CmdBuffer, source->CmdBuffer);
+    copyImVector(&drawList->IdxBuffer, source->IdxBuffer);
+    copyImVector(&drawList->VtxBuffer, source->VtxBuffer);
+    drawList->Flags = source->Flags;
+  }
+  packet->imguiDrawData = *drawData;
+  packet->imguiDrawData.CmdLists = packet->imguiDrawLists;
+}
+
+// Publishes the packet. Threaded, this replaces any packet still waiting and then blocks until the render thread picks
+// it up, which happens once the previous packet has been swapped. Input is pumped while blocked so the next frame's
+// events are stamped when they arrive. Single threaded, the packet is drawn and swapped before returning.
+void submitFramePacket(Renderer* renderer, FramePacket* packet) {
+  assert(packet == renderer->packets + renderer->recordingIndex && "ERROR: Submitted a packet that is not being recorded!");
+  if(!renderer->threaded) {
+    renderer->recordingIndex = -1;
+    drawFramePacket(renderer, packet);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(renderer->mutex);
+    if(renderer->waitingIndex >= 0) {
+      renderer->stats.droppedCount++;
+    }
+    renderer->waitingIndex = renderer->recordingIndex;
+    renderer->recordingIndex = -1;
+    renderer->condition.notify_all();
+    while(!renderer->condition.wait_for(lock, std::chrono::milliseconds(FRAME_PACKET_SUBMIT_PUMP_MS),
+                                        [renderer]() { return renderer->waitingIndex < 0; })) {
+      lock.unlock();
+      pumpInputEvents();
+      lock.lock();
+    }
+  }
+}
+
+RenderStats renderStats(Renderer* renderer) {
+  std::lock_guard<std::mutex> lock(renderer->mutex);
+  return renderer->stats;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+// Session record and replay
+// A replay is an input event recording (input_events.h) that also stores what the simulation consumed each frame:
+// the InputState and the Stopwatch delta. Replaying feeds the same stream back into the scene with a fixed timestep
+// instead of the wall clock, so two builds simulate an identical workload and their per frame timings can be compared
+// directly. Plain input recordings replay too, their InputState is rebuilt from the events through the current
+// bindings and their delta comes from the frame's counters.
+// Dear ImGui reads SDL directly and is not part of the stream, menu interactions are not replayed.
+
+#define REPLAY_DEFAULT_TIMESTEP_SECONDS (1.0 / 60.0)
+
+// Stored after each frame's events
+struct ReplayFrameData {
+  u32 down;
+  u32 activated;
+  u32 released;
+  s32 mouseDeltaX;
+  s32 mouseDeltaY;
+  f32 deltaSeconds; // as measured while recording
+  u8 quit;
+  u8 padding[3];
+};
+
+struct ReplayPlayback {
+  InputEventPlayback input;
+};
+
+// Per frame CPU time of a replay, from the start of the frame until its packet is submitted
+struct ReplayTimings {
+  f32* frameMs;
+  f32* recordedDeltaMs;
+  u32 count;
+  u32 capacity;
+};
+
+// Saved and released like any input event recording
+inline void initReplayRecording(InputEventRecording* recording) {
+  initInputEventRecording(recording, sizeof(ReplayFrameData), Megabytes(4));
+}
+
+void recordReplayFrame(InputEventRecording* recording, const InputState& inputState, const InputEventFrame& inputEvents, f64 deltaSeconds) {
+  ReplayFrameData frameData{};
+  frameData.down = (u32)inputState.down;
+  frameData.activated = (u32)inputState.activated;
+  frameData.released = (u32)inputState.released;
+  frameData.mouseDeltaX = inputState.mouseDeltaX;
+  frameData.mouseDeltaY = inputState.mouseDeltaY;
+  frameData.deltaSeconds = (f32)deltaSeconds;
+  frameData.quit = inputState.quit ? 1 : 0;
+  recordInputEventFrame(recording, inputEvents, &frameData);
+}
+
+bool openReplayPlayback(ReplayPlayback* playback, const char* fileName) {
+  if(!openInputEventPlayback(&playback->input, fileName)) { return false; }
+  if(playback->input.frameDataSize != 0 && playback->input.frameDataSize != sizeof(ReplayFrameData)) {
+    printf("Replay %s holds frame data of an unknown size\n", fileName);
+    closeInputEventPlayback(&playback->input);
+    return false;
+  }
+  return true;
+}
+
+inline u32 replayFrameCount(const ReplayPlayback& playback) { return playback.input.frameCount; }
+
+void closeReplayPlayback(ReplayPlayback* playback) {
+  closeInputEventPlayback(&playback->input);
+}
+
+// False once every recorded frame has been played or the replay turns out to be corrupt.
+// outInputState must hold the previous frame's state, plain input recordings build on it.
+bool nextReplayFrame(ReplayPlayback* playback, InputState* outInputState, InputEventFrame* outInputEvents, f64* outRecordedDeltaSeconds) {
+  const u8* frameDataBytes;
+  if(!nextInputEventFrame(&playback->input, outInputEvents, &frameDataBytes)) { return false; }
+  if(frameDataBytes == nullptr) {
+    applyInputEvents(outInputState, *outInputEvents);
+    *outRecordedDeltaSeconds = (f64)(outInputEvents->endCounter - outInputEvents->beginCounter) / (f64)playback->input.perfCounterFrequency;
+    return true;
+  }
+
+  ReplayFrameData frameData;
+  memcpy(&frameData, frameDataBytes, sizeof(frameData));
+  outInputState->down = (b32)frameData.down;
+  outInputState->activated = (b32)frameData.activated;
+  outInputState->released = (b32)frameData.released;
+  outInputState->mouseDeltaX = frameData.mouseDeltaX;
+  outInputState->mouseDeltaY = frameData.mouseDeltaY;
+  outInputState->quit = frameData.quit != 0;
+  updateKeyboardState(&outInputState->keys, *outInputEvents);
+  *outRecordedDeltaSeconds = frameData.deltaSeconds;
+  return true;
+}
+
+void initReplayTimings(ReplayTimings* timings, u32 capacity) {
+  timings->frameMs = new f32[capacity];
+  timings->recordedDeltaMs = new f32[capacity];
+  timings->count = 0;
+  timings->capacity = capacity;
+}
+
+void deinitReplayTimings(ReplayTimings* timings) {
+  delete[] timings->frameMs;
+  delete[] timings->recordedDeltaMs;
+  *timings = {}; // clear to zero
+}
+
+inline void addReplayTiming(ReplayTimings* timings, f64 frameSeconds, f64 recordedDeltaSeconds) {
+  if(timings->count == timings->capacity) { return; }
+  timings->frameMs[timings->count] = (f32)(frameSeconds * 1000.0);
+  timings->recordedDeltaMs[timings->count++] = (f32)(recordedDeltaSeconds * 1000.0);
+}
+
+// Writes frame,frame_ms,recorded_delta_ms rows next to the replay and prints a summary
+void saveReplayTimings(const ReplayTimings& timings, const char* replayFileName) {
+  if(timings.count == 0) { return; }
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  const u32 maxRowLength = 48;
+  char* csv = pushArray(tempMemory.arena, (timings.count + 1) * maxRowLength, char);
+  s32 length = sprintf(csv, "frame,frame_ms,recorded_delta_ms\n");
+  for(u32 i = 0; i < timings.count; ++i) {
+    length += snprintf(csv + length, maxRowLength, "%u,%.4f,%.4f\n", i, timings.frameMs[i], timings.recordedDeltaMs[i]);
+  }
+  char timingsFileName[512];
+  snprintf(timingsFileName, sizeof(timingsFileName), "%s.timings.csv", replayFileName);
+  writeFile(timingsFileName, csv, length);
+
+  f32* sortedMs = pushArray(tempMemory.arena, timings.count, f32);
+  memcpy(sortedMs, timings.frameMs, timings.count * sizeof(f32));
+  std::sort(sortedMs, sortedMs + timings.count);
+  f64 totalMs = 0.0;
+  for(u32 i = 0; i < timings.count; ++i) { totalMs += sortedMs[i]; }
+  auto percentile = [sortedMs, &timings](f64 p) { return sortedMs[Min((u32)(p * timings.count), timings.count - 1)]; };
+  printf("Replay of %s: %u frames in %.1f ms\n", replayFileName, timings.count, totalMs);
+  printf("  frame ms: mean %.3f | p50 %.3f | p95 %.3f | p99 %.3f | max %.3f\n",
+         totalMs / timings.count, percentile(0.5), percentile(0.95), percentile(0.99), sortedMs[timings.count - 1]);
+  printf("  per frame timings written to %s\n", timingsFileName);
+  endTempMemory(tempMemory);
+}
\ No newline at end of file
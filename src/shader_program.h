@@ -32,23 +32,23 @@ ShaderProgram createShaderProgram(const char* vertexPath, const char* fragmentPa
 }
 
 internal u32 loadShader(const char* shaderPath, GLenum shaderType) {
-  std::string shaderTypeStr;
+  const char* shaderTypeStr = "";
   if(shaderType == GL_VERTEX_SHADER) {
     shaderTypeStr = "VERTEX";
   } else if(shaderType == GL_FRAGMENT_SHADER){
     shaderTypeStr = "FRAGMENT";
   }
 
-  size_t shaderFileLength;
-  FILE_HANDLE file;
-  openFile(shaderPath, &file, &shaderFileLength);
-  const char* shaderCodeCStr = fileBytes(file);
+  AssetFile shaderFile;
+  openAsset(shaderPath, &shaderFile); // a missing file compiles as empty source and reports the failure below
+  const char* shaderCodeCStr = shaderFile.bytes != nullptr ? (const char*)shaderFile.bytes : "";
+  GLint shaderCodeLength = (GLint)shaderFile.size; // pack entries are not null terminated
 
   u32 shader = glCreateShader(shaderType);
-  glShaderSource(shader, 1, &shaderCodeCStr, nullptr);
+  glShaderSource(shader, 1, &shaderCodeCStr, &shaderCodeLength);
   glCompileShader(shader);
 
-  closeFile(file);
+  closeAsset(&shaderFile);
 
   s32 shaderSuccess;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &shaderSuccess);
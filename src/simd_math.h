@@ -0,0 +1,552 @@
+#pragma once
+
+// SIMD math
+// 16 byte aligned vector, quaternion and matrix types with glm's layout: matrices are column major and quaternions
+// are stored x, y, z, w, so converting to and from glm is a copy. Kernels use SSE, AVX for two matrices or vectors
+// at a time in the batched versions, or plain scalar code. Each does its arithmetic in the same order as glm does,
+// so results match glm bit for bit as long as the compiler does not contract multiplies and adds into FMAs.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATH_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_SIMD_WIDTH 4
+#else
+#define MATH_SIMD_WIDTH 1
+#endif
+
+struct alignas(16) Vec4 {
+  f32 x, y, z, w;
+};
+
+struct alignas(16) Quat {
+  f32 x, y, z, w;
+};
+
+struct alignas(16) Mat4 {
+  Vec4 columns[4];
+};
+
+static_assert(sizeof(Mat4) == sizeof(glm::mat4) && sizeof(Vec4) == sizeof(glm::vec4), "ERROR: Math types must match glm's layout!");
+
+inline Vec4 toVec4(const glm::vec4& v) { return Vec4{ v.x, v.y, v.z, v.w }; }
+inline Vec4 toVec4(const glm::vec3& v, f32 w) { return Vec4{ v.x, v.y, v.z, w }; }
+inline Quat toQuat(const glm::quat& q) { return Quat{ q.x, q.y, q.z, q.w }; }
+inline glm::vec4 toGlm(const Vec4& v) { return glm::vec4(v.x, v.y, v.z, v.w); }
+inline glm::quat toGlm(const Quat& q) { return glm::quat(q.w, q.x, q.y, q.z); }
+
+inline Mat4 toMat4(const glm::mat4& m) {
+  Mat4 result;
+  memcpy(&result, &m[0].x, sizeof(result));
+  return result;
+}
+
+inline glm::mat4 toGlm(const Mat4& m) {
+  glm::mat4 result;
+  memcpy(&result[0].x, &m, sizeof(result));
+  return result;
+}
+
+#if MATH_SIMD_WIDTH > 1
+#define MATH_SPLAT(v, lane) _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+
+internal inline __m128 loadVec4(const Vec4& v) { return _mm_load_ps(&v.x); }
+internal inline void storeVec4(Vec4* out, __m128 v) { _mm_store_ps(&out->x, v); }
+
+// glm sums mat * mat columns in order: ((a0 * b.x + a1 * b.y) + a2 * b.z) + a3 * b.w
+internal inline __m128 mulMat4Column(__m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 b) {
+  __m128 sum = _mm_mul_ps(a0, MATH_SPLAT(b, 0));
+  sum = _mm_add_ps(sum, _mm_mul_ps(a1, MATH_SPLAT(b, 1)));
+  sum = _mm_add_ps(sum, _mm_mul_ps(a2, MATH_SPLAT(b, 2)));
+  return _mm_add_ps(sum, _mm_mul_ps(a3, MATH_SPLAT(b, 3)));
+}
+
+// glm sums mat * vec in pairs: (m0 * v.x + m1 * v.y) + (m2 * v.z + m3 * v.w)
+internal inline __m128 mulMat4Vec4(__m128 m0, __m128 m1, __m128 m2, __m128 m3, __m128 v) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, MATH_SPLAT(v, 0)), _mm_mul_ps(m1, MATH_SPLAT(v, 1))),
+                    _mm_add_ps(_mm_mul_ps(m2, MATH_SPLAT(v, 2)), _mm_mul_ps(m3, MATH_SPLAT(v, 3))));
+}
+#endif
+
+#if MATH_SIMD_WIDTH == 8
+#define MATH_SPLAT8(v, lane) _mm256_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane))
+
+// a is broadcast to both halves, b holds two columns
+internal inline __m256 mulMat4Column2(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 b) {
+  __m256 sum = _mm256_mul_ps(a0, MATH_SPLAT8(b, 0));
+  sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, MATH_SPLAT8(b, 1)));
+  sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, MATH_SPLAT8(b, 2)));
+  return _mm256_add_ps(sum, _mm256_mul_ps(a3, MATH_SPLAT8(b, 3)));
+}
+
+internal inline void mulMat4Avx(__m256 a0, __m256 a1, __m256 a2, __m256 a3, const Mat4& b, Mat4* out) {
+  __m256 b01 = _mm256_loadu_ps(&b.columns[0].x);
+  __m256 b23 = _mm256_loadu_ps(&b.columns[2].x);
+  _mm256_storeu_ps(&out->columns[0].x, mulMat4Column2(a0, a1, a2, a3, b01));
+  _mm256_storeu_ps(&out->columns[2].x, mulMat4Column2(a0, a1, a2, a3, b23));
+}
+#endif
+
+Mat4 mulMat4(const Mat4& a, const Mat4& b) {
+  Mat4 result;
+#if MATH_SIMD_WIDTH > 1
+  __m128 a0 = loadVec4(a.columns[0]), a1 = loadVec4(a.columns[1]), a2 = loadVec4(a.columns[2]), a3 = loadVec4(a.columns[3]);
+  for(u32 column = 0; column < 4; ++column) {
+    storeVec4(result.columns + column, mulMat4Column(a0, a1, a2, a3, loadVec4(b.columns[column])));
+  }
+#else
+  const f32* aPtr = &a.columns[0].x;
+  for(u32 column = 0; column < 4; ++column) {
+    const Vec4& bColumn = b.columns[column];
+    f32* out = &result.columns[column].x;
+    for(u32 row = 0; row < 4; ++row) {
+      out[row] = aPtr[row] * bColumn.x + aPtr[4 + row] * bColumn.y + aPtr[8 + row] * bColumn.z + aPtr[12 + row] * bColumn.w;
+    }
+  }
+#endif
+  return result;
+}
+
+// out[i] = a * b[i], the usual projection view * model. out may alias b.
+void mulMat4Batch(const Mat4& a, const Mat4* b, Mat4* out, u32 count) {
+#if MATH_SIMD_WIDTH == 8
+  __m256 a0 = _mm256_broadcast_ps((const __m128*)&a.columns[0]), a1 = _mm256_broadcast_ps((const __m128*)&a.columns[1]);
+  __m256 a2 = _mm256_broadcast_ps((const __m128*)&a.columns[2]), a3 = _mm256_broadcast_ps((const __m128*)&a.columns[3]);
+  for(u32 i = 0; i < count; ++i) {
+    mulMat4Avx(a0, a1, a2, a3, b[i], out + i);
+  }
+#elif MATH_SIMD_WIDTH == 4
+  __m128 a0 = loadVec4(a.columns[0]), a1 = loadVec4(a.columns[1]), a2 = loadVec4(a.columns[2]), a3 = loadVec4(a.columns[3]);
+  for(u32 i = 0; i < count; ++i) {
+    __m128 b0 = loadVec4(b[i].columns[0]), b1 = loadVec4(b[i].columns[1]), b2 = loadVec4(b[i].columns[2]), b3 = loadVec4(b[i].columns[3]);
+    storeVec4(out[i].columns + 0, mulMat4Column(a0, a1, a2, a3, b0));
+    storeVec4(out[i].columns + 1, mulMat4Column(a0, a1, a2, a3, b1));
+    storeVec4(out[i].columns + 2, mulMat4Column(a0, a1, a2, a3, b2));
+    storeVec4(out[i].columns + 3, mulMat4Column(a0, a1, a2, a3, b3));
+  }
+#else
+  for(u32 i = 0; i < count; ++i) {
+    out[i] = mulMat4(a, b[i]);
+  }
+#endif
+}
+
+// out[i] = a[i] * b[i], e.g. parent world * child local. out may alias b.
+void mulMat4Batch(const Mat4* a, const Mat4* b, Mat4* out, u32 count) {
+#if MATH_SIMD_WIDTH == 8
+  for(u32 i = 0; i < count; ++i) {
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)&a[i].columns[0]), a1 = _mm256_broadcast_ps((const __m128*)&a[i].columns[1]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)&a[i].columns[2]), a3 = _mm256_broadcast_ps((const __m128*)&a[i].columns[3]);
+    mulMat4Avx(a0, a1, a2, a3, b[i], out + i);
+  }
+#else
+  for(u32 i = 0; i < count; ++i) {
+    out[i] = mulMat4(a[i], b[i]);
+  }
+#endif
+}
+
+Vec4 mulMat4Vec4(const Mat4& m, const Vec4& v) {
+  Vec4 result;
+#if MATH_SIMD_WIDTH > 1
+  storeVec4(&result, mulMat4Vec4(loadVec4(m.columns[0]), loadVec4(m.columns[1]), loadVec4(m.columns[2]), loadVec4(m.columns[3]), loadVec4(v)));
+#else
+  const f32* mPtr = &m.columns[0].x;
+  f32* out = &result.x;
+  for(u32 row = 0; row < 4; ++row) {
+    out[row] = (mPtr[row] * v.x + mPtr[4 + row] * v.y) + (mPtr[8 + row] * v.z + mPtr[12 + row] * v.w);
+  }
+#endif
+  return result;
+}
+
+// out[i] = m * v[i], out may alias v
+void mulMat4Vec4Batch(const Mat4& m, const Vec4* v, Vec4* out, u32 count) {
+  u32 i = 0;
+#if MATH_SIMD_WIDTH == 8
+  __m256 m0 = _mm256_broadcast_ps((const __m128*)&m.columns[0]), m1 = _mm256_broadcast_ps((const __m128*)&m.columns[1]);
+  __m256 m2 = _mm256_broadcast_ps((const __m128*)&m.columns[2]), m3 = _mm256_broadcast_ps((const __m128*)&m.columns[3]);
+  for(; i + 2 <= count; i += 2) {
+    __m256 v01 = _mm256_loadu_ps(&v[i].x);
+    __m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, MATH_SPLAT8(v01, 0)), _mm256_mul_ps(m1, MATH_SPLAT8(v01, 1))),
+                                  _mm256_add_ps(_mm256_mul_ps(m2, MATH_SPLAT8(v01, 2)), _mm256_mul_ps(m3, MATH_SPLAT8(v01, 3))));
+    _mm256_storeu_ps(&out[i].x, result);
+  }
+#endif
+#if MATH_SIMD_WIDTH > 1
+  __m128 c0 = loadVec4(m.columns[0]), c1 = loadVec4(m.columns[1]), c2 = loadVec4(m.columns[2]), c3 = loadVec4(m.columns[3]);
+  for(; i < count; ++i) {
+    storeVec4(out + i, mulMat4Vec4(c0, c1, c2, c3, loadVec4(v[i])));
+  }
+#else
+  for(; i < count; ++i) {
+    out[i] = mulMat4Vec4(m, v[i]);
+  }
+#endif
+}
+
+#if MATH_SIMD_WIDTH > 1
+// Lane-wise helpers so the inverse is written once for one matrix in an __m128 and two in an __m256
+internal inline __m128 mathAdd(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+internal inline __m128 mathSub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+internal inline __m128 mathMul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+internal inline __m128 mathDiv(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+template<s32 imm> internal inline __m128 mathShuffle(__m128 a, __m128 b) { return _mm_shuffle_ps(a, b, imm); }
+internal inline __m128 mathSet(f32 x, f32 y, f32 z, f32 w) { return _mm_setr_ps(x, y, z, w); }
+internal inline __m128 mathSet1(f32 x) { return _mm_set1_ps(x); }
+#if MATH_SIMD_WIDTH == 8
+internal inline __m256 mathAdd(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+internal inline __m256 mathSub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+internal inline __m256 mathMul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+internal inline __m256 mathDiv(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+template<s32 imm> internal inline __m256 mathShuffle(__m256 a, __m256 b) { return _mm256_shuffle_ps(a, b, imm); }
+#endif
+
+// (X, X, Y, Z) for rows p and q, the 2x2 determinants of glm's inverse:
+// X = m[2][p] * m[3][q] - m[3][p] * m[2][q], Y = m[1][p] * m[3][q] - m[3][p] * m[1][q], Z = m[1][p] * m[2][q] - m[2][p] * m[1][q]
+template<s32 p, s32 q, typename V>
+internal inline V inverseFactor(V col1, V col2, V col3) {
+  V a = mathShuffle<_MM_SHUFFLE(p, p, p, p)>(col2, col1);
+  V d = mathShuffle<_MM_SHUFFLE(q, q, q, q)>(col2, col1);
+  V b = mathShuffle<_MM_SHUFFLE(q, q, q, q)>(col3, col2);
+  V c = mathShuffle<_MM_SHUFFLE(p, p, p, p)>(col3, col2);
+  b = mathShuffle<_MM_SHUFFLE(2, 0, 0, 0)>(b, b);
+  c = mathShuffle<_MM_SHUFFLE(2, 0, 0, 0)>(c, c);
+  return mathSub(mathMul(a, b), mathMul(c, d));
+}
+
+// (m[1][r], m[0][r], m[0][r], m[0][r])
+template<s32 r, typename V>
+internal inline V inverseVec(V col0, V col1) {
+  V t = mathShuffle<_MM_SHUFFLE(r, r, r, r)>(col1, col0);
+  return mathShuffle<_MM_SHUFFLE(2, 2, 2, 0)>(t, t);
+}
+
+// glm's inverse, step for step, on the columns of one or two matrices
+template<typename V>
+internal inline void inverseColumns(V* cols, V signA, V signB, V one) {
+  V fac0 = inverseFactor<2, 3>(cols[1], cols[2], cols[3]);
+  V fac1 = inverseFactor<1, 3>(cols[1], cols[2], cols[3]);
+  V fac2 = inverseFactor<1, 2>(cols[1], cols[2], cols[3]);
+  V fac3 = inverseFactor<0, 3>(cols[1], cols[2], cols[3]);
+  V fac4 = inverseFactor<0, 2>(cols[1], cols[2], cols[3]);
+  V fac5 = inverseFactor<0, 1>(cols[1], cols[2], cols[3]);
+  V vec0 = inverseVec<0>(cols[0], cols[1]);
+  V vec1 = inverseVec<1>(cols[0], cols[1]);
+  V vec2 = inverseVec<2>(cols[0], cols[1]);
+  V vec3 = inverseVec<3>(cols[0], cols[1]);
+
+  V inv0 = mathMul(mathAdd(mathSub(mathMul(vec1, fac0), mathMul(vec2, fac1)), mathMul(vec3, fac2)), signA);
+  V inv1 = mathMul(mathAdd(mathSub(mathMul(vec0, fac0), mathMul(vec2, fac3)), mathMul(vec3, fac4)), signB);
+  V inv2 = mathMul(mathAdd(mathSub(mathMul(vec0, fac1), mathMul(vec1, fac3)), mathMul(vec3, fac5)), signA);
+  V inv3 = mathMul(mathAdd(mathSub(mathMul(vec0, fac2), mathMul(vec1, fac4)), mathMul(vec2, fac5)), signB);
+
+  // determinant = (d.x + d.y) + (d.z + d.w), d = m[0] * (inv0.x, inv1.x, inv2.x, inv3.x)
+  V row0 = mathShuffle<_MM_SHUFFLE(2, 0, 2, 0)>(mathShuffle<0>(inv0, inv1), mathShuffle<0>(inv2, inv3));
+  V dot = mathMul(cols[0], row0);
+  dot = mathAdd(dot, mathShuffle<_MM_SHUFFLE(2, 3, 0, 1)>(dot, dot));
+  dot = mathAdd(dot, mathShuffle<_MM_SHUFFLE(1, 0, 3, 2)>(dot, dot));
+  V oneOverDeterminant = mathDiv(one, dot);
+
+  cols[0] = mathMul(inv0, oneOverDeterminant);
+  cols[1] = mathMul(inv1, oneOverDeterminant);
+  cols[2] = mathMul(inv2, oneOverDeterminant);
+  cols[3] = mathMul(inv3, oneOverDeterminant);
+}
+
+template<typename V>
+internal inline void transposeColumns(V* cols) {
+  V t0 = mathShuffle<_MM_SHUFFLE(1, 0, 1, 0)>(cols[0], cols[1]); // 00 01 10 11
+  V t1 = mathShuffle<_MM_SHUFFLE(3, 2, 3, 2)>(cols[0], cols[1]); // 02 03 12 13
+  V t2 = mathShuffle<_MM_SHUFFLE(1, 0, 1, 0)>(cols[2], cols[3]); // 20 21 30 31
+  V t3 = mathShuffle<_MM_SHUFFLE(3, 2, 3, 2)>(cols[2], cols[3]); // 22 23 32 33
+  cols[0] = mathShuffle<_MM_SHUFFLE(2, 0, 2, 0)>(t0, t2);
+  cols[1] = mathShuffle<_MM_SHUFFLE(3, 1, 3, 1)>(t0, t2);
+  cols[2] = mathShuffle<_MM_SHUFFLE(2, 0, 2, 0)>(t1, t3);
+  cols[3] = mathShuffle<_MM_SHUFFLE(3, 1, 3, 1)>(t1, t3);
+}
+#else
+internal void inverseMat4Scalar(const Mat4& mat, Mat4* out) {
+  auto m = [&mat](u32 column, u32 row) { return (&mat.columns[column].x)[row]; };
+  f32 fac[6][4];
+  const u32 factorRows[6][2] = { {2, 3}, {1, 3}, {1, 2}, {0, 3}, {0, 2}, {0, 1} };
+  for(u32 i = 0; i < 6; ++i) {
+    u32 p = factorRows[i][0], q = factorRows[i][1];
+    fac[i][0] = fac[i][1] = m(2, p) * m(3, q) - m(3, p) * m(2, q);
+    fac[i][2] = m(1, p) * m(3, q) - m(3, p) * m(1, q);
+    fac[i][3] = m(1, p) * m(2, q) - m(2, p) * m(1, q);
+  }
+  f32 vec[4][4];
+  for(u32 r = 0; r < 4; ++r) {
+    vec[r][0] = m(1, r);
+    vec[r][1] = vec[r][2] = vec[r][3] = m(0, r);
+  }
+  const u32 terms[4][6] = { {1, 0, 2, 1, 3, 2}, {0, 0, 2, 3, 3, 4}, {0, 1, 1, 3, 3, 5}, {0, 2, 1, 4, 2, 5} }; // vec, fac pairs
+  f32 inv[4][4];
+  for(u32 column = 0; column < 4; ++column) {
+    const u32* t = terms[column];
+    for(u32 lane = 0; lane < 4; ++lane) {
+      f32 sign = ((column + lane) % 2 == 0) ? 1.0f : -1.0f;
+      inv[column][lane] = ((vec[t[0]][lane] * fac[t[1]][lane] - vec[t[2]][lane] * fac[t[3]][lane]) + vec[t[4]][lane] * fac[t[5]][lane]) * sign;
+    }
+  }
+  f32 determinant = (m(0, 0) * inv[0][0] + m(0, 1) * inv[1][0]) + (m(0, 2) * inv[2][0] + m(0, 3) * inv[3][0]);
+  f32 oneOverDeterminant = 1.0f / determinant;
+  for(u32 column = 0; column < 4; ++column) {
+    for(u32 lane = 0; lane < 4; ++lane) {
+      (&out->columns[column].x)[lane] = inv[column][lane] * oneOverDeterminant;
+    }
+  }
+}
+#endif
+
+Mat4 inverseMat4(const Mat4& m) {
+  Mat4 result;
+#if MATH_SIMD_WIDTH > 1
+  __m128 cols[4] = { loadVec4(m.columns[0]), loadVec4(m.columns[1]), loadVec4(m.columns[2]), loadVec4(m.columns[3]) };
+  inverseColumns(cols, mathSet(1.0f, -1.0f, 1.0f, -1.0f), mathSet(-1.0f, 1.0f, -1.0f, 1.0f), mathSet1(1.0f));
+  for(u32 i = 0; i < 4; ++i) { storeVec4(result.columns + i, cols[i]); }
+#else
+  inverseMat4Scalar(m, &result);
+#endif
+  return result;
+}
+
+// transpose(inverse(m)), turns model matrices into normal matrices
+Mat4 inverseTransposeMat4(const Mat4& m) {
+  Mat4 result;
+#if MATH_SIMD_WIDTH > 1
+  __m128 cols[4] = { loadVec4(m.columns[0]), loadVec4(m.columns[1]), loadVec4(m.columns[2]), loadVec4(m.columns[3]) };
+  inverseColumns(cols, mathSet(1.0f, -1.0f, 1.0f, -1.0f), mathSet(-1.0f, 1.0f, -1.0f, 1.0f), mathSet1(1.0f));
+  transposeColumns(cols);
+  for(u32 i = 0; i < 4; ++i) { storeVec4(result.columns + i, cols[i]); }
+#else
+  Mat4 inverse;
+  inverseMat4Scalar(m, &inverse);
+  for(u32 column = 0; column < 4; ++column) {
+    for(u32 row = 0; row < 4; ++row) {
+      (&result.columns[column].x)[row] = (&inverse.columns[row].x)[column];
+    }
+  }
+#endif
+  return result;
+}
+
+// out may alias m
+void inverseTransposeMat4Batch(const Mat4* m, Mat4* out, u32 count) {
+  u32 i = 0;
+#if MATH_SIMD_WIDTH == 8
+  // one matrix per 128 bit half
+  const __m256 signA = _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+  const __m256 signB = _mm256_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  for(; i + 2 <= count; i += 2) {
+    __m256 cols[4];
+    for(u32 c = 0; c < 4; ++c) {
+      cols[c] = _mm256_insertf128_ps(_mm256_castps128_ps256(loadVec4(m[i].columns[c])), loadVec4(m[i + 1].columns[c]), 1);
+    }
+    inverseColumns(cols, signA, signB, one);
+    transposeColumns(cols);
+    for(u32 c = 0; c < 4; ++c) {
+      storeVec4(out[i].columns + c, _mm256_castps256_ps128(cols[c]));
+      storeVec4(out[i + 1].columns + c, _mm256_extractf128_ps(cols[c], 1));
+    }
+  }
+#endif
+  for(; i < count; ++i) {
+    out[i] = inverseTransposeMat4(m[i]);
+  }
+}
+
+// View matrix of a camera at eye looking down forward, with right/up/forward as the x/y/z axes.
+// right, up and forward must be orthonormal, w of every argument is ignored.
+Mat4 viewMat4(const Vec4& eye, const Vec4& right, const Vec4& up, const Vec4& forward) {
+  Mat4 result;
+#if MATH_SIMD_WIDTH > 1
+  const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  __m128 e = loadVec4(eye);
+  __m128 axes[4] = { _mm_and_ps(loadVec4(right), xyzMask), _mm_and_ps(loadVec4(up), xyzMask), _mm_and_ps(loadVec4(forward), xyzMask), _mm_setzero_ps() };
+  // -dot(axis, eye) with glm's (x + y) + z
+  __m128 negatedDots[3];
+  for(u32 i = 0; i < 3; ++i) {
+    __m128 products = _mm_mul_ps(axes[i], e);
+    __m128 dot = _mm_add_ss(_mm_add_ss(products, MATH_SPLAT(products, 1)), MATH_SPLAT(products, 2));
+    negatedDots[i] = _mm_xor_ps(dot, _mm_set_ss(-0.0f));
+  }
+  transposeColumns(axes);
+  storeVec4(result.columns + 0, axes[0]);
+  storeVec4(result.columns + 1, axes[1]);
+  storeVec4(result.columns + 2, axes[2]);
+  __m128 translation = _mm_movelh_ps(_mm_unpacklo_ps(negatedDots[0], negatedDots[1]), _mm_unpacklo_ps(negatedDots[2], _mm_set_ss(1.0f)));
+  storeVec4(result.columns + 3, translation);
+#else
+  result.columns[0] = Vec4{ right.x, up.x, forward.x, 0.0f };
+  result.columns[1] = Vec4{ right.y, up.y, forward.y, 0.0f };
+  result.columns[2] = Vec4{ right.z, up.z, forward.z, 0.0f };
+  result.columns[3] = Vec4{ -(right.x * eye.x + right.y * eye.y + right.z * eye.z),
+                            -(up.x * eye.x + up.y * eye.y + up.z * eye.z),
+                            -(forward.x * eye.x + forward.y * eye.y + forward.z * eye.z), 1.0f };
+#endif
+  return result;
+}
+
+// Left handed like glm::lookAt with GLM_FORCE_LEFT_HANDED, w of every argument is ignored
+Mat4 lookAtMat4(const Vec4& eye, const Vec4& center, const Vec4& up) {
+#if MATH_SIMD_WIDTH > 1
+  const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  auto normalize = [](__m128 v) { // v * (1 / sqrt(dot(v, v)))
+    __m128 squares = _mm_mul_ps(v, v);
+    __m128 dot = _mm_add_ss(_mm_add_ss(squares, MATH_SPLAT(squares, 1)), MATH_SPLAT(squares, 2));
+    __m128 inverseLength = _mm_div_ss(_mm_set_ss(1.0f), _mm_sqrt_ss(dot));
+    return _mm_mul_ps(v, MATH_SPLAT(inverseLength, 0));
+  };
+  auto cross = [](__m128 a, __m128 b) { // a.yzx * b.zxy - b.yzx * a.zxy
+    __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1)), bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+    return _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(bYZX, aZXY));
+  };
+  __m128 e = _mm_and_ps(loadVec4(eye), xyzMask);
+  __m128 f = normalize(_mm_sub_ps(_mm_and_ps(loadVec4(center), xyzMask), e));
+  __m128 s = normalize(cross(_mm_and_ps(loadVec4(up), xyzMask), f));
+  __m128 u = cross(f, s);
+  Vec4 right, newUp, forward;
+  storeVec4(&right, s);
+  storeVec4(&newUp, u);
+  storeVec4(&forward, f);
+  return viewMat4(eye, right, newUp, forward);
+#else
+  auto normalize = [](Vec4 v) {
+    f32 inverseLength = 1.0f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    return Vec4{ v.x * inverseLength, v.y * inverseLength, v.z * inverseLength, 0.0f };
+  };
+  auto cross = [](const Vec4& a, const Vec4& b) {
+    return Vec4{ a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y, 0.0f };
+  };
+  Vec4 f = normalize(Vec4{ center.x - eye.x, center.y - eye.y, center.z - eye.z, 0.0f });
+  Vec4 s = normalize(cross(up, f));
+  Vec4 u = cross(f, s);
+  return viewMat4(eye, s, u, f);
+#endif
+}
+
+// p * q, same order as glm::quat's operator*
+Quat mulQuat(const Quat& p, const Quat& q) {
+  return Quat{ p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+               p.w * q.y + p.y * q.w + p.z * q.x - p.x * q.z,
+               p.w * q.z + p.z * q.w + p.x * q.y - p.y * q.x,
+               p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z };
+}
+
+// Rotation matrix of a unit quaternion, same as glm::mat4_cast
+Mat4 quatToMat4(const Quat& q) {
+  f32 xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  f32 xz = q.x * q.z, xy = q.x * q.y, yz = q.y * q.z;
+  f32 wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  Mat4 result;
+  result.columns[0] = Vec4{ 1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f };
+  result.columns[1] = Vec4{ 2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f };
+  result.columns[2] = Vec4{ 2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f };
+  result.columns[3] = Vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+  return result;
+}
+
+// Times every batched kernel against glm on the same inputs and counts the results that differ from glm's in any bit.
+// Results are printed to stdout.
+void benchmarkSimdMath() {
+  const u32 count = 4096;
+  const u32 repetitions = 200;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  u32 randomState = 0x2545F491u;
+  auto randomFloat = [&randomState](f32 low, f32 high) { // xorshift32
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return low + ((high - low) * (f32)(randomState >> 8) / (f32)(1u << 24));
+  };
+  auto timeMs = [repetitions, secondsPerCounter](auto&& run) {
+    u64 startCounter = getPerformanceCounter();
+    for(u32 repetition = 0; repetition < repetitions; ++repetition) { run(); }
+    return (getPerformanceCounter() - startCounter) * secondsPerCounter * 1000.0 / repetitions;
+  };
+  auto countDiffering = [count](const void* glmResults, const void* simdResults, size_t resultSize) {
+    u32 differing = 0;
+    for(u32 i = 0; i < count; ++i) {
+      differing += memcmp((const u8*)glmResults + (i * resultSize), (const u8*)simdResults + (i * resultSize), resultSize) != 0;
+    }
+    return differing;
+  };
+  auto report = [count](const char* name, f64 glmMs, f64 simdMs, u32 differing) {
+    printf("  %-20s glm %7.4f ms | simd %7.4f ms (%5.2fx) | %u/%u differ from glm\n", name, glmMs, simdMs, glmMs / simdMs, differing, count);
+  };
+
+  glm::mat4* glmModels = new glm::mat4[count];
+  glm::mat4* glmLocals = new glm::mat4[count];
+  glm::vec4* glmPoints = new glm::vec4[count];
+  glm::vec3* eyes = new glm::vec3[count];
+  glm::vec3* centers = new glm::vec3[count];
+  glm::mat4* glmMats = new glm::mat4[count];
+  glm::vec4* glmVecs = new glm::vec4[count];
+  Mat4* models = new Mat4[count];
+  Mat4* locals = new Mat4[count];
+  Vec4* points = new Vec4[count];
+  Mat4* mats = new Mat4[count];
+  Vec4* vecs = new Vec4[count];
+  for(u32 i = 0; i < count; ++i) {
+    glm::vec3 axis = glm::normalize(glm::vec3(randomFloat(-1.0f, 1.0f), randomFloat(0.1f, 1.0f), randomFloat(-1.0f, 1.0f)));
+    glm::vec3 translation(randomFloat(-100.0f, 100.0f), randomFloat(-100.0f, 100.0f), randomFloat(-100.0f, 100.0f));
+    glm::vec3 scale(randomFloat(0.5f, 2.0f), randomFloat(0.5f, 2.0f), randomFloat(0.5f, 2.0f));
+    glmModels[i] = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), translation), randomFloat(0.0f, Tau32), axis), scale);
+    glmLocals[i] = glm::rotate(glm::translate(glm::mat4(1.0f), translation * 0.01f), randomFloat(0.0f, Tau32), axis);
+    glmPoints[i] = glm::vec4(randomFloat(-10.0f, 10.0f), randomFloat(-10.0f, 10.0f), randomFloat(-10.0f, 10.0f), 1.0f);
+    eyes[i] = translation;
+    centers[i] = translation + glm::vec3(randomFloat(-1.0f, 1.0f), randomFloat(-0.5f, 0.5f), randomFloat(-1.0f, 1.0f));
+    models[i] = toMat4(glmModels[i]);
+    locals[i] = toMat4(glmLocals[i]);
+    points[i] = toVec4(glmPoints[i]);
+  }
+  glm::mat4 glmView = glm::lookAt(glm::vec3(0.0f, 5.0f, -20.0f), glm::vec3(0.0f), worldUp);
+  Mat4 view = toMat4(glmView);
+
+  printf("SIMD math: %u inputs, %u repetitions, %u floats per register%s\n", count, repetitions, MATH_SIMD_WIDTH,
+#if defined(__FMA__)
+         ", FMA contraction may make results differ from glm");
+#else
+         "");
+#endif
+
+  f64 glmMs = timeMs([&] { for(u32 i = 0; i < count; ++i) { glmMats[i] = glmView * glmModels[i]; } });
+  f64 simdMs = timeMs([&] { mulMat4Batch(view, models, mats, count); });
+  report("view * model", glmMs, simdMs, countDiffering(glmMats, mats, sizeof(Mat4)));
+
+  glmMs = timeMs([&] { for(u32 i = 0; i < count; ++i) { glmMats[i] = glmModels[i] * glmLocals[i]; } });
+  simdMs = timeMs([&] { mulMat4Batch(models, locals, mats, count); });
+  report("parent * local", glmMs, simdMs, countDiffering(glmMats, mats, sizeof(Mat4)));
+
+  glmMs = timeMs([&] { for(u32 i = 0; i < count; ++i) { glmVecs[i] = glmView * glmPoints[i]; } });
+  simdMs = timeMs([&] { mulMat4Vec4Batch(view, points, vecs, count); });
+  report("mat4 * vec4", glmMs, simdMs, countDiffering(glmVecs, vecs, sizeof(Vec4)));
+
+  glmMs = timeMs([&] { for(u32 i = 0; i < count; ++i) { glmMats[i] = glm::transpose(glm::inverse(glmModels[i])); } });
+  simdMs = timeMs([&] { inverseTransposeMat4Batch(models, mats, count); });
+  report("inverse transpose", glmMs, simdMs, countDiffering(glmMats, mats, sizeof(Mat4)));
+
+  glmMs = timeMs([&] { for(u32 i = 0; i < count; ++i) { glmMats[i] = glm::lookAt(eyes[i], centers[i], worldUp); } });
+  simdMs = timeMs([&] {
+    for(u32 i = 0; i < count; ++i) { mats[i] = lookAtMat4(toVec4(eyes[i], 1.0f), toVec4(centers[i], 1.0f), toVec4(worldUp, 0.0f)); }
+  });
+  report("look at", glmMs, simdMs, countDiffering(glmMats, mats, sizeof(Mat4)));
+
+  delete[] glmModels;
+  delete[] glmLocals;
+  delete[] glmPoints;
+  delete[] eyes;
+  delete[] centers;
+  delete[] glmMats;
+  delete[] glmVecs;
+  delete[] models;
+  delete[] locals;
+  delete[] points;
+  delete[] mats;
+  delete[] vecs;
+}
\ No newline at end of file
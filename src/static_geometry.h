@@ -0,0 +1,443 @@
+#pragma once
+
+// Static geometry pool
+// All static meshes share one VAO with one large vertex buffer and one large index buffer in a
+// common vertex format. Meshes are sub-allocated ranges of those buffers. Draws are recorded into a
+// StaticDrawList each frame, which can be filled on any thread and flushed later on the thread that owns
+// the GL context. Flushing buckets them by albedo texture and issues one glMultiDrawElementsIndirect per bucket.
+// Each draw's model matrix is an instanced vertex attribute selected through the command's baseInstance.
+// Contexts without multi-draw indirect (GL 4.3) issue the commands one at a time. Without base instance
+// (GL 4.2) the model matrix attribute is left disabled and its constant value is set before each draw.
+
+#define STATIC_GEOMETRY_POSITION_ATTRIBUTE_INDEX 0
+#define STATIC_GEOMETRY_NORMAL_ATTRIBUTE_INDEX 1
+#define STATIC_GEOMETRY_TEXTURE0_ATTRIBUTE_INDEX 2
+#define STATIC_GEOMETRY_MODEL_MAT_ATTRIBUTE_INDEX 3 // mat4 occupies indices 3-6
+
+// Layout defined by the GL spec for indirect indexed draws
+struct DrawElementsIndirectCommand {
+  u32 count;
+  u32 instanceCount;
+  u32 firstIndex;
+  s32 baseVertex;
+  u32 baseInstance;
+};
+
+struct StaticDraw {
+  StaticMeshRange range;
+  GLuint albedoTextureId;
+  glm::mat4 modelMat;
+};
+
+struct StaticGeometryStats {
+  u32 drawCount;
+  u32 bucketCount;
+  u32 glDrawCallCount;
+  u32 triangleCount;
+};
+
+struct StaticGeometryPool {
+  GLuint arrayObject;
+  GLuint vertexBufferObject;
+  GLuint indexBufferObject;
+  GLuint instanceBufferObject; // per draw model matrices
+  GLuint commandBufferObject;
+
+  u32 vertexCapacity;
+  u32 vertexCount;
+  u32 indexCapacity;
+  u32 indexCount;
+
+  u32 drawCapacity;
+  DrawElementsIndirectCommand* commands;
+  glm::mat4* modelMats;
+
+  b32 multiDrawIndirectAvailable;
+  b32 baseInstanceAvailable;
+};
+
+struct StaticDrawList {
+  StaticDraw* draws;
+  u32 count;
+  u32 capacity;
+};
+
+struct StaticMesh {
+  StaticMeshRange lods[LOD_MAX_COUNT]; // all LODs share the vertices of LOD 0
+  u32 lodCount;
+  GLuint albedoTextureId;
+  glm::vec4 baseColor;
+  Box boundingBox;
+};
+
+// One StaticMesh per glTF primitive
+struct StaticModel {
+  StaticMesh* meshes;
+  u32 meshCount;
+  GLuint* textureIds; // indexed by glTF image, TEXTURE_ID_NO_TEXTURE for images no mesh uses, shared by the meshes
+  u32 textureCount;
+  Box boundingBox;
+  const char* fileName;
+};
+
+void initStaticGeometryPool(StaticGeometryPool* pool, u32 vertexCapacity, u32 indexCapacity, u32 drawCapacity) {
+  *pool = {};
+  pool->vertexCapacity = vertexCapacity;
+  pool->indexCapacity = indexCapacity;
+  pool->drawCapacity = drawCapacity;
+  pool->commands = new DrawElementsIndirectCommand[drawCapacity];
+  pool->modelMats = new glm::mat4[drawCapacity];
+  pool->multiDrawIndirectAvailable = glMultiDrawElementsIndirect != nullptr;
+  pool->baseInstanceAvailable = glDrawElementsInstancedBaseVertexBaseInstance != nullptr;
+
+  glGenVertexArrays(1, &pool->arrayObject);
+  glGenBuffers(1, &pool->vertexBufferObject);
+  glGenBuffers(1, &pool->indexBufferObject);
+  glGenBuffers(1, &pool->instanceBufferObject);
+  glGenBuffers(1, &pool->commandBufferObject);
+
+  glBindVertexArray(pool->arrayObject);
+
+  glBindBuffer(GL_ARRAY_BUFFER, pool->vertexBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(StaticVertex), nullptr, GL_STATIC_DRAW);
+  glVertexAttribPointer(STATIC_GEOMETRY_POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, position));
+  glEnableVertexAttribArray(STATIC_GEOMETRY_POSITION_ATTRIBUTE_INDEX);
+  glVertexAttribPointer(STATIC_GEOMETRY_NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, normal));
+  glEnableVertexAttribArray(STATIC_GEOMETRY_NORMAL_ATTRIBUTE_INDEX);
+  glVertexAttribPointer(STATIC_GEOMETRY_TEXTURE0_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, texCoord));
+  glEnableVertexAttribArray(STATIC_GEOMETRY_TEXTURE0_ATTRIBUTE_INDEX);
+
+  // model matrix as four vec4 attributes that advance once per instance
+  glBindBuffer(GL_ARRAY_BUFFER, pool->instanceBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, drawCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+  for(u32 column = 0; column < 4 && pool->baseInstanceAvailable; ++column) {
+    u32 attributeIndex = STATIC_GEOMETRY_MODEL_MAT_ATTRIBUTE_INDEX + column;
+    glVertexAttribPointer(attributeIndex, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(attributeIndex);
+    glVertexAttribDivisor(attributeIndex, 1);
+  }
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->indexBufferObject);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * sizeof(u32), nullptr, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  // Must unbind EBO AFTER unbinding VAO, since VAO stores all glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _) calls
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, pool->commandBufferObject);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void deinitStaticGeometryPool(StaticGeometryPool* pool) {
+  GLuint buffers[] = { pool->vertexBufferObject, pool->indexBufferObject, pool->instanceBufferObject, pool->commandBufferObject };
+  glDeleteBuffers(ArrayCount(buffers), buffers);
+  glDeleteVertexArrays(1, &pool->arrayObject);
+  delete[] pool->commands;
+  delete[] pool->modelMats;
+  *pool = {}; // clear to zero
+}
+
+// Indices are relative to the first vertex of the mesh
+StaticMeshRange addStaticMesh(StaticGeometryPool* pool, const StaticVertex* vertices, u32 vertexCount, const u32* indices, u32 indexCount) {
+  assert(pool->vertexCount + vertexCount <= pool->vertexCapacity && "ERROR: Static geometry pool is out of vertex space!");
+  assert(pool->indexCount + indexCount <= pool->indexCapacity && "ERROR: Static geometry pool is out of index space!");
+
+  StaticMeshRange range;
+  range.firstIndex = pool->indexCount;
+  range.indexCount = indexCount;
+  range.baseVertex = (s32)pool->vertexCount;
+  range.vertexCount = vertexCount;
+
+  glBindBuffer(GL_ARRAY_BUFFER, pool->vertexBufferObject);
+  glBufferSubData(GL_ARRAY_BUFFER, pool->vertexCount * sizeof(StaticVertex), vertexCount * sizeof(StaticVertex), vertices);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // VAO does not need to be bound, GL_ELEMENT_ARRAY_BUFFER is only used as a copy target here
+  glBindVertexArray(0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->indexBufferObject);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, pool->indexCount * sizeof(u32), indexCount * sizeof(u32), indices);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  pool->vertexCount += vertexCount;
+  pool->indexCount += indexCount;
+  return range;
+}
+
+// Adds indices for a mesh whose vertices were already added with addStaticMesh()
+StaticMeshRange addStaticMeshIndices(StaticGeometryPool* pool, const StaticMeshRange& vertexRange, const u32* indices, u32 indexCount) {
+  assert(pool->indexCount + indexCount <= pool->indexCapacity && "ERROR: Static geometry pool is out of index space!");
+
+  StaticMeshRange range = vertexRange;
+  range.firstIndex = pool->indexCount;
+  range.indexCount = indexCount;
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->indexBufferObject);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, pool->indexCount * sizeof(u32), indexCount * sizeof(u32), indices);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  pool->indexCount += indexCount;
+  return range;
+}
+
+// Adds the mesh followed by up to maxLODCount - 1 progressively simplified versions of it.
+// Stops early once simplification stops paying off. Returns the number of LODs written to outLODs.
+u32 addStaticMeshWithLODs(StaticGeometryPool* pool, const StaticVertex* vertices, u32 vertexCount, const u32* indices, u32 indexCount,
+                          u32 maxLODCount, StaticMeshRange* outLODs) {
+  assert(maxLODCount > 0 && maxLODCount <= LOD_MAX_COUNT);
+  outLODs[0] = addStaticMesh(pool, vertices, vertexCount, indices, indexCount);
+  if(maxLODCount == 1) { return 1; }
+
+  glm::vec3 boundsMin = vertices[0].position, boundsMax = vertices[0].position;
+  for(u32 i = 1; i < vertexCount; ++i) {
+    boundsMin = glm::min(boundsMin, vertices[i].position);
+    boundsMax = glm::max(boundsMax, vertices[i].position);
+  }
+  f32 meshSize = length(boundsMax - boundsMin);
+
+  // each LOD is simplified from the previous one
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* lodIndices[2] = { pushArray(tempMemory.arena, indexCount, u32), pushArray(tempMemory.arena, indexCount, u32) };
+  const u32* sourceIndices = indices;
+  u32 sourceIndexCount = indexCount;
+  u32 lodCount = 1;
+  for(; lodCount < maxLODCount; ++lodCount) {
+    u32 targetIndexCount = (sourceIndexCount / 6) * 3; // half the triangles
+    u32* simplified = lodIndices[lodCount % 2];
+    u32 simplifiedCount = simplifyMesh(vertices, vertexCount, sourceIndices, sourceIndexCount,
+                                       targetIndexCount, LOD_ERROR_PER_LEVEL * lodCount * meshSize, simplified);
+    if(simplifiedCount == 0 || simplifiedCount > (sourceIndexCount * 4) / 5) { break; }
+    optimizeTriangleOrder(simplified, simplifiedCount, vertexCount, (const f32*)vertices + (offsetof(StaticVertex, position) / sizeof(f32)), sizeof(StaticVertex) / sizeof(f32));
+    outLODs[lodCount] = addStaticMeshIndices(pool, outLODs[0], simplified, simplifiedCount);
+    sourceIndices = simplified;
+    sourceIndexCount = simplifiedCount;
+  }
+
+  endTempMemory(tempMemory);
+  return lodCount;
+}
+
+void addModelToStaticGeometryPool(StaticGeometryPool* pool, const char* filePath, StaticModel* returnModel, u32 maxLODCount = 1) {
+  tinygltf::Model gltfModel;
+  if(!loadGLTF(filePath, &gltfModel)) {
+    return;
+  }
+
+  returnModel->fileName = filePath;
+  returnModel->meshCount = 0;
+  for(const tinygltf::Mesh& gltfMesh : gltfModel.meshes) {
+    returnModel->meshCount += (u32)gltfMesh.primitives.size();
+  }
+  assert(returnModel->meshCount != 0);
+  returnModel->meshes = pushArray(&permanentArena, returnModel->meshCount, StaticMesh);
+  returnModel->textureCount = (u32)gltfModel.images.size();
+  returnModel->textureIds = pushArray(&permanentArena, returnModel->textureCount, GLuint);
+  for(u32 i = 0; i < returnModel->textureCount; ++i) { returnModel->textureIds[i] = TEXTURE_ID_NO_TEXTURE; }
+
+  u32 meshIndex = 0;
+  for(const tinygltf::Mesh& gltfMesh : gltfModel.meshes) {
+    for(const tinygltf::Primitive& gltfPrimitive : gltfMesh.primitives) {
+      StaticMesh* mesh = &returnModel->meshes[meshIndex];
+      assert(gltfPrimitive.mode == TINYGLTF_MODE_TRIANGLES && "ERROR: Static geometry only supports triangle primitives!");
+
+      auto positionIter = gltfPrimitive.attributes.find("POSITION");
+      assert(positionIter != gltfPrimitive.attributes.end());
+      const tinygltf::Accessor& positionAccessor = gltfModel.accessors[positionIter->second];
+      u32 vertexCount = (u32)positionAccessor.count;
+      mesh->boundingBox = boxFromMinMax(glm::vec3{(f32)positionAccessor.minValues[0], (f32)positionAccessor.minValues[1], (f32)positionAccessor.minValues[2]},
+                                        glm::vec3{(f32)positionAccessor.maxValues[0], (f32)positionAccessor.maxValues[1], (f32)positionAccessor.maxValues[2]});
+      returnModel->boundingBox = (meshIndex == 0) ? mesh->boundingBox : mergeBoxes(returnModel->boundingBox, mesh->boundingBox);
+
+      TempMemory tempMemory = beginTempMemory(threadTempArena());
+      StaticVertex* vertices = pushArrayZero(tempMemory.arena, vertexCount, StaticVertex);
+      const u32 vertexStrideInFloats = sizeof(StaticVertex) / sizeof(f32);
+      copyGLTFAccessorFloats(gltfModel, positionIter->second, 3, (f32*)vertices + offsetof(StaticVertex, position) / sizeof(f32), vertexStrideInFloats);
+      auto normalIter = gltfPrimitive.attributes.find("NORMAL");
+      if(normalIter != gltfPrimitive.attributes.end()) {
+        copyGLTFAccessorFloats(gltfModel, normalIter->second, 3, (f32*)vertices + offsetof(StaticVertex, normal) / sizeof(f32), vertexStrideInFloats);
+      }
+      auto texture0Iter = gltfPrimitive.attributes.find("TEXCOORD_0");
+      if(texture0Iter != gltfPrimitive.attributes.end()) {
+        copyGLTFAccessorFloats(gltfModel, texture0Iter->second, 2, (f32*)vertices + offsetof(StaticVertex, texCoord) / sizeof(f32), vertexStrideInFloats);
+      }
+
+      // primitives without indices draw their vertices in order
+      u32 indexCount = gltfPrimitive.indices > -1 ? (u32)gltfModel.accessors[gltfPrimitive.indices].count : vertexCount;
+      u32* indices = pushArray(tempMemory.arena, indexCount, u32);
+      if(gltfPrimitive.indices > -1) {
+        copyGLTFAccessorIndices(gltfModel, gltfPrimitive.indices, indices);
+      } else {
+        for(u32 i = 0; i < indexCount; ++i) { indices[i] = i; }
+      }
+
+      VertexCacheStats cacheStatsBefore = analyzeVertexCache(indices, indexCount, vertexCount);
+      vertexCount = optimizeStaticMesh(vertices, vertexCount, indices, indexCount);
+      printVertexCacheStats(filePath, meshIndex, cacheStatsBefore, analyzeVertexCache(indices, indexCount, vertexCount));
+
+      mesh->lodCount = addStaticMeshWithLODs(pool, vertices, vertexCount, indices, indexCount, maxLODCount, mesh->lods);
+      endTempMemory(tempMemory);
+
+      mesh->albedoTextureId = TEXTURE_ID_NO_TEXTURE;
+      mesh->baseColor = {};
+      s32 gltfMaterialIndex = gltfPrimitive.material;
+      if(gltfMaterialIndex >= 0) {
+        const tinygltf::Material& gltfMaterial = gltfModel.materials[gltfMaterialIndex];
+        const f64* baseColor = gltfMaterial.pbrMetallicRoughness.baseColorFactor.data();
+        mesh->baseColor = {(f32)baseColor[0], (f32)baseColor[1], (f32)baseColor[2], (f32)baseColor[3] };
+
+        // each image is uploaded once, by the first mesh that uses it
+        s32 baseColorTextureIndex = gltfMaterial.pbrMetallicRoughness.baseColorTexture.index;
+        if(baseColorTextureIndex >= 0) {
+          u32 albedoColorImageIndex = gltfModel.textures[baseColorTextureIndex].source;
+          GLuint* albedoTextureId = &returnModel->textureIds[albedoColorImageIndex];
+          if(*albedoTextureId == TEXTURE_ID_NO_TEXTURE) {
+            const tinygltf::Image& albedoImage = gltfModel.images[albedoColorImageIndex];
+            load2DTexture(albedoImage.image.data(), albedoImage.component, albedoImage.width, albedoImage.height, albedoTextureId);
+          }
+          mesh->albedoTextureId = *albedoTextureId;
+        }
+      }
+      meshIndex++;
+    }
+  }
+}
+
+void deleteStaticModels(StaticModel* models, u32 count = 1) {
+  for(u32 i = 0; i < count; ++i) {
+    StaticModel* modelPtr = models + i;
+    for(u32 textureIndex = 0; textureIndex < modelPtr->textureCount; ++textureIndex) {
+      GLuint textureId = modelPtr->textureIds[textureIndex];
+      if(textureId != TEXTURE_ID_NO_TEXTURE) {
+        glDeleteTextures(1, &textureId);
+      }
+    }
+    *modelPtr = {}; // clear model to zero
+  }
+  // NOTE: Pool space, mesh and texture arrays (permanent arena) are not reclaimed, static geometry is expected to live as long as the pool
+}
+
+void initStaticDrawList(StaticDrawList* list, u32 capacity) {
+  list->draws = new StaticDraw[capacity];
+  list->count = 0;
+  list->capacity = capacity;
+}
+
+void deinitStaticDrawList(StaticDrawList* list) {
+  delete[] list->draws;
+  *list = {}; // clear to zero
+}
+
+inline void clearStaticDrawList(StaticDrawList* list) { list->count = 0; }
+
+void submitStaticDraw(StaticDrawList* list, const StaticMeshRange& range, GLuint albedoTextureId, const glm::mat4& modelMat) {
+  assert(list->count < list->capacity && "ERROR: Too many static draws submitted this frame!");
+  StaticDraw* draw = list->draws + list->count++;
+  draw->range = range;
+  draw->albedoTextureId = albedoTextureId;
+  draw->modelMat = modelMat;
+}
+
+// lod is clamped to the number of LODs each mesh has
+void submitStaticDraw(StaticDrawList* list, const StaticModel& model, const glm::mat4& modelMat, u32 lod = 0) {
+  for(u32 i = 0; i < model.meshCount; ++i) {
+    const StaticMesh& mesh = model.meshes[i];
+    submitStaticDraw(list, mesh.lods[Min(lod, mesh.lodCount - 1)], mesh.albedoTextureId, modelMat);
+  }
+}
+
+// Issues every draw in the list. The caller is expected to have bound a shader program
+// that reads the model matrix from STATIC_GEOMETRY_MODEL_MAT_ATTRIBUTE_INDEX and samples its albedo from
+// activeTextureIndex. Each bucket's albedo texture gets bound to that texture unit.
+// The list is sorted in place but otherwise left intact, clearing it is up to whoever recorded it.
+StaticGeometryStats flushStaticDraws(StaticGeometryPool* pool, StaticDrawList* list, s32 activeTextureIndex) {
+  StaticGeometryStats stats{};
+  if(list->count == 0) {
+    return stats;
+  }
+  assert(list->count <= pool->drawCapacity && "ERROR: Static draw list is larger than the pool's draw capacity!");
+
+  // sort into material buckets
+  std::sort(list->draws, list->draws + list->count, [](const StaticDraw& a, const StaticDraw& b) {
+    return a.albedoTextureId < b.albedoTextureId;
+  });
+
+  for(u32 i = 0; i < list->count; ++i) {
+    const StaticDraw& draw = list->draws[i];
+    DrawElementsIndirectCommand& command = pool->commands[i];
+    command.count = draw.range.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = draw.range.firstIndex;
+    command.baseVertex = draw.range.baseVertex;
+    command.baseInstance = i; // selects this draw's model matrix
+    pool->modelMats[i] = draw.modelMat;
+    stats.triangleCount += draw.range.indexCount / 3;
+  }
+
+  // orphan and refill the per frame buffers
+  if(pool->baseInstanceAvailable) {
+    glBindBuffer(GL_ARRAY_BUFFER, pool->instanceBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, pool->drawCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, list->count * sizeof(glm::mat4), pool->modelMats);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  b32 multiDrawIndirectAvailable = pool->multiDrawIndirectAvailable;
+  if(multiDrawIndirectAvailable) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, pool->commandBufferObject);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, pool->drawCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, list->count * sizeof(DrawElementsIndirectCommand), pool->commands);
+  }
+
+  glBindVertexArray(pool->arrayObject);
+  u32 bucketStart = 0;
+  while(bucketStart < list->count) {
+    GLuint bucketTextureId = list->draws[bucketStart].albedoTextureId;
+    u32 bucketEnd = bucketStart + 1;
+    while(bucketEnd < list->count && list->draws[bucketEnd].albedoTextureId == bucketTextureId) {
+      bucketEnd++;
+    }
+    u32 bucketDrawCount = bucketEnd - bucketStart;
+
+    bindActiveTexture2d(activeTextureIndex, bucketTextureId);
+    if(multiDrawIndirectAvailable) {
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                  (void*)(bucketStart * sizeof(DrawElementsIndirectCommand)), // offset in the indirect buffer
+                                  bucketDrawCount,
+                                  sizeof(DrawElementsIndirectCommand));
+      stats.glDrawCallCount++;
+    } else if(pool->baseInstanceAvailable) {
+      // GL 4.2 fallback, same commands issued one at a time from the CPU
+      for(u32 i = bucketStart; i < bucketEnd; ++i) {
+        const DrawElementsIndirectCommand& command = pool->commands[i];
+        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                                      (void*)(command.firstIndex * sizeof(u32)),
+                                                      command.instanceCount, command.baseVertex, command.baseInstance);
+      }
+      stats.glDrawCallCount += bucketDrawCount;
+    } else {
+      // GL 3.3 fallback, the disabled model matrix attribute reads the constant value set before each draw
+      for(u32 i = bucketStart; i < bucketEnd; ++i) {
+        const DrawElementsIndirectCommand& command = pool->commands[i];
+        const glm::mat4& modelMat = pool->modelMats[i];
+        for(u32 column = 0; column < 4; ++column) {
+          glVertexAttrib4fv(STATIC_GEOMETRY_MODEL_MAT_ATTRIBUTE_INDEX + column, (const f32*)&modelMat[column]);
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                 (void*)(command.firstIndex * sizeof(u32)), command.baseVertex);
+      }
+      stats.glDrawCallCount += bucketDrawCount;
+    }
+
+    stats.bucketCount++;
+    bucketStart = bucketEnd;
+  }
+  glBindVertexArray(0);
+  if(multiDrawIndirectAvailable) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  stats.drawCount = list->count;
+  return stats;
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+// Systems run over entity queries once per frame. Queries are owned by the caller so their archetype
+// lists stay cached between frames.
+
+// Spinning entities rewrite their local rotation, then every dirty world matrix is recomputed
+void updateTransformSystem(EcsWorld* world, EcsQuery* spinQuery, TransformHierarchy* transforms, f64 totalSeconds) {
+  forEachChunk(world, spinQuery, [transforms, totalSeconds](EcsChunkView& view) {
+    TransformComponent* transformComponents = view.get<TransformComponent>();
+    SpinComponent* spins = view.get<SpinComponent>();
+    for(u32 i = 0; i < view.count; ++i) {
+      f32 angle = (f32)(spins[i].radiansPerSecond * totalSeconds);
+      setLocalRotation(transforms, transformComponents[i].node, spins[i].baseRotation * glm::angleAxis(angle, spins[i].axis));
+    }
+  });
+  updateTransforms(transforms);
+}
+
+// Culls the query's meshes against the frustum, picks their LODs and records the visible ones. Pickable meshes
+// get their BVH boxes updated, refitting is left to the caller.
+// Returns the triangles the visible meshes would have cost without LODs.
+u32 renderStaticMeshSystem(EcsWorld* world, EcsQuery* meshQuery, const TransformHierarchy& transforms,
+                           CullingBoxes* cullingBoxes, const Frustum& frustum, const glm::vec3& cameraPosition, const glm::mat4& projMat,
+                           bool lodEnabled, BVH* bvh, StaticDrawList* drawList, CullStats* cullStats) {
+  // culling index -> mesh, valid until the end of the frame
+  StaticMeshComponent** meshes = pushArray(&frameArena, cullingBoxes->capacity, StaticMeshComponent*);
+  const glm::mat4** modelMats = pushArray(&frameArena, cullingBoxes->capacity, const glm::mat4*);
+  Box* worldBoxes = pushArray(&frameArena, cullingBoxes->capacity, Box);
+
+  clearCullingBoxes(cullingBoxes);
+  forEachChunk(world, meshQuery, [&](EcsChunkView& view) {
+    TransformComponent* transformComponents = view.get<TransformComponent>();
+    StaticMeshComponent* meshComponents = view.get<StaticMeshComponent>();
+    for(u32 i = 0; i < view.count; ++i) {
+      const glm::mat4& modelMat = worldMat(transforms, transformComponents[i].node);
+      Box worldBox = transformBox(meshComponents[i].meshBox, modelMat);
+      u32 cullingIndex = addCullingBox(cullingBoxes, worldBox);
+      meshes[cullingIndex] = meshComponents + i;
+      modelMats[cullingIndex] = &modelMat;
+      worldBoxes[cullingIndex] = worldBox;
+      if(meshComponents[i].bvhObject != U32_MAX) {
+        setBVHObjectBox(bvh, meshComponents[i].bvhObject, worldBox);
+      }
+    }
+  });
+
+  u32* visibleIndices = pushArray(&frameArena, cullingBoxes->count, u32);
+  u32 visibleCount = cullBoxes(cullingBoxes, frustum, visibleIndices, cullStats);
+  u32 fullDetailTriangleCount = 0;
+  for(u32 i = 0; i < visibleCount; ++i) {
+    u32 cullingIndex = visibleIndices[i];
+    StaticMeshComponent* mesh = meshes[cullingIndex];
+    mesh->currentLOD = lodEnabled ? selectLOD(projectedScreenSize(worldBoxes[cullingIndex], cameraPosition, projMat), mesh->currentLOD, mesh->lodCount) : 0;
+    fullDetailTriangleCount += mesh->lods[0].indexCount / 3;
+    submitStaticDraw(drawList, mesh->lods[mesh->currentLOD], mesh->albedoTextureId, *modelMats[cullingIndex]);
+  }
+  return fullDetailTriangleCount;
+}
+
+// Moves sprites by their velocity, keeping them within the emulated sprite resolution
+void updateSpriteSystem(EcsWorld* world, EcsQuery* spriteQuery, f64 deltaSeconds, const ivec2& emulatedSpriteResolution) {
+  glm::vec2 maxPosition = glm::vec2((f32)emulatedSpriteResolution.x - 0.5f, (f32)emulatedSpriteResolution.y - 0.5f);
+  forEachChunk(world, spriteQuery, [deltaSeconds, maxPosition](EcsChunkView& view) {
+    SpriteComponent* sprites = view.get<SpriteComponent>();
+    for(u32 i = 0; i < view.count; ++i) {
+      sprites[i].position += sprites[i].velocity * (f32)deltaSeconds;
+      sprites[i].position.x = Clamp(sprites[i].position.x, 0.5f, maxPosition.x);
+      sprites[i].position.y = Clamp(sprites[i].position.y, 0.5f, maxPosition.y);
+    }
+  });
+}
+
+// Returns the number of sprite positions written, at most maxCount
+u32 renderSpriteSystem(EcsWorld* world, EcsQuery* spriteQuery, glm::vec2* outPositions, u32 maxCount) {
+  u32 count = 0;
+  forEachChunk(world, spriteQuery, [&count, outPositions, maxCount](EcsChunkView& view) {
+    SpriteComponent* sprites = view.get<SpriteComponent>();
+    for(u32 i = 0; i < view.count && count < maxCount; ++i) {
+      outPositions[count++] = sprites[i].position;
+    }
+  });
+  return count;
+}
+
+// Triggered emitters play the sound effect unless they are still cooling down, triggers never queue up
+void updateAudioEmitterSystem(EcsWorld* world, EcsQuery* emitterQuery, AUDIO_HANDLE audioHandle, f64 deltaSeconds) {
+  forEachChunk(world, emitterQuery, [audioHandle, deltaSeconds](EcsChunkView& view) {
+    AudioEmitterComponent* emitters = view.get<AudioEmitterComponent>();
+    for(u32 i = 0; i < view.count; ++i) {
+      AudioEmitterComponent* emitter = emitters + i;
+      emitter->remainingCooldownSeconds = Max(emitter->remainingCooldownSeconds - (f32)deltaSeconds, 0.0f);
+      if(emitter->triggered && emitter->remainingCooldownSeconds == 0.0f) {
+        playSoundEffect(audioHandle);
+        emitter->remainingCooldownSeconds = emitter->cooldownSeconds;
+      }
+      emitter->triggered = false;
+    }
+  });
+}
\ No newline at end of file
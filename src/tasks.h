@@ -0,0 +1,328 @@
+#pragma once
+
+// Coroutine tasks
+// Tasks are C++20 coroutines that suspend instead of blocking. Awaitables move a task between threads and frames:
+// - co_await toWorkerThread(): continue on a job system worker
+// - co_await toRenderThread(): continue on the thread that owns the GL context, during its next runRenderThreadTasks()
+// - co_await nextFrame(): continue on the main thread during the next runScheduledTasks()
+// - co_await waitSeconds(s): continue on the main thread once s seconds of frame time have passed
+// - co_await readFile(path): open an asset through the VFS on a worker, continue on that worker
+// - co_await otherTask: run a child task to completion, continue wherever it finished
+// Top level tasks are started with spawnTask() and free themselves when they finish. Every task belongs to the
+// scheduler it was spawned on, the global one unless given another, e.g. for benchmarks. Child tasks inherit it.
+
+#define TASK_QUEUE_CAPACITY (1 << 16)
+
+struct TaskTimer {
+  f64 resumeSeconds;
+  std::coroutine_handle<> handle;
+};
+
+struct TaskScheduler {
+  std::mutex mutex;
+  std::coroutine_handle<>* nextFrameHandles;
+  u32 nextFrameCount;
+  std::coroutine_handle<>* resumingHandles; // swapped with nextFrameHandles every frame
+  std::coroutine_handle<>* renderThreadHandles;
+  u32 renderThreadCount;
+  std::coroutine_handle<>* renderResumingHandles; // swapped with renderThreadHandles every runRenderThreadTasks()
+  TaskTimer* timers; // min heap on resumeSeconds
+  u32 timerCount;
+  f64 nowSeconds;
+  std::atomic<s32> liveTaskCount; // spawned tasks that have not finished
+  JobCounter workerJobs;
+  u64 resumeCount; // main thread resumes, for stats
+};
+
+global TaskScheduler taskScheduler;
+
+struct Task {
+  struct promise_type {
+    std::coroutine_handle<> continuation;
+    TaskScheduler* scheduler = &taskScheduler;
+    bool detached = false;
+
+    Task get_return_object() { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { assert(false && "ERROR: Unhandled exception in task!"); std::terminate(); }
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+  Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() { if(handle) { handle.destroy(); } }
+
+  // awaiting a task starts it and resumes the awaiting task when it finishes
+  bool await_ready() { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> awaitingHandle) {
+    handle.promise().continuation = awaitingHandle;
+    handle.promise().scheduler = awaitingHandle.promise().scheduler;
+    return handle;
+  }
+  void await_resume() {}
+};
+
+std::coroutine_handle<> Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+  promise_type& promise = handle.promise();
+  if(promise.detached) {
+    TaskScheduler* scheduler = promise.scheduler;
+    handle.destroy();
+    scheduler->liveTaskCount.fetch_sub(1, std::memory_order_release);
+    return std::noop_coroutine();
+  }
+  return promise.continuation ? promise.continuation : std::noop_coroutine();
+}
+
+void initTaskScheduler(TaskScheduler* scheduler = &taskScheduler) {
+  scheduler->nextFrameHandles = new std::coroutine_handle<>[TASK_QUEUE_CAPACITY];
+  scheduler->resumingHandles = new std::coroutine_handle<>[TASK_QUEUE_CAPACITY];
+  scheduler->timers = new TaskTimer[TASK_QUEUE_CAPACITY];
+  scheduler->renderThreadHandles = new std::coroutine_handle<>[TASK_QUEUE_CAPACITY];
+  scheduler->renderResumingHandles = new std::coroutine_handle<>[TASK_QUEUE_CAPACITY];
+  scheduler->nextFrameCount = 0;
+  scheduler->renderThreadCount = 0;
+  scheduler->timerCount = 0;
+  scheduler->nowSeconds = 0.0;
+  scheduler->liveTaskCount.store(0);
+  scheduler->resumeCount = 0;
+}
+
+// Tasks still suspended at this point are abandoned
+void deinitTaskScheduler(TaskScheduler* scheduler = &taskScheduler) {
+  waitForCounter(&scheduler->workerJobs);
+  delete[] scheduler->nextFrameHandles;
+  delete[] scheduler->resumingHandles;
+  delete[] scheduler->timers;
+  delete[] scheduler->renderThreadHandles;
+  delete[] scheduler->renderResumingHandles;
+  scheduler->nextFrameHandles = nullptr;
+  scheduler->resumingHandles = nullptr;
+  scheduler->timers = nullptr;
+  scheduler->renderThreadHandles = nullptr;
+  scheduler->renderResumingHandles = nullptr;
+}
+
+// Starts the task on the calling thread, it runs until its first suspension
+void spawnTask(Task task, TaskScheduler* scheduler = &taskScheduler) {
+  std::coroutine_handle<Task::promise_type> handle = task.handle;
+  task.handle = nullptr;
+  handle.promise().detached = true;
+  handle.promise().scheduler = scheduler;
+  scheduler->liveTaskCount.fetch_add(1, std::memory_order_relaxed);
+  handle.resume();
+}
+
+inline bool timerLater(const TaskTimer& a, const TaskTimer& b) { return a.resumeSeconds > b.resumeSeconds; }
+
+// Called once per frame on the main thread, resumes tasks waiting on nextFrame() and expired timers
+void runScheduledTasks(f64 nowSeconds, TaskScheduler* scheduler = &taskScheduler) {
+  u32 resumingCount;
+  {
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    scheduler->nowSeconds = nowSeconds;
+    std::coroutine_handle<>* swap = scheduler->resumingHandles;
+    scheduler->resumingHandles = scheduler->nextFrameHandles;
+    scheduler->nextFrameHandles = swap;
+    resumingCount = scheduler->nextFrameCount;
+    scheduler->nextFrameCount = 0;
+  }
+  // tasks that await nextFrame() again go into the other buffer
+  for(u32 i = 0; i < resumingCount; ++i) {
+    scheduler->resumingHandles[i].resume();
+  }
+  scheduler->resumeCount += resumingCount;
+
+  for(;;) {
+    std::coroutine_handle<> handle;
+    {
+      std::lock_guard<std::mutex> lock(scheduler->mutex);
+      if(scheduler->timerCount == 0 || scheduler->timers[0].resumeSeconds > nowSeconds) { break; }
+      std::pop_heap(scheduler->timers, scheduler->timers + scheduler->timerCount, timerLater);
+      handle = scheduler->timers[--scheduler->timerCount].handle;
+    }
+    handle.resume();
+    scheduler->resumeCount++;
+  }
+}
+
+// Called by whichever thread owns the GL context: the render thread before each frame it draws, the main thread
+// while the render thread is disabled or not started yet. Resumes tasks waiting on toRenderThread().
+void runRenderThreadTasks(TaskScheduler* scheduler = &taskScheduler) {
+  u32 resumingCount;
+  {
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    std::coroutine_handle<>* swap = scheduler->renderResumingHandles;
+    scheduler->renderResumingHandles = scheduler->renderThreadHandles;
+    scheduler->renderThreadHandles = swap;
+    resumingCount = scheduler->renderThreadCount;
+    scheduler->renderThreadCount = 0;
+  }
+  // tasks that await toRenderThread() again go into the other buffer
+  for(u32 i = 0; i < resumingCount; ++i) {
+    scheduler->renderResumingHandles[i].resume();
+  }
+}
+
+struct NextFrameAwaiter {
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+    TaskScheduler* scheduler = handle.promise().scheduler;
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    assert(scheduler->nextFrameCount < TASK_QUEUE_CAPACITY && "ERROR: Too many tasks waiting on the next frame!");
+    scheduler->nextFrameHandles[scheduler->nextFrameCount++] = handle;
+  }
+  void await_resume() {}
+};
+inline NextFrameAwaiter nextFrame() { return {}; }
+
+struct WaitSecondsAwaiter {
+  f64 seconds;
+  bool await_ready() { return seconds <= 0.0; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+    TaskScheduler* scheduler = handle.promise().scheduler;
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    assert(scheduler->timerCount < TASK_QUEUE_CAPACITY && "ERROR: Too many tasks waiting on timers!");
+    scheduler->timers[scheduler->timerCount++] = TaskTimer{ scheduler->nowSeconds + seconds, handle };
+    std::push_heap(scheduler->timers, scheduler->timers + scheduler->timerCount, timerLater);
+  }
+  void await_resume() {}
+};
+inline WaitSecondsAwaiter waitSeconds(f64 seconds) { return WaitSecondsAwaiter{ seconds }; }
+
+internal void resumeTaskJob(void* data) {
+  std::coroutine_handle<>::from_address(data).resume();
+}
+
+// Without worker threads the task keeps running where it is
+struct WorkerThreadAwaiter {
+  bool await_ready() { return jobThreadCount() == 1; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+    runJob(resumeTaskJob, handle.address(), &handle.promise().scheduler->workerJobs);
+  }
+  void await_resume() {}
+};
+inline WorkerThreadAwaiter toWorkerThread() { return {}; }
+
+// For GL calls. Always suspends, even on the thread that owns the context.
+struct RenderThreadAwaiter {
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+    TaskScheduler* scheduler = handle.promise().scheduler;
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    assert(scheduler->renderThreadCount < TASK_QUEUE_CAPACITY && "ERROR: Too many tasks waiting on the render thread!");
+    scheduler->renderThreadHandles[scheduler->renderThreadCount++] = handle;
+  }
+  void await_resume() {}
+};
+inline RenderThreadAwaiter toRenderThread() { return {}; }
+
+// Result of readFile(), the caller owns the asset and must closeAsset() it. found is false and the asset is empty
+// when neither the mounted pack nor a loose file has the path.
+struct FileRead {
+  AssetFile asset;
+  bool found;
+};
+
+struct ReadFileAwaiter {
+  const char* fileName;
+  FileRead result;
+  std::coroutine_handle<> handle; // the awaiter lives in the suspended task's frame until the read job resumes it
+
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<Task::promise_type> awaitingHandle) {
+    handle = awaitingHandle;
+    runJob([](void* data) {
+      ReadFileAwaiter* awaiter = (ReadFileAwaiter*)data;
+      awaiter->result.found = openAsset(awaiter->fileName, &awaiter->result.asset);
+      awaiter->handle.resume();
+    }, this, &awaitingHandle.promise().scheduler->workerJobs);
+  }
+  FileRead await_resume() { return result; }
+};
+inline ReadFileAwaiter readFile(const char* fileName) { return ReadFileAwaiter{ fileName, {}, nullptr }; }
+
+// Thousands of suspended tasks resumed across simulated frames on a scheduler of their own, results are printed to
+// stdout. The scene's tasks keep running on the global scheduler in real time.
+void benchmarkTasks() {
+  const u32 taskCount = 10000;
+  const u32 framesPerTask = 100;
+  const f64 secondsPerCounter = 1.0 / getPerformanceCounterFrequencyPerSecond();
+  std::atomic<u32> finishedCount{0};
+  TaskScheduler benchmarkScheduler;
+  TaskScheduler* scheduler = &benchmarkScheduler;
+  initTaskScheduler(scheduler);
+
+  struct Local {
+    static Task frameLoop(u32 frameCount, std::atomic<u32>* finished) {
+      for(u32 i = 0; i < frameCount; ++i) {
+        co_await nextFrame();
+      }
+      finished->fetch_add(1, std::memory_order_relaxed);
+    }
+    static Task timerLoop(u32 timerCount, std::atomic<u32>* finished) {
+      for(u32 i = 0; i < timerCount; ++i) {
+        co_await waitSeconds(0.5);
+      }
+      finished->fetch_add(1, std::memory_order_relaxed);
+    }
+    static Task workerHops(u32 hopCount, std::atomic<u32>* finished) {
+      for(u32 i = 0; i < hopCount; ++i) {
+        co_await toWorkerThread();
+        co_await nextFrame();
+      }
+      finished->fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  // frame and timer resumes are measured without the coroutine bodies doing any work
+  auto simulateFrames = [&](u32 frameCount, f64 secondsPerFrame) -> f64 {
+    f64 simulatedSeconds = scheduler->nowSeconds;
+    u64 resumeCountBefore = scheduler->resumeCount;
+    u64 start = getPerformanceCounter();
+    for(u32 frame = 0; frame < frameCount; ++frame) {
+      simulatedSeconds += secondsPerFrame;
+      runScheduledTasks(simulatedSeconds, scheduler);
+    }
+    f64 elapsedNs = (getPerformanceCounter() - start) * secondsPerCounter * 1000000000.0;
+    return elapsedNs / Max(scheduler->resumeCount - resumeCountBefore, 1ull);
+  };
+
+  printf("Coroutine tasks (%u concurrent tasks)\n", taskCount);
+
+  for(u32 i = 0; i < taskCount; ++i) { spawnTask(Local::frameLoop(framesPerTask, &finishedCount), scheduler); }
+  f64 nextFrameNs = simulateFrames(framesPerTask, 1.0 / 60.0);
+  printf("  nextFrame():   %u resumes | %6.1f ns per resume | finished %u/%u\n", taskCount * framesPerTask, nextFrameNs, finishedCount.load(), taskCount);
+
+  finishedCount = 0;
+  for(u32 i = 0; i < taskCount; ++i) { spawnTask(Local::timerLoop(framesPerTask / 10, &finishedCount), scheduler); }
+  f64 timerNs = simulateFrames(framesPerTask, 0.5);
+  printf("  waitSeconds(): %u resumes | %6.1f ns per resume | finished %u/%u\n", taskCount * (framesPerTask / 10), timerNs, finishedCount.load(), taskCount);
+
+  // worker hops go through the job system, the time includes the hop back to the main thread
+  const u32 hopTaskCount = Min(taskCount, (u32)JOB_DEQUE_CAPACITY / 2);
+  const u32 hopsPerTask = 10;
+  finishedCount = 0;
+  u64 start = getPerformanceCounter();
+  for(u32 i = 0; i < hopTaskCount; ++i) { spawnTask(Local::workerHops(hopsPerTask, &finishedCount), scheduler); }
+  f64 simulatedSeconds = scheduler->nowSeconds;
+  while(finishedCount.load() < hopTaskCount) {
+    waitForCounter(&scheduler->workerJobs);
+    simulatedSeconds += 1.0 / 60.0;
+    runScheduledTasks(simulatedSeconds, scheduler);
+  }
+  f64 hopNs = (getPerformanceCounter() - start) * secondsPerCounter * 1000000000.0 / (hopTaskCount * hopsPerTask);
+  printf("  toWorkerThread() + nextFrame(): %u round trips | %6.1f ns per round trip | finished %u/%u\n",
+         hopTaskCount * hopsPerTask, hopNs, finishedCount.load(), hopTaskCount);
+  deinitTaskScheduler(scheduler);
+}
\ No newline at end of file
@@ -4,6 +4,7 @@ enum LoadTextureFlags {
   HORZ_FLIP = 1 << 0,
   INPUT_SRGB = 1 << 1,
   CHUNKY_PIXELS = 1 << 2,
+  PREMULTIPLY_ALPHA = 1 << 3, // done in linear space for INPUT_SRGB images
 };
 
 void load2DTexture(const u8* data, u32 numChannels, s32 width, s32 height, GLuint* textureId, b32 textureFlags = 0) {
@@ -51,17 +52,124 @@ void load2DTexture(const u8* data, u32 numChannels, s32 width, s32 height, GLuin
   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void load2DTexture(const char* imgLocation, GLuint* textureId, s32* width, s32* height, b32 textureFlags = 0) {
-  // load image data
+struct DecodedImage {
+  u8* data;
+  s32 width;
+  s32 height;
   s32 numChannels;
-  stbi_set_flip_vertically_on_load(flagIsSet(textureFlags, LoadTextureFlags::HORZ_FLIP));
-  u8* data = stbi_load(imgLocation, width, height, &numChannels, 0 /*desired channels*/);
+};
 
-  assert(data);
+// Safe to call from any thread. Flipping is done here since stb_image's flip setting is global.
+// RGB images come back as RGBA: their rows needn't match the default GL_UNPACK_ALIGNMENT of 4 and drivers keep
+// RGB8 textures as RGBA8 anyway. Returns false and leaves outImage empty when the bytes are not a decodable image.
+bool decodeImage(const u8* imageBytes, size_t imageSize, b32 textureFlags, DecodedImage* outImage) {
+  *outImage = {};
+  if(imageBytes == nullptr) { return false; }
+  outImage->data = stbi_load_from_memory(imageBytes, (int)imageSize, &outImage->width, &outImage->height, &outImage->numChannels, 0 /*desired channels*/);
+  if(outImage->data == nullptr) { return false; }
+  memory_index pixelCount = (memory_index)outImage->width * outImage->height;
 
-  load2DTexture(data, numChannels, *width, *height, textureId, textureFlags);
+  if(outImage->numChannels == 3) {
+    u8* rgba = (u8*)malloc(pixelCount * 4); // stb.c uses the default allocator, stbi_image_free() releases this too
+    expandRGBToRGBA(outImage->data, rgba, pixelCount);
+    stbi_image_free(outImage->data);
+    outImage->data = rgba;
+    outImage->numChannels = 4;
+  }
+
+  if(flagIsSet(textureFlags, LoadTextureFlags::HORZ_FLIP)) {
+    flipImageRows(outImage->data, outImage->width, outImage->height, outImage->numChannels);
+  }
 
-  stbi_image_free(data); // free texture image memory
+  if(flagIsSet(textureFlags, LoadTextureFlags::PREMULTIPLY_ALPHA) && outImage->numChannels == 4) {
+    if(flagIsSet(textureFlags, LoadTextureFlags::INPUT_SRGB)) {
+      premultiplyAlphaSRGB(outImage->data, pixelCount);
+    } else {
+      premultiplyAlpha(outImage->data, pixelCount);
+    }
+  }
+  return true;
+}
+
+bool decodeImage(const char* imgLocation, b32 textureFlags, DecodedImage* outImage) {
+  AssetFile imageFile;
+  openAsset(imgLocation, &imageFile);
+  bool decoded = decodeImage(imageFile.bytes, imageFile.size, textureFlags, outImage);
+  closeAsset(&imageFile);
+  return decoded;
+}
+
+// Stands in for images that fail to decode: a single magenta pixel, hard to miss on screen
+void decodeFallbackImage(const char* imgLocation, DecodedImage* outImage) {
+  const char* reason = stbi_failure_reason(); // must be read on the thread whose decode failed
+  fprintf(stderr, "Could not decode image %s: %s\n", imgLocation, reason ? reason : "no data");
+  outImage->data = (u8*)malloc(4); // released by stbi_image_free() like decoded images
+  outImage->data[0] = 255;
+  outImage->data[1] = 0;
+  outImage->data[2] = 255;
+  outImage->data[3] = 255;
+  outImage->width = 1;
+  outImage->height = 1;
+  outImage->numChannels = 4;
+}
+
+inline void freeDecodedImage(DecodedImage* image) {
+  stbi_image_free(image->data); // free texture image memory
+  *image = {};
+}
+
+void load2DTexture(const char* imgLocation, GLuint* textureId, s32* width, s32* height, b32 textureFlags = 0) {
+  DecodedImage image;
+  if(!decodeImage(imgLocation, textureFlags, &image)) {
+    decodeFallbackImage(imgLocation, &image);
+  }
+  *width = image.width;
+  *height = image.height;
+  load2DTexture(image.data, image.numChannels, image.width, image.height, textureId, textureFlags);
+  freeDecodedImage(&image);
+}
+
+// Files are read together and each image is decoded on the job system as soon as its bytes arrive,
+// GL uploads happen on the calling thread. Images that fail to decode get the fallback texture.
+void load2DTextures(const char** imgLocations, u32 count, GLuint* outTextureIds, ivec2* outDimens, b32 textureFlags = 0) {
+  struct DecodeJob {
+    const char* imgLocation;
+    const AssetFile* file;
+    b32 textureFlags;
+    DecodedImage image;
+  };
+  struct DecodeBatch {
+    DecodeJob* jobs;
+    JobCounter counter;
+  };
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  AssetFile* imageFiles = pushArray(tempMemory.arena, count, AssetFile);
+  DecodeBatch decodeBatch;
+  decodeBatch.jobs = pushArray(tempMemory.arena, count, DecodeJob);
+  for(u32 i = 0; i < count; ++i) {
+    decodeBatch.jobs[i].imgLocation = imgLocations[i];
+    decodeBatch.jobs[i].file = imageFiles + i;
+    decodeBatch.jobs[i].textureFlags = textureFlags;
+  }
+  openAssetsAsync(imgLocations, count, imageFiles, [](u32 index, void* data) {
+    DecodeBatch* batch = (DecodeBatch*)data;
+    runJob([](void* data) {
+      DecodeJob* job = (DecodeJob*)data;
+      if(!decodeImage(job->file->bytes, job->file->size, job->textureFlags, &job->image)) {
+        decodeFallbackImage(job->imgLocation, &job->image);
+      }
+    }, batch->jobs + index, &batch->counter);
+  }, &decodeBatch);
+  waitForCounter(&decodeBatch.counter);
+  closeAssetsAsync(imageFiles, count);
+
+  for(u32 i = 0; i < count; ++i) {
+    DecodedImage& image = decodeBatch.jobs[i].image;
+    outDimens[i] = ivec2{image.width, image.height};
+    load2DTexture(image.data, image.numChannels, image.width, image.height, outTextureIds + i, textureFlags);
+    freeDecodedImage(&image);
+  }
+  endTempMemory(tempMemory);
 }
 
 internal inline void bindActiveTexture(s32 activeIndex, GLuint textureId, GLenum target) {
@@ -71,4 +179,114 @@ internal inline void bindActiveTexture(s32 activeIndex, GLuint textureId, GLenum
 
 void inline bindActiveTexture2d(s32 activeIndex, GLuint textureId) {
   bindActiveTexture(activeIndex, textureId, GL_TEXTURE_2D);
+}
+
+// Decodes hundreds of generated PNGs serially the way textures used to load (stb_image expanding RGB, row flips
+// through a temporary row, scalar premultiply) and then in parallel through decodeImage(). Results are printed to stdout.
+void benchmarkTextureDecode() {
+  const u32 textureCount = 256;
+  const s32 size = 256;
+  const b32 flags = LoadTextureFlags::HORZ_FLIP | LoadTextureFlags::PREMULTIPLY_ALPHA;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+
+  // smooth gradients with some noise and a varying alpha, compressing about like real art does
+  struct EncodedImage {
+    u8* bytes;
+    u32 size;
+    u32 capacity;
+  };
+  EncodedImage* encoded = new EncodedImage[textureCount]{};
+  u8* pixels = new u8[size * size * 4];
+  u32 seed = 1;
+  for(u32 t = 0; t < textureCount; ++t) {
+    s32 channels = (t % 2 == 0) ? 3 : 4;
+    for(s32 i = 0; i < size * size; ++i) {
+      seed = seed * 1664525u + 1013904223u;
+      s32 x = i % size, y = i / size;
+      u8* pixel = pixels + (i * channels);
+      pixel[0] = (u8)(x + t);
+      pixel[1] = (u8)(y * 2 + (seed >> 29));
+      pixel[2] = (u8)((x ^ y) + t * 3);
+      if(channels == 4) { pixel[3] = (u8)(((x / 32) + (y / 32)) % 2 == 0 ? 255 : (x + y) / 2); }
+    }
+    stbi_write_png_to_func([](void* context, void* data, int dataSize) {
+      EncodedImage* image = (EncodedImage*)context;
+      if(image->size + dataSize > image->capacity) {
+        u32 newCapacity = Max(image->capacity * 2, image->size + (u32)dataSize);
+        u8* newBytes = new u8[newCapacity];
+        memcpy(newBytes, image->bytes, image->size);
+        delete[] image->bytes;
+        image->bytes = newBytes;
+        image->capacity = newCapacity;
+      }
+      memcpy(image->bytes + image->size, data, dataSize);
+      image->size += dataSize;
+    }, encoded + t, size, size, channels, pixels, size * channels);
+  }
+  delete[] pixels;
+
+  DecodedImage* serialImages = new DecodedImage[textureCount];
+  u64 startCounter = getPerformanceCounter();
+  for(u32 t = 0; t < textureCount; ++t) {
+    DecodedImage& image = serialImages[t];
+    image.data = stbi_load_from_memory(encoded[t].bytes, (int)encoded[t].size, &image.width, &image.height, &image.numChannels, 4);
+    image.numChannels = 4;
+    memory_index rowSize = (memory_index)image.width * 4;
+    u8* swapRow = new u8[rowSize];
+    for(s32 row = 0; row < image.height / 2; ++row) {
+      u8* topRow = image.data + (row * rowSize);
+      u8* bottomRow = image.data + ((image.height - 1 - row) * rowSize);
+      memcpy(swapRow, topRow, rowSize);
+      memcpy(topRow, bottomRow, rowSize);
+      memcpy(bottomRow, swapRow, rowSize);
+    }
+    delete[] swapRow;
+    for(s32 i = 0; i < image.width * image.height; ++i) {
+      u8* pixel = image.data + (i * 4);
+      for(u32 c = 0; c < 3; ++c) { pixel[c] = (u8)((pixel[c] * pixel[3] + 127) / 255); }
+    }
+  }
+  f64 serialSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  DecodedImage* parallelImages = new DecodedImage[textureCount];
+  startCounter = getPerformanceCounter();
+  parallelFor(textureCount, 1, [encoded, parallelImages, flags](u32 begin, u32 end) {
+    for(u32 t = begin; t < end; ++t) {
+      decodeImage(encoded[t].bytes, encoded[t].size, flags, parallelImages + t);
+    }
+  });
+  f64 parallelSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  // post-processing alone, on one thread
+  const memory_index pixelCount = (memory_index)size * size;
+  u8* rgb = new u8[pixelCount * 3];
+  u8* rgba = new u8[pixelCount * 4];
+  for(memory_index i = 0; i < pixelCount * 3; ++i) { rgb[i] = (u8)(i * 7); }
+  startCounter = getPerformanceCounter();
+  for(u32 t = 0; t < textureCount; ++t) {
+    expandRGBToRGBA(rgb, rgba, pixelCount);
+    flipImageRows(rgba, size, size, 4);
+    premultiplyAlpha(rgba, pixelCount);
+  }
+  f64 kernelSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  bool match = true;
+  for(u32 t = 0; t < textureCount; ++t) {
+    match = match && memcmp(serialImages[t].data, parallelImages[t].data, pixelCount * 4) == 0;
+    freeDecodedImage(serialImages + t);
+    freeDecodedImage(parallelImages + t);
+    delete[] encoded[t].bytes;
+  }
+  delete[] rgb;
+  delete[] rgba;
+  delete[] serialImages;
+  delete[] parallelImages;
+  delete[] encoded;
+
+  printf("Texture decode: %u PNGs of %dx%d, half RGB and half RGBA, flipped and premultiplied\n", textureCount, size, size);
+  printf("  serial:   %8.3f ms\n", serialSeconds * 1000.0);
+  printf("  parallel: %8.3f ms (%u threads, %.2fx) | results %s\n", parallelSeconds * 1000.0, jobThreadCount(),
+         serialSeconds / parallelSeconds, match ? "match" : "DIFFER");
+  printf("  post-processing kernels alone: %.3f ms for %u images (SSSE3: %s, SSE2: %s)\n", kernelSeconds * 1000.0, textureCount,
+         IMAGE_SIMD_SSSE3 ? "yes" : "no", IMAGE_SIMD_SSE2 ? "yes" : "no");
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#pragma once
+
+// Chunked tile map
+// Tiles are indices into an atlas texture, grouped into square chunks. Each chunk is baked into its own instance
+// buffer, one TileInstance per non-empty tile, and drawn with a single instanced draw of a four vertex strip.
+// Writing a tile only marks its chunk dirty. Chunks are baked on the thread that owns the GL context right before
+// they are drawn, so dirty chunks that are never on screen are never baked. Positions are in tiles, matching the
+// emulated sprite resolution.
+
+#define TILEMAP_CHUNK_SIZE 32 // tiles per side, chunk local coordinates fit in a byte
+#define TILEMAP_MAX_VISIBLE_CHUNKS 64
+#define TILEMAP_INSTANCE_ATTRIBUTE_INDEX 0
+#define TILE_EMPTY 0 // any other tile is its atlas index + 1
+
+struct TileInstance {
+  u16 position; // chunk local x | y << 8
+  u16 atlasIndex;
+};
+
+struct TileChunk {
+  GLuint arrayObject; // 0 until first baked
+  GLuint instanceBufferObject;
+  u32 instanceCount;
+  bool dirty;
+};
+
+struct TileMap {
+  u16* tiles; // row major, bottom row first
+  u32 width; // in tiles
+  u32 height;
+  u32 chunkColumns;
+  u32 chunkRows;
+  TileChunk* chunks;
+  std::mutex mutex; // guards tiles and dirty flags, written by the simulation and read by the renderer
+  std::atomic<u32> bakeCount;
+};
+
+// Chunks of one frame's viewport, recorded by the simulation and drawn by the renderer
+struct TileMapView {
+  glm::vec2 origin; // bottom left of the viewport in tiles
+  u32 chunks[TILEMAP_MAX_VISIBLE_CHUNKS];
+  u32 chunkCount;
+};
+
+void initTileMap(TileMap* map, u32 width, u32 height) {
+  map->width = width;
+  map->height = height;
+  map->chunkColumns = (width + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  map->chunkRows = (height + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  map->tiles = new u16[(memory_index)width * height];
+  memset(map->tiles, 0, (memory_index)width * height * sizeof(u16));
+  u32 chunkCount = map->chunkColumns * map->chunkRows;
+  map->chunks = new TileChunk[chunkCount];
+  for(u32 i = 0; i < chunkCount; ++i) {
+    map->chunks[i] = TileChunk{ 0, 0, 0, true };
+  }
+  map->bakeCount = 0;
+}
+
+// Deletes GL objects, the GL context must be current
+void deinitTileMap(TileMap* map) {
+  for(u32 i = 0; i < map->chunkColumns * map->chunkRows; ++i) {
+    TileChunk* chunk = map->chunks + i;
+    if(chunk->arrayObject != 0) {
+      glDeleteBuffers(1, &chunk->instanceBufferObject);
+      glDeleteVertexArrays(1, &chunk->arrayObject);
+    }
+  }
+  delete[] map->tiles;
+  delete[] map->chunks;
+  map->tiles = nullptr;
+  map->chunks = nullptr;
+}
+
+inline u16 getTile(const TileMap& map, u32 x, u32 y) {
+  return map.tiles[((memory_index)y * map.width) + x];
+}
+
+// Marks the tile's chunk for a rebake, does nothing if the tile is unchanged
+void setTile(TileMap* map, u32 x, u32 y, u16 tile) {
+  assert(x < map->width && y < map->height && "ERROR: Tile is outside of the map!");
+  std::lock_guard<std::mutex> lock(map->mutex);
+  u16* mapTile = map->tiles + ((memory_index)y * map->width) + x;
+  if(*mapTile == tile) { return; }
+  *mapTile = tile;
+  map->chunks[((y / TILEMAP_CHUNK_SIZE) * map->chunkColumns) + (x / TILEMAP_CHUNK_SIZE)].dirty = true;
+}
+
+// Writes the chunk's non-empty tiles, outInstances must hold TILEMAP_CHUNK_SIZE^2. Returns the instance count.
+u32 bakeTileChunk(const TileMap& map, u32 chunkIndex, TileInstance* outInstances) {
+  u32 firstX = (chunkIndex % map.chunkColumns) * TILEMAP_CHUNK_SIZE;
+  u32 firstY = (chunkIndex / map.chunkColumns) * TILEMAP_CHUNK_SIZE;
+  u32 columns = Min(map.width - firstX, (u32)TILEMAP_CHUNK_SIZE);
+  u32 rows = Min(map.height - firstY, (u32)TILEMAP_CHUNK_SIZE);
+  u32 count = 0;
+  for(u32 y = 0; y < rows; ++y) {
+    const u16* row = map.tiles + ((memory_index)(firstY + y) * map.width) + firstX;
+    for(u32 x = 0; x < columns; ++x) {
+      if(row[x] == TILE_EMPTY) { continue; }
+      outInstances[count++] = TileInstance{ (u16)(x | (y << 8)), (u16)(row[x] - 1) };
+    }
+  }
+  return count;
+}
+
+// Records the chunks overlapping a viewport of viewDimens tiles with its bottom left at origin
+void tileMapView(const TileMap& map, glm::vec2 origin, ivec2 viewDimens, OUT TileMapView* outView) {
+  outView->origin = origin;
+  outView->chunkCount = 0;
+  s32 firstColumn = Max((s32)floorf(origin.x / TILEMAP_CHUNK_SIZE), 0);
+  s32 firstRow = Max((s32)floorf(origin.y / TILEMAP_CHUNK_SIZE), 0);
+  s32 lastColumn = Min((s32)ceilf((origin.x + viewDimens.x) / TILEMAP_CHUNK_SIZE), (s32)map.chunkColumns) - 1;
+  s32 lastRow = Min((s32)ceilf((origin.y + viewDimens.y) / TILEMAP_CHUNK_SIZE), (s32)map.chunkRows) - 1;
+  for(s32 row = firstRow; row <= lastRow; ++row) {
+    for(s32 column = firstColumn; column <= lastColumn; ++column) {
+      if(outView->chunkCount == TILEMAP_MAX_VISIBLE_CHUNKS) { return; }
+      outView->chunks[outView->chunkCount++] = ((u32)row * map.chunkColumns) + (u32)column;
+    }
+  }
+}
+
+internal void uploadTileChunk(TileChunk* chunk, const TileInstance* instances, u32 instanceCount) {
+  if(chunk->arrayObject == 0) {
+    glGenVertexArrays(1, &chunk->arrayObject);
+    glGenBuffers(1, &chunk->instanceBufferObject);
+    glBindVertexArray(chunk->arrayObject);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->instanceBufferObject);
+    glVertexAttribIPointer(TILEMAP_INSTANCE_ATTRIBUTE_INDEX, 2, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)0);
+    glEnableVertexAttribArray(TILEMAP_INSTANCE_ATTRIBUTE_INDEX);
+    glVertexAttribDivisor(TILEMAP_INSTANCE_ATTRIBUTE_INDEX, 1);
+    glBindVertexArray(0);
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->instanceBufferObject);
+  }
+  glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(TileInstance), instances, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  chunk->instanceCount = instanceCount;
+}
+
+// Bakes the view's dirty chunks and draws them, the tile map shader must be in use. Returns the number of tiles drawn.
+u32 drawTileMap(TileMap* map, const TileMapView& view, GLuint shaderId) {
+  GLint chunkOffsetLocation = glGetUniformLocation(shaderId, "chunkOffset");
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  TileInstance* instances = pushArray(tempMemory.arena, TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE, TileInstance);
+  u32 tileCount = 0;
+  for(u32 i = 0; i < view.chunkCount; ++i) {
+    u32 chunkIndex = view.chunks[i];
+    TileChunk* chunk = map->chunks + chunkIndex;
+    s32 bakedCount = -1;
+    {
+      std::lock_guard<std::mutex> lock(map->mutex);
+      if(chunk->dirty) {
+        bakedCount = (s32)bakeTileChunk(*map, chunkIndex, instances);
+        chunk->dirty = false;
+      }
+    }
+    if(bakedCount >= 0) { // uploaded outside of the lock so tile writes never wait on GL
+      uploadTileChunk(chunk, instances, (u32)bakedCount);
+      map->bakeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if(chunk->instanceCount == 0) { continue; }
+    glm::vec2 chunkOrigin = glm::vec2((f32)((chunkIndex % map->chunkColumns) * TILEMAP_CHUNK_SIZE), (f32)((chunkIndex / map->chunkColumns) * TILEMAP_CHUNK_SIZE));
+    glUniform2f(chunkOffsetLocation, chunkOrigin.x - view.origin.x, chunkOrigin.y - view.origin.y);
+    glBindVertexArray(chunk->arrayObject);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, chunk->instanceCount);
+    tileCount += chunk->instanceCount;
+  }
+  glBindVertexArray(0);
+  endTempMemory(tempMemory);
+  return tileCount;
+}
+
+// Cheap integer hash for procedural tiles
+internal inline u32 hashTile(u32 x, u32 y, u32 seed) {
+  u32 h = (x * 0x8DA6B343u) ^ (y * 0xD8163841u) ^ (seed * 0xCB1AB31Fu);
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return h;
+}
+
+// Patches of ground tiles with empty gaps between them, the patches follow an 8x8 tile grid.
+// Ground tiles are the first groundTileCount tiles of the atlas.
+void generateTileMap(TileMap* map, u32 groundTileCount, u32 seed) {
+  std::lock_guard<std::mutex> lock(map->mutex);
+  for(u32 y = 0; y < map->height; ++y) {
+    for(u32 x = 0; x < map->width; ++x) {
+      bool patch = (hashTile(x / 8, y / 8, seed) & 3) != 0;
+      u32 detail = hashTile(x, y, seed + 1);
+      map->tiles[((memory_index)y * map->width) + x] = patch ? (u16)(1 + (detail % groundTileCount)) : TILE_EMPTY;
+    }
+  }
+  for(u32 i = 0; i < map->chunkColumns * map->chunkRows; ++i) {
+    map->chunks[i].dirty = true;
+  }
+}
+
+// Flat colored tiles with a darker border, atlasDimens tiles of tilePixels squared. Pixels are RGBA, bottom row first.
+void generateTileAtlas(ivec2 atlasDimens, u32 tilePixels, OUT u8* outPixels) {
+  u32 atlasWidth = atlasDimens.x * tilePixels;
+  for(s32 tileY = 0; tileY < atlasDimens.y; ++tileY) {
+    for(s32 tileX = 0; tileX < atlasDimens.x; ++tileX) {
+      u32 color = hashTile(tileX, tileY, 7);
+      u8 r = (u8)(64 + (color & 0x7F)), g = (u8)(96 + ((color >> 8) & 0x7F)), b = (u8)(32 + ((color >> 16) & 0x3F));
+      for(u32 y = 0; y < tilePixels; ++y) {
+        for(u32 x = 0; x < tilePixels; ++x) {
+          bool border = x == 0 || y == 0 || x == tilePixels - 1 || y == tilePixels - 1;
+          u8* pixel = outPixels + ((((tileY * tilePixels) + y) * atlasWidth) + (tileX * tilePixels) + x) * 4;
+          pixel[0] = border ? r / 2 : r;
+          pixel[1] = border ? g / 2 : g;
+          pixel[2] = border ? b / 2 : b;
+          pixel[3] = 255;
+        }
+      }
+    }
+  }
+}
+
+// CPU side of a million tile map: a full bake, which is what any edit would cost with one buffer for the whole map,
+// against rebaking the one chunk an edit touches, plus the per frame visible chunk query. Results are printed to stdout.
+void benchmarkTileMap() {
+  const u32 mapSize = 1024;
+  const u32 viewCount = 100000;
+  const ivec2 viewDimens{ 16, 9 };
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  TileMap map;
+  initTileMap(&map, mapSize, mapSize);
+  generateTileMap(&map, 15, 1);
+  u32 chunkCount = map.chunkColumns * map.chunkRows;
+  TileInstance* instances = new TileInstance[TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE];
+
+  u64 instanceCount = 0;
+  u64 startCounter = getPerformanceCounter();
+  for(u32 i = 0; i < chunkCount; ++i) {
+    instanceCount += bakeTileChunk(map, i, instances);
+  }
+  f64 fullBakeSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  u64 checksum = 0;
+  startCounter = getPerformanceCounter();
+  for(u32 i = 0; i < chunkCount; ++i) {
+    u32 x = hashTile(i, 0, 3) % mapSize, y = hashTile(i, 1, 3) % mapSize;
+    setTile(&map, x, y, (u16)(1 + (i % 15)));
+    checksum += bakeTileChunk(map, ((y / TILEMAP_CHUNK_SIZE) * map.chunkColumns) + (x / TILEMAP_CHUNK_SIZE), instances);
+  }
+  f64 editSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  TileMapView view;
+  u64 visibleChunkCount = 0;
+  startCounter = getPerformanceCounter();
+  for(u32 i = 0; i < viewCount; ++i) {
+    glm::vec2 origin = glm::vec2((f32)(hashTile(i, 0, 5) % (mapSize * 16)) / 16.0f, (f32)(hashTile(i, 1, 5) % (mapSize * 16)) / 16.0f);
+    tileMapView(map, origin, viewDimens, &view);
+    visibleChunkCount += view.chunkCount;
+    checksum += view.chunks[0];
+  }
+  f64 viewSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+
+  printf("Tile map: %u x %u tiles (%llu non-empty) in %u chunks of %u x %u (checksum %llu)\n", mapSize, mapSize,
+         (unsigned long long)instanceCount, chunkCount, TILEMAP_CHUNK_SIZE, TILEMAP_CHUNK_SIZE, (unsigned long long)checksum);
+  printf("  full map bake:      %8.3f ms\n", fullBakeSeconds * 1000.0);
+  printf("  tile edit + rebake: %8.3f us per edit\n", editSeconds * 1000000.0 / chunkCount);
+  printf("  visible chunks:     %8.3f us per %d x %d view (%.2f chunks on average)\n", viewSeconds * 1000000.0 / viewCount,
+         viewDimens.x, viewDimens.y, (f64)visibleChunkCount / viewCount);
+
+  delete[] instances;
+  deinitTileMap(&map); // nothing was uploaded, no GL calls
+}
\ No newline at end of file
@@ -0,0 +1,478 @@
+#pragma once
+
+// Transform hierarchy
+// Local translation/rotation/scale are stored in structure-of-arrays form so the local matrices of
+// TRANSFORM_SIMD_WIDTH nodes are built at once. Nodes are only ever appended after their parent, so walking the
+// arrays front to back visits parents before children. World matrices are only recomputed for nodes whose
+// local transform changed or whose parent's world matrix changed.
+// Large hierarchies are updated in parallel one depth level at a time through a breadth first ordering.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TRANSFORM_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SIMD_WIDTH 4
+#else
+#define TRANSFORM_SIMD_WIDTH 1
+#endif
+
+#define TRANSFORM_NO_PARENT U32_MAX
+#define TRANSFORM_ALIGNMENT 32
+#define TRANSFORM_PARALLEL_MIN_COUNT 16384 // below this jobs cost more than they save
+#define TRANSFORM_PARALLEL_BATCH_SIZE 2048 // multiple of TRANSFORM_SIMD_WIDTH
+
+struct TransformHierarchy {
+  // local transform
+  f32* translationX;
+  f32* translationY;
+  f32* translationZ;
+  f32* rotationX; // unit quaternion
+  f32* rotationY;
+  f32* rotationZ;
+  f32* rotationW;
+  f32* scaleX;
+  f32* scaleY;
+  f32* scaleZ;
+
+  u32* parents; // TRANSFORM_NO_PARENT or an index lower than the node's own
+  u32* depths;
+  u8* localDirty; // local transform changed since the last update
+  u8* worldChanged; // world matrix was recomputed by the last update
+  glm::mat4* localMats;
+  glm::mat4* worldMats;
+
+  // breadth first order, levelOrder[levelStarts[d]..levelStarts[d+1]] are the nodes at depth d
+  u32* levelOrder;
+  u32* levelStarts;
+  u32 levelCount;
+  bool levelsValid;
+
+  u32 count;
+  u32 capacity; // always a multiple of TRANSFORM_SIMD_WIDTH
+  u8* memory;
+};
+
+void initTransformHierarchy(TransformHierarchy* hierarchy, u32 capacity) {
+  *hierarchy = {};
+  hierarchy->capacity = ((capacity + TRANSFORM_SIMD_WIDTH - 1) / TRANSFORM_SIMD_WIDTH) * TRANSFORM_SIMD_WIDTH;
+  u32 cap = hierarchy->capacity;
+
+  auto alignedSize = [](memory_index size) -> memory_index { return (size + TRANSFORM_ALIGNMENT - 1) & ~(memory_index)(TRANSFORM_ALIGNMENT - 1); };
+  memory_index floatArraySize = alignedSize(cap * sizeof(f32));
+  memory_index u32ArraySize = alignedSize(cap * sizeof(u32));
+  memory_index u8ArraySize = alignedSize(cap * sizeof(u8));
+  memory_index matArraySize = alignedSize(cap * sizeof(glm::mat4));
+  memory_index totalSize = (floatArraySize * 10) + (u32ArraySize * 3) + alignedSize((cap + 1) * sizeof(u32)) + (u8ArraySize * 2) + (matArraySize * 2);
+  hierarchy->memory = (u8*)operator new(totalSize, std::align_val_t(TRANSFORM_ALIGNMENT));
+  memset(hierarchy->memory, 0, totalSize);
+
+  u8* cursor = hierarchy->memory;
+  f32** floatArrays[] = { &hierarchy->translationX, &hierarchy->translationY, &hierarchy->translationZ,
+                          &hierarchy->rotationX, &hierarchy->rotationY, &hierarchy->rotationZ, &hierarchy->rotationW,
+                          &hierarchy->scaleX, &hierarchy->scaleY, &hierarchy->scaleZ };
+  for(u32 i = 0; i < ArrayCount(floatArrays); ++i) {
+    *floatArrays[i] = (f32*)cursor;
+    cursor += floatArraySize;
+  }
+  hierarchy->parents = (u32*)cursor; cursor += u32ArraySize;
+  hierarchy->depths = (u32*)cursor; cursor += u32ArraySize;
+  hierarchy->levelOrder = (u32*)cursor; cursor += u32ArraySize;
+  hierarchy->levelStarts = (u32*)cursor; cursor += alignedSize((cap + 1) * sizeof(u32));
+  hierarchy->localDirty = cursor; cursor += u8ArraySize;
+  hierarchy->worldChanged = cursor; cursor += u8ArraySize;
+  hierarchy->localMats = (glm::mat4*)cursor; cursor += matArraySize;
+  hierarchy->worldMats = (glm::mat4*)cursor; cursor += matArraySize;
+  assert(cursor == hierarchy->memory + totalSize);
+}
+
+void deinitTransformHierarchy(TransformHierarchy* hierarchy) {
+  operator delete(hierarchy->memory, std::align_val_t(TRANSFORM_ALIGNMENT));
+  *hierarchy = {}; // clear to zero
+}
+
+inline void clearTransformHierarchy(TransformHierarchy* hierarchy) {
+  hierarchy->count = 0;
+  hierarchy->levelsValid = false;
+}
+
+void setLocalTransform(TransformHierarchy* hierarchy, u32 index, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+  assert(index < hierarchy->count);
+  hierarchy->translationX[index] = translation.x;
+  hierarchy->translationY[index] = translation.y;
+  hierarchy->translationZ[index] = translation.z;
+  hierarchy->rotationX[index] = rotation.x;
+  hierarchy->rotationY[index] = rotation.y;
+  hierarchy->rotationZ[index] = rotation.z;
+  hierarchy->rotationW[index] = rotation.w;
+  hierarchy->scaleX[index] = scale.x;
+  hierarchy->scaleY[index] = scale.y;
+  hierarchy->scaleZ[index] = scale.z;
+  hierarchy->localDirty[index] = true;
+}
+
+void setLocalTranslation(TransformHierarchy* hierarchy, u32 index, const glm::vec3& translation) {
+  assert(index < hierarchy->count);
+  hierarchy->translationX[index] = translation.x;
+  hierarchy->translationY[index] = translation.y;
+  hierarchy->translationZ[index] = translation.z;
+  hierarchy->localDirty[index] = true;
+}
+
+void setLocalRotation(TransformHierarchy* hierarchy, u32 index, const glm::quat& rotation) {
+  assert(index < hierarchy->count);
+  hierarchy->rotationX[index] = rotation.x;
+  hierarchy->rotationY[index] = rotation.y;
+  hierarchy->rotationZ[index] = rotation.z;
+  hierarchy->rotationW[index] = rotation.w;
+  hierarchy->localDirty[index] = true;
+}
+
+// Returns the index of the new node, which stays valid for the life of the hierarchy.
+// parent must already be in the hierarchy, which keeps the arrays sorted parents first.
+u32 addTransform(TransformHierarchy* hierarchy, u32 parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+  assert(hierarchy->count < hierarchy->capacity && "ERROR: TransformHierarchy is full!");
+  assert((parent == TRANSFORM_NO_PARENT || parent < hierarchy->count) && "ERROR: Transform parent must be added before its children!");
+  u32 index = hierarchy->count++;
+  hierarchy->parents[index] = parent;
+  hierarchy->depths[index] = (parent == TRANSFORM_NO_PARENT) ? 0 : hierarchy->depths[parent] + 1;
+  hierarchy->levelsValid = false;
+  setLocalTransform(hierarchy, index, translation, rotation, scale);
+  return index;
+}
+
+inline const glm::mat4& worldMat(const TransformHierarchy& hierarchy, u32 index) {
+  assert(index < hierarchy.count);
+  return hierarchy.worldMats[index];
+}
+
+// glTF node matrices are required to be decomposable into TRS
+void decomposeTransform(const glm::mat4& mat, glm::vec3* outTranslation, glm::quat* outRotation, glm::vec3* outScale) {
+  *outTranslation = glm::vec3(mat[3]);
+  glm::vec3 columns[3] = { glm::vec3(mat[0]), glm::vec3(mat[1]), glm::vec3(mat[2]) };
+  *outScale = glm::vec3(length(columns[0]), length(columns[1]), length(columns[2]));
+  if(dot(cross(columns[0], columns[1]), columns[2]) < 0.0f) { // mirrored
+    outScale->x = -outScale->x;
+  }
+  for(u32 i = 0; i < 3; ++i) {
+    columns[i] = ((*outScale)[i] != 0.0f) ? columns[i] / (*outScale)[i] : columns[i];
+  }
+
+  // source: "Quaternion Calculus and Fast Animation", Shoemake 1987
+  f32 trace = columns[0].x + columns[1].y + columns[2].z;
+  glm::quat rotation;
+  if(trace > 0.0f) {
+    f32 s = sqrtf(trace + 1.0f) * 2.0f;
+    rotation = glm::quat(0.25f * s, (columns[1].z - columns[2].y) / s, (columns[2].x - columns[0].z) / s, (columns[0].y - columns[1].x) / s);
+  } else if(columns[0].x > columns[1].y && columns[0].x > columns[2].z) {
+    f32 s = sqrtf(1.0f + columns[0].x - columns[1].y - columns[2].z) * 2.0f;
+    rotation = glm::quat((columns[1].z - columns[2].y) / s, 0.25f * s, (columns[1].x + columns[0].y) / s, (columns[2].x + columns[0].z) / s);
+  } else if(columns[1].y > columns[2].z) {
+    f32 s = sqrtf(1.0f + columns[1].y - columns[0].x - columns[2].z) * 2.0f;
+    rotation = glm::quat((columns[2].x - columns[0].z) / s, (columns[1].x + columns[0].y) / s, 0.25f * s, (columns[2].y + columns[1].z) / s);
+  } else {
+    f32 s = sqrtf(1.0f + columns[2].z - columns[0].x - columns[1].y) * 2.0f;
+    rotation = glm::quat((columns[0].y - columns[1].x) / s, (columns[2].x + columns[0].z) / s, (columns[2].y + columns[1].z) / s, 0.25f * s);
+  }
+  *outRotation = normalize(rotation);
+}
+
+// out = a * b, out may alias either input
+internal inline void multiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4* out) {
+  const f32* aPtr = (const f32*)&a;
+  const f32* bPtr = (const f32*)&b;
+  f32* outPtr = (f32*)out;
+#if TRANSFORM_SIMD_WIDTH == 8
+  // two result columns per iteration
+  __m256 a0 = _mm256_broadcast_ps((const __m128*)(aPtr + 0));
+  __m256 a1 = _mm256_broadcast_ps((const __m128*)(aPtr + 4));
+  __m256 a2 = _mm256_broadcast_ps((const __m128*)(aPtr + 8));
+  __m256 a3 = _mm256_broadcast_ps((const __m128*)(aPtr + 12));
+  __m256 b01 = _mm256_loadu_ps(bPtr);
+  __m256 b23 = _mm256_loadu_ps(bPtr + 8);
+  __m256 r01 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0))),
+                                           _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1)))),
+                             _mm256_add_ps(_mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2))),
+                                           _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3)))));
+  __m256 r23 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0))),
+                                           _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1)))),
+                             _mm256_add_ps(_mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2))),
+                                           _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3)))));
+  _mm256_storeu_ps(outPtr, r01);
+  _mm256_storeu_ps(outPtr + 8, r23);
+#elif TRANSFORM_SIMD_WIDTH == 4
+  __m128 a0 = _mm_loadu_ps(aPtr + 0);
+  __m128 a1 = _mm_loadu_ps(aPtr + 4);
+  __m128 a2 = _mm_loadu_ps(aPtr + 8);
+  __m128 a3 = _mm_loadu_ps(aPtr + 12);
+  __m128 result[4];
+  for(u32 column = 0; column < 4; ++column) {
+    const f32* bColumn = bPtr + (column * 4);
+    result[column] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bColumn[0])), _mm_mul_ps(a1, _mm_set1_ps(bColumn[1]))),
+                                _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bColumn[2])), _mm_mul_ps(a3, _mm_set1_ps(bColumn[3]))));
+  }
+  for(u32 column = 0; column < 4; ++column) {
+    _mm_storeu_ps(outPtr + (column * 4), result[column]);
+  }
+#else
+  *out = a * b;
+#endif
+}
+
+#if TRANSFORM_SIMD_WIDTH > 1
+// Each register holds one matrix element of 4 nodes, transposing turns them into one column per node
+internal inline void storeMat4Column4(glm::mat4* outMats, u32 column, __m128 row0, __m128 row1, __m128 row2, __m128 row3) {
+  _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+  _mm_storeu_ps(&outMats[0][column][0], row0);
+  _mm_storeu_ps(&outMats[1][column][0], row1);
+  _mm_storeu_ps(&outMats[2][column][0], row2);
+  _mm_storeu_ps(&outMats[3][column][0], row3);
+}
+#endif
+
+// local = translate * rotate * scale, for nodes [begin, end). begin must be a multiple of TRANSFORM_SIMD_WIDTH.
+// Groups without a dirty node are skipped.
+internal void updateLocalMatRange(TransformHierarchy* hierarchy, u32 begin, u32 end) {
+  const TransformHierarchy* h = hierarchy;
+#if TRANSFORM_SIMD_WIDTH == 8
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for(u32 i = begin; i < end; i += 8) {
+    u64 groupDirty;
+    memcpy(&groupDirty, h->localDirty + i, sizeof(groupDirty));
+    if(groupDirty == 0) { continue; }
+
+    __m256 x = _mm256_load_ps(h->rotationX + i), y = _mm256_load_ps(h->rotationY + i);
+    __m256 z = _mm256_load_ps(h->rotationZ + i), w = _mm256_load_ps(h->rotationW + i);
+    __m256 sx = _mm256_load_ps(h->scaleX + i), sy = _mm256_load_ps(h->scaleY + i), sz = _mm256_load_ps(h->scaleZ + i);
+    __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+    __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+    __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+    __m256 elements[12]; // column major, 3 rows per column, the 4th column is the translation
+    elements[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+    elements[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+    elements[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+    elements[3] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+    elements[4] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+    elements[5] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+    elements[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+    elements[7] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+    elements[8] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+    elements[9] = _mm256_load_ps(h->translationX + i);
+    elements[10] = _mm256_load_ps(h->translationY + i);
+    elements[11] = _mm256_load_ps(h->translationZ + i);
+
+    for(u32 half = 0; half < 2; ++half) {
+      glm::mat4* outMats = h->localMats + i + (half * 4);
+      __m128 e[12];
+      for(u32 j = 0; j < 12; ++j) {
+        e[j] = half == 0 ? _mm256_castps256_ps128(elements[j]) : _mm256_extractf128_ps(elements[j], 1);
+      }
+      storeMat4Column4(outMats, 0, e[0], e[1], e[2], zero);
+      storeMat4Column4(outMats, 1, e[3], e[4], e[5], zero);
+      storeMat4Column4(outMats, 2, e[6], e[7], e[8], zero);
+      storeMat4Column4(outMats, 3, e[9], e[10], e[11], _mm256_castps256_ps128(one));
+    }
+  }
+#elif TRANSFORM_SIMD_WIDTH == 4
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for(u32 i = begin; i < end; i += 4) {
+    u32 groupDirty;
+    memcpy(&groupDirty, h->localDirty + i, sizeof(groupDirty));
+    if(groupDirty == 0) { continue; }
+
+    __m128 x = _mm_load_ps(h->rotationX + i), y = _mm_load_ps(h->rotationY + i);
+    __m128 z = _mm_load_ps(h->rotationZ + i), w = _mm_load_ps(h->rotationW + i);
+    __m128 sx = _mm_load_ps(h->scaleX + i), sy = _mm_load_ps(h->scaleY + i), sz = _mm_load_ps(h->scaleZ + i);
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    glm::mat4* outMats = h->localMats + i;
+    storeMat4Column4(outMats, 0,
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+                     zero);
+    storeMat4Column4(outMats, 1,
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+                     zero);
+    storeMat4Column4(outMats, 2,
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                     _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                     _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                     zero);
+    storeMat4Column4(outMats, 3, _mm_load_ps(h->translationX + i), _mm_load_ps(h->translationY + i), _mm_load_ps(h->translationZ + i), one);
+  }
+#else
+  for(u32 i = begin; i < end; ++i) {
+    if(!h->localDirty[i]) { continue; }
+    glm::quat rotation(h->rotationW[i], h->rotationX[i], h->rotationY[i], h->rotationZ[i]);
+    glm::mat4 local = glm::mat4_cast(rotation);
+    local[0] = local[0] * h->scaleX[i];
+    local[1] = local[1] * h->scaleY[i];
+    local[2] = local[2] * h->scaleZ[i];
+    local[3] = glm::vec4(h->translationX[i], h->translationY[i], h->translationZ[i], 1.0f);
+    h->localMats[i] = local;
+  }
+#endif
+}
+
+internal inline void updateWorldMat(TransformHierarchy* hierarchy, u32 index) {
+  u32 parent = hierarchy->parents[index];
+  bool changed = hierarchy->localDirty[index] || (parent != TRANSFORM_NO_PARENT && hierarchy->worldChanged[parent]);
+  hierarchy->worldChanged[index] = changed;
+  if(!changed) { return; }
+  if(parent == TRANSFORM_NO_PARENT) {
+    hierarchy->worldMats[index] = hierarchy->localMats[index];
+  } else {
+    multiplyMat4(hierarchy->worldMats[parent], hierarchy->localMats[index], hierarchy->worldMats + index);
+  }
+}
+
+internal void buildTransformLevels(TransformHierarchy* hierarchy) {
+  u32* levelStarts = hierarchy->levelStarts;
+  u32 levelCount = 0;
+  memset(levelStarts, 0, (hierarchy->count + 1) * sizeof(u32));
+  for(u32 i = 0; i < hierarchy->count; ++i) {
+    levelStarts[hierarchy->depths[i] + 1]++;
+    levelCount = Max(levelCount, hierarchy->depths[i] + 1);
+  }
+  for(u32 level = 0; level < levelCount; ++level) {
+    levelStarts[level + 1] += levelStarts[level];
+  }
+  // counting sort by depth, stable so each level stays in index order
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  u32* levelFill = pushArray(tempMemory.arena, levelCount, u32);
+  memcpy(levelFill, levelStarts, levelCount * sizeof(u32));
+  for(u32 i = 0; i < hierarchy->count; ++i) {
+    hierarchy->levelOrder[levelFill[hierarchy->depths[i]]++] = i;
+  }
+  endTempMemory(tempMemory);
+  hierarchy->levelCount = levelCount;
+  hierarchy->levelsValid = true;
+}
+
+// Recomputes the world matrices of every node whose local transform or ancestors changed since the last update
+void updateTransforms(TransformHierarchy* hierarchy) {
+  u32 count = hierarchy->count;
+  if(count == 0) { return; }
+  u32 simdCount = ((count + TRANSFORM_SIMD_WIDTH - 1) / TRANSFORM_SIMD_WIDTH) * TRANSFORM_SIMD_WIDTH;
+
+  if(count < TRANSFORM_PARALLEL_MIN_COUNT || jobThreadCount() == 1) {
+    updateLocalMatRange(hierarchy, 0, simdCount);
+    for(u32 i = 0; i < count; ++i) {
+      updateWorldMat(hierarchy, i);
+    }
+  } else {
+    parallelFor(simdCount, TRANSFORM_PARALLEL_BATCH_SIZE, [hierarchy](u32 begin, u32 end) {
+      updateLocalMatRange(hierarchy, begin, end);
+    });
+    // every parent is finished by the time its children's level starts
+    if(!hierarchy->levelsValid) {
+      buildTransformLevels(hierarchy);
+    }
+    for(u32 level = 0; level < hierarchy->levelCount; ++level) {
+      const u32* levelNodes = hierarchy->levelOrder + hierarchy->levelStarts[level];
+      u32 levelSize = hierarchy->levelStarts[level + 1] - hierarchy->levelStarts[level];
+      parallelFor(levelSize, TRANSFORM_PARALLEL_BATCH_SIZE, [hierarchy, levelNodes](u32 begin, u32 end) {
+        for(u32 i = begin; i < end; ++i) {
+          updateWorldMat(hierarchy, levelNodes[i]);
+        }
+      });
+    }
+  }
+
+  memset(hierarchy->localDirty, 0, count * sizeof(u8));
+}
+
+void benchmarkTransforms() {
+  const u32 nodeCount = 100000;
+  const u32 repetitions = 20;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+
+  TransformHierarchy hierarchy;
+  initTransformHierarchy(&hierarchy, nodeCount);
+  glm::vec3* translations = new glm::vec3[nodeCount];
+  glm::quat* rotations = new glm::quat[nodeCount];
+  glm::vec3* scales = new glm::vec3[nodeCount];
+  u32* parents = new u32[nodeCount];
+  glm::mat4* baselineWorldMats = new glm::mat4[nodeCount];
+
+  // random tree with a branching factor around 4, roughly 9 levels deep
+  u32 randomState = 0x9E3779B9;
+  auto randomUnit = [&randomState]() { // xorshift32
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (f32)(randomState >> 8) / (f32)(1 << 24);
+  };
+  for(u32 i = 0; i < nodeCount; ++i) {
+    parents[i] = (i == 0) ? TRANSFORM_NO_PARENT : (i - 1) / 4;
+    translations[i] = glm::vec3(randomUnit() * 2.0f - 1.0f, randomUnit() * 2.0f - 1.0f, randomUnit() * 2.0f - 1.0f);
+    rotations[i] = normalize(glm::quat(randomUnit() * 2.0f - 1.0f, randomUnit() * 2.0f - 1.0f, randomUnit() * 2.0f - 1.0f, randomUnit() * 2.0f - 1.0f));
+    scales[i] = glm::vec3(0.9f + randomUnit() * 0.2f);
+    addTransform(&hierarchy, parents[i], translations[i], rotations[i], scales[i]);
+  }
+
+  // baseline: what scene() did per object, glm matrices composed one node at a time
+  u64 start = getPerformanceCounter();
+  for(u32 rep = 0; rep < repetitions; ++rep) {
+    for(u32 i = 0; i < nodeCount; ++i) {
+      glm::mat4 local = glm::translate(glm::mat4(), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(), scales[i]);
+      baselineWorldMats[i] = (parents[i] == TRANSFORM_NO_PARENT) ? local : baselineWorldMats[parents[i]] * local;
+    }
+  }
+  f64 baselineMs = (getPerformanceCounter() - start) * secondsPerCounter * 1000.0 / repetitions;
+
+  auto timeUpdate = [&](f32 dirtyFraction) -> f64 {
+    u32 dirtyStride = (u32)(1.0f / dirtyFraction);
+    f64 totalSeconds = 0.0;
+    for(u32 rep = 0; rep < repetitions; ++rep) {
+      for(u32 i = dirtyStride - 1; i < nodeCount; i += dirtyStride) {
+        setLocalRotation(&hierarchy, i, rotations[i]);
+      }
+      u64 updateStart = getPerformanceCounter();
+      updateTransforms(&hierarchy);
+      totalSeconds += (getPerformanceCounter() - updateStart) * secondsPerCounter;
+    }
+    return totalSeconds * 1000.0 / repetitions;
+  };
+
+  u32 maxThreadCount = jobThreadCount();
+  JobSystem* scalingJobs = new JobSystem(); // the global job system keeps serving everything else
+  printf("Transform hierarchy benchmark (%u nodes, %u levels, SIMD width %u)\n", nodeCount, hierarchy.depths[nodeCount - 1] + 1, TRANSFORM_SIMD_WIDTH);
+  printf("  glm per node:              %8.3f ms\n", baselineMs);
+  for(u32 threadCount = 1; ; threadCount = Min(threadCount * 2, maxThreadCount)) {
+    initJobSystem(threadCount, scalingJobs);
+    f64 allDirtyMs = timeUpdate(1.0f);
+    f64 someDirtyMs = timeUpdate(0.01f);
+    deinitJobSystem(scalingJobs);
+    printf("  SoA, %2u thread(s): all dirty %8.3f ms (%5.2fx) | 1%% dirty %8.3f ms\n", threadCount, allDirtyMs, baselineMs / allDirtyMs, someDirtyMs);
+    if(threadCount == maxThreadCount) { break; }
+  }
+  delete scalingJobs;
+
+  // the hierarchy holds the same TRS as the baseline, every world matrix was recomputed by the all dirty updates
+  f32 maxError = 0.0f;
+  for(u32 i = 0; i < nodeCount; ++i) {
+    for(u32 column = 0; column < 4; ++column) {
+      glm::vec4 difference = abs(worldMat(hierarchy, i)[column] - baselineWorldMats[i][column]);
+      maxError = Max(maxError, Max(Max(difference.x, difference.y), Max(difference.z, difference.w)));
+    }
+  }
+  printf("  max difference from glm: %g\n", maxError);
+
+  delete[] translations;
+  delete[] rotations;
+  delete[] scales;
+  delete[] parents;
+  delete[] baselineWorldMats;
+  deinitTransformHierarchy(&hierarchy);
+}
\ No newline at end of file
@@ -24,6 +24,10 @@ typedef size_t memory_index;
 #define internal static // file private function
 #define global static // global variables
 
+#ifndef OUT // windows.h defines it the same way
+#define OUT // output parameter
+#endif
+
 #define ArrayCount(Array) (sizeof(Array) / sizeof((Array)[0]))
 
 #define Pi32 3.14159265359f
@@ -31,6 +35,7 @@ typedef size_t memory_index;
 #define Tau32 6.28318530717958647692f
 #define RadiansPerDegree (Pi32 / 180.0f)
 #define Radians(x) (x * RadiansPerDegree)
+#define U16_MAX 0xFFFF
 #define U32_MAX ~0u
 
 #define Kilobytes(Value) ((Value)*1024LL)
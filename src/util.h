@@ -5,6 +5,11 @@ struct Box {
   glm::vec3 diagonal;
 };
 
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;
+};
+
 struct Stopwatch {
   u64 lastPerfCounter;
   f64 secondsPerPerfCounter;
@@ -12,6 +17,64 @@ struct Stopwatch {
   f64 deltaSeconds;
 };
 
+inline glm::vec3 boxMax(const Box& box) { return box.min + box.diagonal; }
+inline glm::vec3 boxCenter(const Box& box) { return box.min + (box.diagonal * 0.5f); }
+
+Box boxFromMinMax(glm::vec3 min, glm::vec3 max) {
+  Box result;
+  result.min = min;
+  result.diagonal = max - min;
+  return result;
+}
+
+Box mergeBoxes(const Box& a, const Box& b) {
+  return boxFromMinMax(glm::min(a.min, b.min), glm::max(boxMax(a), boxMax(b)));
+}
+
+// Axis aligned box enclosing the transformed box
+// source: "Transforming Axis-Aligned Bounding Boxes", James Arvo, Graphics Gems 1990
+Box transformBox(const Box& box, const glm::mat4& mat) {
+  glm::vec3 extent = box.diagonal * 0.5f;
+  glm::vec4 center = mat * glm::vec4(boxCenter(box), 1.0f);
+  glm::vec3 transformedExtent;
+  for(u32 row = 0; row < 3; ++row) {
+    transformedExtent[row] = fabsf(mat[0][row]) * extent.x + fabsf(mat[1][row]) * extent.y + fabsf(mat[2][row]) * extent.z;
+  }
+  Box result;
+  result.min = glm::vec3(center.x, center.y, center.z) - transformedExtent;
+  result.diagonal = transformedExtent * 2.0f;
+  return result;
+}
+
+bool boxesOverlap(const Box& a, const Box& b) {
+  glm::vec3 aMax = boxMax(a);
+  glm::vec3 bMax = boxMax(b);
+  return a.min.x <= bMax.x && b.min.x <= aMax.x &&
+         a.min.y <= bMax.y && b.min.y <= aMax.y &&
+         a.min.z <= bMax.z && b.min.z <= aMax.z;
+}
+
+// slab test, invDirection is 1 / ray.direction per component
+// returns whether the ray hits the box between [0, maxT], outT is the entry distance
+bool rayIntersectsBox(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& boxMin, const glm::vec3& boxMax, f32 maxT, f32* outT) {
+  f32 tMin = 0.0f;
+  f32 tMax = maxT;
+  for(u32 axis = 0; axis < 3; ++axis) {
+    f32 t0 = (boxMin[axis] - origin[axis]) * invDirection[axis];
+    f32 t1 = (boxMax[axis] - origin[axis]) * invDirection[axis];
+    if(t0 > t1) { f32 swap = t0; t0 = t1; t1 = swap; }
+    tMin = Max(tMin, t0);
+    tMax = Min(tMax, t1);
+  }
+  *outT = tMin;
+  return tMin <= tMax;
+}
+
+f32 surfaceArea(const Box& box) {
+  const glm::vec3& d = box.diagonal;
+  return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
 bool flagIsSet(b32 flags, b32 queryFlag) { return (flags & queryFlag); } // ensure the values are 0/1
 bool flagsAreSet(b32 flags, b32 queryFlags) { return ((flags & queryFlags) == queryFlags); }
 void setFlags(b32* outFlags, b32 newFlags) { *outFlags |= newFlags; }
@@ -51,73 +114,208 @@ struct RingSampler {
 template <typename T, u32 maxCount>
 struct Stack {
   T slots[maxCount];
-  u32 top;
+  u32 top = 0;
 
-  bool empty() { return top > 0; }
-  bool full() { return top == maxCount; }
-  u32 count() { return top; }
+  bool empty() const { return top == 0; }
+  bool full() const { return top == maxCount; }
+  u32 count() const { return top; }
   T pop() {
     assert(!empty());
-    return slots[top--];
+    return slots[--top];
   }
   void push(T item) {
     assert(!full());
     slots[top++] = item;
   }
-  void pushBatch(std::function<T(u64)>& itemPerIndex, u32 count) {
-    u64 newTop = top + count;
-    assert(newTop <= maxCount && "ERROR: Filling Stack with too many elements.");
-    for(u64 i = 0; i < count; i++) {
+  template <typename ItemPerIndex> // T(u32 index)
+  void pushBatch(const ItemPerIndex& itemPerIndex, u32 count) {
+    assert(top + count <= maxCount && "ERROR: Filling Stack with too many elements.");
+    for(u32 i = 0; i < count; i++) {
       slots[top + i] = itemPerIndex(i);
     }
-    top = newTop;
+    top += count;
   }
 };
 
 namespace Generation {
-  template <typename T>
-  struct Item {
-    T value;
-    u64 generation;
+  // slot selects an entry in the sparse table, generation invalidates handles to removed values
+  struct Index {
+    u32 value;
+    u32 generation;
   };
-  typedef Item<u64> Index;
 
-  template <typename T, u64 maxCount>
+  // never handed out, no map contains it
+  constexpr Index invalidIndex = { U32_MAX, 0 };
+
+  // Slot map
+  // Values are packed densely so iteration is linear in memory. Handles go through a sparse slot table
+  // that points into the dense array, removal swaps the last value into the hole and patches its slot.
+  // Free slots form a linked list through their denseIndex.
+  template <typename T>
   struct Map {
-  public:
-    Item<T> items[maxCount];
-    Stack<u64, maxCount> unusedSlots;
-
-    Map() {
-      // Fill stack bottom up so pops go from 0 to maxCount - 1
-      u64 lastElement = maxCount - 1;
-      unusedSlots.pushBatch([lastElement](u64 index){ return lastElement - index; }, maxCount);
+    struct Slot {
+      u32 denseIndex; // next free slot while unused
+      u32 generation;
+    };
+
+    T* values;
+    u32* denseToSlot;
+    Slot* slots;
+    u32 valueCount;
+    u32 slotCount; // slots handed out at least once
+    u32 capacity;
+    u32 freeSlotHead;
+    bool growable;
+
+    explicit Map(u32 initialCapacity = 64, bool isGrowable = true) : values(nullptr), denseToSlot(nullptr), slots(nullptr), valueCount(0),
+                                                                   slotCount(0), capacity(0), freeSlotHead(U32_MAX), growable(isGrowable) {
+      reserve(Max(initialCapacity, 1u));
+    }
+    ~Map() {
+      delete[] values;
+      delete[] denseToSlot;
+      delete[] slots;
+    }
+    Map(const Map&) = delete;
+    Map& operator=(const Map&) = delete;
+
+    void reserve(u32 newCapacity) {
+      if(newCapacity <= capacity) { return; }
+      T* newValues = new T[newCapacity];
+      u32* newDenseToSlot = new u32[newCapacity];
+      Slot* newSlots = new Slot[newCapacity];
+      for(u32 i = 0; i < valueCount; ++i) { newValues[i] = std::move(values[i]); }
+      if(capacity > 0) { // nothing allocated before the first reserve
+        memcpy(newDenseToSlot, denseToSlot, valueCount * sizeof(u32));
+        memcpy(newSlots, slots, slotCount * sizeof(Slot));
+      }
+      delete[] values;
+      delete[] denseToSlot;
+      delete[] slots;
+      values = newValues;
+      denseToSlot = newDenseToSlot;
+      slots = newSlots;
+      capacity = newCapacity;
+    }
+
+    // invalidIndex when the map is full and cannot grow
+    Index put(const T& value) {
+      if(valueCount == capacity) {
+        assert(growable && "ERROR: Generation::Map is full!");
+        if(!growable) { return invalidIndex; }
+        reserve(capacity * 2);
+      }
+      u32 slotIndex;
+      if(freeSlotHead != U32_MAX) {
+        slotIndex = freeSlotHead;
+        freeSlotHead = slots[slotIndex].denseIndex;
+      } else {
+        slotIndex = slotCount++;
+        slots[slotIndex].generation = 0;
+      }
+      u32 denseIndex = valueCount++;
+      slots[slotIndex].denseIndex = denseIndex;
+      values[denseIndex] = value;
+      denseToSlot[denseIndex] = slotIndex;
+      return Index{ slotIndex, slots[slotIndex].generation };
     }
 
-    Index put(T value) {
-      assert(!unusedSlots.empty() && "ERROR: Generation::Map is full!");
-      u64 slot = unusedSlots.pop();
-      items[slot].value = value;
-      Index index;
-      index.value = slot;
-      index.generation = items[slot].generation;
-      return index;
+    bool contains(Index index) const {
+      return index.value < slotCount && slots[index.value].generation == index.generation;
     }
 
     void remove(Index index) {
-      assert(index.value < maxCount);
-      assert(index.generation == items[index.value].generation);
-      items[index.value].generation++;
-      unusedSlots.push(index.value);
+      assert(contains(index) && "ERROR: Attempting to remove GenerationMap item with expired generation!");
+      Slot& slot = slots[index.value];
+      u32 lastDenseIndex = --valueCount;
+      if(slot.denseIndex != lastDenseIndex) {
+        values[slot.denseIndex] = std::move(values[lastDenseIndex]);
+        denseToSlot[slot.denseIndex] = denseToSlot[lastDenseIndex];
+        slots[denseToSlot[slot.denseIndex]].denseIndex = slot.denseIndex;
+      }
+      slot.generation++;
+      slot.denseIndex = freeSlotHead;
+      freeSlotHead = index.value;
+    }
+
+    // nullptr if the handle has expired
+    T* get(Index index) {
+      return contains(index) ? values + slots[index.value].denseIndex : nullptr;
+    }
+
+    T& at(Index index) {
+      assert(contains(index) && "ERROR: Attempting to access GenerationMap item with expired generation!");
+      return values[slots[index.value].denseIndex];
     }
 
-    T at(Index index) {
-      assert(index.value < maxCount);
-      Item item = items[index.value];
-      assert(item.generation == index.generation && "ERROR: Attempting to access GenerationMap item with expired generation!");
-      return item.value;
+    // handle of the value at a dense position, for use while iterating
+    Index indexAt(u32 denseIndex) const {
+      assert(denseIndex < valueCount);
+      u32 slotIndex = denseToSlot[denseIndex];
+      return Index{ slotIndex, slots[slotIndex].generation };
     }
 
-    u64 count() { return maxCount - unusedSlots.count(); }
+    u32 count() const { return valueCount; }
+    T* begin() { return values; }
+    T* end() { return values + valueCount; }
   };
+}
+
+// Generation::Map vs std::unordered_map at 1M entries, results are printed to stdout
+void benchmarkGenerationMap() {
+  const u32 entryCount = 1000000;
+  const f64 secondsPerCounter = 1.0 / getPerformanceCounterFrequencyPerSecond();
+  auto elapsedMs = [secondsPerCounter](u64 startCounter) { return (getPerformanceCounter() - startCounter) * secondsPerCounter * 1000.0; };
+
+  // random visiting order, xorshift shuffle
+  u32* order = new u32[entryCount];
+  for(u32 i = 0; i < entryCount; ++i) { order[i] = i; }
+  u32 rngState = 0x9E3779B9;
+  for(u32 i = entryCount - 1; i > 0; --i) {
+    rngState ^= rngState << 13; rngState ^= rngState >> 17; rngState ^= rngState << 5;
+    u32 j = rngState % (i + 1);
+    u32 swap = order[i]; order[i] = order[j]; order[j] = swap;
+  }
+
+  f32 checksum = 0.0f; // keeps the optimizer from removing the work
+  printf("Generation::Map vs std::unordered_map (%u entries, glm::vec4 values)\n", entryCount);
+
+  { // Generation::Map
+    Generation::Map<glm::vec4> map(entryCount, false);
+    Generation::Index* handles = new Generation::Index[entryCount];
+    u64 start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { handles[i] = map.put(glm::vec4((f32)i)); }
+    f64 insertMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { checksum += map.at(handles[order[i]]).x; }
+    f64 lookupMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(const glm::vec4& value : map) { checksum += value.y; }
+    f64 iterateMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { map.remove(handles[order[i]]); }
+    f64 eraseMs = elapsedMs(start);
+    printf("  Generation::Map     insert %8.3f ms | lookup %8.3f ms | iterate %8.3f ms | erase %8.3f ms\n", insertMs, lookupMs, iterateMs, eraseMs);
+    delete[] handles;
+  }
+
+  { // std::unordered_map
+    std::unordered_map<u32, glm::vec4> map;
+    u64 start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { map.emplace(i, glm::vec4((f32)i)); }
+    f64 insertMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { checksum += map.find(order[i])->second.x; }
+    f64 lookupMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(const auto& entry : map) { checksum += entry.second.y; }
+    f64 iterateMs = elapsedMs(start);
+    start = getPerformanceCounter();
+    for(u32 i = 0; i < entryCount; ++i) { map.erase(order[i]); }
+    f64 eraseMs = elapsedMs(start);
+    printf("  std::unordered_map  insert %8.3f ms | lookup %8.3f ms | iterate %8.3f ms | erase %8.3f ms\n", insertMs, lookupMs, iterateMs, eraseMs);
+  }
+
+  printf("  (checksum %f)\n", checksum);
+  delete[] order;
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#pragma once
+
+// Virtual file system
+// Assets are opened by their path relative to the working directory. When a pack is mounted its entries are used
+// first: the pack is memory mapped once, so uncompressed entries are zero-copy views into it and only compressed
+// entries are decompressed into their own buffer. Paths missing from the pack fall back to loose files on disk.
+// Lookups are read only once mounted and safe from any thread.
+
+struct Pack {
+  MappedFile file;
+  const PackHeader* header;
+  const PackEntry* entries;
+  const char* paths;
+};
+
+struct AssetFile {
+  const u8* bytes;
+  size_t size;
+  FILE_HANDLE looseFile; // nullptr when the bytes come from the pack
+  u8* ownedBytes; // decompressed pack entries and async reads that did not fit the read buffer
+};
+
+struct VfsStats {
+  std::atomic<u32> packOpenCount;
+  std::atomic<u32> looseOpenCount;
+  std::atomic<u32> decompressCount;
+  std::atomic<u64> bytesOpened;
+  std::atomic<u64> openPerfCounter; // total time spent in openAsset()
+};
+
+global Pack mountedPack{};
+global VfsStats vfsStats{};
+global AsyncIo assetIo{}; // loose file reads for openAssetsAsync()
+
+// False if the file is missing or is not a pack, loose files are used as before
+bool mountPack(const char* fileName) {
+  assert(mountedPack.header == nullptr && "ERROR: A pack is already mounted!");
+  MappedFile file;
+  if(!mapFile(fileName, &file)) { return false; }
+  const PackHeader* header = (const PackHeader*)file.data;
+  if(file.size < sizeof(PackHeader) || header->magic != PACK_MAGIC || header->version != PACK_VERSION ||
+     header->directoryOffset + (header->entryCount * sizeof(PackEntry)) > file.size || header->pathsOffset + header->pathsSize > file.size) {
+    printf("%s is not a version %u pack\n", fileName, PACK_VERSION);
+    unmapFile(&file);
+    return false;
+  }
+  // a truncated or corrupt pack would have entries pointing past the mapping
+  const PackEntry* entries = (const PackEntry*)(file.data + header->directoryOffset);
+  for(u32 i = 0; i < header->entryCount; ++i) {
+    const PackEntry& entry = entries[i];
+    bool compressionValid = entry.compression == PackCompression_LZ4 || (entry.compression == PackCompression_None && entry.storedSize == entry.size);
+    if(entry.storedSize > file.size || entry.offset > file.size - entry.storedSize ||
+       (u64)entry.pathOffset + entry.pathLength > header->pathsSize || !compressionValid) {
+      printf("%s is corrupt at entry %u of %u\n", fileName, i, header->entryCount);
+      unmapFile(&file);
+      return false;
+    }
+  }
+  mountedPack.file = file;
+  mountedPack.header = header;
+  mountedPack.entries = entries;
+  mountedPack.paths = (const char*)(file.data + header->pathsOffset);
+  return true;
+}
+
+void unmountPack() {
+  if(mountedPack.header != nullptr) {
+    unmapFile(&mountedPack.file);
+  }
+  mountedPack = {};
+}
+
+// Binary search of the sorted directory, colliding hashes are told apart by their paths
+const PackEntry* findPackEntry(const Pack& pack, const char* path) {
+  if(pack.header == nullptr) { return nullptr; }
+  u32 pathLength = (u32)strlen(path);
+  u64 hash = hashPackPath(path, pathLength);
+  const PackEntry* entriesEnd = pack.entries + pack.header->entryCount;
+  const PackEntry* entry = std::lower_bound(pack.entries, entriesEnd, hash, [](const PackEntry& entry, u64 hash) { return entry.pathHash < hash; });
+  for(; entry != entriesEnd && entry->pathHash == hash; ++entry) {
+    if(entry->pathLength == pathLength && packPathsEqual(pack.paths + entry->pathOffset, path, pathLength)) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+// A pack entry that fails to decompress is reported and the loose file is opened in its place.
+// False and an empty asset when the loose file is missing too.
+bool openAsset(const char* path, OUT AssetFile* outAsset) {
+  u64 startCounter = getPerformanceCounter();
+  *outAsset = {};
+  const PackEntry* entry = findPackEntry(mountedPack, path);
+  if(entry != nullptr) {
+    const u8* storedBytes = mountedPack.file.data + entry->offset;
+    if(entry->compression == PackCompression_None) {
+      outAsset->bytes = storedBytes;
+    } else {
+      outAsset->ownedBytes = new u8[entry->size];
+      if(lz4Decompress(storedBytes, entry->storedSize, outAsset->ownedBytes, entry->size)) {
+        outAsset->bytes = outAsset->ownedBytes;
+        vfsStats.decompressCount.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        fprintf(stderr, "Pack entry %s is corrupt, falling back to the loose file\n", path);
+        delete[] outAsset->ownedBytes;
+        outAsset->ownedBytes = nullptr;
+        entry = nullptr;
+      }
+    }
+  }
+  if(entry != nullptr) {
+    outAsset->size = entry->size;
+    vfsStats.packOpenCount.fetch_add(1, std::memory_order_relaxed);
+  } else if(openFile(path, &outAsset->looseFile, &outAsset->size)) {
+    outAsset->bytes = (const u8*)fileBytes(outAsset->looseFile);
+    vfsStats.looseOpenCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  vfsStats.bytesOpened.fetch_add(outAsset->size, std::memory_order_relaxed);
+  vfsStats.openPerfCounter.fetch_add(getPerformanceCounter() - startCounter, std::memory_order_relaxed);
+  return outAsset->bytes != nullptr;
+}
+
+void closeAsset(AssetFile* asset) {
+  if(asset->looseFile != nullptr) {
+    closeFile(asset->looseFile);
+  }
+  delete[] asset->ownedBytes;
+  *asset = {}; // clear to zero
+}
+
+typedef void (*AssetReadyCallback)(u32 index, void* userData);
+
+// Opens all assets at once, calling onReady as each one becomes available: right away for pack entries and as their
+// reads complete for loose files, which are read together through assetIo. Returns once every asset is open.
+// Loose files that fail to read go through openAsset() instead, assets that are missing are empty when ready.
+// The whole batch must be released with closeAssetsAsync() before assetIo reads anything else.
+void openAssetsAsync(const char** paths, u32 count, OUT AssetFile* outAssets, AssetReadyCallback onReady, void* userData) {
+  struct LooseReads {
+    AsyncFileRead* reads;
+    u32* assetIndices;
+    AssetFile* assets;
+    AssetReadyCallback onReady;
+    void* userData;
+  };
+  TempMemory tempMemory = beginTempMemory(threadTempArena());
+  LooseReads looseReads{ pushArrayZero(tempMemory.arena, count, AsyncFileRead), pushArray(tempMemory.arena, count, u32), outAssets, onReady, userData };
+  u32 looseCount = 0;
+  for(u32 i = 0; i < count; ++i) {
+    if(findPackEntry(mountedPack, paths[i]) != nullptr) {
+      openAsset(paths[i], outAssets + i);
+      onReady(i, userData);
+    } else {
+      looseReads.reads[looseCount].path = paths[i];
+      looseReads.assetIndices[looseCount++] = i;
+    }
+  }
+
+  u64 startCounter = getPerformanceCounter(); // pack entries were counted by openAsset()
+  readFilesAsync(&assetIo, looseReads.reads, looseCount, [](AsyncFileRead* read, void* data) {
+    LooseReads* looseReads = (LooseReads*)data;
+    u32 index = looseReads->assetIndices[read - looseReads->reads];
+    AssetFile* asset = looseReads->assets + index;
+    *asset = {};
+    if(read->error != 0) {
+      if(read->ownsBytes) {
+        delete[] read->bytes;
+        read->ownsBytes = false;
+      }
+      read->bytes = nullptr;
+      openAsset(read->path, asset);
+    } else {
+      asset->bytes = read->bytes;
+      asset->size = read->size;
+      if(read->ownsBytes) { // the asset frees it now
+        asset->ownedBytes = read->bytes;
+        read->ownsBytes = false;
+      }
+      vfsStats.looseOpenCount.fetch_add(1, std::memory_order_relaxed);
+      vfsStats.bytesOpened.fetch_add(read->size, std::memory_order_relaxed);
+    }
+    looseReads->onReady(index, looseReads->userData);
+  }, &looseReads);
+  vfsStats.openPerfCounter.fetch_add(getPerformanceCounter() - startCounter, std::memory_order_relaxed);
+  endTempMemory(tempMemory);
+}
+
+void closeAssetsAsync(AssetFile* assets, u32 count) {
+  for(u32 i = 0; i < count; ++i) {
+    closeAsset(assets + i);
+  }
+  releaseAsyncReads(&assetIo, nullptr, 0); // buffered bytes go with the batch
+}
+
+// baselineReadSyscalls is a readSyscallCount() from before the reads being reported
+void printVfsStats(const char* label, u64 baselineReadSyscalls) {
+  f64 openMs = (f64)vfsStats.openPerfCounter.load() * 1000.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  printf("%s: %u from pack (%u decompressed), %u loose files, %.1f KB in %.3f ms | read syscalls: %llu\n", label,
+         vfsStats.packOpenCount.load(), vfsStats.decompressCount.load(), vfsStats.looseOpenCount.load(),
+         (f64)vfsStats.bytesOpened.load() / Kilobytes(1), openMs, (unsigned long long)(readSyscallCount() - baselineReadSyscalls));
+}
+
+// Loads every entry of the mounted pack from loose files and then from the pack, results are printed to stdout.
+// Loose files are read first so they are the ones paying for a cold disk cache, if anything.
+void benchmarkVfs() {
+  if(mountedPack.header == nullptr) {
+    printf("VFS benchmark needs a mounted pack, build one with the packer\n");
+    return;
+  }
+  const u32 iterations = 20;
+  const f64 secondsPerCounter = 1.0 / (f64)getPerformanceCounterFrequencyPerSecond();
+  u32 entryCount = mountedPack.header->entryCount;
+  char path[512];
+  u64 checksum = 0;
+  auto touch = [&checksum](const u8* bytes, size_t size) { // page in every byte
+    for(size_t i = 0; i < size; i += 64) { checksum += bytes[i]; }
+  };
+
+  u64 looseSyscalls = readSyscallCount();
+  u64 startCounter = getPerformanceCounter();
+  for(u32 iteration = 0; iteration < iterations; ++iteration) {
+    for(u32 i = 0; i < entryCount; ++i) {
+      const PackEntry& entry = mountedPack.entries[i];
+      snprintf(path, sizeof(path), "%.*s", (int)entry.pathLength, mountedPack.paths + entry.pathOffset);
+      FILE_HANDLE file;
+      size_t size;
+      if(openFile(path, &file, &size)) {
+        touch((const u8*)fileBytes(file), size);
+        closeFile(file);
+      }
+    }
+  }
+  f64 looseSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+  looseSyscalls = readSyscallCount() - looseSyscalls;
+
+  u64 packSyscalls = readSyscallCount();
+  startCounter = getPerformanceCounter();
+  for(u32 iteration = 0; iteration < iterations; ++iteration) {
+    for(u32 i = 0; i < entryCount; ++i) {
+      const PackEntry& entry = mountedPack.entries[i];
+      snprintf(path, sizeof(path), "%.*s", (int)entry.pathLength, mountedPack.paths + entry.pathOffset);
+      AssetFile asset;
+      if(openAsset(path, &asset)) {
+        touch(asset.bytes, asset.size);
+        closeAsset(&asset);
+      }
+    }
+  }
+  f64 packSeconds = (getPerformanceCounter() - startCounter) * secondsPerCounter;
+  packSyscalls = readSyscallCount() - packSyscalls;
+
+  printf("VFS: %u entries x %u iterations (checksum %llu)\n", entryCount, iterations, (unsigned long long)checksum);
+  printf("  loose files: %8.3f ms | read syscalls: %llu\n", looseSeconds * 1000.0, (unsigned long long)looseSyscalls);
+  printf("  mapped pack: %8.3f ms | read syscalls: %llu\n", packSeconds * 1000.0, (unsigned long long)packSyscalls);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#define REPLAY_DEFAULT_TIMESTEP_SECONDS (1.0 / 60.0)
+
+// Stored after each frame's events
+struct ReplayFrameData {
+  u32 down;
+  u32 activated;
+  u32 released;
+  s32 mouseDeltaX;
+  s32 mouseDeltaY;
+  f32 deltaSeconds; // as measured while recording
+  u8 quit;
+  u8 padding[3];
+};
+
+struct ReplayPlayback {
+  InputEventPlayback input;
+};
+
+// Per frame CPU time of a replay, from the start of the frame until its packet is submitted
+struct ReplayTimings {
+  f32* frameMs;
+  f32* recordedDeltaMs;
+  u32 count;
+  u32 capacity;
+};
+
+// Saved and released like any input event recording
+inline void initReplayRecording(InputEventRecording* recording) {
+  initInputEventRecording(recording, sizeof(ReplayFrameData), Megabytes(4));
+}
+
+void recordReplayFrame(InputEventRecording* recording, const InputState& inputState, const InputEventFrame& inputEvents, f64 deltaSeconds) {
+  ReplayFrameData frameData{};
+  frameData.down = (u32)inputState.down;
+  frameData.activated = (u32)inputState.activated;
+  frameData.released = (u32)inputState.released;
+  frameData.mouseDeltaX = inputState.mouseDeltaX;
+  frameData.mouseDeltaY = inputState.mouseDeltaY;
+  frameData.deltaSeconds = (f32)deltaSeconds;
+  frameData.quit = inputState.quit ? 1 : 0;
+  recordInputEventFrame(recording, inputEvents, &frameData);
+}
+
+bool openReplayPlayback(ReplayPlayback* playback, const char* fileName) {
+  if(!openInputEventPlayback(&playback->input, fileName)) { return false; }
+  if(playback->input.frameDataSize != 0 && playback->input.frameDataSize != sizeof(ReplayFrameData)) {
+    printf("Replay %s holds frame data of an unknown size\n", fileName);
+    closeInputEventPlayback(&playback->input);
+    return false;
+  }
+  return true;
+}
+
+inline u32 replayFrameCount(const ReplayPlayback& playback) { return playback.input.frameCount; }
+
+void closeReplayPlayback(ReplayPlayback* playback) {
+  closeInputEventPlayback(&playback->input);
+}
+
+// False once every recorded frame has been played or the replay turns out to be corrupt.
+// outInputState must hold the previous frame's state, plain input recordings build on it.
+bool nextReplayFrame(ReplayPlayback* playback, InputState* outInputState, InputEventFrame* outInputEvents, f64* outRecordedDeltaSeconds) {
+  const u8* frameDataBytes;
+  if(!nextInputEventFrame(&playback->input, outInputEvents, &frameDataBytes)) { return false; }
+  if(frameDataBytes == nullptr) {
+    applyInputEvents(outInputState, *outInputEvents);
+    *outRecordedDeltaSeconds = (f64)(outInputEvents->endCounter - outInputEvents->beginCounter) / (f64)playback->input.perfCounterFrequency;
+    return true;
+  }
+
+  ReplayFrameData frameData;
+  memcpy(&frameData, frameDataBytes, sizeof(frameData));
+  outInputState->down = (b32)frameData.down;
+  outInputState->activated = (b32)frameData.activated;
+  outInputState->released = (b32)frameData.released;
+  outInputState->mouseDeltaX = frameData.mouseDeltaX;
+  outInputState->mouseDeltaY = frameData.mouseDeltaY;
+  outInputState->quit = frameData.quit != 0;
+  updateKeyboardState(&outInputState->keys, *outInputEvents);
+  *outRecordedDeltaSeconds = frameData.deltaSeconds;
+  return true;
+}
+
+int main(){
+  InputEventRecording r{}; initReplayRecording(&r);
+  InputEventFrame f; initInputEventFrame(&f);
+  for(int i=0;i<10;i++){ f.eventCount=i%3; for(u32 e=0;e<f.eventCount;e++){ f.events[e]={}; f.events[e].type=InputEvent_KeyDown; f.events[e].scancode=4+e; f.events[e].perfCounter=f.beginCounter;} f.endCounter=f.beginCounter+1000; InputState st{}; st.down=i; recordReplayFrame(&r, st, f, 0.016); f.beginCounter=f.endCounter; }
+  saveInputEventRecording(&r,"a.rec");
+  ReplayPlayback p; printf("open missing %d\n", openReplayPlayback(&p,"nope.rec"));
+  printf("open %d frames %u\n", openReplayPlayback(&p,"a.rec"), replayFrameCount(p));
+  InputState st{}; InputEventFrame out; f64 d; int n=0; while(nextReplayFrame(&p,&st,&out,&d)) { if(st.down!=(u32)n) printf("bad\n"); n++; } printf("played %d\n",n); closeReplayPlayback(&p);
+  // truncated
+  FILE* fi=fopen("a.rec","rb"); char buf[100000]; size_t sz=fread(buf,1,sizeof buf,fi); fclose(fi); writeFile("b.rec",buf,sz-30);
+  openReplayPlayback(&p,"b.rec"); n=0; while(nextReplayFrame(&p,&st,&out,&d)) n++; printf("truncated played %d\n",n); closeReplayPlayback(&p);
+  // plain recording
+  InputEventRecording q{}; initInputEventRecording(&q); f.eventCount=2; recordInputEventFrame(&q,f); saveInputEventRecording(&q,"c.rec");
+  openReplayPlayback(&p,"c.rec"); st={}; nextReplayFrame(&p,&st,&out,&d); printf("plain delta %g derived %d\n", d, st.mouseDeltaX);
+}